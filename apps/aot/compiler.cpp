@@ -0,0 +1,1097 @@
+#include "compiler.h"
+
+#include "eval/procedure.h"
+#include "io/printer.h"
+#include "runtime/env.h"
+#include "runtime/error.h"
+#include "runtime/list_utils.h"
+#include "stdlib/builtins.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+using ObjectPtr = std::shared_ptr<Object>;
+using ArgsVec = std::vector<ObjectPtr>;
+
+const std::unordered_set<std::string> kSpecialForms = {
+    "quote", "if",     "define", "set!",       "lambda",       "let",          "let*",
+    "begin", "and",    "or",     "cond",       "letrec",       "do",           "case",
+    "guard", "receive", "let-values", "quasiquote", "define-syntax", "unquote", "unquote-splicing"};
+
+const std::unordered_set<std::string> kCppKeywords = {
+    "alignas",  "alignof",   "and",      "and_eq",   "asm",       "auto",     "bitand",
+    "bitor",    "bool",      "break",    "case",     "catch",     "char",     "class",
+    "compl",    "concept",   "const",    "continue", "default",   "delete",   "do",
+    "double",   "else",      "enum",     "explicit", "export",    "extern",   "false",
+    "float",    "for",       "friend",   "goto",     "if",        "inline",   "int",
+    "long",     "main",      "mutable",  "namespace", "new",      "noexcept", "not",
+    "not_eq",   "nullptr",   "operator", "or",       "or_eq",     "private",  "protected",
+    "public",   "register",  "requires", "return",   "short",     "signed",   "sizeof",
+    "static",   "struct",    "switch",   "template", "this",      "throw",    "true",
+    "try",      "typedef",   "typeid",   "typename", "union",     "unsigned", "using",
+    "virtual",  "void",      "volatile", "while",    "xor",       "xor_eq",   "Load",
+    "ObjectPtr"};
+
+[[noreturn]] void Reject(const std::string& what, const ObjectPtr& expr) {
+    throw SyntaxError{what + ": " + Print(expr)};
+}
+
+ArgsVec ToVector(const ObjectPtr& expr) {
+    if (!listutils::IsProperList(expr)) {
+        Reject("Improper form", expr);
+    }
+    return listutils::ToVector(expr);
+}
+
+std::string HeadName(const ObjectPtr& expr) {
+    auto cell = As<Cell>(expr);
+    auto head = cell ? As<Symbol>(cell->GetFirst()) : nullptr;
+    return head ? head->GetName() : std::string{};
+}
+
+// C++ identifier for the Scheme name `name`.
+std::string Mangle(const std::string& name) {
+    static const std::unordered_map<char, const char*> kReplacements = {
+        {'-', "_"},    {'?', "_p"},  {'!', "_x"},  {'*', "_star"}, {'+', "_plus"},
+        {'/', "_div"}, {'<', "_lt"}, {'>', "_gt"}, {'=', "_eq"},   {'.', "_dot"}};
+    std::string result;
+    for (char c : name) {
+        if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+            result += c;
+        } else if (auto it = kReplacements.find(c); it != kReplacements.end()) {
+            result += it->second;
+        } else {
+            static const char* kHex = "0123456789abcdef";
+            result += "_x";
+            result += kHex[static_cast<unsigned char>(c) >> 4];
+            result += kHex[static_cast<unsigned char>(c) & 15];
+        }
+    }
+    if (result.empty() || std::isdigit(static_cast<unsigned char>(result[0]))) {
+        result = "n" + result;
+    }
+    if (kCppKeywords.contains(result)) {
+        result += '_';
+    }
+    return result;
+}
+
+std::string IntLiteral(int64_t value) {
+    if (value == std::numeric_limits<int64_t>::min()) {
+        return "(int64_t{" + std::to_string(value + 1) + "} - 1)";
+    }
+    return "int64_t{" + std::to_string(value) + "}";
+}
+
+std::string StringLiteral(const std::string& text) {
+    std::string result = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result + '"';
+}
+
+// Lines of generated code at some indentation.
+class Code {
+public:
+    explicit Code(int indent = 0) : indent_(indent) {
+    }
+
+    void Line(const std::string& text) {
+        text_.append(4 * indent_, ' ');
+        text_ += text;
+        text_ += '\n';
+    }
+
+    void Open(const std::string& head) {
+        Line(head.empty() ? "{" : head + " {");
+        ++indent_;
+    }
+
+    void Close() {
+        --indent_;
+        Line("}");
+    }
+
+    void Append(const Code& other) {
+        text_ += other.text_;
+    }
+
+    int GetIndent() const {
+        return indent_;
+    }
+
+    const std::string& GetText() const {
+        return text_;
+    }
+
+private:
+    int indent_;
+    std::string text_;
+};
+
+// Target of jumps: a named let, or the procedure being compiled for its self tail calls.
+struct Loop {
+    std::string label;
+    std::vector<std::string> vars;
+    bool used = false;
+};
+
+// Procedure defined at the top level.
+struct Function {
+    std::string name;
+    std::string cpp_name;
+    std::vector<std::string> params;
+    ArgsVec body;
+    // Number of the top-level forms that run on load before the definition.
+    size_t position = 0;
+};
+
+// Variable in scope in the code being compiled; `loop` is set for the name of a named let.
+struct Local {
+    std::string name;
+    std::string cpp_name;
+    Loop* loop = nullptr;
+};
+
+class Compiler {
+public:
+    explicit Compiler(const AotOptions& options)
+        : options_(options), builtins_(std::make_shared<Environment>()) {
+        AddBuiltins(builtins_);
+    }
+
+    ~Compiler() {
+        builtins_->Clear();
+    }
+
+    AotProgram Compile(const ArgsVec& forms) {
+        ArgsVec top_level;
+        for (const auto& form : forms) {
+            Collect(form, &top_level);
+        }
+
+        Code functions;
+        for (const auto& function : functions_) {
+            CompileFunction(function, &functions);
+            callees_.push_back(std::move(calls_));
+            calls_.clear();
+        }
+        Code load(1);
+        for (size_t i = 0; i < top_level.size(); ++i) {
+            CompileTopLevel(top_level[i], &load);
+            CheckDefinedBefore(top_level[i], i);
+            calls_.clear();
+        }
+        return {.source = Source(functions, load), .header = Header()};
+    }
+
+private:
+    // Sorts out the top-level forms: definitions of procedures become functions, everything
+    // else runs on load.
+    void Collect(const ObjectPtr& form, ArgsVec* top_level) {
+        auto head = HeadName(form);
+        if (head == "begin") {
+            auto items = ToVector(form);
+            for (size_t i = 1; i < items.size(); ++i) {
+                Collect(items[i], top_level);
+            }
+            return;
+        }
+        if (head != "define") {
+            top_level->push_back(form);
+            return;
+        }
+        auto items = ToVector(form);
+        if (items.size() < 3) {
+            Reject("Invalid define", form);
+        }
+        ObjectPtr formals;
+        std::string name;
+        ArgsVec body;
+        if (auto signature = As<Cell>(items[1])) {
+            auto symbol = As<Symbol>(signature->GetFirst());
+            if (!symbol) {
+                Reject("Invalid define", form);
+            }
+            name = symbol->GetName();
+            formals = signature->GetSecond();
+            body.assign(items.begin() + 2, items.end());
+        } else if (auto symbol = As<Symbol>(items[1]); symbol && items.size() == 3 &&
+                                                       HeadName(items[2]) == "lambda") {
+            auto lambda = ToVector(items[2]);
+            if (lambda.size() < 3) {
+                Reject("Invalid lambda", items[2]);
+            }
+            name = symbol->GetName();
+            formals = lambda[1];
+            body.assign(lambda.begin() + 2, lambda.end());
+        } else {
+            auto target = As<Symbol>(items[1]);
+            if (!target || items.size() != 3) {
+                Reject("Invalid define", form);
+            }
+            DeclareName(target->GetName(), form);
+            if (function_index_.contains(target->GetName())) {
+                Reject("Procedure redefined as a variable", form);
+            }
+            if (!globals_.contains(target->GetName())) {
+                auto cpp_name = "g_" + Mangle(target->GetName());
+                globals_.emplace(target->GetName(), cpp_name);
+                definitions_.push_back("aot::Global " + cpp_name + "{" +
+                                       StringLiteral(target->GetName()) + "};");
+            }
+            top_level->push_back(form);
+            return;
+        }
+
+        DeclareName(name, form);
+        if (function_index_.contains(name) || globals_.contains(name)) {
+            Reject("Procedure defined twice", form);
+        }
+        if (!listutils::IsProperList(formals)) {
+            Reject("Rest parameters are not supported", form);
+        }
+        Function function{.name = name,
+                          .cpp_name = Mangle(name),
+                          .body = std::move(body),
+                          .position = top_level->size()};
+        for (const auto& param : listutils::ToVector(formals)) {
+            auto symbol = As<Symbol>(param);
+            if (!symbol) {
+                Reject("Invalid parameter", form);
+            }
+            function.params.push_back(symbol->GetName());
+        }
+        if (!cpp_names_.insert(function.cpp_name).second) {
+            Reject("Procedure name clashes with another one in C++", form);
+        }
+        function_index_.emplace(name, functions_.size());
+        functions_.push_back(std::move(function));
+    }
+
+    // Names of special forms and builtins cannot be redefined by compiled programs.
+    void DeclareName(const std::string& name, const ObjectPtr& form) {
+        if (kSpecialForms.contains(name) || builtins_->Find(name)) {
+            Reject("Redefining a builtin is not supported", form);
+        }
+    }
+
+    void CompileFunction(const Function& function, Code* out) {
+        locals_.clear();
+        assigned_.clear();
+        for (const auto& expr : function.body) {
+            CollectAssigned(expr);
+        }
+        Loop self{.label = "start"};
+        std::string signature;
+        for (const auto& param : function.params) {
+            auto cpp_name = NewVar(param);
+            locals_.push_back({param, cpp_name});
+            self.vars.push_back(cpp_name);
+            signature += (signature.empty() ? "ObjectPtr " : ", ObjectPtr ") + cpp_name;
+        }
+        current_ = &function;
+        self_ = &self;
+
+        Code body(1);
+        CompileBody(function.body, "return ", {&self}, &body);
+        out->Open("ObjectPtr " + function.cpp_name + "(" + signature + ")");
+        out->Open("if (!aot::HasStackRoom())");
+        out->Line("return aot::OnNewSegment([&] { return " + function.cpp_name + "(" +
+                  Join(self.vars, ", ") + "); });");
+        out->Close();
+        if (self.used) {
+            out->Line("start:;");
+        }
+        out->Append(body);
+        out->Close();
+        out->Line("");
+        current_ = nullptr;
+        self_ = nullptr;
+    }
+
+    // Procedures exist from the start of compiled code but only once their definitions have run
+    // in the interpreter, so the top-level form `index` may only call those defined before it,
+    // directly or through the procedures it calls.
+    void CheckDefinedBefore(const ObjectPtr& form, size_t index) const {
+        std::vector<size_t> pending(calls_.begin(), calls_.end());
+        std::unordered_set<size_t> seen(calls_.begin(), calls_.end());
+        while (!pending.empty()) {
+            auto callee = pending.back();
+            pending.pop_back();
+            if (functions_[callee].position > index) {
+                Reject("Procedure " + functions_[callee].name + " called before its definition",
+                       form);
+            }
+            for (auto next : callees_[callee]) {
+                if (seen.insert(next).second) {
+                    pending.push_back(next);
+                }
+            }
+        }
+    }
+
+    void CompileTopLevel(const ObjectPtr& form, Code* out) {
+        locals_.clear();
+        assigned_.clear();
+        if (HeadName(form) == "define") {
+            auto items = ToVector(form);
+            if (As<Cell>(items[1]) || HeadName(items[2]) == "lambda") {
+                return;
+            }
+            auto value = CompileValue(items[2], out);
+            out->Line(globals_.at(As<Symbol>(items[1])->GetName()) + ".Define(" + value + ");");
+            return;
+        }
+        auto value = CompileValue(form, out);
+        out->Line("if (on_value) {");
+        out->Line("    on_value(" + value + ");");
+        out->Line("}");
+    }
+
+    // Names assigned by set! anywhere in `expr`, whose values are copied before use.
+    void CollectAssigned(const ObjectPtr& expr) {
+        auto cell = As<Cell>(expr);
+        if (!cell) {
+            return;
+        }
+        if (HeadName(expr) == "quote") {
+            return;
+        }
+        if (HeadName(expr) == "set!") {
+            if (auto rest = As<Cell>(cell->GetSecond())) {
+                if (auto name = As<Symbol>(rest->GetFirst())) {
+                    assigned_.insert(name->GetName());
+                }
+            }
+        }
+        for (auto cur = expr; cur;) {
+            auto item = As<Cell>(cur);
+            if (!item) {
+                break;
+            }
+            CollectAssigned(item->GetFirst());
+            cur = item->GetSecond();
+        }
+    }
+
+    std::string NewVar(const std::string& name) {
+        return "v_" + Mangle(name) + "_" + std::to_string(counter_++);
+    }
+
+    std::string NewTemp(const char* prefix) {
+        return prefix + std::to_string(counter_++);
+    }
+
+    const Local* FindLocal(const std::string& name) const {
+        for (auto it = locals_.rbegin(); it != locals_.rend(); ++it) {
+            if (it->name == name) {
+                return &*it;
+            }
+        }
+        return nullptr;
+    }
+
+    // Name `head` refers to in the head of a call, unless a local variable shadows it.
+    bool IsGlobalName(const ObjectPtr& expr, const char* name) const {
+        return HeadName(expr) == name && !FindLocal(name);
+    }
+
+    std::string Constant(const ObjectPtr& datum) {
+        std::string key;
+        if (auto number = As<Number>(datum)) {
+            key = "n" + std::to_string(number->GetValue());
+        } else if (auto symbol = As<Symbol>(datum)) {
+            key = "s" + symbol->GetName();
+        } else {
+            key = "d" + Print(datum);
+        }
+        if (auto it = constants_.find(key); it != constants_.end()) {
+            return it->second;
+        }
+        auto name = NewTemp("k");
+        definitions_.push_back("const ObjectPtr " + name + " = " + Datum(datum) + ";");
+        constants_.emplace(key, name);
+        return name;
+    }
+
+    std::string Datum(const ObjectPtr& datum) {
+        if (!datum) {
+            return "nullptr";
+        }
+        if (auto number = As<Number>(datum)) {
+            return "aot::Box(" + IntLiteral(number->GetValue()) + ")";
+        }
+        if (auto boolean = As<Boolean>(datum)) {
+            return boolean->GetValue() ? "True()" : "False()";
+        }
+        if (auto symbol = As<Symbol>(datum)) {
+            return "aot::MakeSymbol(" + StringLiteral(symbol->GetName()) + ")";
+        }
+        auto cell = As<Cell>(datum);
+        if (!cell) {
+            Reject("Unsupported constant", datum);
+        }
+        return "aot::Cons(" + Datum(cell->GetFirst()) + ", " + Datum(cell->GetSecond()) + ")";
+    }
+
+    // Function entry point of a builtin for `arity` arguments, or an empty string if it has none.
+    std::string EntryPoint(const std::string& name, size_t arity) {
+        auto builtin = As<BuiltinProcedure>(*builtins_->Find(name));
+        const auto& fixed = builtin ? builtin->GetFixedArity() : BuiltinProcedure::FixedArity{};
+        if ((arity == 1 && !fixed.apply1) || (arity == 2 && !fixed.apply2) ||
+            (arity != 1 && arity != 2)) {
+            return {};
+        }
+        auto key = name + "/" + std::to_string(arity);
+        if (auto it = entry_points_.find(key); it != entry_points_.end()) {
+            return it->second;
+        }
+        auto var = NewTemp("b");
+        definitions_.push_back(std::string(arity == 1 ? "const aot::Fn1 " : "const aot::Fn2 ") +
+                               var + " = aot::" + (arity == 1 ? "Unary(" : "Binary(") +
+                               StringLiteral(name) + ");");
+        entry_points_.emplace(key, var);
+        return var;
+    }
+
+    // Compiles `body` with its last expression in tail position, see CompileTail.
+    void CompileBody(const ArgsVec& body, const std::string& sink, const std::vector<Loop*>& jumps,
+                     Code* out) {
+        if (body.empty()) {
+            throw SyntaxError{"Empty body"};
+        }
+        for (size_t i = 0; i + 1 < body.size(); ++i) {
+            if (IsGlobalName(body[i], "define")) {
+                Reject("Internal define is not supported", body[i]);
+            }
+            CompileValue(body[i], out);
+        }
+        CompileTail(body.back(), sink, jumps, out);
+    }
+
+    // Compiles `expr` so that its value is delivered as `sink` followed by the value, as in
+    // `return ` or `t1 = `. Calls in tail position to the loops in `jumps` become jumps.
+    void CompileTail(const ObjectPtr& expr, const std::string& sink,
+                     const std::vector<Loop*>& jumps, Code* out) {
+        auto head = HeadName(expr);
+        if (head.empty() || FindLocal(head)) {
+            if (!head.empty() && FindLocal(head)->loop) {
+                CompileJump(expr, jumps, out);
+                return;
+            }
+            out->Line(sink + CompileValue(expr, out) + ";");
+            return;
+        }
+        auto items = ToVector(expr);
+        if (head == "if") {
+            if (items.size() != 3 && items.size() != 4) {
+                Reject("Invalid if", expr);
+            }
+            out->Open("if (" + CompileCondition(items[1], out) + ")");
+            CompileTail(items[2], sink, jumps, out);
+            out->Close();
+            out->Open("else");
+            if (items.size() == 4) {
+                CompileTail(items[3], sink, jumps, out);
+            } else {
+                out->Line(sink + "nullptr;");
+            }
+            out->Close();
+        } else if (head == "begin") {
+            CompileBody(ArgsVec(items.begin() + 1, items.end()), sink, jumps, out);
+        } else if (head == "let" || head == "let*") {
+            CompileLet(expr, items, head == "let*", sink, jumps, out);
+        } else if (head == "cond") {
+            CompileCond(expr, items, 1, sink, jumps, out);
+        } else if (head == "and" || head == "or") {
+            CompileLogic(items, head == "and", sink, jumps, out);
+        } else if (current_ && head == current_->name && self_ &&
+                   std::find(jumps.begin(), jumps.end(), self_) != jumps.end()) {
+            CompileJump(expr, jumps, out);
+        } else {
+            out->Line(sink + CompileValue(expr, out) + ";");
+        }
+    }
+
+    void CompileJump(const ObjectPtr& expr, const std::vector<Loop*>& jumps, Code* out) {
+        auto items = ToVector(expr);
+        auto* local = FindLocal(HeadName(expr));
+        auto* loop = local ? local->loop : self_;
+        if (std::find(jumps.begin(), jumps.end(), loop) == jumps.end()) {
+            Reject("Named let is only compiled with calls in tail position", expr);
+        }
+        if (items.size() - 1 != loop->vars.size()) {
+            Reject("Invalid argument count", expr);
+        }
+        std::vector<std::string> values;
+        for (size_t i = 1; i < items.size(); ++i) {
+            auto value = CompileValue(items[i], out);
+            auto temp = NewTemp("a");
+            out->Line("ObjectPtr " + temp + " = " + value + ";");
+            values.push_back(temp);
+        }
+        for (size_t i = 0; i < values.size(); ++i) {
+            out->Line(loop->vars[i] + " = std::move(" + values[i] + ");");
+        }
+        out->Line("goto " + loop->label + ";");
+        loop->used = true;
+    }
+
+    void CompileLet(const ObjectPtr& expr, const ArgsVec& items, bool sequential,
+                    const std::string& sink, const std::vector<Loop*>& jumps, Code* out) {
+        if (items.size() < 3) {
+            Reject("Invalid let", expr);
+        }
+        auto name = As<Symbol>(items[1]);
+        if (name && !sequential) {
+            CompileNamedLet(expr, items, name->GetName(), sink, jumps, out);
+            return;
+        }
+        auto saved = locals_.size();
+        out->Open("");
+        std::vector<std::pair<std::string, std::string>> bindings;
+        for (const auto& binding : ToVector(items[1])) {
+            auto pair = ToVector(binding);
+            auto var = pair.empty() ? nullptr : As<Symbol>(pair[0]);
+            if (!var || pair.size() != 2) {
+                Reject("Invalid binding", binding);
+            }
+            auto value = CompileValue(pair[1], out);
+            if (sequential) {
+                auto cpp_name = NewVar(var->GetName());
+                out->Line("ObjectPtr " + cpp_name + " = " + value + ";");
+                locals_.push_back({var->GetName(), cpp_name});
+            } else {
+                bindings.emplace_back(var->GetName(), value);
+            }
+        }
+        for (const auto& [var, value] : bindings) {
+            auto cpp_name = NewVar(var);
+            out->Line("ObjectPtr " + cpp_name + " = " + value + ";");
+            locals_.push_back({var, cpp_name});
+        }
+        CompileBody(ArgsVec(items.begin() + 2, items.end()), sink, jumps, out);
+        out->Close();
+        locals_.resize(saved);
+    }
+
+    void CompileNamedLet(const ObjectPtr& expr, const ArgsVec& items, const std::string& name,
+                         const std::string& sink, const std::vector<Loop*>& jumps, Code* out) {
+        if (items.size() < 4) {
+            Reject("Invalid let", expr);
+        }
+        auto saved = locals_.size();
+        out->Open("");
+        Loop loop{.label = NewTemp("loop")};
+        std::vector<Local> vars;
+        for (const auto& binding : ToVector(items[2])) {
+            auto pair = ToVector(binding);
+            auto var = pair.empty() ? nullptr : As<Symbol>(pair[0]);
+            if (!var || pair.size() != 2) {
+                Reject("Invalid binding", binding);
+            }
+            auto value = CompileValue(pair[1], out);
+            auto cpp_name = NewVar(var->GetName());
+            out->Line("ObjectPtr " + cpp_name + " = " + value + ";");
+            vars.push_back({var->GetName(), cpp_name});
+            loop.vars.push_back(cpp_name);
+        }
+        locals_.push_back({name, {}, &loop});
+        locals_.insert(locals_.end(), vars.begin(), vars.end());
+        auto inner = jumps;
+        inner.push_back(&loop);
+        Code body(out->GetIndent());
+        CompileBody(ArgsVec(items.begin() + 3, items.end()), sink, inner, &body);
+        if (loop.used) {
+            out->Line(loop.label + ":;");
+        }
+        out->Append(body);
+        out->Close();
+        locals_.resize(saved);
+    }
+
+    void CompileCond(const ObjectPtr& expr, const ArgsVec& items, size_t index,
+                     const std::string& sink, const std::vector<Loop*>& jumps, Code* out) {
+        if (index == items.size()) {
+            out->Line(sink + "nullptr;");
+            return;
+        }
+        auto clause = ToVector(items[index]);
+        if (clause.empty()) {
+            Reject("Invalid cond clause", expr);
+        }
+        if (clause.size() > 1 && As<Symbol>(clause[1]) &&
+            As<Symbol>(clause[1])->GetName() == "=>") {
+            Reject("=> in cond is not supported", items[index]);
+        }
+        auto is_else = As<Symbol>(clause[0]) && As<Symbol>(clause[0])->GetName() == "else";
+        if (is_else) {
+            if (index + 1 != items.size() || clause.size() < 2) {
+                Reject("Invalid else clause", expr);
+            }
+            CompileBody(ArgsVec(clause.begin() + 1, clause.end()), sink, jumps, out);
+            return;
+        }
+        if (clause.size() == 1) {
+            auto value = CompileValue(clause[0], out);
+            out->Open("if (aot::IsTrue(" + value + "))");
+            out->Line(sink + value + ";");
+        } else {
+            out->Open("if (" + CompileCondition(clause[0], out) + ")");
+            CompileBody(ArgsVec(clause.begin() + 1, clause.end()), sink, jumps, out);
+        }
+        out->Close();
+        out->Open("else");
+        CompileCond(expr, items, index + 1, sink, jumps, out);
+        out->Close();
+    }
+
+    void CompileLogic(const ArgsVec& items, bool is_and, const std::string& sink,
+                      const std::vector<Loop*>& jumps, Code* out) {
+        if (items.size() == 1) {
+            out->Line(sink + Constant(MakeBool(is_and)) + ";");
+            return;
+        }
+        std::vector<std::string> values;
+        for (size_t i = 1; i + 1 < items.size(); ++i) {
+            auto value = CompileValue(items[i], out);
+            values.push_back(value);
+            out->Open(std::string("if (") + (is_and ? "" : "!") + "aot::IsTrue(" + value + "))");
+        }
+        CompileTail(items.back(), sink, jumps, out);
+        for (auto it = values.rbegin(); it != values.rend(); ++it) {
+            out->Close();
+            out->Open("else");
+            out->Line(sink + *it + ";");
+            out->Close();
+        }
+    }
+
+    // C++ expression for the value of `expr`, which is a variable, a constant or a temporary that
+    // the code emitted to `out` computes.
+    std::string CompileValue(const ObjectPtr& expr, Code* out) {
+        if (Is<Number>(expr) || Is<Boolean>(expr)) {
+            return Constant(expr);
+        }
+        if (auto symbol = As<Symbol>(expr)) {
+            return CompileVariable(symbol->GetName(), expr, out);
+        }
+        auto cell = As<Cell>(expr);
+        if (!cell) {
+            Reject("Invalid expression", expr);
+        }
+        auto head = HeadName(expr);
+        if (head.empty()) {
+            Reject("Calls of procedure values are not supported", expr);
+        }
+        if (auto* local = FindLocal(head)) {
+            if (local->loop) {
+                Reject("Named let is only compiled with calls in tail position", expr);
+            }
+            Reject("Calls of procedure values are not supported", expr);
+        }
+        auto items = ToVector(expr);
+        if (head == "quote") {
+            if (items.size() != 2) {
+                Reject("Invalid quote", expr);
+            }
+            return Constant(items[1]);
+        }
+        if (head == "if" || head == "begin" || head == "let" || head == "let*" ||
+            head == "cond" || head == "and" || head == "or") {
+            auto temp = NewTemp("t");
+            out->Line("ObjectPtr " + temp + ";");
+            CompileTail(expr, temp + " = ", {}, out);
+            return temp;
+        }
+        if (head == "set!") {
+            CompileSet(expr, items, out);
+            return "nullptr";
+        }
+        if (kSpecialForms.contains(head)) {
+            Reject("Unsupported form", expr);
+        }
+        return CompileCall(expr, head, items, out);
+    }
+
+    std::string CompileVariable(const std::string& name, const ObjectPtr& expr, Code* out) {
+        if (auto* local = FindLocal(name)) {
+            if (local->loop) {
+                Reject("Procedures are not values", expr);
+            }
+            if (!assigned_.contains(name)) {
+                return local->cpp_name;
+            }
+            auto temp = NewTemp("t");
+            out->Line("ObjectPtr " + temp + " = " + local->cpp_name + ";");
+            return temp;
+        }
+        if (auto it = globals_.find(name); it != globals_.end()) {
+            auto temp = NewTemp("t");
+            out->Line("ObjectPtr " + temp + " = " + it->second + ".Get();");
+            return temp;
+        }
+        if (function_index_.contains(name) || builtins_->Find(name)) {
+            Reject("Procedures are not values", expr);
+        }
+        Reject("Name not found", expr);
+    }
+
+    void CompileSet(const ObjectPtr& expr, const ArgsVec& items, Code* out) {
+        auto target = items.size() == 3 ? As<Symbol>(items[1]) : nullptr;
+        if (!target) {
+            Reject("Invalid set!", expr);
+        }
+        auto value = CompileValue(items[2], out);
+        if (auto* local = FindLocal(target->GetName()); local && !local->loop) {
+            out->Line(local->cpp_name + " = " + value + ";");
+        } else if (auto it = globals_.find(target->GetName()); !local && it != globals_.end()) {
+            out->Line(it->second + ".Set(" + value + ");");
+        } else {
+            Reject("Only variables can be assigned", expr);
+        }
+    }
+
+    std::string CompileCall(const ObjectPtr& expr, const std::string& head, const ArgsVec& items,
+                            Code* out) {
+        auto arity = items.size() - 1;
+        if (auto it = function_index_.find(head); it != function_index_.end()) {
+            const auto& function = functions_[it->second];
+            if (arity != function.params.size()) {
+                Reject("Invalid argument count", expr);
+            }
+            calls_.insert(it->second);
+            std::string args;
+            for (size_t i = 1; i < items.size(); ++i) {
+                args += (args.empty() ? "" : ", ") + CompileValue(items[i], out);
+            }
+            auto temp = NewTemp("t");
+            out->Line("ObjectPtr " + temp + " = " + function.cpp_name + "(" + args + ");");
+            return temp;
+        }
+        if (!builtins_->Find(head)) {
+            Reject("Name not found", expr);
+        }
+        if (head == "+" || head == "-" || head == "*") {
+            if (arity == 0) {
+                if (head == "-") {
+                    Reject("Invalid argument count", expr);
+                }
+                return Constant(std::make_shared<Number>(head == "+" ? 0 : 1));
+            }
+            std::vector<std::string> checks;
+            auto result = CompileFixnum(expr, &checks, out);
+            auto temp = NewTemp("t");
+            if (checks.empty()) {
+                out->Line("ObjectPtr " + temp + " = aot::Box(" + result.value + ");");
+            } else {
+                out->Line("ObjectPtr " + temp + " = " + Join(checks) + " ? aot::Box(" +
+                          result.value + ") : " + result.generic + ";");
+            }
+            return temp;
+        }
+        if (kComparisons.contains(head) || head == "not" || head == "null?" || head == "pair?") {
+            if (kComparisons.contains(head) && arity != 2) {
+                return CompileGeneric(kComparisons.at(head).primitive, items, out);
+            }
+            if (!kComparisons.contains(head) && arity != 1) {
+                Reject("Invalid argument count", expr);
+            }
+            auto temp = NewTemp("t");
+            out->Line("ObjectPtr " + temp + " = MakeBool(" + CompileCondition(expr, out) + ");");
+            return temp;
+        }
+        std::vector<std::string> args;
+        for (size_t i = 1; i < items.size(); ++i) {
+            args.push_back(CompileValue(items[i], out));
+        }
+        std::string call;
+        if (head == "list") {
+            call = "nullptr";
+            for (auto it = args.rbegin(); it != args.rend(); ++it) {
+                call = "aot::Cons(" + *it + ", " + call + ")";
+            }
+        } else if (head == "cons" && arity == 2) {
+            call = "aot::Cons(" + args[0] + ", " + args[1] + ")";
+        } else if ((head == "car" || head == "cdr") && arity == 1) {
+            call = std::string(head == "car" ? "aot::Car(" : "aot::Cdr(") + args[0] + ")";
+        } else if (head == "/" && arity == 2) {
+            call = "aot::Divide(" + args[0] + ", " + args[1] + ")";
+        } else if (auto entry = EntryPoint(head, arity); !entry.empty()) {
+            call = "aot::Check(" + entry + "(" + Join(args, ", ") + "))";
+        } else {
+            Reject("Builtin is not supported with " + std::to_string(arity) + " arguments", expr);
+        }
+        auto temp = NewTemp("t");
+        out->Line("ObjectPtr " + temp + " = " + call + ";");
+        return temp;
+    }
+
+    std::string CompileGeneric(const char* primitive, const ArgsVec& items, Code* out) {
+        std::vector<std::string> args;
+        for (size_t i = 1; i < items.size(); ++i) {
+            args.push_back(CompileValue(items[i], out));
+        }
+        auto temp = NewTemp("t");
+        out->Line("ObjectPtr " + temp + " = aot::Generic(Primitive::" + primitive + ", {" +
+                  Join(args, ", ") + "});");
+        return temp;
+    }
+
+    // C++ boolean telling whether `expr` is true, computed by the code emitted to `out`.
+    std::string CompileCondition(const ObjectPtr& expr, Code* out) {
+        if (auto boolean = As<Boolean>(expr)) {
+            return boolean->GetValue() ? "true" : "false";
+        }
+        auto head = HeadName(expr);
+        if (head.empty() || FindLocal(head) || function_index_.contains(head) ||
+            globals_.contains(head)) {
+            return "aot::IsTrue(" + CompileValue(expr, out) + ")";
+        }
+        auto items = ToVector(expr);
+        if (auto it = kComparisons.find(head); it != kComparisons.end() && items.size() == 3) {
+            std::vector<std::string> checks;
+            auto lhs = CompileFixnum(items[1], &checks, out);
+            auto rhs = CompileFixnum(items[2], &checks, out);
+            auto fast = "(" + lhs.value + " " + it->second.op + " " + rhs.value + ")";
+            auto temp = NewTemp("c");
+            if (checks.empty()) {
+                out->Line("bool " + temp + " = " + fast + ";");
+            } else {
+                out->Line("bool " + temp + " = " + Join(checks) + " ? " + fast +
+                          " : aot::IsTrue(aot::Generic(Primitive::" + it->second.primitive +
+                          ", {" + lhs.generic + ", " + rhs.generic + "}));");
+            }
+            return temp;
+        }
+        if (head == "not" && items.size() == 2) {
+            return "!" + CompileCondition(items[1], out);
+        }
+        if (head == "null?" && items.size() == 2) {
+            return "(" + CompileValue(items[1], out) + " == nullptr)";
+        }
+        if (head == "pair?" && items.size() == 2) {
+            return "aot::IsPair(" + CompileValue(items[1], out) + ")";
+        }
+        if ((head == "and" || head == "or") && items.size() > 1) {
+            auto is_and = head == "and";
+            auto temp = NewTemp("c");
+            out->Line("bool " + temp + " = " + CompileCondition(items[1], out) + ";");
+            for (size_t i = 2; i < items.size(); ++i) {
+                out->Open(std::string("if (") + (is_and ? "" : "!") + temp + ")");
+                out->Line(temp + " = " + CompileCondition(items[i], out) + ";");
+            }
+            for (size_t i = 2; i < items.size(); ++i) {
+                out->Close();
+            }
+            return temp;
+        }
+        return "aot::IsTrue(" + CompileValue(expr, out) + ")";
+    }
+
+    // Integer arithmetic: `value` is an int64_t expression valid if all `checks` hold, which
+    // they do when every operand is a number and nothing overflows; `generic` is the boxed
+    // result computed by the builtins otherwise.
+    struct Fixnum {
+        std::string value;
+        std::string generic;
+    };
+
+    struct Comparison {
+        const char* op;
+        const char* primitive;
+    };
+
+    static inline const std::unordered_map<std::string, Comparison> kComparisons = {
+        {"=", {"==", "Eq"}}, {"<", {"<", "Lt"}}, {">", {">", "Gt"}},
+        {"<=", {"<=", "Le"}}, {">=", {">=", "Ge"}}};
+
+    Fixnum CompileFixnum(const ObjectPtr& expr, std::vector<std::string>* checks, Code* out) {
+        if (auto number = As<Number>(expr)) {
+            return {IntLiteral(number->GetValue()), Constant(expr)};
+        }
+        auto head = HeadName(expr);
+        auto items = Is<Cell>(expr) && listutils::IsProperList(expr) ? listutils::ToVector(expr)
+                                                                       : ArgsVec{};
+        auto is_arithmetic = (head == "+" || head == "-" || head == "*") && items.size() > 1 &&
+                             !FindLocal(head);
+        if (!is_arithmetic) {
+            auto value = CompileValue(expr, out);
+            auto var = NewTemp("n");
+            out->Line("int64_t " + var + " = 0;");
+            checks->push_back("aot::Fixnum(" + value + ", &" + var + ")");
+            return {var, value};
+        }
+        const char* primitive = head == "+" ? "Add" : head == "-" ? "Sub" : "Mul";
+        const char* builtin = head == "+"   ? "__builtin_add_overflow"
+                              : head == "-" ? "__builtin_sub_overflow"
+                                            : "__builtin_mul_overflow";
+        std::vector<Fixnum> operands;
+        for (size_t i = 1; i < items.size(); ++i) {
+            operands.push_back(CompileFixnum(items[i], checks, out));
+        }
+        std::vector<std::string> generics;
+        for (const auto& operand : operands) {
+            generics.push_back(operand.generic);
+        }
+        Fixnum result{operands[0].value, "aot::Generic(Primitive::" + std::string(primitive) +
+                                             ", {" + Join(generics, ", ") + "})"};
+        if (head == "-" && operands.size() == 1) {
+            operands.insert(operands.begin(), Fixnum{"int64_t{0}", {}});
+        }
+        if (operands.size() == 1) {
+            return result;
+        }
+        result.value = operands[0].value;
+        for (size_t i = 1; i < operands.size(); ++i) {
+            auto var = NewTemp("n");
+            out->Line("int64_t " + var + " = 0;");
+            checks->push_back("!" + std::string(builtin) + "(" + result.value + ", " +
+                              operands[i].value + ", &" + var + ")");
+            result.value = var;
+        }
+        return result;
+    }
+
+    static std::string Join(const std::vector<std::string>& parts,
+                            const std::string& separator) {
+        std::string result;
+        for (const auto& part : parts) {
+            result += (result.empty() ? "" : separator) + part;
+        }
+        return result;
+    }
+
+    // Checks joined into one condition.
+    static std::string Join(const std::vector<std::string>& checks) {
+        return "(" + Join(checks, " && ") + ")";
+    }
+
+    std::string Declaration(const Function& function, bool with_names) const {
+        std::string params;
+        for (const auto& param : function.params) {
+            params += (params.empty() ? "" : ", ") +
+                      std::string(with_names ? "std::shared_ptr<Object> " + Mangle(param)
+                                             : "ObjectPtr");
+        }
+        return (with_names ? "std::shared_ptr<Object> " : "ObjectPtr ") + function.cpp_name +
+               "(" + params + ");";
+    }
+
+    std::string Source(const Code& functions, const Code& load) const {
+        Code out;
+        out.Line("// Generated by scheme-aot from " + options_.source_name + ". Do not edit.");
+        out.Line("");
+        out.Line("#include \"aot/runtime.h\"");
+        if (options_.main) {
+            out.Line("#include \"io/printer.h\"");
+            out.Line("");
+            out.Line("#include <exception>");
+            out.Line("#include <iostream>");
+        }
+        out.Line("");
+        out.Line("namespace " + options_.name_space + " {");
+        out.Line("");
+        out.Line("using aot::ObjectPtr;");
+        out.Line("");
+        out.Line("void Load(void (*on_value)(const ObjectPtr&));");
+        for (const auto& function : functions_) {
+            out.Line(Declaration(function, false));
+        }
+        out.Line("");
+        out.Line("namespace {");
+        out.Line("");
+        for (const auto& definition : definitions_) {
+            out.Line(definition);
+        }
+        out.Line("");
+        out.Line("}  // namespace");
+        out.Line("");
+        out.Append(functions);
+        out.Line("void Load(void (*on_value)(const ObjectPtr&)) {");
+        out.Line("    static_cast<void>(on_value);");
+        out.Append(load);
+        out.Line("}");
+        out.Line("");
+        out.Line("}  // namespace " + options_.name_space);
+        if (options_.main) {
+            out.Line("");
+            out.Open("int main()");
+            out.Open("try");
+            out.Line(options_.name_space + "::Load([](const std::shared_ptr<Object>& value) {");
+            out.Line("    std::cout << Print(value) << '\\n';");
+            out.Line("});");
+            out.Close();
+            out.Open("catch (const std::exception& error)");
+            out.Line("std::cerr << error.what() << '\\n';");
+            out.Line("return 1;");
+            out.Close();
+            out.Close();
+        }
+        return out.GetText();
+    }
+
+    std::string Header() const {
+        Code out;
+        out.Line("// Generated by scheme-aot from " + options_.source_name + ". Do not edit.");
+        out.Line("");
+        out.Line("#pragma once");
+        out.Line("");
+        out.Line("#include \"runtime/object.h\"");
+        out.Line("");
+        out.Line("#include <memory>");
+        out.Line("");
+        out.Line("namespace " + options_.name_space + " {");
+        out.Line("");
+        out.Line("// Runs the top-level forms of the program in order, passing the values of the "
+                 "ones that");
+        out.Line("// are not definitions to `on_value` unless it is null. Must be called before "
+                 "the procedures.");
+        out.Line("void Load(void (*on_value)(const std::shared_ptr<Object>&));");
+        out.Line("");
+        for (const auto& function : functions_) {
+            out.Line(Declaration(function, true));
+        }
+        out.Line("");
+        out.Line("}  // namespace " + options_.name_space);
+        return out.GetText();
+    }
+
+    const AotOptions& options_;
+    std::shared_ptr<Environment> builtins_;
+    std::vector<Function> functions_;
+    std::unordered_map<std::string, size_t> function_index_;
+    std::unordered_set<std::string> cpp_names_;
+    std::unordered_map<std::string, std::string> globals_;
+    std::vector<std::string> definitions_;
+    std::unordered_map<std::string, std::string> constants_;
+    std::unordered_map<std::string, std::string> entry_points_;
+    std::vector<Local> locals_;
+    std::unordered_set<std::string> assigned_;
+    // Procedures called by the code being compiled, and by each compiled procedure in turn.
+    std::unordered_set<size_t> calls_;
+    std::vector<std::unordered_set<size_t>> callees_;
+    const Function* current_ = nullptr;
+    Loop* self_ = nullptr;
+    size_t counter_ = 0;
+};
+
+}  // namespace
+
+AotProgram CompileProgram(const std::vector<std::shared_ptr<Object>>& forms,
+                          const AotOptions& options) {
+    return Compiler(options).Compile(forms);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "runtime/object.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Translation of a Scheme program into C++ for scheme-aot.
+//
+// The program is a sequence of top-level forms. Procedures it defines at the top level become
+// C++ functions of the same names that call each other directly; the other forms run in order
+// when the program is loaded, and may only call procedures defined before them, as in the
+// interpreter. Deep recursions grow the native stack by segments as the interpreter does and
+// end in a RuntimeError at its limit. Arithmetic and comparisons work on unboxed integers with
+// overflow checks and hand anything else to the builtins, self calls in tail position and named
+// let loops become jumps, and conditions are plain C++ booleans. Compiled code covers a
+// first-order subset of the language: quote, if, define, set!, let, let*, named let, begin, and,
+// or and cond, with calls to the procedures of the program and to the builtins that need no
+// evaluator. Procedures are not values, so there are no lambdas other than as the value of a
+// top-level define, and there are no macros, continuations or exceptions. Programs outside of
+// the subset are rejected with a SyntaxError naming the form.
+struct AotOptions {
+    // Namespace of the generated code.
+    std::string name_space = "scheme_aot";
+    // Whether to add a main that loads the program and prints the values of its top-level
+    // expressions.
+    bool main = false;
+    // Name of the source file, for the comment heading the generated code.
+    std::string source_name;
+};
+
+// Generated code: the source, and a header declaring Load and the procedures of the program.
+struct AotProgram {
+    std::string source;
+    std::string header;
+};
+
+AotProgram CompileProgram(const std::vector<std::shared_ptr<Object>>& forms,
+                          const AotOptions& options);
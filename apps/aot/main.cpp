@@ -0,0 +1,97 @@
+#include "compiler.h"
+
+#include "reader/parser.h"
+#include "reader/tokenizer.h"
+
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view kUsage =
+    "usage: scheme-aot [--main] [--namespace NAME] [--header PATH] INPUT OUTPUT\n";
+
+// Source without its `;` comments, which the tokenizer does not know.
+std::string StripComments(std::istream& in) {
+    std::string result;
+    std::string line;
+    while (std::getline(in, line)) {
+        auto in_string = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            if (line[i] == '"' && (i == 0 || line[i - 1] != '\\')) {
+                in_string = !in_string;
+            } else if (line[i] == ';' && !in_string) {
+                line.resize(i);
+                break;
+            }
+        }
+        result += line;
+        result += '\n';
+    }
+    return result;
+}
+
+std::vector<std::shared_ptr<Object>> ReadProgram(const std::string& path) {
+    std::ifstream file{path};
+    if (!file) {
+        throw std::runtime_error{"cannot open the file"};
+    }
+    std::istringstream in{StripComments(file)};
+    Tokenizer tokenizer{&in};
+    std::vector<std::shared_ptr<Object>> forms;
+    while (!tokenizer.IsEnd()) {
+        forms.push_back(ReadNext(&tokenizer));
+    }
+    return forms;
+}
+
+void WriteFile(const std::string& path, const std::string& text) {
+    std::ofstream file{path};
+    file << text;
+    if (!file) {
+        throw std::runtime_error{"cannot write " + path};
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    AotOptions options;
+    std::string header;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--main") {
+            options.main = true;
+        } else if ((arg == "--namespace" || arg == "--header") && i + 1 < argc) {
+            (arg == "--header" ? header : options.name_space) = argv[++i];
+        } else if (arg.starts_with("--")) {
+            std::cerr << kUsage;
+            return 2;
+        } else {
+            paths.emplace_back(arg);
+        }
+    }
+    if (paths.size() != 2) {
+        std::cerr << kUsage;
+        return 2;
+    }
+
+    const auto& input = paths[0];
+    options.source_name = input.substr(input.find_last_of('/') + 1);
+    try {
+        auto program = CompileProgram(ReadProgram(input), options);
+        WriteFile(paths[1], program.source);
+        if (!header.empty()) {
+            WriteFile(header, program.header);
+        }
+    } catch (const std::exception& error) {
+        std::cerr << "scheme-aot: " << input << ": " << error.what() << '\n';
+        return 1;
+    }
+}
@@ -1,7 +1,6 @@
 #include "scheme.h"
 
 #include <iostream>
-#include <stdexcept>
 #include <string>
 
 int main() {
@@ -14,11 +13,8 @@ int main() {
         if (expression.empty()) {
             continue;
         }
-        try {
-            std::cout << scheme.Evaluate(expression);
-        } catch (const std::runtime_error& ex) {
-            std::cout << ex.what();
-        }
+        auto result = scheme.TryEvaluate(expression);
+        std::cout << (result ? *result : result.error().GetMessage());
         std::cout << '\n';
     }
 }
@@ -0,0 +1,38 @@
+# add_scheme_aot(NAME SOURCE [LIBRARY | SHARED] [NAMESPACE NS])
+#
+# Compiles the Scheme program SOURCE into C++ with scheme-aot and builds it. By default the
+# result is an executable NAME that runs the program and prints the values of its top-level
+# expressions; with LIBRARY or SHARED it is a static or shared library whose header NAME.h
+# declares the procedures of the program in namespace NS, which defaults to NAME.
+function(add_scheme_aot NAME SOURCE)
+  cmake_parse_arguments(AOT "LIBRARY;SHARED" "NAMESPACE" "" ${ARGN})
+  if(NOT AOT_NAMESPACE)
+    set(AOT_NAMESPACE ${NAME})
+  endif()
+
+  get_filename_component(AOT_INPUT ${SOURCE} ABSOLUTE)
+  set(AOT_DIR ${CMAKE_CURRENT_BINARY_DIR}/${NAME}_aot)
+  set(AOT_FLAGS --namespace ${AOT_NAMESPACE} --header ${AOT_DIR}/${NAME}.h)
+  if(NOT AOT_LIBRARY AND NOT AOT_SHARED)
+    list(APPEND AOT_FLAGS --main)
+  endif()
+
+  add_custom_command(
+    OUTPUT ${AOT_DIR}/${NAME}.cpp ${AOT_DIR}/${NAME}.h
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${AOT_DIR}
+    COMMAND scheme-aot ${AOT_FLAGS} ${AOT_INPUT} ${AOT_DIR}/${NAME}.cpp
+    DEPENDS scheme-aot ${AOT_INPUT}
+    COMMENT "Compiling ${SOURCE} with scheme-aot"
+    VERBATIM)
+
+  if(AOT_SHARED)
+    set_target_properties(libscheme PROPERTIES POSITION_INDEPENDENT_CODE ON)
+    add_library(${NAME} SHARED ${AOT_DIR}/${NAME}.cpp)
+  elseif(AOT_LIBRARY)
+    add_library(${NAME} STATIC ${AOT_DIR}/${NAME}.cpp)
+  else()
+    add_executable(${NAME} ${AOT_DIR}/${NAME}.cpp)
+  endif()
+  target_link_libraries(${NAME} PUBLIC libscheme)
+  target_include_directories(${NAME} PUBLIC ${AOT_DIR})
+endfunction()
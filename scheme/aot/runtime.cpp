@@ -0,0 +1,74 @@
+#include "aot/runtime.h"
+
+#include "eval/procedure.h"
+#include "runtime/env.h"
+#include "stdlib/builtins.h"
+
+namespace aot {
+
+namespace {
+
+const BuiltinProcedure::FixedArity& EntryPoints(const char* name) {
+    static const auto builtins = [] {
+        auto env = std::make_shared<Environment>();
+        AddBuiltins(env);
+        return env;
+    }();
+    auto* value = builtins->Find(name);
+    auto builtin = value ? As<BuiltinProcedure>(*value) : nullptr;
+    if (!builtin) {
+        throw NameError{name};
+    }
+    return builtin->GetFixedArity();
+}
+
+}  // namespace
+
+void Throw() {
+    TakeError().Throw();
+}
+
+Fn1 Unary(const char* name) {
+    auto fn = EntryPoints(name).apply1;
+    if (!fn) {
+        throw RuntimeError{"Invalid argument count"};
+    }
+    return fn;
+}
+
+Fn2 Binary(const char* name) {
+    auto fn = EntryPoints(name).apply2;
+    if (!fn) {
+        throw RuntimeError{"Invalid argument count"};
+    }
+    return fn;
+}
+
+ObjectPtr Generic(Primitive primitive, std::initializer_list<ObjectPtr> args) {
+    return Check(ApplyPrimitive(primitive, args.begin(), args.size()));
+}
+
+NativeStack& GetNativeStack() {
+    static thread_local NativeStack stack;
+    return stack;
+}
+
+ObjectPtr OnNewSegment(const std::function<ObjectPtr()>& fn) {
+    return Check(GetNativeStack().RunOnNewSegment(fn));
+}
+
+ObjectPtr Divide(const ObjectPtr& lhs, const ObjectPtr& rhs) {
+    int64_t left, right;
+    if (!helpers::RequireInt(lhs, &left) || !helpers::RequireInt(rhs, &right)) {
+        Throw();
+    }
+    if (right == 0) {
+        throw RuntimeError{"Division by zero"};
+    }
+    if (right == -1) {
+        return Generic(Primitive::Sub, {lhs});
+    }
+    return Box(left / right);
+}
+
+}  // namespace aot
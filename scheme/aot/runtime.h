@@ -0,0 +1,129 @@
+#pragma once
+
+#include "eval/native_stack.h"
+#include "eval/primitives.h"
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+#include "runtime/object.h"
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+
+// Support for the C++ that scheme-aot translates Scheme programs into. Compiled code works on
+// the objects of the interpreter and calls builtins through their plain function entry points,
+// so it needs neither a reader nor an evaluator. It keeps integers unboxed within arithmetic
+// and falls back to the builtins on anything else, including overflow, so results and errors
+// are those of the interpreter. Errors are thrown the way Scheme::Evaluate throws them.
+namespace aot {
+
+using ObjectPtr = std::shared_ptr<Object>;
+using Fn1 = ObjectPtr (*)(const ObjectPtr&);
+using Fn2 = ObjectPtr (*)(const ObjectPtr&, const ObjectPtr&);
+
+// Throws the error recorded by the last Fail.
+[[noreturn]] void Throw();
+
+inline ObjectPtr Check(ObjectPtr value) {
+    if (IsFailure(value)) {
+        Throw();
+    }
+    return value;
+}
+
+// Entry point of the builtin `name` for one or two arguments. The translator only asks for
+// entry points that exist.
+Fn1 Unary(const char* name);
+Fn2 Binary(const char* name);
+
+// `primitive` applied to `args` as the interpreter applies it, for what fast paths leave over.
+ObjectPtr Generic(Primitive primitive, std::initializer_list<ObjectPtr> args);
+
+inline bool Fixnum(const ObjectPtr& value, int64_t* out) {
+    auto* number = dynamic_cast<const Number*>(value.get());
+    if (!number) {
+        return false;
+    }
+    *out = number->GetValue();
+    return true;
+}
+
+inline ObjectPtr Box(int64_t value) {
+    return std::make_shared<Number>(value);
+}
+
+inline ObjectPtr MakeSymbol(const char* name) {
+    return std::make_shared<Symbol>(name);
+}
+
+inline bool IsTrue(const ObjectPtr& value) {
+    return !helpers::IsFalse(value);
+}
+
+inline ObjectPtr Cons(ObjectPtr first, ObjectPtr second) {
+    return std::make_shared<Cell>(std::move(first), std::move(second));
+}
+
+inline ObjectPtr Car(const ObjectPtr& pair) {
+    auto* cell = dynamic_cast<const Cell*>(pair.get());
+    return cell ? cell->GetFirst() : Generic(Primitive::Car, {pair});
+}
+
+inline ObjectPtr Cdr(const ObjectPtr& pair) {
+    auto* cell = dynamic_cast<const Cell*>(pair.get());
+    return cell ? cell->GetSecond() : Generic(Primitive::Cdr, {pair});
+}
+
+inline bool IsPair(const ObjectPtr& value) {
+    return dynamic_cast<const Cell*>(value.get()) != nullptr;
+}
+
+// Native stack of compiled code on the current thread. Procedures continue on a new segment
+// when the current one runs out, as in the interpreter, so deep recursions end in a
+// RuntimeError once the limit of the stack is reached rather than in a crash.
+NativeStack& GetNativeStack();
+
+inline bool HasStackRoom() {
+    return GetNativeStack().HasRoom();
+}
+
+// Result of `fn` called on a new segment of the native stack.
+ObjectPtr OnNewSegment(const std::function<ObjectPtr()>& fn);
+
+// Truncating division of two integers. Fails on a zero divisor, on which the interpreter traps.
+ObjectPtr Divide(const ObjectPtr& lhs, const ObjectPtr& rhs);
+
+// Top-level variable of a compiled program. Using it before its definition has run is a
+// NameError, as in the interpreter.
+class Global {
+public:
+    explicit Global(const char* name) : name_(name) {
+    }
+
+    const ObjectPtr& Get() const {
+        if (!bound_) {
+            throw NameError{name_};
+        }
+        return value_;
+    }
+
+    void Define(ObjectPtr value) {
+        value_ = std::move(value);
+        bound_ = true;
+    }
+
+    void Set(ObjectPtr value) {
+        Get();
+        value_ = std::move(value);
+    }
+
+private:
+    const char* name_;
+    ObjectPtr value_;
+    bool bound_ = false;
+};
+
+}  // namespace aot
@@ -0,0 +1,691 @@
+#include "eval/analyzer.h"
+
+#include "eval/eval.h"
+#include "eval/macros.h"
+#include "eval/optimizer.h"
+#include "eval/procedure.h"
+#include "eval/values.h"
+#include "runtime/error.h"
+#include "runtime/object.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+using ObjectPtr = Node::ObjectPtr;
+using EnvPtr = Node::EnvPtr;
+
+class ConstantNode : public Node {
+public:
+    explicit ConstantNode(ObjectPtr value) : value_(std::move(value)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr&, Evaluator&) override {
+        return value_;
+    }
+
+private:
+    ObjectPtr value_;
+};
+
+class VariableNode : public Node {
+public:
+    explicit VariableNode(std::string name) : name_(std::move(name)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator&) override {
+        auto* value = env->Find(name_);
+        return value ? *value : Fail(Error::Name(name_));
+    }
+
+private:
+    std::string name_;
+};
+
+class SequenceNode : public Node {
+public:
+    explicit SequenceNode(std::vector<NodePtr> nodes) : nodes_(std::move(nodes)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        ObjectPtr result = nullptr;
+        for (const auto& node : nodes_) {
+            result = node->Eval(env, evaluator);
+            if (IsFailure(result)) {
+                break;
+            }
+        }
+        return result;
+    }
+
+private:
+    std::vector<NodePtr> nodes_;
+};
+
+class ApplicationNode : public Node {
+public:
+    ApplicationNode(NodePtr head, std::vector<NodePtr> args, bool tail)
+        : head_(std::move(head)), args_(std::move(args)), tail_(tail) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        auto proc = EvalHead(env, evaluator);
+        if (!proc) {
+            return Failure();
+        }
+        ArgsBuffer arg_values(args_.size());
+        if (!EvalArgs(env, evaluator, &arg_values)) {
+            return Failure();
+        }
+        if (tail_ && proc.get() == evaluator.GetCurrentProcedure()) {
+            return evaluator.ScheduleTailCall(arg_values.Get());
+        }
+        return proc->ApplyTaking(&arg_values, env, evaluator);
+    }
+
+protected:
+    // The procedure the head evaluates to, nullptr on failure.
+    std::shared_ptr<Procedure> EvalHead(const EnvPtr& env, Evaluator& evaluator) {
+        auto value = head_->Eval(env, evaluator);
+        if (IsFailure(value)) {
+            return nullptr;
+        }
+        auto proc = As<Procedure>(value);
+        if (!proc) {
+            Fail(Error::Runtime("Not a procedure"));
+        }
+        return proc;
+    }
+
+    // Pushes the argument values to `arg_values`; false as soon as one fails.
+    bool EvalArgs(const EnvPtr& env, Evaluator& evaluator, ArgsBuffer* arg_values) {
+        for (const auto& arg : args_) {
+            auto value = OneValue(arg->Eval(env, evaluator));
+            if (IsFailure(value)) {
+                return false;
+            }
+            arg_values->Push(std::move(value));
+        }
+        return true;
+    }
+
+    NodePtr head_;
+    std::vector<NodePtr> args_;
+    bool tail_;
+};
+
+// Call whose head names a binding outside every analyzed scope. The procedure it resolves to is
+// cached together with its kind and reused until a define or set! bumps the binding version.
+// A builtin with an entry point for the number of arguments at the call site is called through
+// it directly. In hot code a call that resolves to a primitive builtin skips the call entirely
+// and computes the result inline from arguments kept on the C++ stack.
+class CachedApplicationNode : public ApplicationNode {
+public:
+    static constexpr size_t kMaxInlineArgs = 4;
+
+    CachedApplicationNode(std::string name, NodePtr head, std::vector<NodePtr> args, bool tail,
+                          bool inline_primitives)
+        : ApplicationNode(std::move(head), std::move(args), tail),
+          name_(std::move(name)),
+          inline_primitives_(inline_primitives && args_.size() <= kMaxInlineArgs) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        std::shared_ptr<Procedure> proc;
+        if (version_ != evaluator.GetBindingVersion()) {
+            proc = Resolve(env, evaluator);
+            if (!proc) {
+                return Failure();
+            }
+        }
+        if (primitive_ != Primitive::None) {
+            std::array<ObjectPtr, kMaxInlineArgs> arg_values;
+            for (size_t i = 0; i < args_.size(); ++i) {
+                arg_values[i] = OneValue(args_[i]->Eval(env, evaluator));
+                if (IsFailure(arg_values[i])) {
+                    return Failure();
+                }
+            }
+            return ApplyPrimitive(primitive_, arg_values.data(), args_.size());
+        }
+        switch (args_.size()) {
+            case 0:
+                if (fixed_.apply0) {
+                    return fixed_.apply0();
+                }
+                break;
+            case 1:
+                if (fixed_.apply1) {
+                    auto arg = OneValue(args_[0]->Eval(env, evaluator));
+                    return IsFailure(arg) ? arg : fixed_.apply1(arg);
+                }
+                break;
+            case 2:
+                if (fixed_.apply2) {
+                    auto lhs = OneValue(args_[0]->Eval(env, evaluator));
+                    if (IsFailure(lhs)) {
+                        return lhs;
+                    }
+                    auto rhs = OneValue(args_[1]->Eval(env, evaluator));
+                    return IsFailure(rhs) ? rhs : fixed_.apply2(lhs, rhs);
+                }
+                break;
+        }
+        return EvalCall(std::move(proc), env, evaluator);
+    }
+
+private:
+    enum class Kind { Builtin, Lambda, Other };
+
+    // Call through an argument buffer, which is kept out of Eval's frame so that inlined
+    // primitives and fixed-arity builtins on a deep recursion take little native stack.
+    [[gnu::noinline]] ObjectPtr EvalCall(std::shared_ptr<Procedure> proc, const EnvPtr& env,
+                                         Evaluator& evaluator) {
+        if (!proc) {
+            proc = procedure_.lock();
+        }
+        if (!proc) {
+            proc = Resolve(env, evaluator);
+            if (!proc) {
+                return Failure();
+            }
+        }
+        ArgsBuffer arg_values(args_.size());
+        if (!EvalArgs(env, evaluator, &arg_values)) {
+            return Failure();
+        }
+        auto args = arg_values.Get();
+        switch (kind_) {
+            case Kind::Builtin:
+                return static_cast<BuiltinProcedure&>(*proc).Apply(args, env, evaluator);
+            case Kind::Lambda:
+                if (tail_ && proc.get() == evaluator.GetCurrentProcedure()) {
+                    return evaluator.ScheduleTailCall(args);
+                }
+                return static_cast<LambdaProcedure&>(*proc).ApplyTaking(&arg_values, env,
+                                                                        evaluator);
+            case Kind::Other:
+                break;
+        }
+        return proc->ApplyTaking(&arg_values, env, evaluator);
+    }
+
+    // Caches what the head evaluates to; nullptr on failure.
+    std::shared_ptr<Procedure> Resolve(const EnvPtr& env, Evaluator& evaluator) {
+        evaluator.NoteCachedName(name_);
+        auto version = evaluator.GetBindingVersion();
+        auto proc = EvalHead(env, evaluator);
+        if (!proc) {
+            return nullptr;
+        }
+        primitive_ = Primitive::None;
+        fixed_ = {};
+        if (auto builtin = As<BuiltinProcedure>(proc)) {
+            kind_ = Kind::Builtin;
+            fixed_ = builtin->GetFixedArity();
+            if (inline_primitives_) {
+                primitive_ = builtin->GetPrimitive();
+            }
+        } else if (Is<LambdaProcedure>(proc)) {
+            kind_ = Kind::Lambda;
+        } else {
+            kind_ = Kind::Other;
+        }
+        procedure_ = proc;
+        version_ = version;
+        return proc;
+    }
+
+    std::string name_;
+    uint64_t version_ = Evaluator::kNoBindingVersion;
+    std::weak_ptr<Procedure> procedure_;
+    Kind kind_ = Kind::Other;
+    bool inline_primitives_;
+    Primitive primitive_ = Primitive::None;
+    BuiltinProcedure::FixedArity fixed_;
+};
+
+// Car or cdr of a pair built on the spot, as in `(car (cons a b))`: evaluates both components in
+// order and returns one of them without building the pair.
+class PairComponentNode : public Node {
+public:
+    PairComponentNode(NodePtr first, NodePtr second, size_t index)
+        : first_(std::move(first)), second_(std::move(second)), index_(index) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        auto first = OneValue(first_->Eval(env, evaluator));
+        if (IsFailure(first)) {
+            return first;
+        }
+        auto second = OneValue(second_->Eval(env, evaluator));
+        if (IsFailure(second) || index_ == 1) {
+            return second;
+        }
+        return first;
+    }
+
+private:
+    NodePtr first_;
+    NodePtr second_;
+    size_t index_;
+};
+
+class TreeWalkNode : public Node {
+public:
+    explicit TreeWalkNode(ObjectPtr expr) : expr_(std::move(expr)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        return evaluator.Eval(expr_, env);
+    }
+
+private:
+    ObjectPtr expr_;
+};
+
+// Names a lambda body may bind or assign, as gathered for its Scope.
+struct DefinedNames {
+    std::unordered_set<std::string> names;
+    std::unordered_set<std::string> mutated;
+    std::unordered_set<std::string> defined;
+    std::unordered_set<std::string> reassigned;
+};
+
+// Macro uses are searched as the code they expand into. Uses that no rule matches are searched
+// as they are and left for the evaluator to reject.
+void CollectDefinedNames(const ObjectPtr& expr, const SpecialFormRegistry& forms, size_t depth,
+                         DefinedNames* result) {
+    if (depth < Macro::kMaxExpansionDepth) {
+        ObjectPtr expansion;
+        try {
+            expansion = ExpandMacroUse(expr, forms);
+        } catch (const SyntaxError&) {
+        }
+        if (expansion) {
+            CollectDefinedNames(expansion, forms, depth + 1, result);
+            return;
+        }
+    }
+    for (auto cur = expr; cur;) {
+        auto cell = As<Cell>(cur);
+        if (!cell) {
+            return;
+        }
+        auto head = As<Symbol>(cell->GetFirst());
+        auto rest = As<Cell>(cell->GetSecond());
+        if (head && (head->GetName() == "define" || head->GetName() == "set!") && rest) {
+            auto target = rest->GetFirst();
+            if (auto signature = As<Cell>(target)) {
+                target = signature->GetFirst();
+            }
+            if (auto name = As<Symbol>(target)) {
+                if (head->GetName() == "define") {
+                    result->names.insert(name->GetName());
+                }
+                if (head->GetName() == "set!" || !result->defined.insert(name->GetName()).second) {
+                    result->reassigned.insert(name->GetName());
+                }
+                result->mutated.insert(name->GetName());
+            }
+        }
+        CollectDefinedNames(cell->GetFirst(), forms, depth, result);
+        cur = cell->GetSecond();
+    }
+}
+
+// Index of the component the primitive selects from a pair, if it is car or cdr.
+std::optional<size_t> ComponentIndex(Primitive primitive) {
+    if (primitive == Primitive::Car) {
+        return 0;
+    }
+    if (primitive == Primitive::Cdr) {
+        return 1;
+    }
+    return std::nullopt;
+}
+
+}  // namespace
+
+// Let variable bound to the components of a pair rather than the pair, while its body is
+// analyzed. `uses` are the calls of car and cdr on it that were analyzed; any other use makes the
+// pair escape.
+struct Analyzer::ReplacedPair {
+    std::string name;
+    const Scope* scope;
+    std::unordered_set<const Object*> uses;
+    std::vector<Assumption> assumptions;
+    bool escapes = false;
+};
+
+Scope::Scope(std::unordered_set<std::string> names, Ptr parent,
+             std::unordered_set<std::string> mutated, std::unordered_set<std::string> reassigned)
+    : names_(std::move(names)),
+      mutated_(std::move(mutated)),
+      reassigned_(std::move(reassigned)),
+      parent_(std::move(parent)) {
+}
+
+Scope::Ptr Scope::ForLambda(const std::vector<std::string>& params,
+                            const std::vector<ObjectPtr>& body, Ptr parent,
+                            const SpecialFormRegistry& forms) {
+    DefinedNames result{.names = {params.begin(), params.end()}};
+    for (const auto& expr : body) {
+        CollectDefinedNames(expr, forms, 0, &result);
+    }
+    return std::make_shared<Scope>(std::move(result.names), std::move(parent),
+                                   std::move(result.mutated), std::move(result.reassigned));
+}
+
+bool Scope::Binds(const std::string& name) const {
+    for (auto* scope = this; scope; scope = scope->parent_.get()) {
+        if (scope->names_.contains(name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Scope::IsImmutable(const std::string& name) const {
+    for (auto* scope = this; scope; scope = scope->parent_.get()) {
+        if (scope->names_.contains(name)) {
+            return !scope->mutated_.contains(name);
+        }
+    }
+    return false;
+}
+
+bool Scope::IsDefinedOnce(const std::string& name) const {
+    return names_.contains(name) && mutated_.contains(name) && !reassigned_.contains(name);
+}
+
+std::optional<size_t> Scope::FindDepth(const std::string& name) const {
+    size_t depth = 0;
+    for (auto* scope = this; scope; scope = scope->parent_.get()) {
+        if (scope->names_.contains(name)) {
+            return depth;
+        }
+        ++depth;
+    }
+    return std::nullopt;
+}
+
+const Scope::Ptr& Scope::GetParent() const {
+    return parent_;
+}
+
+Analyzer::Analyzer(const SpecialFormRegistry& forms, Tier tier, Scope::Ptr scope, EnvPtr env,
+                   const LambdaCode* code)
+    : forms_(forms), tier_(tier), scope_(std::move(scope)) {
+    if (tier_ == Tier::Hot && env) {
+        optimizer_ = std::make_unique<Optimizer>(forms_, scope_, std::move(env), code);
+    }
+}
+
+Analyzer::~Analyzer() = default;
+
+Tier Analyzer::GetTier() const {
+    return tier_;
+}
+
+const Scope::Ptr& Analyzer::GetScope() const {
+    return scope_;
+}
+
+const SpecialFormRegistry& Analyzer::GetSpecialForms() const {
+    return forms_;
+}
+
+NodePtr Analyzer::Analyze(const ObjectPtr& expr, bool tail) {
+    if (Is<Number>(expr) || Is<Boolean>(expr)) {
+        return Constant(expr);
+    }
+    if (auto symbol = As<Symbol>(expr)) {
+        if (auto* pair = FindReplacedPair(symbol->GetName())) {
+            pair->escapes = true;
+        }
+        return std::make_shared<VariableNode>(symbol->GetName());
+    }
+    if (auto folded = TryFold(expr)) {
+        auto value = Constant(folded->value);
+        if (folded->assumptions.empty()) {
+            return value;
+        }
+        return Guard(std::move(folded->assumptions), std::move(value),
+                     AnalyzeUnfolded(expr, tail));
+    }
+    return AnalyzeUnfolded(expr, tail);
+}
+
+NodePtr Analyzer::AnalyzeUnfolded(const ObjectPtr& expr, bool tail) {
+    auto cell = As<Cell>(expr);
+    if (!cell) {
+        return Fallback(expr);
+    }
+
+    if (optimizer_) {
+        if (auto node = AnalyzePairAccess(expr, tail)) {
+            return node;
+        }
+    }
+
+    auto head = cell->GetFirst();
+    if (auto sym = As<Symbol>(head)) {
+        if (auto* form = forms_.Lookup(*sym)) {
+            try {
+                return form->Analyze(expr, cell->GetSecond(), *this, tail);
+            } catch (const SyntaxError&) {
+                return Fallback(expr);
+            }
+        }
+    }
+
+    if (optimizer_ && inline_depth_ < Optimizer::kMaxInlineDepth) {
+        if (auto inlined = optimizer_->Inline(expr)) {
+            ++inline_depth_;
+            auto body = AnalyzeBody(inlined->body, tail);
+            --inline_depth_;
+            return Guard(std::move(inlined->assumptions), std::move(body),
+                         AnalyzeApplication(expr, tail));
+        }
+    }
+    return AnalyzeApplication(expr, tail);
+}
+
+NodePtr Analyzer::AnalyzeApplication(const ObjectPtr& expr, bool tail) {
+    auto cell = As<Cell>(expr);
+    auto head = cell->GetFirst();
+    std::vector<NodePtr> args;
+    for (auto cur = cell->GetSecond(); cur;) {
+        auto arg_cell = As<Cell>(cur);
+        if (!arg_cell) {
+            return Fallback(expr);
+        }
+        args.push_back(Analyze(arg_cell->GetFirst()));
+        cur = arg_cell->GetSecond();
+    }
+    auto callee = As<Symbol>(head);
+    for (auto loop = loops_.rbegin(); callee && loop != loops_.rend(); ++loop) {
+        if (loop->name == callee->GetName()) {
+            return loop->jump(std::move(args));
+        }
+    }
+    if (callee && !(scope_ && scope_->Binds(callee->GetName()))) {
+        return std::make_shared<CachedApplicationNode>(callee->GetName(), Analyze(head),
+                                                       std::move(args), tail, tier_ == Tier::Hot);
+    }
+    return std::make_shared<ApplicationNode>(Analyze(head), std::move(args), tail);
+}
+
+// Car and cdr of a pair that is taken apart are its components; anything else is left alone.
+NodePtr Analyzer::AnalyzePairAccess(const ObjectPtr& expr, bool tail) {
+    auto cell = As<Cell>(expr);
+    auto head = As<Symbol>(cell->GetFirst());
+    auto rest = As<Cell>(cell->GetSecond());
+    if (!head || !rest || rest->GetSecond()) {
+        return nullptr;
+    }
+    auto primitive = optimizer_->Speculate(head->GetName());
+    auto index = ComponentIndex(primitive);
+    if (!index) {
+        return nullptr;
+    }
+    auto arg = rest->GetFirst();
+    if (auto name = As<Symbol>(arg)) {
+        auto* pair = FindReplacedPair(name->GetName());
+        if (!pair) {
+            return nullptr;
+        }
+        pair->uses.insert(expr.get());
+        if (std::ranges::none_of(pair->assumptions, [&](const Assumption& assumption) {
+                return assumption.name == head->GetName();
+            })) {
+            pair->assumptions.push_back({head->GetName(), primitive});
+        }
+        return std::make_shared<VariableNode>(ComponentName(name->GetName(), *index));
+    }
+    auto pair = optimizer_->TakeApartPair(arg);
+    if (!pair) {
+        return nullptr;
+    }
+    pair->assumptions.push_back({head->GetName(), primitive});
+    auto fast = std::make_shared<PairComponentNode>(Analyze(pair->components[0]),
+                                                    Analyze(pair->components[1]), *index);
+    return Guard(std::move(pair->assumptions), std::move(fast), AnalyzeApplication(expr, tail));
+}
+
+// The innermost pair taken apart whose variable `name` refers to where it is analyzed.
+Analyzer::ReplacedPair* Analyzer::FindReplacedPair(const std::string& name) {
+    for (auto it = replaced_pairs_.rbegin(); it != replaced_pairs_.rend(); ++it) {
+        if (it->name != name) {
+            continue;
+        }
+        auto depth = scope_ ? scope_->FindDepth(name) : std::nullopt;
+        if (!depth) {
+            return nullptr;
+        }
+        auto* scope = scope_.get();
+        for (size_t i = 0; i < *depth; ++i) {
+            scope = scope->GetParent().get();
+        }
+        return scope == it->scope ? &*it : nullptr;
+    }
+    return nullptr;
+}
+
+NodePtr Analyzer::AnalyzeBody(const std::vector<ObjectPtr>& body, bool tail) {
+    std::vector<NodePtr> nodes;
+    nodes.reserve(body.size());
+    for (auto i = 0; i < body.size(); ++i) {
+        nodes.push_back(Analyze(body[i], tail && i + 1 == body.size()));
+    }
+    if (nodes.size() == 1) {
+        return nodes.front();
+    }
+    return std::make_shared<SequenceNode>(std::move(nodes));
+}
+
+NodePtr Analyzer::AnalyzeBodyIn(Scope::Ptr scope, const std::vector<ObjectPtr>& body,
+                                bool tail) {
+    // Restores the outer scope however the analysis of the body ends.
+    class ScopeSwap {
+    public:
+        ScopeSwap(Analyzer& analyzer, Scope::Ptr scope)
+            : analyzer_(analyzer), outer_(std::exchange(analyzer.scope_, std::move(scope))) {
+            if (analyzer_.optimizer_) {
+                analyzer_.optimizer_->SetScope(analyzer_.scope_);
+            }
+        }
+
+        ~ScopeSwap() {
+            analyzer_.scope_ = std::move(outer_);
+            if (analyzer_.optimizer_) {
+                analyzer_.optimizer_->SetScope(analyzer_.scope_);
+            }
+        }
+
+    private:
+        Analyzer& analyzer_;
+        Scope::Ptr outer_;
+    };
+
+    ScopeSwap swap(*this, std::move(scope));
+    return AnalyzeBody(body, tail);
+}
+
+NodePtr Analyzer::AnalyzeLoopBody(Scope::Ptr scope, LoopTarget loop,
+                                  const std::vector<ObjectPtr>& body, bool tail) {
+    loops_.push_back(std::move(loop));
+    try {
+        auto node = AnalyzeBodyIn(std::move(scope), body, tail);
+        loops_.pop_back();
+        return node;
+    } catch (...) {
+        loops_.pop_back();
+        throw;
+    }
+}
+
+std::optional<BuiltPair> Analyzer::TakeApartPair(const std::string& name, const ObjectPtr& init,
+                                                 const std::vector<ObjectPtr>& body) {
+    if (!optimizer_ || !optimizer_->CountPairAccesses(name, body)) {
+        return std::nullopt;
+    }
+    return optimizer_->TakeApartPair(init);
+}
+
+std::optional<NodePtr> Analyzer::AnalyzeBodyWithoutPairs(Scope::Ptr scope,
+                                                         const std::vector<std::string>& pairs,
+                                                         const std::vector<ObjectPtr>& body,
+                                                         bool tail,
+                                                         std::vector<Assumption>* assumptions) {
+    auto outer = replaced_pairs_.size();
+    for (const auto& name : pairs) {
+        replaced_pairs_.push_back({.name = name, .scope = scope.get()});
+    }
+    NodePtr node;
+    try {
+        node = AnalyzeBodyIn(std::move(scope), body, tail);
+    } catch (...) {
+        replaced_pairs_.resize(outer);
+        throw;
+    }
+    std::vector<ReplacedPair> replaced(std::make_move_iterator(replaced_pairs_.begin() + outer),
+                                       std::make_move_iterator(replaced_pairs_.end()));
+    replaced_pairs_.resize(outer);
+    for (auto& pair : replaced) {
+        if (pair.escapes || pair.uses.size() != optimizer_->CountPairAccesses(pair.name, body)) {
+            return std::nullopt;
+        }
+        assumptions->insert(assumptions->end(), std::make_move_iterator(pair.assumptions.begin()),
+                            std::make_move_iterator(pair.assumptions.end()));
+    }
+    return node;
+}
+
+std::string Analyzer::ComponentName(const std::string& pair, size_t index) {
+    return (index == 0 ? "(car " : "(cdr ") + pair + ")";
+}
+
+NodePtr Analyzer::Fallback(const ObjectPtr& expr) {
+    return std::make_shared<TreeWalkNode>(expr);
+}
+
+NodePtr Analyzer::Constant(const ObjectPtr& value) {
+    return std::make_shared<ConstantNode>(value);
+}
+
+std::optional<FoldedValue> Analyzer::TryFold(const ObjectPtr& expr) {
+    if (!optimizer_) {
+        return std::nullopt;
+    }
+    return optimizer_->Fold(expr);
+}
+
+NodePtr Analyzer::Guard(std::vector<Assumption> assumptions, NodePtr fast, NodePtr slow) {
+    return Optimizer::Guard(std::move(assumptions), std::move(fast), std::move(slow));
+}
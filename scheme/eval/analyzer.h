@@ -0,0 +1,148 @@
+#pragma once
+
+#include "eval/node.h"
+#include "eval/special_forms.h"
+#include "eval/tier.h"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class Environment;
+class LambdaCode;
+class Object;
+class Optimizer;
+struct Assumption;
+struct BuiltPair;
+struct FoldedValue;
+
+// Names bound by one analyzed lambda: its parameters and every name its body may `define`.
+// Anything not bound by a scope chain is resolved past the outermost analyzed lambda.
+class Scope {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+    using Ptr = std::shared_ptr<const Scope>;
+
+    // `mutated` are the names some `define` or `set!` in the body may assign, `reassigned` those
+    // of them that are defined more than once or assigned by `set!`.
+    Scope(std::unordered_set<std::string> names, Ptr parent,
+          std::unordered_set<std::string> mutated = {},
+          std::unordered_set<std::string> reassigned = {});
+
+    // Uses of the macros in `forms` are expanded to find the names the body defines.
+    static Ptr ForLambda(const std::vector<std::string>& params,
+                         const std::vector<ObjectPtr>& body, Ptr parent,
+                         const SpecialFormRegistry& forms);
+
+    bool Binds(const std::string& name) const;
+
+    // Whether `name` is a parameter of an enclosing lambda that is never assigned, so it refers
+    // to the same value everywhere in the lambda's body.
+    bool IsImmutable(const std::string& name) const;
+
+    // Whether `name` is bound by this scope itself through a single `define` and never assigned,
+    // so once defined it refers to the same value everywhere in the body.
+    bool IsDefinedOnce(const std::string& name) const;
+
+    // Number of scopes between this one and the innermost one binding `name`, if any does.
+    std::optional<size_t> FindDepth(const std::string& name) const;
+
+    const Ptr& GetParent() const;
+
+private:
+    std::unordered_set<std::string> names_;
+    std::unordered_set<std::string> mutated_;
+    std::unordered_set<std::string> reassigned_;
+    Ptr parent_;
+};
+
+// Loop whose body is being analyzed: applications of `name` in it jump back to the start of the
+// loop and are analyzed into the node `jump` makes from their arguments.
+struct LoopTarget {
+    std::string name;
+    std::function<NodePtr(std::vector<NodePtr>)> jump;
+};
+
+// Turns expressions into Node trees. Special forms analyze themselves through
+// SpecialForm::Analyze; anything the analyzer cannot take apart, including forms rejected with
+// SyntaxError, is left to the tree walker so errors still surface only when evaluated.
+class Analyzer {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+    using EnvPtr = std::shared_ptr<Environment>;
+
+    // Hot analysis given the environment the body is about to run in also runs the Optimizer.
+    // `code` is the lambda whose body is analyzed; it is never inlined into itself.
+    Analyzer(const SpecialFormRegistry& forms, Tier tier, Scope::Ptr scope = nullptr,
+             EnvPtr env = nullptr, const LambdaCode* code = nullptr);
+    ~Analyzer();
+
+    Tier GetTier() const;
+
+    const Scope::Ptr& GetScope() const;
+
+    const SpecialFormRegistry& GetSpecialForms() const;
+
+    // `tail` marks expressions whose value is returned directly from the enclosing lambda body.
+    NodePtr Analyze(const ObjectPtr& expr, bool tail = false);
+
+    // Sequence evaluating every expression and returning the last one, which is in tail position
+    // when `tail` is set.
+    NodePtr AnalyzeBody(const std::vector<ObjectPtr>& body, bool tail = true);
+
+    // AnalyzeBody for a body evaluated in a new environment, whose names `scope` adds to the
+    // current scope.
+    NodePtr AnalyzeBodyIn(Scope::Ptr scope, const std::vector<ObjectPtr>& body, bool tail);
+
+    // AnalyzeBodyIn for the body of `loop`. The caller makes sure that the name of the loop only
+    // occurs in the body as the head of calls in its tail positions.
+    NodePtr AnalyzeLoopBody(Scope::Ptr scope, LoopTarget loop, const std::vector<ObjectPtr>& body,
+                            bool tail);
+
+    // The pair `init` builds when hot analysis can bind its components to the variable `name`
+    // of a let in place of the pair itself, because `body` does not let the pair escape: every
+    // use of `name` in it is analyzed on the spot and might be an argument of car or cdr.
+    std::optional<BuiltPair> TakeApartPair(const std::string& name, const ObjectPtr& init,
+                                           const std::vector<ObjectPtr>& body);
+
+    // AnalyzeBodyIn for a body in which the variables `pairs` of `scope`, which TakeApartPair
+    // took apart, are only bound to their components under ComponentName. Empty if the body
+    // turns out to need one of the pairs itself. Adds what the result relies on to `assumptions`.
+    std::optional<NodePtr> AnalyzeBodyWithoutPairs(Scope::Ptr scope,
+                                                   const std::vector<std::string>& pairs,
+                                                   const std::vector<ObjectPtr>& body, bool tail,
+                                                   std::vector<Assumption>* assumptions);
+
+    // Name of the variable holding the car (`index` 0) or the cdr of the pair variable `pair`.
+    static std::string ComponentName(const std::string& pair, size_t index);
+
+    // Node that hands `expr` over to Evaluator::Eval when evaluated.
+    NodePtr Fallback(const ObjectPtr& expr);
+
+    NodePtr Constant(const ObjectPtr& value);
+
+    // Value `expr` is known to evaluate to. Always empty unless the optimizer runs.
+    std::optional<FoldedValue> TryFold(const ObjectPtr& expr);
+
+    // `fast` while the assumptions hold, `slow` otherwise.
+    NodePtr Guard(std::vector<Assumption> assumptions, NodePtr fast, NodePtr slow);
+
+private:
+    struct ReplacedPair;
+
+    NodePtr AnalyzeUnfolded(const ObjectPtr& expr, bool tail);
+    NodePtr AnalyzeApplication(const ObjectPtr& expr, bool tail);
+    NodePtr AnalyzePairAccess(const ObjectPtr& expr, bool tail);
+    ReplacedPair* FindReplacedPair(const std::string& name);
+
+    const SpecialFormRegistry& forms_;
+    Tier tier_;
+    Scope::Ptr scope_;
+    std::unique_ptr<Optimizer> optimizer_;
+    size_t inline_depth_ = 0;
+    std::vector<LoopTarget> loops_;
+    std::vector<ReplacedPair> replaced_pairs_;
+};
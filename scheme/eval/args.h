@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+class Object;
+
+// Argument values as procedures receive them.
+using Args = std::span<const std::shared_ptr<Object>>;
+
+// Argument values of one call being marshaled. Up to kInlineArgs values live inside the buffer
+// itself, so calls with that many arguments allocate nothing to pass them; longer argument
+// lists spill to the heap.
+class ArgsBuffer {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+
+    static constexpr size_t kInlineArgs = 6;
+
+    ArgsBuffer() = default;
+
+    explicit ArgsBuffer(size_t capacity) {
+        if (capacity > kInlineArgs) {
+            spilled_.reserve(capacity);
+        }
+    }
+
+    void Push(ObjectPtr value) {
+        if (spilled_.empty() && size_ < kInlineArgs) {
+            inline_[size_++] = std::move(value);
+            return;
+        }
+        if (spilled_.empty()) {
+            spilled_.reserve(2 * kInlineArgs);
+            for (size_t i = 0; i < size_; ++i) {
+                spilled_.push_back(std::move(inline_[i]));
+            }
+            size_ = 0;
+        }
+        spilled_.push_back(std::move(value));
+    }
+
+    // Replaces the contents with copies of `args`.
+    void Assign(Args args) {
+        Clear();
+        for (const auto& arg : args) {
+            Push(arg);
+        }
+    }
+
+    void Clear() {
+        for (size_t i = 0; i < size_; ++i) {
+            inline_[i].reset();
+        }
+        size_ = 0;
+        spilled_.clear();
+    }
+
+    Args Get() const {
+        if (!spilled_.empty()) {
+            return spilled_;
+        }
+        return {inline_.data(), size_};
+    }
+
+    size_t Size() const {
+        return spilled_.empty() ? size_ : spilled_.size();
+    }
+
+private:
+    std::array<ObjectPtr, kInlineArgs> inline_;
+    size_t size_ = 0;
+    std::vector<ObjectPtr> spilled_;
+};
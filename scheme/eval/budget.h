@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+// Limits on the work one evaluation may do before it fails with ErrorCode::Budget. Fuel counts
+// reduction steps: compound expressions walked by the tree walker, procedure applications, loop
+// iterations and machine steps. The deadline is checked every kClockPeriod steps.
+struct Budget {
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr uint64_t kUnlimited = std::numeric_limits<uint64_t>::max();
+    static constexpr uint64_t kClockPeriod = 1024;
+
+    uint64_t fuel = kUnlimited;
+    std::optional<Clock::time_point> deadline = std::nullopt;
+};
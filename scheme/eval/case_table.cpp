@@ -0,0 +1,114 @@
+#include "eval/case_table.h"
+
+#include "runtime/object.h"
+
+#include <algorithm>
+#include <bit>
+
+CaseTable::CaseTable(const std::vector<std::vector<ObjectPtr>>& clauses, size_t fallback)
+    : fallback_(fallback),
+      true_clause_(fallback),
+      false_clause_(fallback),
+      null_clause_(fallback) {
+    size_t symbol_count = 0;
+    for (const auto& datums : clauses) {
+        for (const auto& datum : datums) {
+            symbol_count += dynamic_cast<const Symbol*>(datum.get()) != nullptr;
+        }
+    }
+    if (symbol_count > 0) {
+        symbols_.resize(std::bit_ceil(2 * symbol_count));
+    }
+
+    for (size_t clause = 0; clause < clauses.size(); ++clause) {
+        for (const auto& datum : clauses[clause]) {
+            if (!datum) {
+                if (null_clause_ == fallback_) {
+                    null_clause_ = clause;
+                }
+            } else if (auto* num = dynamic_cast<const Number*>(datum.get())) {
+                AddNumber(num->GetValue(), clause);
+            } else if (auto* sym = dynamic_cast<const Symbol*>(datum.get())) {
+                AddSymbol(sym->GetName(), sym->GetHash(), clause);
+            } else if (auto* boolean = dynamic_cast<const Boolean*>(datum.get())) {
+                auto& slot = boolean->GetValue() ? true_clause_ : false_clause_;
+                if (slot == fallback_) {
+                    slot = clause;
+                }
+            }
+        }
+    }
+    BuildJumpTable();
+}
+
+size_t CaseTable::Find(const ObjectPtr& key) const {
+    if (!key) {
+        return null_clause_;
+    }
+    if (auto* num = dynamic_cast<const Number*>(key.get())) {
+        if (!jump_table_.empty()) {
+            auto offset = static_cast<uint64_t>(num->GetValue()) - static_cast<uint64_t>(jump_base_);
+            return offset < jump_table_.size() ? jump_table_[offset] : fallback_;
+        }
+        auto it = numbers_.find(num->GetValue());
+        return it == numbers_.end() ? fallback_ : it->second;
+    }
+    if (auto* sym = dynamic_cast<const Symbol*>(key.get())) {
+        auto clause = FindSymbol(sym->GetName(), sym->GetHash());
+        return clause == kNoMatch ? fallback_ : clause;
+    }
+    if (auto* boolean = dynamic_cast<const Boolean*>(key.get())) {
+        return boolean->GetValue() ? true_clause_ : false_clause_;
+    }
+    return fallback_;
+}
+
+void CaseTable::AddNumber(int64_t value, size_t clause) {
+    numbers_.try_emplace(value, clause);
+}
+
+void CaseTable::AddSymbol(const std::string& name, size_t hash, size_t clause) {
+    auto mask = symbols_.size() - 1;
+    auto index = hash & mask;
+    while (symbols_[index].clause != kNoMatch) {
+        if (symbols_[index].hash == hash && symbols_[index].name == name) {
+            return;
+        }
+        index = (index + 1) & mask;
+    }
+    symbols_[index] = {.hash = hash, .name = name, .clause = clause};
+}
+
+// Replaces the hash map of fixnums with a jump table when they are dense enough.
+void CaseTable::BuildJumpTable() {
+    if (numbers_.empty()) {
+        return;
+    }
+    auto [min, max] = std::minmax_element(
+        numbers_.begin(), numbers_.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    auto span = static_cast<uint64_t>(max->first) - static_cast<uint64_t>(min->first);
+    if (span >= kMaxJumpTableSize || 4 * numbers_.size() < span + 1) {
+        return;
+    }
+    jump_base_ = min->first;
+    jump_table_.assign(span + 1, fallback_);
+    for (const auto& [value, clause] : numbers_) {
+        jump_table_[static_cast<uint64_t>(value) - static_cast<uint64_t>(jump_base_)] = clause;
+    }
+    numbers_.clear();
+}
+
+size_t CaseTable::FindSymbol(const std::string& name, size_t hash) const {
+    if (symbols_.empty()) {
+        return kNoMatch;
+    }
+    auto mask = symbols_.size() - 1;
+    for (auto index = hash & mask; symbols_[index].clause != kNoMatch;
+         index = (index + 1) & mask) {
+        if (symbols_[index].hash == hash && symbols_[index].name == name) {
+            return symbols_[index].clause;
+        }
+    }
+    return kNoMatch;
+}
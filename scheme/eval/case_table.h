@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Object;
+
+// Dispatch table of an analyzed `case`: maps a key to the clause whose datums contain it in
+// constant time, whatever the number of clauses. Fixnums in a dense range index a jump table and
+// other fixnums a hash map. Symbols go to an open-addressing table that compares the hash each
+// symbol carries before the name. Booleans and the empty list have a slot each; other datums,
+// which no key is eqv? to, are ignored.
+class CaseTable {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+
+    static constexpr size_t kNoMatch = SIZE_MAX;
+
+    // Jump tables span at most this many values and at least a quarter of them are datums.
+    static constexpr size_t kMaxJumpTableSize = 4096;
+
+    // `clauses` are the datum lists of the clauses in order; a datum repeated in a later clause
+    // is ignored, as the earlier clause always takes it. Keys matching no datum map to
+    // `fallback`.
+    explicit CaseTable(const std::vector<std::vector<ObjectPtr>>& clauses,
+                       size_t fallback = kNoMatch);
+
+    // Index of the clause `key` selects, or the fallback.
+    size_t Find(const ObjectPtr& key) const;
+
+private:
+    struct SymbolSlot {
+        size_t hash = 0;
+        std::string name;
+        size_t clause = kNoMatch;
+    };
+
+    void AddNumber(int64_t value, size_t clause);
+    void AddSymbol(const std::string& name, size_t hash, size_t clause);
+    void BuildJumpTable();
+    size_t FindSymbol(const std::string& name, size_t hash) const;
+
+    size_t fallback_;
+    size_t true_clause_;
+    size_t false_clause_;
+    size_t null_clause_;
+
+    std::unordered_map<int64_t, size_t> numbers_;
+    int64_t jump_base_ = 0;
+    std::vector<size_t> jump_table_;
+
+    // Size is a power of two, at least twice the number of symbols.
+    std::vector<SymbolSlot> symbols_;
+};
@@ -0,0 +1,161 @@
+#include "eval/closure_conversion.h"
+
+#include "eval/macros.h"
+#include "runtime/object.h"
+
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using ObjectPtr = Node::ObjectPtr;
+using EnvPtr = Node::EnvPtr;
+
+// Lambdas using more variables of the enclosing scopes keep closing over them.
+constexpr size_t kMaxCaptured = 4;
+
+// Variable of an enclosing scope copied into a flat closure. `depth` counts the environments
+// from the one the lambda is created in up to the one binding it.
+struct Capture {
+    std::string name;
+    size_t depth;
+};
+
+// Adds the symbols `expr` may refer to as variables; false on macro uses, whose expansions may
+// refer to anything.
+bool CollectSymbols(const ObjectPtr& expr, const SpecialFormRegistry& forms,
+                    std::unordered_set<std::string>* symbols) {
+    if (auto sym = As<Symbol>(expr)) {
+        symbols->insert(sym->GetName());
+        return true;
+    }
+    auto cell = As<Cell>(expr);
+    if (!cell) {
+        return true;
+    }
+    if (auto head = As<Symbol>(cell->GetFirst())) {
+        auto* form = forms.Lookup(*head);
+        if (dynamic_cast<Macro*>(form)) {
+            return false;
+        }
+        if (form && head->GetName() == "quote") {
+            return true;
+        }
+    }
+    auto cur = expr;
+    while (auto item = As<Cell>(cur)) {
+        if (!CollectSymbols(item->GetFirst(), forms, symbols)) {
+            return false;
+        }
+        cur = item->GetSecond();
+    }
+    return CollectSymbols(cur, forms, symbols);
+}
+
+// Creates closures of the converted `code` over the environment `depth` levels up from the one
+// it is evaluated in. A captured variable still unbound there, as in the inits of a letrec, makes
+// it create a closure of the unconverted `fallback` instead.
+class ClosureNode : public Node {
+public:
+    ClosureNode(LambdaCodePtr code, LambdaCodePtr fallback, size_t depth,
+                std::vector<Capture> captures)
+        : code_(std::move(code)),
+          fallback_(std::move(fallback)),
+          depth_(depth),
+          captures_(std::move(captures)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator&) override {
+        const auto* outer = &env;
+        for (size_t i = 0; i < depth_ && *outer; ++i) {
+            outer = &(*outer)->GetParent();
+        }
+        if (!*outer) {
+            return std::make_shared<LambdaProcedure>(fallback_, env);
+        }
+        if (captures_.empty()) {
+            if ((*outer)->GetParent()) {
+                return std::make_shared<LambdaProcedure>(code_, *outer);
+            }
+            if (!lifted_ || lifted_->GetClosure() != *outer) {
+                lifted_ = std::make_shared<LambdaProcedure>(code_, *outer);
+            }
+            return lifted_;
+        }
+        auto flat = std::make_shared<Environment>(*outer);
+        for (const auto& capture : captures_) {
+            const auto* frame = env.get();
+            for (size_t i = 0; i < capture.depth; ++i) {
+                frame = frame->GetParent().get();
+            }
+            auto* value = frame->FindLocal(capture.name);
+            if (!value) {
+                return std::make_shared<LambdaProcedure>(fallback_, env);
+            }
+            flat->Define(capture.name, *value);
+        }
+        return std::make_shared<LambdaProcedure>(code_, std::move(flat));
+    }
+
+private:
+    LambdaCodePtr code_;
+    LambdaCodePtr fallback_;
+    size_t depth_;
+    std::vector<Capture> captures_;
+    // The one procedure of a lifted lambda, whose closure is the global environment.
+    std::shared_ptr<LambdaProcedure> lifted_;
+};
+
+}  // namespace
+
+NodePtr AnalyzeClosure(const LambdaCodePtr& code, Analyzer& analyzer,
+                       const std::optional<std::string>& name) {
+    const auto& scope = analyzer.GetScope();
+    if (!scope) {
+        return nullptr;
+    }
+    std::unordered_set<std::string> symbols;
+    for (const auto& expr : code->GetBody()) {
+        if (!CollectSymbols(expr, analyzer.GetSpecialForms(), &symbols)) {
+            return nullptr;
+        }
+    }
+    std::unordered_set<std::string> own(code->GetParams().begin(), code->GetParams().end());
+    if (code->GetRest()) {
+        own.insert(*code->GetRest());
+    }
+
+    std::optional<std::string> self;
+    std::vector<Capture> captures;
+    for (const auto& symbol : symbols) {
+        auto depth = scope->FindDepth(symbol);
+        if (own.contains(symbol) || !depth) {
+            continue;
+        }
+        if (symbol == name && *depth == 0 && scope->IsDefinedOnce(symbol)) {
+            self = symbol;
+            continue;
+        }
+        if (!scope->IsImmutable(symbol) || captures.size() == kMaxCaptured) {
+            return nullptr;
+        }
+        captures.push_back({symbol, *depth});
+    }
+
+    Scope::Ptr flat;
+    if (!captures.empty()) {
+        std::unordered_set<std::string> names;
+        for (const auto& capture : captures) {
+            names.insert(capture.name);
+        }
+        flat = std::make_shared<Scope>(std::move(names), nullptr);
+    }
+    size_t depth = 0;
+    for (auto* cur = scope.get(); cur; cur = cur->GetParent().get()) {
+        ++depth;
+    }
+    auto converted = std::make_shared<LambdaCode>(code->GetParams(), code->GetBody(),
+                                                  std::move(flat), code->GetRest(), self);
+    return std::make_shared<ClosureNode>(std::move(converted), code, depth, std::move(captures));
+}
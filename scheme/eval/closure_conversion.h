@@ -0,0 +1,23 @@
+#pragma once
+
+#include "eval/analyzer.h"
+#include "eval/node.h"
+#include "eval/procedure.h"
+
+#include <optional>
+#include <string>
+
+// Closure conversion of lambdas in analyzed code. A lambda inside another one closes over every
+// environment around it, although it often refers to none of their variables or only to a few
+// parameters that never change. Such a lambda is converted to close over the environment past
+// the analyzed scopes alone, where it finds the same global names, with the variables it does use
+// copied into a small flat environment between the two. A lambda referring to nothing from the
+// enclosing scopes is lifted out of them entirely: with the global environment past them, one
+// procedure is created for it and reused by every evaluation of the expression. A helper defined
+// by name refers to itself through its self name rather than through the body defining it.
+
+// Node creating the closures of `code`, a lambda expression analyzed in the scope of
+// `analyzer`, or nullptr if they need the environments they are created in. `name` is the
+// variable a define binds the closures to, if any.
+NodePtr AnalyzeClosure(const LambdaCodePtr& code, Analyzer& analyzer,
+                       const std::optional<std::string>& name = std::nullopt);
@@ -0,0 +1,63 @@
+#include "eval/continuation.h"
+
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+
+namespace {
+
+// Expires a continuation when the call that captured it returns or unwinds.
+class ExtentScope {
+public:
+    explicit ExtentScope(Continuation& continuation) : continuation_(continuation) {
+    }
+
+    ~ExtentScope() {
+        continuation_.Expire();
+    }
+
+private:
+    Continuation& continuation_;
+};
+
+}  // namespace
+
+bool Continuation::Enter() {
+    if (!escape_only_) {
+        return true;
+    }
+    if (!alive_) {
+        Fail(Error::Runtime("Continuation called outside of its extent"));
+        return false;
+    }
+    alive_ = false;
+    return true;
+}
+
+Procedure::ObjectPtr Continuation::Apply(Args args, const EnvPtr&, Evaluator&) {
+    if (!helpers::RequireArgsCount(args, 1) || !Enter()) {
+        return Failure();
+    }
+    throw ContinuationInvoked{std::static_pointer_cast<Continuation>(shared_from_this()), args[0]};
+}
+
+Procedure::ObjectPtr CallWithContinuation::Apply(Args args, const EnvPtr& env,
+                                                 Evaluator& evaluator) {
+    if (!helpers::RequireArgsCount(args, 1)) {
+        return Failure();
+    }
+    auto receiver = As<Procedure>(args[0]);
+    if (!receiver) {
+        return Fail(Error::Runtime("Not a procedure"));
+    }
+    auto continuation = std::make_shared<Continuation>(nullptr, true);
+    ExtentScope extent(*continuation);
+    ObjectPtr arg = continuation;
+    try {
+        return receiver->Apply(Args{&arg, 1}, env, evaluator);
+    } catch (const ContinuationInvoked& invoked) {
+        if (invoked.GetContinuation() != continuation) {
+            throw;
+        }
+        return invoked.GetValue();
+    }
+}
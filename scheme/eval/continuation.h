@@ -0,0 +1,80 @@
+#pragma once
+
+#include "eval/machine.h"
+#include "eval/procedure.h"
+
+#include <memory>
+
+// Continuation passed to the receiver of call/cc or call/ec. One captured by the Machine resumes
+// its frames from anywhere and any number of times. One captured by the recursive evaluator can
+// only escape: it unwinds the C++ stack back to its call/cc and fails once that call returned.
+// Escape continuations from call/ec fail after their extent ends under either evaluator.
+class Continuation final : public Procedure {
+public:
+    Continuation(Frame::Ptr frames, bool escape_only)
+        : frames_(std::move(frames)), escape_only_(escape_only) {
+    }
+
+    // Throws ContinuationInvoked, or RuntimeError if the continuation expired.
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override;
+
+    // Frames to resume, nullptr for continuations captured by the recursive evaluator.
+    const Frame::Ptr& GetFrames() const {
+        return frames_;
+    }
+
+    bool IsEscapeOnly() const {
+        return escape_only_;
+    }
+
+    // Called when control transfers to the continuation. Fails with a runtime error and returns
+    // false if it expired; an escape continuation expires here, since escaping ends its extent.
+    bool Enter();
+
+    void Expire() {
+        alive_ = false;
+    }
+
+private:
+    Frame::Ptr frames_;
+    bool escape_only_;
+    bool alive_ = true;
+};
+
+// call/cc when `escape_only` is false and call/ec otherwise. The Machine captures its
+// continuation directly; Apply is the recursive evaluator's version, where both are escapes.
+class CallWithContinuation final : public Procedure {
+public:
+    explicit CallWithContinuation(bool escape_only) : escape_only_(escape_only) {
+    }
+
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override;
+
+    bool IsEscapeOnly() const {
+        return escape_only_;
+    }
+
+private:
+    bool escape_only_;
+};
+
+// Unwinds the C++ stack to whoever resumes `continuation`: the call/cc that captured it or a
+// running Machine. Deliberately not an std::exception, so error handlers let it through.
+class ContinuationInvoked {
+public:
+    ContinuationInvoked(std::shared_ptr<Continuation> continuation, Procedure::ObjectPtr value)
+        : continuation_(std::move(continuation)), value_(std::move(value)) {
+    }
+
+    const std::shared_ptr<Continuation>& GetContinuation() const {
+        return continuation_;
+    }
+
+    const Procedure::ObjectPtr& GetValue() const {
+        return value_;
+    }
+
+private:
+    std::shared_ptr<Continuation> continuation_;
+    Procedure::ObjectPtr value_;
+};
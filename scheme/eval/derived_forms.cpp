@@ -0,0 +1,1267 @@
+#include "eval/derived_forms.h"
+
+#include "eval/analyzer.h"
+#include "eval/case_table.h"
+#include "eval/eval.h"
+#include "eval/machine.h"
+#include "eval/macros.h"
+#include "eval/optimizer.h"
+#include "eval/procedure.h"
+#include "eval/syntax.h"
+#include "eval/values.h"
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+#include "runtime/list_utils.h"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using ObjectPtr = SpecialForm::ObjectPtr;
+using EnvPtr = SpecialForm::EnvPtr;
+using ArgsVec = std::vector<ObjectPtr>;
+
+using syntax::ToVectorOrSyntaxError;
+using syntax::UnpackOrSyntaxError;
+
+// `((name init) ...) body...` of let, let* and letrec.
+struct Bindings {
+    std::vector<std::string> names;
+    ArgsVec inits;
+    // Non-empty proper list.
+    ObjectPtr body;
+};
+
+using BindingsPtr = std::shared_ptr<const Bindings>;
+
+// Names must be distinct unless `sequential` is set, as for let*.
+Bindings ParseBindings(const ObjectPtr& args, bool sequential) {
+    auto form = As<Cell>(args);
+    if (!form || !Is<Cell>(form->GetSecond()) || !listutils::IsProperList(form->GetSecond())) {
+        throw SyntaxError{""};
+    }
+    Bindings bindings;
+    for (const auto& binding : ToVectorOrSyntaxError(form->GetFirst())) {
+        std::array<ObjectPtr, 2> parts;
+        UnpackOrSyntaxError(binding, &parts, 2);
+        auto name = As<Symbol>(parts[0]);
+        if (!name) {
+            throw SyntaxError{""};
+        }
+        for (const auto& bound : bindings.names) {
+            if (!sequential && bound == name->GetName()) {
+                throw SyntaxError{""};
+            }
+        }
+        bindings.names.push_back(name->GetName());
+        bindings.inits.push_back(std::move(parts[1]));
+    }
+    bindings.body = form->GetSecond();
+    return bindings;
+}
+
+ObjectPtr MakeList(std::initializer_list<ObjectPtr> items) {
+    return listutils::FromVector(std::span<const ObjectPtr>{items.begin(), items.size()});
+}
+
+}  // namespace
+
+ObjectPtr EvalSequence(const ObjectPtr& exprs, const EnvPtr& env, Evaluator& evaluator,
+                       bool tail) {
+    ObjectPtr result = nullptr;
+    for (auto cur = exprs; cur;) {
+        auto cell = As<Cell>(cur);
+        if (!cell) {
+            throw SyntaxError{""};
+        }
+        if (tail && !cell->GetSecond()) {
+            return evaluator.EvalInTail(cell->GetFirst(), env);
+        }
+        result = evaluator.Eval(cell->GetFirst(), env);
+        if (IsFailure(result)) {
+            break;
+        }
+        cur = cell->GetSecond();
+    }
+    return result;
+}
+
+namespace {
+
+// Remaining expressions of a body evaluated on the machine.
+class SequenceFrame : public Frame {
+public:
+    SequenceFrame(ObjectPtr rest, EnvPtr env) : rest_(std::move(rest)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override;
+
+private:
+    ObjectPtr rest_;
+    EnvPtr env_;
+};
+
+}  // namespace
+
+void StepSequence(const ObjectPtr& exprs, const EnvPtr& env, Machine& machine) {
+    if (!exprs) {
+        machine.Return(nullptr);
+        return;
+    }
+    auto cell = As<Cell>(exprs);
+    if (!cell) {
+        throw SyntaxError{""};
+    }
+    if (cell->GetSecond()) {
+        machine.Push(std::make_shared<SequenceFrame>(cell->GetSecond(), env));
+    }
+    machine.Eval(cell->GetFirst(), env);
+}
+
+namespace {
+
+void SequenceFrame::Resume(ObjectPtr, Machine& machine) const {
+    StepSequence(rest_, env_, machine);
+}
+
+// let, or letrec when `recursive_` is set: binds the values of `inits` in a new environment and
+// evaluates `body` in it. A let evaluates its inits in the outer environment and a letrec in the
+// new one, binding each name as soon as its value is known. No procedure is created for either.
+class LetNode : public Node {
+public:
+    LetNode(std::vector<std::string> names, std::vector<NodePtr> inits, NodePtr body,
+            bool recursive)
+        : names_(std::move(names)),
+          inits_(std::move(inits)),
+          body_(std::move(body)),
+          recursive_(recursive) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        auto let_env = std::make_shared<Environment>(env);
+        const auto& init_env = recursive_ ? let_env : env;
+        for (size_t i = 0; i < names_.size(); ++i) {
+            auto value = OneValue(inits_[i]->Eval(init_env, evaluator));
+            if (IsFailure(value)) {
+                return value;
+            }
+            let_env->Define(names_[i], std::move(value));
+        }
+        return body_->Eval(let_env, evaluator);
+    }
+
+private:
+    std::vector<std::string> names_;
+    std::vector<NodePtr> inits_;
+    NodePtr body_;
+    bool recursive_;
+};
+
+NodePtr AnalyzeLet(const Bindings& bindings, Analyzer& analyzer, bool tail, bool recursive) {
+    const auto& forms = analyzer.GetSpecialForms();
+    auto scope = Scope::ForLambda(bindings.names, ToVectorOrSyntaxError(bindings.body),
+                                  analyzer.GetScope(), forms);
+    std::vector<NodePtr> inits;
+    inits.reserve(bindings.inits.size());
+    if (recursive) {
+        // Inits see the new names, so they are analyzed in the new scope.
+        ArgsVec exprs = bindings.inits;
+        auto body = ToVectorOrSyntaxError(bindings.body);
+        exprs.insert(exprs.end(), body.begin(), body.end());
+        scope = Scope::ForLambda(bindings.names, exprs, analyzer.GetScope(), forms);
+        for (const auto& init : bindings.inits) {
+            inits.push_back(analyzer.AnalyzeBodyIn(scope, {init}, false));
+        }
+    } else {
+        for (const auto& init : bindings.inits) {
+            inits.push_back(analyzer.Analyze(init));
+        }
+    }
+    auto body = analyzer.AnalyzeBodyIn(scope, ToVectorOrSyntaxError(bindings.body), tail);
+    return std::make_shared<LetNode>(bindings.names, std::move(inits), std::move(body),
+                                     recursive);
+}
+
+// Hot analysis of the let `expr` when some of its variables are bound to pairs that never leave
+// its body: each of them is bound to the components of its pair instead, so the pair is never
+// built. Should the builtins it relies on be redefined, the let is left to the tree walker.
+std::optional<NodePtr> AnalyzeLetWithoutPairs(const ObjectPtr& expr, const Bindings& bindings,
+                                              Analyzer& analyzer, bool tail) {
+    auto body = ToVectorOrSyntaxError(bindings.body);
+    std::vector<std::string> names;
+    std::vector<NodePtr> inits;
+    std::vector<std::string> pairs;
+    std::vector<Assumption> assumptions;
+    for (size_t i = 0; i < bindings.names.size(); ++i) {
+        const auto& name = bindings.names[i];
+        auto pair = analyzer.TakeApartPair(name, bindings.inits[i], body);
+        if (!pair) {
+            names.push_back(name);
+            inits.push_back(analyzer.Analyze(bindings.inits[i]));
+            continue;
+        }
+        for (size_t j = 0; j < pair->components.size(); ++j) {
+            names.push_back(Analyzer::ComponentName(name, j));
+            inits.push_back(analyzer.Analyze(pair->components[j]));
+        }
+        pairs.push_back(name);
+        assumptions.insert(assumptions.end(), pair->assumptions.begin(), pair->assumptions.end());
+    }
+    if (pairs.empty()) {
+        return std::nullopt;
+    }
+    auto scope =
+        Scope::ForLambda(bindings.names, body, analyzer.GetScope(), analyzer.GetSpecialForms());
+    auto body_node = analyzer.AnalyzeBodyWithoutPairs(scope, pairs, body, tail, &assumptions);
+    if (!body_node) {
+        return std::nullopt;
+    }
+    auto let = std::make_shared<LetNode>(std::move(names), std::move(inits),
+                                         std::move(*body_node), false);
+    return analyzer.Guard(std::move(assumptions), std::move(let), analyzer.Fallback(expr));
+}
+
+void ContinueLet(Machine& machine, BindingsPtr bindings, ArgsVec values, const EnvPtr& env);
+
+// Inits of a let evaluated so far. Keeps its own copy of their values, so resuming it through a
+// captured continuation binds fresh variables.
+class LetFrame : public Frame {
+public:
+    LetFrame(BindingsPtr bindings, ArgsVec values, EnvPtr env)
+        : bindings_(std::move(bindings)), values_(std::move(values)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        value = OneValue(std::move(value));
+        if (IsFailure(value)) {
+            machine.Return(std::move(value));
+            return;
+        }
+        auto values = values_;
+        values.push_back(std::move(value));
+        ContinueLet(machine, bindings_, std::move(values), env_);
+    }
+
+private:
+    BindingsPtr bindings_;
+    ArgsVec values_;
+    EnvPtr env_;
+};
+
+void ContinueLet(Machine& machine, BindingsPtr bindings, ArgsVec values, const EnvPtr& env) {
+    auto index = values.size();
+    if (index < bindings->names.size()) {
+        const auto& init = bindings->inits[index];
+        machine.Push(std::make_shared<LetFrame>(std::move(bindings), std::move(values), env));
+        machine.Eval(init, env);
+        return;
+    }
+    auto let_env = std::make_shared<Environment>(env);
+    for (size_t i = 0; i < index; ++i) {
+        let_env->Define(bindings->names[i], std::move(values[i]));
+    }
+    StepSequence(bindings->body, let_env, machine);
+}
+
+// Binding `index` of a let* or letrec. A let* binds it in a new environment nested in `env`; a
+// letrec binds it in `env`, which all its names share.
+class SequentialBindingFrame : public Frame {
+public:
+    SequentialBindingFrame(BindingsPtr bindings, size_t index, EnvPtr env, bool recursive)
+        : bindings_(std::move(bindings)), index_(index), env_(std::move(env)),
+          recursive_(recursive) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override;
+
+private:
+    BindingsPtr bindings_;
+    size_t index_;
+    EnvPtr env_;
+    bool recursive_;
+};
+
+void StepSequentialBindings(Machine& machine, BindingsPtr bindings, size_t index, EnvPtr env,
+                            bool recursive) {
+    if (index == bindings->names.size()) {
+        StepSequence(bindings->body, env, machine);
+        return;
+    }
+    const auto& init = bindings->inits[index];
+    machine.Push(std::make_shared<SequentialBindingFrame>(std::move(bindings), index, env,
+                                                          recursive));
+    machine.Eval(init, std::move(env));
+}
+
+void SequentialBindingFrame::Resume(ObjectPtr value, Machine& machine) const {
+    value = OneValue(std::move(value));
+    if (IsFailure(value)) {
+        machine.Return(std::move(value));
+        return;
+    }
+    auto env = recursive_ ? env_ : std::make_shared<Environment>(env_);
+    env->Define(bindings_->names[index_], std::move(value));
+    StepSequentialBindings(machine, bindings_, index_ + 1, std::move(env), recursive_);
+}
+
+// Calls `fn(item, is_last)` on each item of the list `items` while it returns true. False if
+// some call does or `items` is not a proper list.
+template <class Fn>
+bool ForEachItem(const ObjectPtr& items, Fn fn) {
+    for (auto cur = items; cur;) {
+        auto cell = As<Cell>(cur);
+        if (!cell || !fn(cell->GetFirst(), !cell->GetSecond())) {
+            return false;
+        }
+        cur = cell->GetSecond();
+    }
+    return true;
+}
+
+bool IsHead(const ObjectPtr& expr, const char* name) {
+    auto symbol = As<Symbol>(expr);
+    return symbol && symbol->GetName() == name;
+}
+
+bool IsLoopBody(const ObjectPtr& body, const std::string& name,
+                const SpecialFormRegistry& forms);
+
+// Whether `name` only occurs in `expr` as the head of calls in tail position of a loop body;
+// `tail` tells whether `expr` itself is in one. Tail positions are followed through the forms
+// that have them and macro uses are checked as their expansions. Anything else, including forms
+// that may rebind `name`, is searched as a plain expression, where any occurrence fails the
+// check.
+bool OnlyTailCalls(const ObjectPtr& expr, const std::string& name, bool tail,
+                   const SpecialFormRegistry& forms);
+
+bool ClauseOnlyTailCalls(const ObjectPtr& clause, const std::string& name, bool tail,
+                         bool is_case, const SpecialFormRegistry& forms) {
+    auto cell = As<Cell>(clause);
+    if (!cell || (!is_case && !OnlyTailCalls(cell->GetFirst(), name, false, forms))) {
+        return false;
+    }
+    auto body = As<Cell>(cell->GetSecond());
+    auto in_tail = !(body && IsHead(body->GetFirst(), "=>")) && tail;
+    return ForEachItem(cell->GetSecond(), [&](const ObjectPtr& expr, bool last) {
+        return OnlyTailCalls(expr, name, in_tail && last, forms);
+    });
+}
+
+bool LetOnlyTailCalls(const ObjectPtr& args, const std::string& name, bool tail,
+                      const SpecialFormRegistry& forms) {
+    auto form = As<Cell>(args);
+    if (!form) {
+        return false;
+    }
+    auto bindings = form->GetFirst();
+    auto body = form->GetSecond();
+    auto body_in_tail = tail;
+    if (auto loop = As<Symbol>(bindings)) {
+        auto rest = As<Cell>(body);
+        if (!rest || loop->GetName() == name) {
+            return false;
+        }
+        bindings = rest->GetFirst();
+        body = rest->GetSecond();
+        body_in_tail = tail && IsLoopBody(body, loop->GetName(), forms);
+    }
+    auto binds = false;
+    auto inits = ForEachItem(bindings, [&](const ObjectPtr& binding, bool) {
+        auto cell = As<Cell>(binding);
+        if (!cell) {
+            return false;
+        }
+        binds = binds || IsHead(cell->GetFirst(), name.c_str());
+        return ForEachItem(cell->GetSecond(), [&](const ObjectPtr& init, bool) {
+            return OnlyTailCalls(init, name, false, forms);
+        });
+    });
+    return inits && !binds && ForEachItem(body, [&](const ObjectPtr& expr, bool last) {
+        return OnlyTailCalls(expr, name, body_in_tail && last, forms);
+    });
+}
+
+bool OnlyTailCalls(const ObjectPtr& expr, const std::string& name, bool tail,
+                   const SpecialFormRegistry& forms) {
+    if (auto symbol = As<Symbol>(expr)) {
+        return symbol->GetName() != name;
+    }
+    if (auto expansion = ExpandMacroUse(expr, forms)) {
+        NestedExpansion nested;
+        return OnlyTailCalls(expansion, name, tail, forms);
+    }
+    auto cell = As<Cell>(expr);
+    if (!cell) {
+        return true;
+    }
+    auto nowhere = [&](const ObjectPtr& item, bool) {
+        return OnlyTailCalls(item, name, false, forms);
+    };
+    auto head = As<Symbol>(cell->GetFirst());
+    if (!head) {
+        return ForEachItem(expr, nowhere);
+    }
+    const auto& form = head->GetName();
+    const auto& args = cell->GetSecond();
+    if (form == name) {
+        return tail && ForEachItem(args, nowhere);
+    }
+    if (form == "quote") {
+        return true;
+    }
+    if (form == "if") {
+        auto test = As<Cell>(args);
+        return test && OnlyTailCalls(test->GetFirst(), name, false, forms) &&
+               ForEachItem(test->GetSecond(), [&](const ObjectPtr& branch, bool) {
+                   return OnlyTailCalls(branch, name, tail, forms);
+               });
+    }
+    if (form == "begin" || form == "and" || form == "or") {
+        return ForEachItem(args, [&](const ObjectPtr& item, bool last) {
+            return OnlyTailCalls(item, name, tail && last, forms);
+        });
+    }
+    if (form == "cond" || form == "case") {
+        auto is_case = form == "case";
+        auto key = As<Cell>(args);
+        if (is_case && !(key && OnlyTailCalls(key->GetFirst(), name, false, forms))) {
+            return false;
+        }
+        return ForEachItem(is_case ? key->GetSecond() : args, [&](const ObjectPtr& clause, bool) {
+            return ClauseOnlyTailCalls(clause, name, tail, is_case, forms);
+        });
+    }
+    if (form == "let" || form == "let*" || form == "letrec") {
+        return LetOnlyTailCalls(args, name, tail, forms);
+    }
+    return ForEachItem(expr, nowhere);
+}
+
+// Whether the named let `name` with `body` runs as an in-place loop: every use of its name is a
+// call in tail position, so no procedure is needed.
+bool IsLoopBody(const ObjectPtr& body, const std::string& name,
+                const SpecialFormRegistry& forms) {
+    return ForEachItem(body, [&](const ObjectPtr& expr, bool last) {
+        return OnlyTailCalls(expr, name, last, forms);
+    });
+}
+
+// `(let name ((var init) ...) body...)`.
+struct NamedLet {
+    std::string name;
+    Bindings bindings;
+};
+
+bool IsNamedLet(const ObjectPtr& args) {
+    auto form = As<Cell>(args);
+    return form && Is<Symbol>(form->GetFirst());
+}
+
+NamedLet ParseNamedLet(const ObjectPtr& args) {
+    auto form = As<Cell>(args);
+    return {As<Symbol>(form->GetFirst())->GetName(), ParseBindings(form->GetSecond(), false)};
+}
+
+LambdaCodePtr MakeNamedLetCode(const NamedLet& let, Scope::Ptr scope) {
+    return std::make_shared<LambdaCode>(let.bindings.names,
+                                        ToVectorOrSyntaxError(let.bindings.body),
+                                        std::move(scope));
+}
+
+// Breaks the cycle between the procedure `proc` of a named let and the environment `env` that
+// binds it once nothing but the caller refers to either of them.
+void ReleaseNamedLet(const EnvPtr& env, const std::shared_ptr<LambdaProcedure>& proc) {
+    if (env.use_count() == 2 && proc.use_count() == 2) {
+        env->Clear();
+    }
+}
+
+// Named let whose name is used as a procedure: binds the procedure in a new environment and
+// applies it to the inits.
+class ProcedureLetNode : public Node {
+public:
+    ProcedureLetNode(std::string name, LambdaCodePtr code, std::vector<NodePtr> inits)
+        : name_(std::move(name)), code_(std::move(code)), inits_(std::move(inits)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        ArgsBuffer args(inits_.size());
+        for (const auto& init : inits_) {
+            auto value = OneValue(init->Eval(env, evaluator));
+            if (IsFailure(value)) {
+                return value;
+            }
+            args.Push(std::move(value));
+        }
+        auto let_env = std::make_shared<Environment>(env);
+        auto proc = std::make_shared<LambdaProcedure>(code_, let_env);
+        let_env->Define(name_, proc);
+        auto result = proc->Apply(args.Get(), env, evaluator);
+        ReleaseNamedLet(let_env, proc);
+        return result;
+    }
+
+private:
+    std::string name_;
+    LambdaCodePtr code_;
+    std::vector<NodePtr> inits_;
+};
+
+// Keeps the procedure of a named let applied by the machine and releases it with the frame,
+// once the procedure has returned or the continuation waiting for it is dropped.
+class ReleaseFrame : public Frame {
+public:
+    ReleaseFrame(EnvPtr env, std::shared_ptr<LambdaProcedure> proc)
+        : env_(std::move(env)), proc_(std::move(proc)) {
+    }
+
+    ~ReleaseFrame() override {
+        ReleaseNamedLet(env_, proc_);
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        machine.Return(std::move(value));
+    }
+
+private:
+    EnvPtr env_;
+    std::shared_ptr<LambdaProcedure> proc_;
+};
+
+// The machine has no loop nodes: every named let runs as the procedure it stands for, which
+// the machine calls in constant space all the same.
+void StepNamedLet(const NamedLet& let, const EnvPtr& env, Machine& machine) {
+    auto let_env = std::make_shared<Environment>(env);
+    auto proc = std::make_shared<LambdaProcedure>(MakeNamedLetCode(let, nullptr), let_env);
+    let_env->Define(let.name, proc);
+    machine.Push(std::make_shared<ReleaseFrame>(let_env, proc));
+    auto head = MakeList({std::make_shared<Symbol>("quote"), proc});
+    machine.Eval(std::make_shared<Cell>(head, listutils::FromVector(let.bindings.inits)), env);
+}
+
+// Values of the loop variables for the next iteration of a LoopNode. The jumps of the loop
+// return the state itself to tell the loop to go on.
+class LoopState : public Object {
+public:
+    ArgsBuffer next;
+};
+
+class LoopJumpNode : public Node {
+public:
+    LoopJumpNode(std::shared_ptr<LoopState> state, std::vector<NodePtr> args)
+        : state_(std::move(state)), args_(std::move(args)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        ArgsBuffer values(args_.size());
+        for (const auto& arg : args_) {
+            auto value = OneValue(arg->Eval(env, evaluator));
+            if (IsFailure(value)) {
+                return value;
+            }
+            values.Push(std::move(value));
+        }
+        state_->next = std::move(values);
+        return state_;
+    }
+
+private:
+    std::shared_ptr<LoopState> state_;
+    std::vector<NodePtr> args_;
+};
+
+// Named let whose name is only used for jumps, run as a loop in one environment. A jump stores
+// the new values of the variables straight into their slots, unless something created in the
+// iteration, such as a closure, still refers to the environment: then the next iteration gets a
+// fresh one, so the closure keeps the values it saw.
+class LoopNode : public Node {
+public:
+    LoopNode(std::vector<std::string> names, std::vector<NodePtr> inits, NodePtr body,
+             std::shared_ptr<LoopState> state)
+        : names_(std::move(names)),
+          inits_(std::move(inits)),
+          body_(std::move(body)),
+          state_(std::move(state)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        ArgsBuffer values(inits_.size());
+        for (const auto& init : inits_) {
+            auto value = OneValue(init->Eval(env, evaluator));
+            if (IsFailure(value)) {
+                return value;
+            }
+            values.Push(std::move(value));
+        }
+        std::vector<ObjectPtr*> slots(names_.size());
+        auto loop_env = Bind(env, values.Get(), &slots);
+        for (;;) {
+            auto result = body_->Eval(loop_env, evaluator);
+            if (result != state_) {
+                return result;
+            }
+            if (!evaluator.Tick()) {
+                return Failure();
+            }
+            auto next = state_->next.Get();
+            if (next.size() != names_.size()) {
+                return Fail(Error::Runtime("Invalid argument count"));
+            }
+            if (loop_env.use_count() == 1) {
+                for (size_t i = 0; i < slots.size(); ++i) {
+                    *slots[i] = next[i];
+                }
+            } else {
+                loop_env = Bind(env, next, &slots);
+            }
+            state_->next.Clear();
+        }
+    }
+
+private:
+    EnvPtr Bind(const EnvPtr& env, Args values, std::vector<ObjectPtr*>* slots) const {
+        auto loop_env = std::make_shared<Environment>(env);
+        for (size_t i = 0; i < names_.size(); ++i) {
+            (*slots)[i] = &loop_env->Define(names_[i], values[i]);
+        }
+        return loop_env;
+    }
+
+    std::vector<std::string> names_;
+    std::vector<NodePtr> inits_;
+    NodePtr body_;
+    std::shared_ptr<LoopState> state_;
+};
+
+NodePtr AnalyzeNamedLet(const NamedLet& let, Analyzer& analyzer, bool tail) {
+    const auto& bindings = let.bindings;
+    std::vector<NodePtr> inits;
+    for (const auto& init : bindings.inits) {
+        inits.push_back(analyzer.Analyze(init));
+    }
+    const auto& forms = analyzer.GetSpecialForms();
+    if (!IsLoopBody(bindings.body, let.name, forms)) {
+        auto scope = Scope::ForLambda({let.name}, {}, analyzer.GetScope(), forms);
+        return std::make_shared<ProcedureLetNode>(let.name, MakeNamedLetCode(let, scope),
+                                                  std::move(inits));
+    }
+    auto names = bindings.names;
+    names.push_back(let.name);
+    auto body = ToVectorOrSyntaxError(bindings.body);
+    auto scope = Scope::ForLambda(names, body, analyzer.GetScope(), forms);
+    auto state = std::make_shared<LoopState>();
+    LoopTarget loop{.name = let.name, .jump = [state](std::vector<NodePtr> args) -> NodePtr {
+                        return std::make_shared<LoopJumpNode>(state, std::move(args));
+                    }};
+    auto body_node = analyzer.AnalyzeLoopBody(std::move(scope), std::move(loop), body, tail);
+    return std::make_shared<LoopNode>(bindings.names, std::move(inits), std::move(body_node),
+                                      std::move(state));
+}
+
+// Loops are run as analyzed code even by the tree walker, so they take constant space.
+ObjectPtr EvaluateNamedLet(const NamedLet& let, const EnvPtr& env, Evaluator& evaluator) {
+    Analyzer analyzer(evaluator.GetSpecialForms(), Tier::Warm);
+    return AnalyzeNamedLet(let, analyzer, false)->Eval(env, evaluator);
+}
+
+// Name of the loop a `do` expands into. It cannot be written in source code, so it never clashes
+// with a name the loop uses.
+constexpr const char* kDoLoopName = "do loop";
+
+// `(let <loop> ((var init) ...) (if test (begin expr...) (begin command... (<loop> step ...))))`
+// for `(do ((var init step) ...) (test expr...) command...)`, where a variable without a step
+// keeps its value.
+NamedLet ExpandDo(const ObjectPtr& args) {
+    auto form = As<Cell>(args);
+    if (!form) {
+        throw SyntaxError{""};
+    }
+    auto exit = As<Cell>(form->GetSecond());
+    if (!exit || !listutils::IsProperList(exit->GetSecond())) {
+        throw SyntaxError{""};
+    }
+    auto result = As<Cell>(exit->GetFirst());
+    if (!result || !listutils::IsProperList(result)) {
+        throw SyntaxError{""};
+    }
+    NamedLet let{.name = kDoLoopName};
+    auto loop = std::make_shared<Symbol>(let.name);
+    ArgsVec steps{loop};
+    for (const auto& spec : ToVectorOrSyntaxError(form->GetFirst())) {
+        auto parts = ToVectorOrSyntaxError(spec);
+        if (parts.size() < 2 || parts.size() > 3 || !Is<Symbol>(parts[0])) {
+            throw SyntaxError{""};
+        }
+        for (const auto& bound : let.bindings.names) {
+            if (bound == As<Symbol>(parts[0])->GetName()) {
+                throw SyntaxError{""};
+            }
+        }
+        let.bindings.names.push_back(As<Symbol>(parts[0])->GetName());
+        let.bindings.inits.push_back(parts[1]);
+        steps.push_back(parts.size() == 3 ? parts[2] : parts[0]);
+    }
+    auto begin = std::make_shared<Symbol>("begin");
+    auto jump = listutils::FromVector(steps);
+    auto commands = ToVectorOrSyntaxError(exit->GetSecond());
+    commands.push_back(jump);
+    auto iterate = std::make_shared<Cell>(begin, listutils::FromVector(commands));
+    auto finish = std::make_shared<Cell>(begin, result->GetSecond());
+    auto body = MakeList({std::make_shared<Symbol>("if"), result->GetFirst(), finish, iterate});
+    let.bindings.body = MakeList({body});
+    return let;
+}
+
+// One clause of a cond: `(test body...)`, `(test => receiver)` or `(else body...)`, or of a
+// case, where `test` is the list of datums and `(else => receiver)` is allowed as well.
+struct Clause {
+    ObjectPtr test;
+    // Proper list, empty when the clause returns the value of its test.
+    ObjectPtr body;
+    ObjectPtr receiver;
+    bool is_else = false;
+    bool receives = false;
+};
+
+Clause ParseClause(const ObjectPtr& clause, bool is_case) {
+    auto cell = As<Cell>(clause);
+    if (!cell || !listutils::IsProperList(clause)) {
+        throw SyntaxError{""};
+    }
+    Clause result{.test = cell->GetFirst(), .body = cell->GetSecond()};
+    auto head = As<Symbol>(result.test);
+    result.is_else = head && head->GetName() == "else";
+    if ((result.is_else || is_case) && !result.body) {
+        throw SyntaxError{""};
+    }
+    if (is_case && !result.is_else && !listutils::IsProperList(result.test)) {
+        throw SyntaxError{""};
+    }
+    auto body = As<Cell>(result.body);
+    auto arrow = body ? As<Symbol>(body->GetFirst()) : nullptr;
+    if ((!result.is_else || is_case) && arrow && arrow->GetName() == "=>") {
+        auto receiver = As<Cell>(body->GetSecond());
+        if (!receiver || receiver->GetSecond()) {
+            throw SyntaxError{""};
+        }
+        result.receiver = receiver->GetFirst();
+        result.receives = true;
+    }
+    return result;
+}
+
+// The first of the clauses `clauses` and the ones after it. Only the last may be `else`.
+std::pair<Clause, ObjectPtr> NextClause(const ObjectPtr& clauses, bool is_case) {
+    auto cell = As<Cell>(clauses);
+    if (!cell) {
+        throw SyntaxError{""};
+    }
+    auto clause = ParseClause(cell->GetFirst(), is_case);
+    if (clause.is_else && cell->GetSecond()) {
+        throw SyntaxError{""};
+    }
+    return {std::move(clause), cell->GetSecond()};
+}
+
+ObjectPtr ApplyReceiver(const ObjectPtr& receiver, const ObjectPtr& value, const EnvPtr& env,
+                        Evaluator& evaluator) {
+    if (IsFailure(receiver)) {
+        return receiver;
+    }
+    auto proc = As<Procedure>(receiver);
+    if (!proc) {
+        return Fail(Error::Runtime("Not a procedure"));
+    }
+    return proc->Apply(Args{&value, 1}, env, evaluator);
+}
+
+// Value of the taken `clause`, whose test produced `value`.
+ObjectPtr EvalClause(const Clause& clause, const ObjectPtr& value, const EnvPtr& env,
+                     Evaluator& evaluator) {
+    if (clause.receives) {
+        return ApplyReceiver(evaluator.Eval(clause.receiver, env), value, env, evaluator);
+    }
+    if (!clause.body) {
+        return value;
+    }
+    return EvalSequence(clause.body, env, evaluator);
+}
+
+// cond as one flat chain of tests. A clause without a test is taken unconditionally; one
+// without a body returns the value of its test, or passes it to the procedure `body` evaluates
+// to when `receives` is set.
+class CondNode : public Node {
+public:
+    struct Branch {
+        NodePtr test;
+        NodePtr body;
+        bool receives = false;
+    };
+
+    explicit CondNode(std::vector<Branch> branches) : branches_(std::move(branches)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        for (const auto& branch : branches_) {
+            ObjectPtr value;
+            if (branch.test) {
+                value = OneValue(branch.test->Eval(env, evaluator));
+                if (IsFailure(value)) {
+                    return value;
+                }
+                if (helpers::IsFalse(value)) {
+                    continue;
+                }
+            }
+            if (!branch.body) {
+                return value;
+            }
+            if (branch.receives) {
+                return ApplyReceiver(branch.body->Eval(env, evaluator), value, env, evaluator);
+            }
+            return branch.body->Eval(env, evaluator);
+        }
+        return nullptr;
+    }
+
+private:
+    std::vector<Branch> branches_;
+};
+
+void StepCond(const ObjectPtr& clauses, const EnvPtr& env, Machine& machine);
+
+// Test of `clause` evaluated; `rest` are the clauses after it.
+class CondFrame : public Frame {
+public:
+    CondFrame(Clause clause, ObjectPtr rest, EnvPtr env)
+        : clause_(std::move(clause)), rest_(std::move(rest)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override;
+
+private:
+    Clause clause_;
+    ObjectPtr rest_;
+    EnvPtr env_;
+};
+
+// Value of a `=>` clause test, waiting for the receiver to be evaluated.
+class ReceiverFrame : public Frame {
+public:
+    ReceiverFrame(ObjectPtr value, EnvPtr env) : value_(std::move(value)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr receiver, Machine& machine) const override {
+        auto proc = As<Procedure>(receiver);
+        if (!proc) {
+            machine.Return(Fail(Error::Runtime("Not a procedure")));
+            return;
+        }
+        machine.Apply(proc, Args{&value_, 1}, env_);
+    }
+
+private:
+    ObjectPtr value_;
+    EnvPtr env_;
+};
+
+void StepClause(const Clause& clause, ObjectPtr value, const EnvPtr& env, Machine& machine) {
+    if (clause.receives) {
+        machine.Push(std::make_shared<ReceiverFrame>(std::move(value), env));
+        machine.Eval(clause.receiver, env);
+    } else if (!clause.body) {
+        machine.Return(std::move(value));
+    } else {
+        StepSequence(clause.body, env, machine);
+    }
+}
+
+void StepCond(const ObjectPtr& clauses, const EnvPtr& env, Machine& machine) {
+    if (!clauses) {
+        machine.Return(nullptr);
+        return;
+    }
+    auto [clause, rest] = NextClause(clauses, false);
+    if (clause.is_else) {
+        StepSequence(clause.body, env, machine);
+        return;
+    }
+    auto test = clause.test;
+    machine.Push(std::make_shared<CondFrame>(std::move(clause), std::move(rest), env));
+    machine.Eval(std::move(test), env);
+}
+
+void CondFrame::Resume(ObjectPtr value, Machine& machine) const {
+    value = OneValue(std::move(value));
+    if (IsFailure(value)) {
+        machine.Return(std::move(value));
+    } else if (helpers::IsFalse(value)) {
+        StepCond(rest_, env_, machine);
+    } else {
+        StepClause(clause_, std::move(value), env_, machine);
+    }
+}
+
+// Whether `clause` of a case is taken for `key`.
+bool Selects(const Clause& clause, const ObjectPtr& key) {
+    if (clause.is_else) {
+        return true;
+    }
+    for (auto cur = clause.test; cur;) {
+        auto cell = As<Cell>(cur);
+        if (helpers::IsEqv(cell->GetFirst(), key)) {
+            return true;
+        }
+        cur = cell->GetSecond();
+    }
+    return false;
+}
+
+// case dispatching through a CaseTable built from the datums of all clauses, so selecting a
+// clause takes the same time however many there are.
+class CaseNode : public Node {
+public:
+    struct Branch {
+        NodePtr body;
+        bool receives = false;
+    };
+
+    CaseNode(NodePtr key, CaseTable table, std::vector<Branch> branches)
+        : key_(std::move(key)), table_(std::move(table)), branches_(std::move(branches)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        auto key = OneValue(key_->Eval(env, evaluator));
+        if (IsFailure(key)) {
+            return key;
+        }
+        auto index = table_.Find(key);
+        if (index == CaseTable::kNoMatch) {
+            return nullptr;
+        }
+        const auto& branch = branches_[index];
+        if (branch.receives) {
+            return ApplyReceiver(branch.body->Eval(env, evaluator), key, env, evaluator);
+        }
+        return branch.body->Eval(env, evaluator);
+    }
+
+private:
+    NodePtr key_;
+    CaseTable table_;
+    std::vector<Branch> branches_;
+};
+
+// Clauses of a case waiting for the key.
+class CaseFrame : public Frame {
+public:
+    CaseFrame(ObjectPtr clauses, EnvPtr env) : clauses_(std::move(clauses)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr key, Machine& machine) const override {
+        key = OneValue(std::move(key));
+        if (IsFailure(key)) {
+            machine.Return(std::move(key));
+            return;
+        }
+        for (auto clauses = clauses_; clauses;) {
+            auto [clause, rest] = NextClause(clauses, true);
+            if (Selects(clause, key)) {
+                StepClause(clause, std::move(key), env_, machine);
+                return;
+            }
+            clauses = rest;
+        }
+        machine.Return(nullptr);
+    }
+
+private:
+    ObjectPtr clauses_;
+    EnvPtr env_;
+};
+
+class BeginForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        return EvalSequence(args, env, evaluator);
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        auto exprs = ToVectorOrSyntaxError(args);
+        if (exprs.empty()) {
+            return analyzer.Constant(nullptr);
+        }
+        return analyzer.AnalyzeBody(exprs, tail);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        StepSequence(args, env, machine);
+    }
+};
+
+class LetForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        if (IsNamedLet(args)) {
+            return EvaluateNamedLet(ParseNamedLet(args), env, evaluator);
+        }
+        auto bindings = ParseBindings(args, false);
+        auto let_env = std::make_shared<Environment>(env);
+        for (size_t i = 0; i < bindings.names.size(); ++i) {
+            auto value = OneValue(evaluator.Eval(bindings.inits[i], env));
+            if (IsFailure(value)) {
+                return value;
+            }
+            let_env->Define(bindings.names[i], std::move(value));
+        }
+        return EvalSequence(bindings.body, let_env, evaluator);
+    }
+
+    NodePtr Analyze(const ObjectPtr& expr, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        if (IsNamedLet(args)) {
+            return AnalyzeNamedLet(ParseNamedLet(args), analyzer, tail);
+        }
+        auto bindings = ParseBindings(args, false);
+        if (auto node = AnalyzeLetWithoutPairs(expr, bindings, analyzer, tail)) {
+            return *node;
+        }
+        return AnalyzeLet(bindings, analyzer, tail, false);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        if (IsNamedLet(args)) {
+            StepNamedLet(ParseNamedLet(args), env, machine);
+            return;
+        }
+        auto bindings = std::make_shared<const Bindings>(ParseBindings(args, false));
+        ContinueLet(machine, std::move(bindings), {}, env);
+    }
+};
+
+class LetStarForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        auto bindings = ParseBindings(args, true);
+        auto let_env = env;
+        for (size_t i = 0; i < bindings.names.size(); ++i) {
+            auto value = OneValue(evaluator.Eval(bindings.inits[i], let_env));
+            if (IsFailure(value)) {
+                return value;
+            }
+            let_env = std::make_shared<Environment>(let_env);
+            let_env->Define(bindings.names[i], std::move(value));
+        }
+        if (let_env == env) {
+            let_env = std::make_shared<Environment>(env);
+        }
+        return EvalSequence(bindings.body, let_env, evaluator);
+    }
+
+    // Expands into lets nested one per binding.
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        auto bindings = ParseBindings(args, true);
+        auto let = std::make_shared<Symbol>("let");
+        auto body = bindings.body;
+        auto i = bindings.names.size();
+        ObjectPtr expr;
+        do {
+            ObjectPtr binding = nullptr;
+            if (i > 0) {
+                --i;
+                binding = MakeList({MakeList({std::make_shared<Symbol>(bindings.names[i]),
+                                              bindings.inits[i]})});
+            }
+            expr = std::make_shared<Cell>(let, std::make_shared<Cell>(binding, body));
+            body = MakeList({expr});
+        } while (i > 0);
+        return analyzer.Analyze(expr, tail);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        auto bindings = std::make_shared<const Bindings>(ParseBindings(args, true));
+        auto start = bindings->names.empty() ? std::make_shared<Environment>(env) : env;
+        StepSequentialBindings(machine, std::move(bindings), 0, std::move(start), false);
+    }
+};
+
+class LetrecForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        auto bindings = ParseBindings(args, false);
+        auto let_env = std::make_shared<Environment>(env);
+        for (size_t i = 0; i < bindings.names.size(); ++i) {
+            auto value = OneValue(evaluator.Eval(bindings.inits[i], let_env));
+            if (IsFailure(value)) {
+                return value;
+            }
+            let_env->Define(bindings.names[i], std::move(value));
+        }
+        return EvalSequence(bindings.body, let_env, evaluator);
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        return AnalyzeLet(ParseBindings(args, false), analyzer, tail, true);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        auto bindings = std::make_shared<const Bindings>(ParseBindings(args, false));
+        StepSequentialBindings(machine, std::move(bindings), 0, std::make_shared<Environment>(env),
+                               true);
+    }
+};
+
+class DoForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        return EvaluateNamedLet(ExpandDo(args), env, evaluator);
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        return AnalyzeNamedLet(ExpandDo(args), analyzer, tail);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        StepNamedLet(ExpandDo(args), env, machine);
+    }
+};
+
+class CondForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        for (auto clauses = args; clauses;) {
+            auto [clause, rest] = NextClause(clauses, false);
+            clauses = rest;
+            ObjectPtr value;
+            if (!clause.is_else) {
+                value = OneValue(evaluator.Eval(clause.test, env));
+                if (IsFailure(value)) {
+                    return value;
+                }
+                if (helpers::IsFalse(value)) {
+                    continue;
+                }
+            }
+            return EvalClause(clause, value, env, evaluator);
+        }
+        return nullptr;
+    }
+
+    // Clauses whose test is known to be false are dropped, and the chain ends at the first one
+    // whose test is known to be true.
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        std::vector<CondNode::Branch> branches;
+        for (auto clauses = args; clauses;) {
+            auto [clause, rest] = NextClause(clauses, false);
+            clauses = rest;
+            CondNode::Branch branch{.receives = clause.receives};
+            auto always = clause.is_else;
+            if (!clause.is_else) {
+                auto folded = analyzer.TryFold(clause.test);
+                if (folded && folded->assumptions.empty()) {
+                    if (helpers::IsFalse(folded->value)) {
+                        continue;
+                    }
+                    always = true;
+                }
+                if (!always || !clause.body || clause.receives) {
+                    branch.test = analyzer.Analyze(clause.test);
+                }
+            }
+            if (clause.receives) {
+                branch.body = analyzer.Analyze(clause.receiver);
+            } else if (clause.body) {
+                branch.body = analyzer.AnalyzeBody(ToVectorOrSyntaxError(clause.body), tail);
+            }
+            branches.push_back(std::move(branch));
+            if (always) {
+                break;
+            }
+        }
+        return std::make_shared<CondNode>(std::move(branches));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        StepCond(args, env, machine);
+    }
+};
+
+class CaseForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        auto form = As<Cell>(args);
+        if (!form) {
+            throw SyntaxError{""};
+        }
+        auto key = OneValue(evaluator.Eval(form->GetFirst(), env));
+        if (IsFailure(key)) {
+            return key;
+        }
+        for (auto clauses = form->GetSecond(); clauses;) {
+            auto [clause, rest] = NextClause(clauses, true);
+            if (Selects(clause, key)) {
+                return EvalClause(clause, key, env, evaluator);
+            }
+            clauses = rest;
+        }
+        return nullptr;
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        auto form = As<Cell>(args);
+        if (!form) {
+            throw SyntaxError{""};
+        }
+        std::vector<std::vector<ObjectPtr>> datums;
+        std::vector<CaseNode::Branch> branches;
+        auto fallback = CaseTable::kNoMatch;
+        for (auto clauses = form->GetSecond(); clauses;) {
+            auto [clause, rest] = NextClause(clauses, true);
+            clauses = rest;
+            if (clause.is_else) {
+                fallback = branches.size();
+                datums.emplace_back();
+            } else {
+                datums.push_back(ToVectorOrSyntaxError(clause.test));
+            }
+            CaseNode::Branch branch{.receives = clause.receives};
+            if (clause.receives) {
+                branch.body = analyzer.Analyze(clause.receiver);
+            } else {
+                branch.body = analyzer.AnalyzeBody(ToVectorOrSyntaxError(clause.body), tail);
+            }
+            branches.push_back(std::move(branch));
+        }
+        return std::make_shared<CaseNode>(analyzer.Analyze(form->GetFirst()),
+                                          CaseTable{datums, fallback}, std::move(branches));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        auto form = As<Cell>(args);
+        if (!form) {
+            throw SyntaxError{""};
+        }
+        machine.Push(std::make_shared<CaseFrame>(form->GetSecond(), env));
+        machine.Eval(form->GetFirst(), env);
+    }
+};
+
+}  // namespace
+
+void RegisterDerivedForms(SpecialFormRegistry* registry) {
+    registry->Register("begin", std::make_shared<BeginForm>());
+    registry->Register("let", std::make_shared<LetForm>());
+    registry->Register("let*", std::make_shared<LetStarForm>());
+    registry->Register("letrec", std::make_shared<LetrecForm>());
+    registry->Register("do", std::make_shared<DoForm>());
+    registry->Register("cond", std::make_shared<CondForm>());
+    registry->Register("case", std::make_shared<CaseForm>());
+}
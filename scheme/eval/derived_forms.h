@@ -0,0 +1,20 @@
+#pragma once
+
+#include "eval/special_forms.h"
+
+// Forms defined in terms of the core ones: begin, let (named let included), let*, letrec, do,
+// cond and case. Analysis turns them into nodes as cheap as the core forms they stand for, named
+// let and do into loops that run in one environment; the tree walker and the machine evaluate
+// them directly.
+void RegisterDerivedForms(SpecialFormRegistry* registry);
+
+// Value of the last of the expressions `exprs`, evaluated in order in `env`; nothing for an
+// empty list. With `tail` set the last one is in tail position of the form being evaluated.
+// Throws SyntaxError if `exprs` is not a list.
+std::shared_ptr<Object> EvalSequence(const std::shared_ptr<Object>& exprs,
+                                     const std::shared_ptr<Environment>& env,
+                                     Evaluator& evaluator, bool tail = true);
+
+// Makes `machine` evaluate `exprs` as EvalSequence does, the last one in tail position.
+void StepSequence(const std::shared_ptr<Object>& exprs, const std::shared_ptr<Environment>& env,
+                  Machine& machine);
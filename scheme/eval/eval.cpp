@@ -2,9 +2,12 @@
 
 #include "eval/procedure.h"
 #include "eval/special_forms.h"
+#include "eval/values.h"
+#include "runtime/env.h"
 #include "runtime/error.h"
 #include "runtime/object.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -14,48 +17,179 @@ Evaluator::Evaluator() : special_forms_(CreateStandardForms()) {
 Evaluator::Evaluator(SpecialFormRegistry special_forms) : special_forms_(std::move(special_forms)) {
 }
 
-ObjectPtr Evaluator::Eval(const ObjectPtr& expr, const EnvPtr& env) {
+namespace {
+
+// Sets whether the forms evaluated are in tail position for as long as it lives.
+class FormTailScope {
+public:
+    FormTailScope(bool* form_tail, bool tail)
+        : form_tail_(form_tail), outer_(std::exchange(*form_tail, tail)) {
+    }
+
+    ~FormTailScope() {
+        *form_tail_ = outer_;
+    }
+
+private:
+    bool* form_tail_;
+    bool outer_;
+};
+
+// Failures kept out of line, so that the errors they build take no room in Eval's frame.
+[[gnu::noinline]] ObjectPtr FailRuntime(const char* text) {
+    return Fail(Error::Runtime(text));
+}
+
+[[gnu::noinline]] ObjectPtr FailName(const std::string& name) {
+    return Fail(Error::Name(name));
+}
+
+}  // namespace
+
+ObjectPtr Evaluator::Eval(const ObjectPtr& expr, const EnvPtr& env, bool tail) {
     if (!env) {
-        throw RuntimeError{"Cannot evaluate with empty environment"};
+        return FailRuntime("Cannot evaluate with empty environment");
     }
-    if (!expr) {
-        throw RuntimeError{"Cannot evaluate empty list"};
+    auto* object = expr.get();
+    if (!object) {
+        return FailRuntime("Cannot evaluate empty list");
     }
-    if (Is<Number>(expr) || Is<Boolean>(expr)) {
+    if (dynamic_cast<const Number*>(object) || dynamic_cast<const Boolean*>(object)) {
         return expr;
     }
-    if (auto symbol = As<Symbol>(expr)) {
-        return env->Lookup(symbol->GetName());
+    if (auto* symbol = dynamic_cast<const Symbol*>(object)) {
+        auto* value = env->Find(symbol->GetName());
+        return value ? *value : FailName(symbol->GetName());
     }
 
-    auto cell = As<Cell>(expr);
+    auto* cell = dynamic_cast<const Cell*>(object);
     if (!cell) {
-        throw RuntimeError{"Invalid expression"};
+        return FailRuntime("Invalid expression");
+    }
+    if (!Tick()) {
+        return Failure();
     }
 
     auto head = cell->GetFirst();
-    auto tail = cell->GetSecond();
-
-    if (auto sym = As<Symbol>(head)) {
-        if (auto form = special_forms_.Lookup(sym->GetName())) {
-            return form->Evaluate(tail, env, *this);
+    if (auto* sym = dynamic_cast<const Symbol*>(head.get())) {
+        if (auto* form = special_forms_.Lookup(*sym)) {
+            FormTailScope scope(&form_tail_, tail);
+            return form->Evaluate(cell->GetSecond(), env, *this);
         }
     }
+    return EvalApplication(head, cell->GetSecond(), env, tail);
+}
 
+ObjectPtr Evaluator::EvalApplication(const ObjectPtr& head, const ObjectPtr& args,
+                                     const EnvPtr& env, bool tail) {
     auto proc_obj = Eval(head, env);
+    if (IsFailure(proc_obj)) {
+        return proc_obj;
+    }
     auto proc = As<Procedure>(proc_obj);
     if (!proc) {
-        throw RuntimeError{"Not a procedure"};
+        return FailRuntime("Not a procedure");
     }
-    std::vector<std::shared_ptr<Object>> arg_values;
-    std::shared_ptr<Object> cur = tail;
+    ArgsBuffer arg_values;
+    auto cur = args;
     while (cur) {
         auto arg_cell = As<Cell>(cur);
         if (!arg_cell) {
-            throw RuntimeError{"Expected proper list"};
+            return FailRuntime("Expected proper list");
         }
-        arg_values.push_back(Eval(arg_cell->GetFirst(), env));
+        auto value = OneValue(Eval(arg_cell->GetFirst(), env));
+        if (IsFailure(value)) {
+            return value;
+        }
+        arg_values.Push(std::move(value));
         cur = arg_cell->GetSecond();
     }
-    return proc->Apply(arg_values, env, *this);
+    if (tail && proc.get() == current_procedure_) {
+        return ScheduleTailCall(arg_values.Get());
+    }
+    return proc->ApplyTaking(&arg_values, env, *this);
+}
+
+std::expected<ObjectPtr, Error> Evaluator::TryEval(const ObjectPtr& expr, const EnvPtr& env) {
+    ObjectPtr value;
+    try {
+        value = Eval(expr, env);
+    } catch (const SyntaxError& error) {
+        return std::unexpected(Error{ErrorCode::Syntax, "", error.what()});
+    }
+    if (IsFailure(value)) {
+        return std::unexpected(TakeError());
+    }
+    return value;
+}
+
+const SpecialFormRegistry& Evaluator::GetSpecialForms() const {
+    return special_forms_;
+}
+
+void Evaluator::DefineSyntax(const std::string& name, SpecialFormPtr form) {
+    special_forms_.Register(name, std::move(form));
+}
+
+void Evaluator::SetBudget(const Budget& budget) {
+    budget_ = budget;
+    period_ = 0;
+    ticks_ = 0;
+}
+
+bool Evaluator::Refuel() {
+    budget_.fuel -= period_;
+    period_ = 0;
+    if (budget_.fuel == 0) {
+        Fail(Error::Budget("Out of fuel"));
+        return false;
+    }
+    if (budget_.deadline && Budget::Clock::now() >= *budget_.deadline) {
+        budget_.fuel = 0;
+        Fail(Error::Budget("Deadline exceeded"));
+        return false;
+    }
+    period_ = budget_.deadline ? std::min(budget_.fuel, Budget::kClockPeriod) : budget_.fuel;
+    ticks_ = period_ - 1;
+    return true;
+}
+
+void Evaluator::NoteCachedName(const std::string& name) {
+    if (!cached_names_.insert(name).second) {
+        return;
+    }
+    // Macro expansions refer to globals by alias, so either name may rebind the same global.
+    auto global = Environment::Unalias(name);
+    cached_names_.insert(global ? *global : Environment::GlobalAlias(name));
+}
+
+const TierPolicy& Evaluator::GetTierPolicy() const {
+    return tier_policy_;
+}
+
+void Evaluator::SetTierPolicy(const TierPolicy& policy) {
+    tier_policy_ = policy;
+}
+
+LambdaProcedure* Evaluator::GetCurrentProcedure() const {
+    return current_procedure_;
+}
+
+LambdaProcedure* Evaluator::SetCurrentProcedure(LambdaProcedure* procedure) {
+    return std::exchange(current_procedure_, procedure);
+}
+
+ObjectPtr Evaluator::ScheduleTailCall(Args args) {
+    tail_call_args_.Assign(args);
+    return TailCallMarker();
+}
+
+void Evaluator::TakeTailCallArgs(ArgsBuffer* args) {
+    std::swap(*args, tail_call_args_);
+    tail_call_args_.Clear();
+}
+
+const ObjectPtr& Evaluator::TailCallMarker() {
+    static const ObjectPtr marker = std::make_shared<Object>();
+    return marker;
 }
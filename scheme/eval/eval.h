@@ -1,11 +1,24 @@
 #pragma once
 
+#include "eval/args.h"
+#include "eval/budget.h"
+#include "eval/native_stack.h"
 #include "eval/special_forms.h"
+#include "eval/tier.h"
+#include "runtime/error.h"
 
+#include <cstdint>
+#include <expected>
+#include <limits>
 #include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 class Environment;
+class LambdaProcedure;
 class Object;
+class Procedure;
 
 using ObjectPtr = std::shared_ptr<Object>;
 using EnvPtr = std::shared_ptr<Environment>;
@@ -15,8 +28,105 @@ public:
     Evaluator();
     explicit Evaluator(SpecialFormRegistry special_forms);
 
-    ObjectPtr Eval(const ObjectPtr& expr, const EnvPtr& env);
+    // Value of `expr`, or Failure() with the error recorded by Fail. Syntax errors are thrown.
+    // With `tail` set, `expr` is in tail position of the body of the current procedure, and a call
+    // of that procedure there is scheduled with ScheduleTailCall rather than made, as analyzed
+    // bodies do. Walked bodies thus loop without keeping the environments of earlier iterations.
+    ObjectPtr Eval(const ObjectPtr& expr, const EnvPtr& env, bool tail = false);
+
+    // Eval for an expression in tail position of the special form being evaluated, which is in
+    // tail position of the body if the form is.
+    ObjectPtr EvalInTail(const ObjectPtr& expr, const EnvPtr& env) {
+        return Eval(expr, env, form_tail_);
+    }
+
+    // Value of `expr` or the error evaluating it, syntax errors included.
+    std::expected<ObjectPtr, Error> TryEval(const ObjectPtr& expr, const EnvPtr& env);
+
+    const SpecialFormRegistry& GetSpecialForms() const;
+
+    // Registers the macro `form` as `name` for the code evaluated from now on. Code analyzed
+    // before keeps the forms it was analyzed with.
+    void DefineSyntax(const std::string& name, SpecialFormPtr form);
+
+    // Bumped whenever define or set! changes the binding of a name some inline cache depends on.
+    // Caches keyed on it stay valid for as long as no such binding changes. Code that binds names
+    // by other means must bump it as well.
+    static constexpr uint64_t kNoBindingVersion = std::numeric_limits<uint64_t>::max();
+    uint64_t GetBindingVersion() const {
+        return binding_version_;
+    }
+    void BumpBindingVersion() {
+        ++binding_version_;
+    }
+
+    // Records that a cache depends on what `name` is bound to.
+    void NoteCachedName(const std::string& name);
+
+    // Bumps the binding version if a cache depends on `name`, which define or set! has rebound.
+    // Assignments to local variables of analyzed code, which no cache looks up, skip this.
+    void NoteRebinding(const std::string& name) {
+        if (cached_names_.contains(name)) {
+            BumpBindingVersion();
+        }
+    }
+
+    NativeStack& GetNativeStack() {
+        return native_stack_;
+    }
+
+    // Limits the evaluations from now on to `budget`.
+    void SetBudget(const Budget& budget);
+
+    // Charges one reduction step. Once the budget runs out every call fails with
+    // ErrorCode::Budget and returns false, until a new budget is set.
+    bool Tick() {
+        if (ticks_ != 0) [[likely]] {
+            --ticks_;
+            return true;
+        }
+        return Refuel();
+    }
+
+    const TierPolicy& GetTierPolicy() const;
+    void SetTierPolicy(const TierPolicy& policy);
+
+    // Lambda whose body is being evaluated right now, if any.
+    LambdaProcedure* GetCurrentProcedure() const;
+    LambdaProcedure* SetCurrentProcedure(LambdaProcedure* procedure);
+
+    // Analyzed bodies do not re-enter Apply for a self call in tail position: the arguments are
+    // parked here and TailCallMarker() is returned to the Apply loop instead.
+    ObjectPtr ScheduleTailCall(Args args);
+    void TakeTailCallArgs(ArgsBuffer* args);
+    static const ObjectPtr& TailCallMarker();
+
+    // Exception handlers installed by with-exception-handler and guard on the recursive
+    // evaluator, innermost last. A guard installs nullptr.
+    std::vector<std::shared_ptr<Procedure>>& GetExceptionHandlers() {
+        return exception_handlers_;
+    }
 
 private:
+    bool Refuel();
+
+    // Eval of a call of `head` with the argument expressions `args`. Kept out of Eval, so special
+    // forms, which recursion mostly goes through, do not reserve stack for argument values.
+    [[gnu::noinline]] ObjectPtr EvalApplication(const ObjectPtr& head, const ObjectPtr& args,
+                                                const EnvPtr& env, bool tail);
+
     SpecialFormRegistry special_forms_;
+    TierPolicy tier_policy_;
+    uint64_t binding_version_ = 0;
+    std::unordered_set<std::string> cached_names_;
+    LambdaProcedure* current_procedure_ = nullptr;
+    // Whether the special form being evaluated is in tail position of the body.
+    bool form_tail_ = false;
+    ArgsBuffer tail_call_args_;
+    std::vector<std::shared_ptr<Procedure>> exception_handlers_;
+    NativeStack native_stack_;
+    Budget budget_;
+    // Steps left before Refuel charges them to the budget, out of `period_` granted last time.
+    uint64_t ticks_ = Budget::kUnlimited;
+    uint64_t period_ = Budget::kUnlimited;
 };
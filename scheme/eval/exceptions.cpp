@@ -0,0 +1,405 @@
+#include "eval/exceptions.h"
+
+#include "eval/analyzer.h"
+#include "eval/derived_forms.h"
+#include "eval/eval.h"
+#include "eval/machine.h"
+#include "eval/syntax.h"
+#include "eval/use_cache.h"
+#include "runtime/helpers.h"
+#include "runtime/list_utils.h"
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using ObjectPtr = SpecialForm::ObjectPtr;
+using EnvPtr = SpecialForm::EnvPtr;
+using ProcPtr = std::shared_ptr<Procedure>;
+
+// Error for raising `obj`. Raising an ErrorObject again raises the error it stands for.
+Error ErrorFor(const ObjectPtr& obj) {
+    if (auto error = As<ErrorObject>(obj)) {
+        return error->GetError();
+    }
+    return Error::Raised(obj);
+}
+
+// Takes the error a failure carries, or leaves it and returns nothing if handlers may not catch
+// it.
+std::optional<Error> TakeCatchable() {
+    auto error = TakeError();
+    if (error.GetCode() == ErrorCode::Budget) {
+        Fail(std::move(error));
+        return std::nullopt;
+    }
+    return error;
+}
+
+ObjectPtr HandlerReturned() {
+    return Fail(Error::Runtime("Exception handler returned"));
+}
+
+// Installs `handler` on the recursive evaluator for the life of the scope.
+class HandlerScope {
+public:
+    HandlerScope(Evaluator& evaluator, ProcPtr handler)
+        : handlers_(evaluator.GetExceptionHandlers()) {
+        handlers_.push_back(std::move(handler));
+    }
+
+    ~HandlerScope() {
+        handlers_.pop_back();
+    }
+
+private:
+    std::vector<ProcPtr>& handlers_;
+};
+
+// Takes the innermost handler off the recursive evaluator for the life of the scope.
+class SuspendedHandler {
+public:
+    explicit SuspendedHandler(Evaluator& evaluator)
+        : handlers_(evaluator.GetExceptionHandlers()), handler_(std::move(handlers_.back())) {
+        handlers_.pop_back();
+    }
+
+    ~SuspendedHandler() {
+        handlers_.push_back(std::move(handler_));
+    }
+
+    const ProcPtr& Get() const {
+        return handler_;
+    }
+
+private:
+    std::vector<ProcPtr>& handlers_;
+    ProcPtr handler_;
+};
+
+// Frame of with-exception-handler on the Machine.
+class HandlerFrame : public Frame {
+public:
+    HandlerFrame(ProcPtr handler, EnvPtr env) : handler_(std::move(handler)), env_(std::move(env)) {
+    }
+
+    const ProcPtr& GetHandler() const {
+        return handler_;
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        machine.Return(std::move(value));
+    }
+
+    Ptr Unwind(Machine& machine) const override;
+
+private:
+    ProcPtr handler_;
+    EnvPtr env_;
+};
+
+// Fails once a handler called for a failure returns.
+class HandlerReturnedFrame : public Frame {
+public:
+    void Resume(ObjectPtr, Machine& machine) const override {
+        machine.Return(HandlerReturned());
+    }
+};
+
+Frame::Ptr HandlerFrame::Unwind(Machine& machine) const {
+    auto error = TakeCatchable();
+    if (!error) {
+        return GetNext();
+    }
+    auto condition = MakeCondition(std::move(*error));
+    machine.Push(std::make_shared<HandlerReturnedFrame>());
+    machine.Apply(handler_, Args{&condition, 1}, env_);
+    return nullptr;
+}
+
+// Continuation of a raise-continuable while its handler runs. The handlers in effect, and the
+// frames errors unwind through, are the ones below `outer`, where the handler was installed.
+class RaiseFrame : public Frame {
+public:
+    explicit RaiseFrame(Ptr outer) : outer_(std::move(outer)) {
+    }
+
+    const Ptr& GetOuter() const {
+        return outer_;
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        machine.Return(std::move(value));
+    }
+
+    Ptr Unwind(Machine&) const override {
+        return outer_;
+    }
+
+private:
+    Ptr outer_;
+};
+
+// `(guard (var clause...) body...)`. The clauses are kept as a cond expression that ends in an
+// else clause returning NoClauseMatched(), unless the guard has an else clause of its own.
+struct Guard {
+    std::string var;
+    ObjectPtr clauses;
+    ObjectPtr body;
+};
+
+using GuardPtr = std::shared_ptr<const Guard>;
+
+const ObjectPtr& NoClauseMatched() {
+    static const ObjectPtr marker = std::make_shared<Object>();
+    return marker;
+}
+
+bool IsElseClause(const ObjectPtr& clause) {
+    auto cell = As<Cell>(clause);
+    auto head = cell ? As<Symbol>(cell->GetFirst()) : nullptr;
+    return head && head->GetName() == "else";
+}
+
+GuardPtr ParseGuard(const ObjectPtr& args) {
+    auto form = As<Cell>(args);
+    auto spec = form ? As<Cell>(form->GetFirst()) : nullptr;
+    auto var = spec ? As<Symbol>(spec->GetFirst()) : nullptr;
+    if (!var || !Is<Cell>(form->GetSecond()) || !listutils::IsProperList(form->GetSecond())) {
+        throw SyntaxError{""};
+    }
+    auto clauses = syntax::ToVectorOrSyntaxError(spec->GetSecond());
+    if (clauses.empty() || !IsElseClause(clauses.back())) {
+        auto quoted = std::make_shared<Cell>(
+            std::make_shared<Symbol>("quote"), std::make_shared<Cell>(NoClauseMatched(), nullptr));
+        clauses.push_back(std::make_shared<Cell>(
+            std::make_shared<Symbol>("else"), std::make_shared<Cell>(std::move(quoted), nullptr)));
+    }
+    auto cond = std::make_shared<Cell>(std::make_shared<Symbol>("cond"),
+                                       listutils::FromVector(clauses));
+    return std::make_shared<const Guard>(Guard{var->GetName(), std::move(cond), form->GetSecond()});
+}
+
+// Environment the clauses of `guard` run in, for the error the body failed with.
+EnvPtr BindCondition(const Guard& guard, Error error, const EnvPtr& env) {
+    auto clause_env = std::make_shared<Environment>(env);
+    clause_env->Define(guard.var, MakeCondition(std::move(error)));
+    return clause_env;
+}
+
+// Result of a guard whose clauses evaluated to `value` for `error`.
+ObjectPtr FinishGuard(ObjectPtr value, Error error) {
+    if (value == NoClauseMatched()) {
+        return Fail(std::move(error));
+    }
+    return value;
+}
+
+class GuardNode : public Node {
+public:
+    GuardNode(GuardPtr guard, NodePtr body, NodePtr clauses)
+        : guard_(std::move(guard)), body_(std::move(body)), clauses_(std::move(clauses)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        ObjectPtr value;
+        {
+            HandlerScope scope(evaluator, nullptr);
+            value = body_->Eval(env, evaluator);
+        }
+        if (!IsFailure(value)) {
+            return value;
+        }
+        auto error = TakeCatchable();
+        if (!error) {
+            return value;
+        }
+        auto clause_env = BindCondition(*guard_, *error, env);
+        return FinishGuard(clauses_->Eval(clause_env, evaluator), std::move(*error));
+    }
+
+private:
+    GuardPtr guard_;
+    NodePtr body_;
+    NodePtr clauses_;
+};
+
+// Passes on the value of the clauses of a guard on the Machine.
+class GuardClausesFrame : public Frame {
+public:
+    explicit GuardClausesFrame(Error error) : error_(std::move(error)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        machine.Return(FinishGuard(std::move(value), error_));
+    }
+
+private:
+    Error error_;
+};
+
+class GuardFrame : public Frame {
+public:
+    GuardFrame(GuardPtr guard, EnvPtr env) : guard_(std::move(guard)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        machine.Return(std::move(value));
+    }
+
+    Ptr Unwind(Machine& machine) const override {
+        auto error = TakeCatchable();
+        if (!error) {
+            return GetNext();
+        }
+        auto clause_env = BindCondition(*guard_, *error, env_);
+        machine.Push(std::make_shared<GuardClausesFrame>(std::move(*error)));
+        machine.Eval(guard_->clauses, std::move(clause_env));
+        return nullptr;
+    }
+
+private:
+    GuardPtr guard_;
+    EnvPtr env_;
+};
+
+class GuardForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        auto guard = GetGuard(args);
+        ObjectPtr value;
+        {
+            HandlerScope scope(evaluator, nullptr);
+            value = EvalSequence(guard->body, env, evaluator, false);
+        }
+        if (!IsFailure(value)) {
+            return value;
+        }
+        auto error = TakeCatchable();
+        if (!error) {
+            return value;
+        }
+        auto clause_env = BindCondition(*guard, *error, env);
+        return FinishGuard(evaluator.Eval(guard->clauses, clause_env), std::move(*error));
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        auto guard = GetGuard(args);
+        auto body = analyzer.AnalyzeBody(syntax::ToVectorOrSyntaxError(guard->body), false);
+        std::vector<ObjectPtr> clauses{guard->clauses};
+        auto scope = Scope::ForLambda({guard->var}, clauses, analyzer.GetScope(),
+                                      analyzer.GetSpecialForms());
+        auto clauses_node = analyzer.AnalyzeBodyIn(std::move(scope), clauses, tail);
+        return std::make_shared<GuardNode>(std::move(guard), std::move(body),
+                                           std::move(clauses_node));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        auto guard = GetGuard(args);
+        const auto& body = guard->body;
+        machine.Push(std::make_shared<GuardFrame>(std::move(guard), env));
+        StepSequence(body, env, machine);
+    }
+
+private:
+    GuardPtr GetGuard(const ObjectPtr& args) {
+        return guards_.Get(args, ParseGuard);
+    }
+
+    UseCache<GuardPtr> guards_;
+};
+
+}  // namespace
+
+std::shared_ptr<Object> MakeCondition(Error error) {
+    if (error.IsRaised()) {
+        return error.GetPayload();
+    }
+    return std::make_shared<ErrorObject>(std::move(error));
+}
+
+Procedure::ObjectPtr Raise::Apply(Args args, const EnvPtr& env, Evaluator& evaluator) {
+    if (!helpers::RequireArgsCount(args, 1)) {
+        return Failure();
+    }
+    const auto& handlers = evaluator.GetExceptionHandlers();
+    if (!continuable_ || handlers.empty() || !handlers.back()) {
+        return Fail(ErrorFor(args[0]));
+    }
+    SuspendedHandler handler(evaluator);
+    return handler.Get()->Apply(args, env, evaluator);
+}
+
+Procedure::ObjectPtr WithExceptionHandler::Apply(Args args, const EnvPtr& env,
+                                                 Evaluator& evaluator) {
+    if (!helpers::RequireArgsCount(args, 2)) {
+        return Failure();
+    }
+    auto handler = As<Procedure>(args[0]);
+    auto thunk = As<Procedure>(args[1]);
+    if (!handler || !thunk) {
+        return Fail(Error::Runtime("Not a procedure"));
+    }
+    ObjectPtr value;
+    {
+        HandlerScope scope(evaluator, handler);
+        value = thunk->Apply({}, env, evaluator);
+    }
+    if (!IsFailure(value)) {
+        return value;
+    }
+    auto error = TakeCatchable();
+    if (!error) {
+        return value;
+    }
+    auto condition = MakeCondition(std::move(*error));
+    value = handler->Apply(Args{&condition, 1}, env, evaluator);
+    return IsFailure(value) ? value : HandlerReturned();
+}
+
+void StepRaiseContinuable(Args args, const EnvPtr& env, Machine& machine) {
+    if (!helpers::RequireArgsCount(args, 1)) {
+        machine.Return(Failure());
+        return;
+    }
+    const auto* frame = machine.GetContinuation().get();
+    while (frame) {
+        if (auto* raise = dynamic_cast<const RaiseFrame*>(frame)) {
+            frame = raise->GetOuter().get();
+            continue;
+        }
+        if (auto* handler = dynamic_cast<const HandlerFrame*>(frame)) {
+            machine.Push(std::make_shared<RaiseFrame>(handler->GetNext()));
+            machine.Apply(handler->GetHandler(), args, env);
+            return;
+        }
+        if (dynamic_cast<const GuardFrame*>(frame)) {
+            break;
+        }
+        frame = frame->GetNext().get();
+    }
+    machine.Return(Fail(ErrorFor(args[0])));
+}
+
+void StepWithExceptionHandler(Args args, const EnvPtr& env, Machine& machine) {
+    if (!helpers::RequireArgsCount(args, 2)) {
+        machine.Return(Failure());
+        return;
+    }
+    auto handler = As<Procedure>(args[0]);
+    auto thunk = As<Procedure>(args[1]);
+    if (!handler || !thunk) {
+        machine.Return(Fail(Error::Runtime("Not a procedure")));
+        return;
+    }
+    machine.Push(std::make_shared<HandlerFrame>(std::move(handler), env));
+    machine.Apply(thunk, {}, env);
+}
+
+void RegisterExceptionForms(SpecialFormRegistry* registry) {
+    registry->Register("guard", std::make_shared<GuardForm>());
+}
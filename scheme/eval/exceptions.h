@@ -0,0 +1,68 @@
+#pragma once
+
+#include "eval/args.h"
+#include "eval/procedure.h"
+#include "eval/special_forms.h"
+#include "runtime/error.h"
+
+#include <memory>
+
+// Exceptions travel as errors do: raise records Error::Raised with Fail and returns Failure(),
+// which every caller passes on until a guard or with-exception-handler takes it. Code that raises
+// nothing runs exactly as before, and catching unwinds by plain returns on the recursive
+// evaluator and by popping frames on the Machine, never through C++ exceptions. Errors of the
+// evaluator itself are caught the same way; running out of budget is not.
+
+// What handlers get for errors the script did not raise itself, such as a builtin given an
+// argument of the wrong type.
+class ErrorObject final : public Object {
+public:
+    explicit ErrorObject(Error error) : error_(std::move(error)) {
+    }
+
+    const Error& GetError() const {
+        return error_;
+    }
+
+private:
+    Error error_;
+};
+
+// Object handed to handlers for `error`: the raised object, or an ErrorObject.
+std::shared_ptr<Object> MakeCondition(Error error);
+
+// raise, or raise-continuable when `continuable` is set. raise-continuable calls the innermost
+// handler in place, with the handlers outside of it installed, and returns what it returns; with
+// a guard innermost or no handler it fails like raise. The Machine applies raise-continuable
+// itself.
+class Raise final : public Procedure {
+public:
+    explicit Raise(bool continuable) : continuable_(continuable) {
+    }
+
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override;
+
+    bool IsContinuable() const {
+        return continuable_;
+    }
+
+private:
+    bool continuable_;
+};
+
+// with-exception-handler. Calls the thunk with the handler installed. An error the thunk fails
+// with reaches the handler after the thunk unwound; as raise is not continuable, the handler
+// returning is an error of its own. The Machine applies it itself.
+class WithExceptionHandler final : public Procedure {
+public:
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override;
+};
+
+// The Machine's raise-continuable and with-exception-handler, whose handlers are frames of its
+// continuation, so continuations captured inside them keep them.
+void StepRaiseContinuable(Args args, const Procedure::EnvPtr& env, Machine& machine);
+void StepWithExceptionHandler(Args args, const Procedure::EnvPtr& env, Machine& machine);
+
+// guard, as `(guard (var clause...) body...)` with the clauses of cond. Errors the body fails
+// with bind `var` and go through the clauses; with none matching, the error is raised again.
+void RegisterExceptionForms(SpecialFormRegistry* registry);
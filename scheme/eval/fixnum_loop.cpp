@@ -0,0 +1,403 @@
+#include "eval/fixnum_loop.h"
+
+#include "eval/procedure.h"
+#include "runtime/env.h"
+#include "runtime/error.h"
+#include "runtime/list_utils.h"
+#include "runtime/object.h"
+
+#include <array>
+#include <unordered_map>
+#include <utility>
+
+// Integer or comparison computed from unboxed parameter values. Comparisons yield 0 or 1.
+class FixnumNode {
+public:
+    virtual ~FixnumNode() = default;
+
+    // False when the result does not fit in int64_t.
+    virtual bool Eval(const int64_t* slots, int64_t* out) const = 0;
+};
+
+using FixnumNodePtr = std::unique_ptr<FixnumNode>;
+
+// Tail position of the body: either returns a value, runs the next iteration or branches.
+struct FixnumTail {
+    enum class Kind { Return, Loop, Branch };
+    enum class Type { Int, Bool };
+
+    Kind kind;
+    Type type = Type::Int;
+    FixnumNodePtr value;
+    std::vector<FixnumNodePtr> args;
+    std::unique_ptr<FixnumTail> then_branch;
+    std::unique_ptr<FixnumTail> else_branch;
+};
+
+namespace {
+
+using ObjectPtr = FixnumLoop::ObjectPtr;
+using EnvPtr = FixnumLoop::EnvPtr;
+using Type = FixnumTail::Type;
+
+class ConstantFixnum : public FixnumNode {
+public:
+    explicit ConstantFixnum(int64_t value) : value_(value) {
+    }
+
+    bool Eval(const int64_t*, int64_t* out) const override {
+        *out = value_;
+        return true;
+    }
+
+private:
+    int64_t value_;
+};
+
+class ParamFixnum : public FixnumNode {
+public:
+    explicit ParamFixnum(size_t slot) : slot_(slot) {
+    }
+
+    bool Eval(const int64_t* slots, int64_t* out) const override {
+        *out = slots[slot_];
+        return true;
+    }
+
+private:
+    size_t slot_;
+};
+
+class ArithmeticFixnum : public FixnumNode {
+public:
+    ArithmeticFixnum(Primitive primitive, std::vector<FixnumNodePtr> operands)
+        : primitive_(primitive), operands_(std::move(operands)) {
+    }
+
+    bool Eval(const int64_t* slots, int64_t* out) const override {
+        if (primitive_ == Primitive::Sub && operands_.size() == 1) {
+            int64_t value;
+            return operands_[0]->Eval(slots, &value) && !__builtin_sub_overflow(0, value, out);
+        }
+        int64_t acc = primitive_ == Primitive::Mul ? 1 : 0;
+        for (size_t i = 0; i < operands_.size(); ++i) {
+            int64_t value;
+            if (!operands_[i]->Eval(slots, &value)) {
+                return false;
+            }
+            bool overflow = false;
+            if (primitive_ == Primitive::Mul) {
+                overflow = __builtin_mul_overflow(acc, value, &acc);
+            } else if (primitive_ == Primitive::Sub && i > 0) {
+                overflow = __builtin_sub_overflow(acc, value, &acc);
+            } else {
+                overflow = __builtin_add_overflow(acc, value, &acc);
+            }
+            if (overflow) {
+                return false;
+            }
+        }
+        *out = acc;
+        return true;
+    }
+
+private:
+    Primitive primitive_;
+    std::vector<FixnumNodePtr> operands_;
+};
+
+class CompareFixnum : public FixnumNode {
+public:
+    CompareFixnum(Primitive primitive, std::vector<FixnumNodePtr> operands)
+        : primitive_(primitive), operands_(std::move(operands)) {
+    }
+
+    bool Eval(const int64_t* slots, int64_t* out) const override {
+        int64_t prev = 0;
+        *out = 1;
+        for (size_t i = 0; i < operands_.size(); ++i) {
+            int64_t cur;
+            if (!operands_[i]->Eval(slots, &cur)) {
+                return false;
+            }
+            if (i > 0 && *out && !Holds(prev, cur)) {
+                *out = 0;
+            }
+            prev = cur;
+        }
+        return true;
+    }
+
+private:
+    bool Holds(int64_t lhs, int64_t rhs) const {
+        switch (primitive_) {
+            case Primitive::Eq:
+                return lhs == rhs;
+            case Primitive::Lt:
+                return lhs < rhs;
+            case Primitive::Gt:
+                return lhs > rhs;
+            case Primitive::Le:
+                return lhs <= rhs;
+            default:
+                return lhs >= rhs;
+        }
+    }
+
+    Primitive primitive_;
+    std::vector<FixnumNodePtr> operands_;
+};
+
+// Infers the types of a lambda body and builds its fixnum code, failing on anything else.
+class FixnumCompiler {
+public:
+    FixnumCompiler(const LambdaCode& code, const SpecialFormRegistry& forms,
+                   const Scope::Ptr& scope, const EnvPtr& closure)
+        : code_(code), forms_(forms), scope_(scope), closure_(closure),
+          optimizer_(forms, scope, closure) {
+        const auto& params = code.GetParams();
+        for (size_t i = 0; i < params.size(); ++i) {
+            slots_.emplace(params[i], i);
+        }
+    }
+
+    std::unique_ptr<FixnumTail> CompileTail(const ObjectPtr& expr) {
+        std::vector<ObjectPtr> items;
+        if (IsCall(expr, &items)) {
+            auto name = As<Symbol>(items[0])->GetName();
+            if (name == "if" && forms_.Lookup(name)) {
+                return CompileIf(items);
+            }
+            if (IsSelf(name)) {
+                return CompileLoop(items);
+            }
+        }
+        auto tail = std::make_unique<FixnumTail>(FixnumTail::Kind::Return);
+        tail->value = Compile(expr, &tail->type);
+        return tail->value ? std::move(tail) : nullptr;
+    }
+
+    std::vector<Assumption> TakeAssumptions() {
+        return std::move(assumptions_);
+    }
+
+private:
+    std::unique_ptr<FixnumTail> CompileIf(const std::vector<ObjectPtr>& items) {
+        if (items.size() != 4) {
+            return nullptr;
+        }
+        auto tail = std::make_unique<FixnumTail>(FixnumTail::Kind::Branch);
+        tail->value = Compile(items[1], &tail->type);
+        if (!tail->value || tail->type != Type::Bool) {
+            return nullptr;
+        }
+        tail->then_branch = CompileTail(items[2]);
+        tail->else_branch = CompileTail(items[3]);
+        if (!tail->then_branch || !tail->else_branch) {
+            return nullptr;
+        }
+        return tail;
+    }
+
+    std::unique_ptr<FixnumTail> CompileLoop(const std::vector<ObjectPtr>& items) {
+        if (items.size() != slots_.size() + 1) {
+            return nullptr;
+        }
+        auto tail = std::make_unique<FixnumTail>(FixnumTail::Kind::Loop);
+        for (size_t i = 1; i < items.size(); ++i) {
+            auto arg = CompileInt(items[i]);
+            if (!arg) {
+                return nullptr;
+            }
+            tail->args.push_back(std::move(arg));
+        }
+        return tail;
+    }
+
+    FixnumNodePtr Compile(const ObjectPtr& expr, Type* type) {
+        *type = Type::Int;
+        if (auto number = As<Number>(expr)) {
+            return std::make_unique<ConstantFixnum>(number->GetValue());
+        }
+        if (auto boolean = As<Boolean>(expr)) {
+            *type = Type::Bool;
+            return std::make_unique<ConstantFixnum>(boolean->GetValue());
+        }
+        if (auto symbol = As<Symbol>(expr)) {
+            auto it = slots_.find(symbol->GetName());
+            if (it == slots_.end()) {
+                return nullptr;
+            }
+            return std::make_unique<ParamFixnum>(it->second);
+        }
+        std::vector<ObjectPtr> items;
+        if (!IsCall(expr, &items)) {
+            return nullptr;
+        }
+        auto name = As<Symbol>(items[0])->GetName();
+        auto primitive = optimizer_.Speculate(name);
+        std::vector<FixnumNodePtr> operands;
+        for (size_t i = 1; i < items.size(); ++i) {
+            auto operand = CompileInt(items[i]);
+            if (!operand) {
+                return nullptr;
+            }
+            operands.push_back(std::move(operand));
+        }
+        switch (primitive) {
+            case Primitive::Sub:
+                if (operands.empty()) {
+                    return nullptr;
+                }
+                [[fallthrough]];
+            case Primitive::Add:
+            case Primitive::Mul:
+                assumptions_.push_back({name, primitive});
+                return std::make_unique<ArithmeticFixnum>(primitive, std::move(operands));
+            case Primitive::Eq:
+            case Primitive::Lt:
+            case Primitive::Gt:
+            case Primitive::Le:
+            case Primitive::Ge:
+                assumptions_.push_back({name, primitive});
+                *type = Type::Bool;
+                return std::make_unique<CompareFixnum>(primitive, std::move(operands));
+            default:
+                return nullptr;
+        }
+    }
+
+    FixnumNodePtr CompileInt(const ObjectPtr& expr) {
+        Type type;
+        auto node = Compile(expr, &type);
+        return type == Type::Int ? std::move(node) : nullptr;
+    }
+
+    bool IsCall(const ObjectPtr& expr, std::vector<ObjectPtr>* items) const {
+        if (!Is<Cell>(expr) || !listutils::IsProperList(expr)) {
+            return false;
+        }
+        *items = listutils::ToVector(expr);
+        auto head = As<Symbol>(items->front());
+        return head && !slots_.contains(head->GetName());
+    }
+
+    // Whether `name` calls the lambda being compiled, i.e. is its self name or refers to a
+    // procedure sharing its code.
+    bool IsSelf(const std::string& name) {
+        if (name == code_.GetSelf() && scope_->IsImmutable(name)) {
+            return true;
+        }
+        if (scope_ && scope_->Binds(name)) {
+            return false;
+        }
+        auto* value = closure_->Find(name);
+        auto proc = value ? As<LambdaProcedure>(*value) : nullptr;
+        if (!proc || proc->GetCode().get() != &code_) {
+            return false;
+        }
+        assumptions_.push_back({name, Primitive::None, proc});
+        return true;
+    }
+
+    const LambdaCode& code_;
+    const SpecialFormRegistry& forms_;
+    const Scope::Ptr& scope_;
+    const EnvPtr& closure_;
+    Optimizer optimizer_;
+    std::unordered_map<std::string, size_t> slots_;
+    std::vector<Assumption> assumptions_;
+};
+
+}  // namespace
+
+std::unique_ptr<FixnumLoop> FixnumLoop::Compile(const LambdaCode& code,
+                                                const SpecialFormRegistry& forms,
+                                                const Scope::Ptr& scope, const EnvPtr& closure) {
+    const auto& params = code.GetParams();
+    const auto& body = code.GetBody();
+    if (params.size() > kMaxParams || code.GetRest() || body.size() != 1) {
+        return nullptr;
+    }
+    for (const auto& param : params) {
+        if (forms.Lookup(param)) {
+            return nullptr;
+        }
+    }
+    FixnumCompiler compiler(code, forms, scope, closure);
+    auto tail = compiler.CompileTail(body.front());
+    if (!tail) {
+        return nullptr;
+    }
+    return std::unique_ptr<FixnumLoop>(
+        new FixnumLoop(params.size(), std::move(tail), compiler.TakeAssumptions()));
+}
+
+FixnumLoop::FixnumLoop(size_t params, std::unique_ptr<FixnumTail> body,
+                       std::vector<Assumption> assumptions)
+    : params_(params), body_(std::move(body)), assumptions_(std::move(assumptions)) {
+}
+
+FixnumLoop::~FixnumLoop() = default;
+
+std::optional<FixnumLoop::ObjectPtr> FixnumLoop::Run(Args args, const EnvPtr& closure,
+                                                     Evaluator& evaluator, ArgsVec* deopt_args,
+                                                     uint64_t* iterations) {
+    if (version_ != evaluator.GetBindingVersion()) {
+        holds_ = Optimizer::Holds(assumptions_, closure, evaluator);
+        version_ = evaluator.GetBindingVersion();
+    }
+    if (!holds_ || args.size() != params_) {
+        return std::nullopt;
+    }
+    std::array<int64_t, kMaxParams> slots;
+    for (size_t i = 0; i < params_; ++i) {
+        auto number = As<Number>(args[i]);
+        if (!number) {
+            return std::nullopt;
+        }
+        slots[i] = number->GetValue();
+    }
+
+    std::array<int64_t, kMaxParams> next;
+    for (;;) {
+        if (!evaluator.Tick()) {
+            return Failure();
+        }
+        const auto* tail = body_.get();
+        int64_t value;
+        while (tail->kind == FixnumTail::Kind::Branch) {
+            if (!tail->value->Eval(slots.data(), &value)) {
+                break;
+            }
+            tail = value ? tail->then_branch.get() : tail->else_branch.get();
+        }
+        if (tail->kind == FixnumTail::Kind::Return) {
+            if (!tail->value->Eval(slots.data(), &value)) {
+                break;
+            }
+            if (tail->type == Type::Bool) {
+                return MakeBool(value);
+            }
+            return std::make_shared<Number>(value);
+        }
+        if (tail->kind != FixnumTail::Kind::Loop) {
+            break;
+        }
+        size_t i = 0;
+        while (i < params_ && tail->args[i]->Eval(slots.data(), &next[i])) {
+            ++i;
+        }
+        if (i < params_) {
+            break;
+        }
+        slots = next;
+        ++*iterations;
+    }
+
+    deopt_args->clear();
+    for (size_t i = 0; i < params_; ++i) {
+        deopt_args->push_back(std::make_shared<Number>(slots[i]));
+    }
+    return std::nullopt;
+}
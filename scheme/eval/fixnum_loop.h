@@ -0,0 +1,57 @@
+#pragma once
+
+#include "eval/analyzer.h"
+#include "eval/args.h"
+#include "eval/eval.h"
+#include "eval/optimizer.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class Environment;
+class LambdaCode;
+class Object;
+
+struct FixnumTail;
+
+// Hot lambda body that only does integer arithmetic on its parameters, compiled to code working
+// on unboxed int64_t values. Type inference proves that every parameter and every intermediate
+// result is a fixnum or a comparison result: the body must be an if/self-call/return tree whose
+// expressions are integer literals, parameters and calls of the arithmetic and comparison
+// builtins. Self calls in tail position run as iterations over values kept on the C++ stack, so
+// counting and accumulating loops allocate nothing but their final result.
+class FixnumLoop {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+    using EnvPtr = std::shared_ptr<Environment>;
+    using ArgsVec = std::vector<ObjectPtr>;
+
+    static constexpr size_t kMaxParams = 8;
+
+    // Nullptr unless the body of `code` fits. Free names are resolved in `closure`.
+    static std::unique_ptr<FixnumLoop> Compile(const LambdaCode& code,
+                                               const SpecialFormRegistry& forms,
+                                               const Scope::Ptr& scope, const EnvPtr& closure);
+
+    ~FixnumLoop();
+
+    // Result of applying the lambda to `args`. Empty when the arguments are not all numbers,
+    // when a builtin the body relies on was rebound or when an operation overflows. In the last
+    // case `deopt_args` receives the arguments of the iteration that overflowed, which the caller
+    // resumes with on the generic path. `iterations` counts the self calls made. Each iteration
+    // is charged to the evaluation budget; once it runs out the result is Failure().
+    std::optional<ObjectPtr> Run(Args args, const EnvPtr& closure, Evaluator& evaluator,
+                                 ArgsVec* deopt_args, uint64_t* iterations);
+
+private:
+    FixnumLoop(size_t params, std::unique_ptr<FixnumTail> body,
+               std::vector<Assumption> assumptions);
+
+    size_t params_;
+    std::unique_ptr<FixnumTail> body_;
+    std::vector<Assumption> assumptions_;
+    uint64_t version_ = Evaluator::kNoBindingVersion;
+    bool holds_ = false;
+};
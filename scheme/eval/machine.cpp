@@ -0,0 +1,397 @@
+#include "eval/machine.h"
+
+#include "eval/continuation.h"
+#include "eval/eval.h"
+#include "eval/exceptions.h"
+#include "eval/procedure.h"
+#include "eval/promise.h"
+#include "eval/special_forms.h"
+#include "eval/values.h"
+#include "runtime/env.h"
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+#include "runtime/object.h"
+
+#include <utility>
+
+namespace {
+
+using ObjectPtr = Machine::ObjectPtr;
+using EnvPtr = Machine::EnvPtr;
+
+// Bottom of every machine continuation. Run stops instead of returning to it.
+class HaltFrame : public Frame {
+public:
+    void Resume(ObjectPtr, Machine&) const override {
+    }
+};
+
+const Frame::Ptr& Halt() {
+    static const Frame::Ptr halt = std::make_shared<HaltFrame>();
+    return halt;
+}
+
+// Stores the value of `expr` in `value` if it takes no steps to compute: constants and variables.
+// An unbound variable stores Failure().
+bool TryEvalAtomic(const ObjectPtr& expr, const EnvPtr& env, ObjectPtr* value) {
+    if (dynamic_cast<const Number*>(expr.get()) || dynamic_cast<const Boolean*>(expr.get())) {
+        *value = expr;
+        return true;
+    }
+    if (auto* symbol = dynamic_cast<const Symbol*>(expr.get())) {
+        auto* slot = env->Find(symbol->GetName());
+        *value = slot ? *slot : Fail(Error::Name(symbol->GetName()));
+        return true;
+    }
+    return false;
+}
+
+// False if `value` is not one value, or is the head of the call and not a procedure.
+bool AddEvaluated(ArgsBuffer* evaluated, ObjectPtr value) {
+    value = OneValue(std::move(value));
+    if (IsFailure(value)) {
+        return false;
+    }
+    if (evaluated->Size() == 0 && !Is<Procedure>(value)) {
+        Fail(Error::Runtime("Not a procedure"));
+        return false;
+    }
+    evaluated->Push(std::move(value));
+    return true;
+}
+
+void ContinueApplication(Machine& machine, ObjectPtr pending, ArgsBuffer evaluated,
+                         const EnvPtr& env);
+
+// Call whose head and arguments are evaluated left to right. Holds its own copy of the values
+// evaluated so far, so resuming it again through a captured continuation starts from them.
+class ApplicationFrame : public Frame {
+public:
+    ApplicationFrame(ObjectPtr pending, ArgsBuffer evaluated, EnvPtr env)
+        : pending_(std::move(pending)), evaluated_(std::move(evaluated)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        auto evaluated = evaluated_;
+        if (!AddEvaluated(&evaluated, std::move(value))) {
+            machine.Return(Failure());
+            return;
+        }
+        ContinueApplication(machine, pending_, std::move(evaluated), env_);
+    }
+
+private:
+    ObjectPtr pending_;
+    ArgsBuffer evaluated_;
+    EnvPtr env_;
+};
+
+// Evaluates the rest of a call, `pending`, after the values in `evaluated`. Constants and
+// variables are evaluated in place; only other expressions take a frame and a step.
+void ContinueApplication(Machine& machine, ObjectPtr pending, ArgsBuffer evaluated,
+                         const EnvPtr& env) {
+    while (pending) {
+        auto cell = As<Cell>(pending);
+        if (!cell) {
+            machine.Return(Fail(Error::Runtime("Expected proper list")));
+            return;
+        }
+        ObjectPtr value;
+        if (!TryEvalAtomic(cell->GetFirst(), env, &value)) {
+            machine.Push(
+                std::make_shared<ApplicationFrame>(cell->GetSecond(), std::move(evaluated), env));
+            machine.Eval(cell->GetFirst(), env);
+            return;
+        }
+        if (IsFailure(value) || !AddEvaluated(&evaluated, std::move(value))) {
+            machine.Return(Failure());
+            return;
+        }
+        pending = cell->GetSecond();
+    }
+    auto values = evaluated.Get();
+    machine.Apply(std::static_pointer_cast<Procedure>(values[0]), values.subspan(1), env);
+}
+
+class BodyFrame : public Frame {
+public:
+    BodyFrame(LambdaCodePtr code, size_t index, EnvPtr env)
+        : code_(std::move(code)), index_(index), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr, Machine& machine) const override {
+        machine.EvalBody(code_, index_, env_);
+    }
+
+private:
+    LambdaCodePtr code_;
+    size_t index_;
+    EnvPtr env_;
+};
+
+// Ends the extent of an escape continuation when its receiver returns normally.
+class ExtentFrame : public Frame {
+public:
+    explicit ExtentFrame(std::shared_ptr<Continuation> continuation)
+        : continuation_(std::move(continuation)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        continuation_->Expire();
+        machine.Return(std::move(value));
+    }
+
+    Ptr Unwind(Machine&) const override {
+        continuation_->Expire();
+        return GetNext();
+    }
+
+private:
+    std::shared_ptr<Continuation> continuation_;
+};
+
+// Applies the consumer of a call-with-values to the values of its producer.
+class ValuesFrame : public Frame {
+public:
+    ValuesFrame(std::shared_ptr<Procedure> consumer, EnvPtr env)
+        : consumer_(std::move(consumer)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        ArgsBuffer values;
+        TakeValues(std::move(value), &values);
+        machine.Apply(consumer_, values.Get(), env_);
+    }
+
+private:
+    std::shared_ptr<Procedure> consumer_;
+    EnvPtr env_;
+};
+
+}  // namespace
+
+Frame::~Frame() {
+    auto next = std::move(next_);
+    while (next && next.use_count() == 1) {
+        next = std::move(next->next_);
+    }
+}
+
+Frame::Ptr Frame::Unwind(Machine&) const {
+    return next_;
+}
+
+Machine::Machine(Evaluator& evaluator) : evaluator_(evaluator) {
+}
+
+Machine::ObjectPtr Machine::Run(const ObjectPtr& expr, const EnvPtr& env) {
+    Start(expr, env);
+    return Continue();
+}
+
+void Machine::Start(ObjectPtr expr, EnvPtr env) {
+    continuation_ = Halt();
+    Eval(std::move(expr), std::move(env));
+}
+
+Machine::ObjectPtr Machine::Continue() {
+    if (returning_ && value_ == MultipleValues()) {
+        value_ = ReturnValues(paused_values_.Get());
+        paused_values_.Clear();
+    }
+    for (;;) {
+        try {
+            while (!returning_ || continuation_ != Halt()) {
+                if (returning_ && IsFailure(value_)) {
+                    if (Unwind()) {
+                        continue;
+                    }
+                    // No frame handled the error: abandons the rest of the computation.
+                    break;
+                }
+                if (!evaluator_.Tick()) {
+                    if (returning_ && value_ == MultipleValues()) {
+                        TakeValues(value_, &paused_values_);
+                    }
+                    return Failure();
+                }
+                Step();
+            }
+            break;
+        } catch (const ContinuationInvoked& invoked) {
+            const auto& frames = invoked.GetContinuation()->GetFrames();
+            if (!frames) {
+                throw;
+            }
+            Resume(frames, invoked.GetValue());
+        }
+    }
+    continuation_.reset();
+    returning_ = false;
+    return std::move(value_);
+}
+
+bool Machine::Unwind() {
+    auto frames = std::move(continuation_);
+    while (frames != Halt()) {
+        continuation_ = frames->next_;
+        frames = frames->Unwind(*this);
+        if (!frames) {
+            return true;
+        }
+    }
+    continuation_ = Halt();
+    return false;
+}
+
+void Machine::Eval(ObjectPtr expr, EnvPtr env) {
+    expr_ = std::move(expr);
+    env_ = std::move(env);
+    returning_ = false;
+}
+
+void Machine::Return(ObjectPtr value) {
+    value_ = std::move(value);
+    returning_ = true;
+}
+
+void Machine::Push(std::shared_ptr<Frame> frame) {
+    frame->next_ = std::move(continuation_);
+    continuation_ = std::move(frame);
+}
+
+void Machine::Apply(const ProcPtr& proc, Args args, const EnvPtr& env) {
+    if (auto* lambda = dynamic_cast<LambdaProcedure*>(proc.get())) {
+        const auto& code = lambda->GetCode();
+        auto call_env = std::make_shared<Environment>(lambda->GetClosure());
+        if (!code->BindArgs(args, *lambda, call_env.get(), evaluator_.GetSpecialForms())) {
+            Return(Failure());
+            return;
+        }
+        EvalBody(code, 0, call_env);
+        return;
+    }
+    if (auto* continuation = dynamic_cast<Continuation*>(proc.get())) {
+        if (continuation->GetFrames()) {
+            if (!helpers::RequireArgsCount(args, 1) || !continuation->Enter()) {
+                Return(Failure());
+                return;
+            }
+            Resume(continuation->GetFrames(), args[0]);
+            return;
+        }
+    }
+    if (auto* call = dynamic_cast<CallWithContinuation*>(proc.get())) {
+        if (!helpers::RequireArgsCount(args, 1)) {
+            Return(Failure());
+            return;
+        }
+        auto receiver = As<Procedure>(args[0]);
+        if (!receiver) {
+            Return(Fail(Error::Runtime("Not a procedure")));
+            return;
+        }
+        auto continuation = std::make_shared<Continuation>(continuation_, call->IsEscapeOnly());
+        if (call->IsEscapeOnly()) {
+            Push(std::make_shared<ExtentFrame>(continuation));
+        }
+        ObjectPtr arg = std::move(continuation);
+        Apply(receiver, Args{&arg, 1}, env);
+        return;
+    }
+    if (auto* raise = dynamic_cast<Raise*>(proc.get()); raise && raise->IsContinuable()) {
+        StepRaiseContinuable(args, env, *this);
+        return;
+    }
+    if (dynamic_cast<WithExceptionHandler*>(proc.get())) {
+        StepWithExceptionHandler(args, env, *this);
+        return;
+    }
+    if (dynamic_cast<ApplyProcedure*>(proc.get())) {
+        ArgsBuffer spread;
+        auto callee = ApplyProcedure::Spread(args, &spread);
+        if (!callee) {
+            Return(Failure());
+            return;
+        }
+        Apply(callee, spread.Get(), env);
+        return;
+    }
+    if (dynamic_cast<ForceProcedure*>(proc.get())) {
+        StepForce(args, env, *this);
+        return;
+    }
+    if (dynamic_cast<CallWithValues*>(proc.get())) {
+        if (!helpers::RequireArgsCount(args, 2)) {
+            Return(Failure());
+            return;
+        }
+        auto producer = As<Procedure>(args[0]);
+        auto consumer = As<Procedure>(args[1]);
+        if (!producer || !consumer) {
+            Return(Fail(Error::Runtime("Not a procedure")));
+            return;
+        }
+        Push(std::make_shared<ValuesFrame>(std::move(consumer), env));
+        Apply(producer, {}, env);
+        return;
+    }
+    Return(proc->Apply(args, env, evaluator_));
+}
+
+void Machine::EvalBody(const LambdaCodePtr& code, size_t index, const EnvPtr& env) {
+    const auto& body = code->GetBody();
+    if (index >= body.size()) {
+        Return(nullptr);
+        return;
+    }
+    if (index + 1 < body.size()) {
+        Push(std::make_shared<BodyFrame>(code, index + 1, env));
+    }
+    Eval(body[index], env);
+}
+
+void Machine::Step() {
+    if (returning_) {
+        auto frame = std::move(continuation_);
+        continuation_ = frame->next_;
+        frame->Resume(std::move(value_), *this);
+        return;
+    }
+    auto expr = std::move(expr_);
+    auto env = std::move(env_);
+    EvalExpression(expr, env);
+}
+
+void Machine::EvalExpression(const ObjectPtr& expr, const EnvPtr& env) {
+    if (!env) {
+        Return(Fail(Error::Runtime("Cannot evaluate with empty environment")));
+        return;
+    }
+    if (!expr) {
+        Return(Fail(Error::Runtime("Cannot evaluate empty list")));
+        return;
+    }
+    ObjectPtr value;
+    if (TryEvalAtomic(expr, env, &value)) {
+        Return(std::move(value));
+        return;
+    }
+    auto* cell = dynamic_cast<const Cell*>(expr.get());
+    if (!cell) {
+        Return(Fail(Error::Runtime("Invalid expression")));
+        return;
+    }
+    if (auto* sym = dynamic_cast<const Symbol*>(cell->GetFirst().get())) {
+        if (auto* form = evaluator_.GetSpecialForms().Lookup(*sym)) {
+            form->Step(cell->GetSecond(), env, *this);
+            return;
+        }
+    }
+    ContinueApplication(*this, expr, ArgsBuffer{}, env);
+}
+
+void Machine::Resume(const Frame::Ptr& frames, ObjectPtr value) {
+    continuation_ = frames;
+    Return(std::move(value));
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "eval/args.h"
+
+#include <memory>
+
+class Environment;
+class Evaluator;
+class LambdaCode;
+class Machine;
+class Object;
+class Procedure;
+
+// How Scheme::Evaluate runs top-level expressions: with the recursive Evaluator, whose Scheme
+// depth is bounded by the native stack, or with the Machine, which supports full call/cc.
+enum class EvalMode { Recursive, Machine };
+
+// One pending step of a machine continuation: what to do with the value of the expression being
+// evaluated. Frames are immutable once pushed and link to the frame below them, so a captured
+// continuation is just a pointer to the top frame and shares the rest with the running machine.
+class Frame {
+public:
+    using Ptr = std::shared_ptr<const Frame>;
+    using ObjectPtr = std::shared_ptr<Object>;
+
+    virtual ~Frame();
+
+    // Continues the computation with `value`. The machine has already popped the frame.
+    virtual void Resume(ObjectPtr value, Machine& machine) const = 0;
+
+    // Called instead of Resume when an error unwinds the continuation through the frame, which
+    // the machine has already popped. Returns the frames to go on unwinding through, the ones
+    // below by default, or nullptr if the frame handled the error and set up the next step.
+    virtual Ptr Unwind(Machine& machine) const;
+
+    const Ptr& GetNext() const {
+        return next_;
+    }
+
+private:
+    friend class Machine;
+
+    // Mutable only so that the destructor can unlink long chains without recursing.
+    mutable Ptr next_;
+};
+
+// Evaluator built as an explicit CEK machine. The control is the expression being evaluated or
+// the value being returned, the environment travels with it and the continuation is a chain of
+// heap-allocated frames. Native stack use does not grow with the depth of Scheme recursion, and
+// call/cc captures the continuation in O(1) by sharing its frames.
+//
+// The machine walks source expressions and does not use tiers. Special forms run through
+// SpecialForm::Step; force steps the thunks of promises itself, procedures other than lambdas and
+// continuations are applied as usual, and lambdas they call run on the recursive evaluator.
+class Machine {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+    using EnvPtr = std::shared_ptr<Environment>;
+    using ProcPtr = std::shared_ptr<Procedure>;
+
+    explicit Machine(Evaluator& evaluator);
+
+    // Value of `expr`, or Failure() with the error recorded as Evaluator::Eval does.
+    ObjectPtr Run(const ObjectPtr& expr, const EnvPtr& env);
+
+    // Sets the machine up to evaluate `expr` in `env` on the following calls to Continue.
+    void Start(ObjectPtr expr, EnvPtr env);
+
+    // Runs the evaluation set up by Start to the end, or until the evaluator's budget runs out
+    // at a step boundary. In the latter case the result is Failure() with ErrorCode::Budget and
+    // the machine is left paused: IsFinished is false and Continue picks up where it stopped.
+    // Budget running out inside a procedure the machine applies through the recursive evaluator
+    // cannot pause and ends the evaluation.
+    ObjectPtr Continue();
+
+    bool IsFinished() const {
+        return !continuation_;
+    }
+
+    // The next step evaluates `expr` in `env` and passes the value to the current continuation.
+    void Eval(ObjectPtr expr, EnvPtr env);
+
+    // The next step passes `value` to the current continuation.
+    void Return(ObjectPtr value);
+
+    // Makes `frame` the current continuation, on top of the previous one.
+    void Push(std::shared_ptr<Frame> frame);
+
+    // Applies `proc` to `args` with the current continuation, so a call made by the last step of
+    // a frame is a proper tail call.
+    void Apply(const ProcPtr& proc, Args args, const EnvPtr& env);
+
+    // Evaluates the body of `code` from the expression at `index` on in `env`.
+    void EvalBody(const std::shared_ptr<LambdaCode>& code, size_t index, const EnvPtr& env);
+
+    const Frame::Ptr& GetContinuation() const {
+        return continuation_;
+    }
+
+    Evaluator& GetEvaluator() const {
+        return evaluator_;
+    }
+
+private:
+    void Step();
+    // Unwinds the continuation after an error; false if no frame handled it.
+    bool Unwind();
+    void EvalExpression(const ObjectPtr& expr, const EnvPtr& env);
+    void Resume(const Frame::Ptr& frames, ObjectPtr value);
+
+    Evaluator& evaluator_;
+    ObjectPtr expr_;
+    EnvPtr env_;
+    ObjectPtr value_;
+    bool returning_ = false;
+    Frame::Ptr continuation_;
+    // Values being returned when the machine paused, out of the register of the thread, which
+    // may be used by others before the machine continues.
+    ArgsBuffer paused_values_;
+};
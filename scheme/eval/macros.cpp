@@ -0,0 +1,636 @@
+#include "eval/macros.h"
+
+#include "eval/analyzer.h"
+#include "eval/eval.h"
+#include "eval/machine.h"
+#include "eval/syntax.h"
+#include "runtime/env.h"
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+
+#include <array>
+#include <atomic>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+using ObjectPtr = SpecialForm::ObjectPtr;
+using EnvPtr = SpecialForm::EnvPtr;
+using ArgsVec = std::vector<ObjectPtr>;
+
+using syntax::ToVectorOrSyntaxError;
+using syntax::UnpackOrSyntaxError;
+
+// Items of a possibly improper list. `rests[i]` is the part of the list from item i on and
+// `tail` what ends it, nullptr for a proper list.
+struct Spine {
+    ArgsVec items;
+    ArgsVec rests;
+    ObjectPtr tail;
+};
+
+Spine SplitList(const ObjectPtr& list) {
+    Spine spine;
+    auto cur = list;
+    while (auto cell = As<Cell>(cur)) {
+        spine.rests.push_back(cur);
+        spine.items.push_back(cell->GetFirst());
+        cur = cell->GetSecond();
+    }
+    spine.tail = std::move(cur);
+    return spine;
+}
+
+ObjectPtr MakeList(const ArgsVec& items, ObjectPtr tail) {
+    for (auto it = items.rbegin(); it != items.rend(); ++it) {
+        tail = std::make_shared<Cell>(*it, std::move(tail));
+    }
+    return tail;
+}
+
+bool IsSymbol(const ObjectPtr& expr, const std::string& name) {
+    auto symbol = As<Symbol>(expr);
+    return symbol && symbol->GetName() == name;
+}
+
+// What a pattern variable matched: a form, or a match for each repetition of the ellipsis the
+// variable is under.
+struct Match {
+    ObjectPtr form;
+    std::vector<Match> repeats;
+    bool repeated = false;
+};
+
+using Matches = std::unordered_map<std::string, Match>;
+using Bindings = std::unordered_map<std::string, const Match*>;
+
+uint64_t NextRenameId() {
+    static std::atomic<uint64_t> next_id = 1;
+    return next_id++;
+}
+
+// Auxiliary keywords, which forms recognize by name wherever they come from.
+bool IsAuxiliaryKeyword(const std::string& name) {
+    return name == "else" || name == "=>" || name == "unquote" || name == "unquote-splicing";
+}
+
+// Renames the binders that the template of a rule introduced into its expansion, within the
+// forms they bind in. `introduced` holds the symbols of the template; any other symbol of the
+// expansion was written at the use and is left alone. Fresh names contain a dot, which the
+// reader never puts in a symbol, so they cannot clash with a name in the source.
+//
+// The other variables the template introduced are free in it and refer to globals, as the
+// macro was defined at top level: they are replaced with their Environment::GlobalAlias, so a
+// local binding at the use does not capture them. Keywords and the names the expansion defines
+// keep their names.
+class Renamer {
+public:
+    using Renames = std::unordered_map<std::string, ObjectPtr>;
+
+    Renamer(const std::unordered_set<const Object*>& introduced, const SpecialFormRegistry& forms)
+        : introduced_(introduced), forms_(forms) {
+    }
+
+    ObjectPtr Rename(const ObjectPtr& expr, const Renames& renames) {
+        if (Is<Symbol>(expr)) {
+            return RenameSymbol(expr, renames);
+        }
+        if (!Is<Cell>(expr)) {
+            return expr;
+        }
+        auto spine = SplitList(expr);
+        const auto& items = spine.items;
+        auto head = As<Symbol>(items[0]);
+        auto form = head ? head->GetName() : std::string();
+        if (form == "quote") {
+            return expr;
+        }
+        if (form == "quasiquote") {
+            return RenameUnquoted(expr, renames);
+        }
+
+        auto renamed = items;
+        auto rename_from = [&](size_t begin, const Renames& scope) {
+            for (auto i = begin; i < items.size(); ++i) {
+                renamed[i] = Rename(items[i], scope);
+            }
+        };
+        if (form == "lambda" && items.size() > 2) {
+            auto inner = Bind(items[1], renames);
+            renamed[1] = RenameSymbols(items[1], inner);
+            rename_from(2, inner);
+            return Rebuild(expr, spine, renamed, spine.tail);
+        }
+        if (form == "define" && items.size() > 2 && Is<Cell>(items[1])) {
+            auto signature = As<Cell>(items[1]);
+            auto inner = Bind(signature->GetSecond(), renames);
+            auto name = Rename(signature->GetFirst(), renames);
+            auto params = RenameSymbols(signature->GetSecond(), inner);
+            if (name != signature->GetFirst() || params != signature->GetSecond()) {
+                renamed[1] = std::make_shared<Cell>(std::move(name), std::move(params));
+            }
+            rename_from(2, inner);
+            return Rebuild(expr, spine, renamed, spine.tail);
+        }
+        if ((form == "let" || form == "let*" || form == "letrec" || form == "do") &&
+            items.size() > 2) {
+            auto inner = renames;
+            size_t index = 1;
+            if (form == "let" && Is<Symbol>(items[1])) {
+                inner = Bind(items[1], inner);
+                renamed[1] = RenameSymbol(items[1], inner);
+                index = 2;
+            }
+            renamed[index] = RenameBindings(items[index], form, renames, &inner);
+            rename_from(index + 1, inner);
+            return Rebuild(expr, spine, renamed, spine.tail);
+        }
+        rename_from(0, renames);
+        return Rebuild(expr, spine, renamed, Rename(spine.tail, renames));
+    }
+
+    // Collects the names of the introduced symbols that `expr` defines, which keep their names.
+    void FindDefined(const ObjectPtr& expr) {
+        auto spine = SplitList(expr);
+        if (spine.items.empty()) {
+            return;
+        }
+        if (IsSymbol(spine.items[0], "quote")) {
+            return;
+        }
+        if (IsSymbol(spine.items[0], "define") && spine.items.size() > 1) {
+            auto target = spine.items[1];
+            if (auto signature = As<Cell>(target)) {
+                target = signature->GetFirst();
+            }
+            if (Is<Symbol>(target) && introduced_.contains(target.get())) {
+                defined_.insert(As<Symbol>(target)->GetName());
+            }
+        }
+        for (const auto& item : spine.items) {
+            FindDefined(item);
+        }
+    }
+
+private:
+    ObjectPtr RenameSymbol(const ObjectPtr& symbol, const Renames& renames) {
+        if (!introduced_.contains(symbol.get())) {
+            return symbol;
+        }
+        const auto& name = As<Symbol>(symbol)->GetName();
+        if (auto it = renames.find(name); it != renames.end()) {
+            return it->second;
+        }
+        if (defined_.contains(name) || IsAuxiliaryKeyword(name) || forms_.Lookup(name)) {
+            return symbol;
+        }
+        auto& alias = aliases_[name];
+        if (!alias) {
+            alias = std::make_shared<Symbol>(Environment::GlobalAlias(name));
+        }
+        return alias;
+    }
+
+    // Quasiquoted `expr`, whose unquoted parts are renamed as expressions and the rest left alone
+    // as data.
+    ObjectPtr RenameUnquoted(const ObjectPtr& expr, const Renames& renames) {
+        if (!Is<Cell>(expr)) {
+            return expr;
+        }
+        auto spine = SplitList(expr);
+        if (IsSymbol(spine.items[0], "unquote") || IsSymbol(spine.items[0], "unquote-splicing")) {
+            return Rename(expr, renames);
+        }
+        auto renamed = spine.items;
+        for (auto& item : renamed) {
+            item = RenameUnquoted(item, renames);
+        }
+        return Rebuild(expr, spine, renamed, spine.tail);
+    }
+
+    // `renames` with fresh names for the introduced symbols among `symbols`, a symbol or a
+    // possibly improper list of them.
+    Renames Bind(const ObjectPtr& symbols, const Renames& renames) const {
+        auto result = renames;
+        auto spine = SplitList(symbols);
+        spine.items.push_back(spine.tail);
+        for (const auto& symbol : spine.items) {
+            if (symbol && introduced_.contains(symbol.get())) {
+                const auto& name = As<Symbol>(symbol)->GetName();
+                result[name] =
+                    std::make_shared<Symbol>(name + "." + std::to_string(NextRenameId()));
+            }
+        }
+        return result;
+    }
+
+    ObjectPtr RenameSymbols(const ObjectPtr& symbols, const Renames& renames) {
+        if (!Is<Cell>(symbols)) {
+            return Is<Symbol>(symbols) ? RenameSymbol(symbols, renames) : symbols;
+        }
+        auto spine = SplitList(symbols);
+        auto renamed = spine.items;
+        for (auto& symbol : renamed) {
+            if (Is<Symbol>(symbol)) {
+                symbol = RenameSymbol(symbol, renames);
+            }
+        }
+        return Rebuild(symbols, spine, renamed, RenameSymbols(spine.tail, renames));
+    }
+
+    // Binding list `((name init step) ...)` of `form`, adding the names to `inner`. Inits see
+    // the names bound before them in let*, all of them in letrec and none in let and do; the
+    // steps of do see them all.
+    ObjectPtr RenameBindings(const ObjectPtr& bindings, const std::string& form,
+                             const Renames& outer, Renames* inner) {
+        auto spine = SplitList(bindings);
+        if (form != "let*") {
+            for (const auto& binding : spine.items) {
+                if (auto cell = As<Cell>(binding)) {
+                    *inner = Bind(cell->GetFirst(), *inner);
+                }
+            }
+        }
+        auto renamed = spine.items;
+        for (auto& binding : renamed) {
+            auto parts = SplitList(binding);
+            if (parts.items.empty()) {
+                continue;
+            }
+            const auto& init_scope = form == "let" || form == "do" ? outer : *inner;
+            auto renamed_parts = parts.items;
+            for (size_t i = 1; i < parts.items.size(); ++i) {
+                renamed_parts[i] = Rename(parts.items[i], i == 1 ? init_scope : *inner);
+            }
+            if (form == "let*") {
+                *inner = Bind(parts.items[0], *inner);
+            }
+            renamed_parts[0] = RenameSymbols(parts.items[0], *inner);
+            binding = Rebuild(binding, parts, renamed_parts, parts.tail);
+        }
+        return Rebuild(bindings, spine, renamed, spine.tail);
+    }
+
+    // `original`, split into `spine`, if nothing was renamed, so that code without introduced
+    // binders keeps its cells.
+    static ObjectPtr Rebuild(const ObjectPtr& original, const Spine& spine, const ArgsVec& items,
+                             const ObjectPtr& tail) {
+        if (spine.items == items && spine.tail == tail) {
+            return original;
+        }
+        return MakeList(items, tail);
+    }
+
+    const std::unordered_set<const Object*>& introduced_;
+    const SpecialFormRegistry& forms_;
+    std::unordered_set<std::string> defined_;
+    std::unordered_map<std::string, ObjectPtr> aliases_;
+};
+
+// Macro expansions being analyzed on this thread, one within another.
+thread_local size_t expansion_depth = 0;
+
+}  // namespace
+
+struct Macro::Rule {
+    // Pattern without the keyword, matched against the tail of a use.
+    ObjectPtr pattern;
+    ObjectPtr tmpl;
+    std::unordered_set<const Object*> introduced;
+};
+
+namespace {
+
+void CollectSymbols(const ObjectPtr& expr, std::unordered_set<const Object*>* symbols) {
+    if (Is<Symbol>(expr)) {
+        symbols->insert(expr.get());
+        return;
+    }
+    auto cur = expr;
+    while (auto cell = As<Cell>(cur)) {
+        CollectSymbols(cell->GetFirst(), symbols);
+        cur = cell->GetSecond();
+        if (Is<Symbol>(cur)) {
+            symbols->insert(cur.get());
+        }
+    }
+}
+
+// Pattern matching and template substitution of one macro.
+class Transformer {
+public:
+    Transformer(const std::string& ellipsis, const std::unordered_set<std::string>& literals)
+        : ellipsis_(ellipsis), literals_(literals) {
+    }
+
+    bool IsEllipsis(const ObjectPtr& expr) const {
+        return IsSymbol(expr, ellipsis_) && !literals_.contains(ellipsis_);
+    }
+
+    // Index of the item an ellipsis follows, or the number of items.
+    size_t FindRepeated(const ArgsVec& items) const {
+        for (size_t i = 0; i + 1 < items.size(); ++i) {
+            if (IsEllipsis(items[i + 1])) {
+                return i;
+            }
+        }
+        return items.size();
+    }
+
+    // Adds the pattern variables of `pattern` to `vars`. Throws SyntaxError on a variable that
+    // occurs twice or a misplaced ellipsis.
+    void CollectVars(const ObjectPtr& pattern, std::unordered_set<std::string>* vars) const {
+        if (auto symbol = As<Symbol>(pattern)) {
+            const auto& name = symbol->GetName();
+            if (IsEllipsis(pattern)) {
+                throw SyntaxError{""};
+            }
+            if (!literals_.contains(name) && name != "_" && !vars->insert(name).second) {
+                throw SyntaxError{""};
+            }
+            return;
+        }
+        if (!Is<Cell>(pattern)) {
+            return;
+        }
+        auto spine = SplitList(pattern);
+        auto repeated = FindRepeated(spine.items);
+        for (size_t i = 0; i < spine.items.size(); ++i) {
+            CollectVars(spine.items[i], vars);
+            if (i == repeated) {
+                ++i;
+            }
+        }
+        CollectVars(spine.tail, vars);
+    }
+
+    void CheckTemplate(const ObjectPtr& tmpl) const {
+        if (IsEllipsis(tmpl)) {
+            throw SyntaxError{""};
+        }
+        if (!Is<Cell>(tmpl)) {
+            return;
+        }
+        auto spine = SplitList(tmpl);
+        for (size_t i = 0; i < spine.items.size(); ++i) {
+            CheckTemplate(spine.items[i]);
+            if (i + 1 < spine.items.size() && IsEllipsis(spine.items[i + 1])) {
+                ++i;
+            }
+        }
+        CheckTemplate(spine.tail);
+    }
+
+    bool TryMatch(const ObjectPtr& pattern, const ObjectPtr& form, Matches* matches) const {
+        if (auto symbol = As<Symbol>(pattern)) {
+            const auto& name = symbol->GetName();
+            if (literals_.contains(name)) {
+                // An outer expansion may have passed the literal on as a global alias.
+                return IsSymbol(form, name) || IsSymbol(form, Environment::GlobalAlias(name));
+            }
+            if (name != "_") {
+                (*matches)[name].form = form;
+            }
+            return true;
+        }
+        if (!Is<Cell>(pattern)) {
+            return helpers::IsEqv(pattern, form);
+        }
+
+        auto patterns = SplitList(pattern);
+        auto forms = SplitList(form);
+        auto repeated = FindRepeated(patterns.items);
+        auto fixed = patterns.items.size() - (repeated < patterns.items.size() ? 2 : 0);
+        if (forms.items.size() < fixed) {
+            return false;
+        }
+        auto repeats = repeated < patterns.items.size() ? forms.items.size() - fixed : 0;
+
+        size_t next = 0;
+        for (size_t i = 0; i < patterns.items.size(); ++i) {
+            if (i != repeated) {
+                if (!TryMatch(patterns.items[i], forms.items[next++], matches)) {
+                    return false;
+                }
+                continue;
+            }
+            if (!MatchRepeated(patterns.items[i], forms.items, next, repeats, matches)) {
+                return false;
+            }
+            next += repeats;
+            ++i;
+        }
+        if (repeated < patterns.items.size() || next == forms.items.size()) {
+            return TryMatch(patterns.tail, forms.tail, matches);
+        }
+        return TryMatch(patterns.tail, forms.rests[next], matches);
+    }
+
+    ObjectPtr Transcribe(const ObjectPtr& tmpl, const Bindings& bindings) const {
+        if (auto symbol = As<Symbol>(tmpl)) {
+            auto it = bindings.find(symbol->GetName());
+            if (it == bindings.end()) {
+                return tmpl;
+            }
+            // A variable under an ellipsis in the pattern must be under one in the template.
+            if (it->second->repeated) {
+                throw SyntaxError{""};
+            }
+            return it->second->form;
+        }
+        if (!Is<Cell>(tmpl)) {
+            return tmpl;
+        }
+        auto spine = SplitList(tmpl);
+        ArgsVec items;
+        for (size_t i = 0; i < spine.items.size(); ++i) {
+            if (i + 1 < spine.items.size() && IsEllipsis(spine.items[i + 1])) {
+                TranscribeRepeated(spine.items[i], bindings, &items);
+                ++i;
+            } else {
+                items.push_back(Transcribe(spine.items[i], bindings));
+            }
+        }
+        return MakeList(items, Transcribe(spine.tail, bindings));
+    }
+
+private:
+    bool MatchRepeated(const ObjectPtr& pattern, const ArgsVec& forms, size_t begin, size_t count,
+                       Matches* matches) const {
+        std::unordered_set<std::string> vars;
+        CollectVars(pattern, &vars);
+        for (const auto& var : vars) {
+            (*matches)[var].repeated = true;
+        }
+        for (auto i = begin; i < begin + count; ++i) {
+            Matches item;
+            if (!TryMatch(pattern, forms[i], &item)) {
+                return false;
+            }
+            for (const auto& var : vars) {
+                (*matches)[var].repeats.push_back(std::move(item[var]));
+            }
+        }
+        return true;
+    }
+
+    // Instances of `tmpl` for each repetition of the variables under an ellipsis in it.
+    void TranscribeRepeated(const ObjectPtr& tmpl, const Bindings& bindings, ArgsVec* out) const {
+        std::unordered_set<const Object*> symbols;
+        CollectSymbols(tmpl, &symbols);
+        std::unordered_map<std::string, const Match*> repeated;
+        for (const auto* symbol : symbols) {
+            const auto& name = static_cast<const Symbol*>(symbol)->GetName();
+            auto it = bindings.find(name);
+            if (it != bindings.end() && it->second->repeated) {
+                repeated.emplace(name, it->second);
+            }
+        }
+        if (repeated.empty()) {
+            throw SyntaxError{""};
+        }
+        auto count = repeated.begin()->second->repeats.size();
+        for (const auto& [name, match] : repeated) {
+            if (match->repeats.size() != count) {
+                throw SyntaxError{""};
+            }
+        }
+        auto inner = bindings;
+        for (size_t i = 0; i < count; ++i) {
+            for (const auto& [name, match] : repeated) {
+                inner[name] = &match->repeats[i];
+            }
+            out->push_back(Transcribe(tmpl, inner));
+        }
+    }
+
+    const std::string& ellipsis_;
+    const std::unordered_set<std::string>& literals_;
+};
+
+}  // namespace
+
+Macro::Macro(const ObjectPtr& spec) : ellipsis_("...") {
+    auto items = ToVectorOrSyntaxError(spec);
+    size_t next = 1;
+    if (items.size() > 1 && Is<Symbol>(items[1])) {
+        ellipsis_ = As<Symbol>(items[1])->GetName();
+        ++next;
+    }
+    if (items.size() <= next || !IsSymbol(items[0], "syntax-rules")) {
+        throw SyntaxError{""};
+    }
+    for (const auto& literal : ToVectorOrSyntaxError(items[next])) {
+        auto symbol = As<Symbol>(literal);
+        if (!symbol) {
+            throw SyntaxError{""};
+        }
+        literals_.insert(symbol->GetName());
+    }
+
+    Transformer transformer(ellipsis_, literals_);
+    for (auto i = next + 1; i < items.size(); ++i) {
+        std::array<ObjectPtr, 2> parts;
+        UnpackOrSyntaxError(items[i], &parts, 2);
+        auto pattern = As<Cell>(parts[0]);
+        if (!pattern) {
+            throw SyntaxError{""};
+        }
+        Rule rule{.pattern = pattern->GetSecond(), .tmpl = parts[1], .introduced = {}};
+        std::unordered_set<std::string> vars;
+        transformer.CollectVars(rule.pattern, &vars);
+        transformer.CheckTemplate(rule.tmpl);
+        CollectSymbols(rule.tmpl, &rule.introduced);
+        rules_.push_back(std::move(rule));
+    }
+}
+
+Macro::~Macro() = default;
+
+ObjectPtr Macro::Expand(const ObjectPtr& args, const SpecialFormRegistry& forms) {
+    return expansions_.Get(
+        args, [this, &forms](const ObjectPtr& args) { return Transcribe(args, forms); });
+}
+
+ObjectPtr Macro::Transcribe(const ObjectPtr& args, const SpecialFormRegistry& forms) const {
+    Transformer transformer(ellipsis_, literals_);
+    for (const auto& rule : rules_) {
+        Matches matches;
+        if (!transformer.TryMatch(rule.pattern, args, &matches)) {
+            continue;
+        }
+        Bindings bindings;
+        for (const auto& [name, match] : matches) {
+            bindings.emplace(name, &match);
+        }
+        auto expansion = transformer.Transcribe(rule.tmpl, bindings);
+        Renamer renamer(rule.introduced, forms);
+        renamer.FindDefined(expansion);
+        return renamer.Rename(expansion, {});
+    }
+    throw SyntaxError{""};
+}
+
+ObjectPtr Macro::Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) {
+    auto& stack = evaluator.GetNativeStack();
+    if (!stack.HasRoom()) {
+        return stack.RunOnNewSegment([&] { return Evaluate(args, env, evaluator); });
+    }
+    // Held here, as evaluating the expansion may redefine the macro.
+    auto expansion = Expand(args, evaluator.GetSpecialForms());
+    return evaluator.EvalInTail(expansion, env);
+}
+
+NodePtr Macro::Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer, bool tail) {
+    NestedExpansion nested;
+    return analyzer.Analyze(Expand(args, analyzer.GetSpecialForms()), tail);
+}
+
+void Macro::Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) {
+    machine.Eval(Expand(args, machine.GetEvaluator().GetSpecialForms()), env);
+}
+
+NestedExpansion::NestedExpansion() {
+    if (expansion_depth == Macro::kMaxExpansionDepth) {
+        throw SyntaxError{""};
+    }
+    ++expansion_depth;
+}
+
+NestedExpansion::~NestedExpansion() {
+    --expansion_depth;
+}
+
+ObjectPtr ExpandMacroUse(const ObjectPtr& expr, const SpecialFormRegistry& forms) {
+    auto* cell = dynamic_cast<const Cell*>(expr.get());
+    auto head = cell ? As<Symbol>(cell->GetFirst()) : nullptr;
+    auto* macro = head ? dynamic_cast<Macro*>(forms.Lookup(*head)) : nullptr;
+    return macro ? macro->Expand(cell->GetSecond(), forms) : nullptr;
+}
+
+namespace {
+
+class DefineSyntaxForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        std::array<ObjectPtr, 2> parts;
+        UnpackOrSyntaxError(args, &parts, 2);
+        auto name = As<Symbol>(parts[0]);
+        if (!name || env->GetParent()) {
+            throw SyntaxError{""};
+        }
+        auto* current = evaluator.GetSpecialForms().Lookup(*name);
+        if (current && !dynamic_cast<Macro*>(current)) {
+            throw SyntaxError{""};
+        }
+        evaluator.DefineSyntax(name->GetName(), std::make_shared<Macro>(parts[1]));
+        return nullptr;
+    }
+};
+
+}  // namespace
+
+void RegisterMacroForms(SpecialFormRegistry* registry) {
+    registry->Register("define-syntax", std::make_shared<DefineSyntaxForm>());
+}
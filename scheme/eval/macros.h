@@ -0,0 +1,72 @@
+#pragma once
+
+#include "eval/special_forms.h"
+#include "eval/use_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Special form defined by `(define-syntax name (syntax-rules (literal...) (pattern template)...))`.
+// A use is replaced by the template of the first rule whose pattern it matches, which is then
+// evaluated, analyzed or stepped in its place.
+//
+// Each use is expanded once: the expansion is cached against the cell holding the arguments of
+// the use, which the cache refers to weakly, so code that is dropped takes its entries with it.
+// Binders a template introduces (parameters of lambda, variables of let, let*, letrec, named let
+// and do) are renamed apart in every expansion, so they never capture names written at the use
+// site. Names a template defines keep their names. Other free names of a template refer to the
+// globals of that name, as the macro is defined at top level, even where the use site binds
+// them locally.
+class Macro : public SpecialForm {
+public:
+    // Macro uses nested in the expansions of others are analyzed at most this deep.
+    static constexpr size_t kMaxExpansionDepth = 256;
+
+    // `spec` is the `(syntax-rules ...)` form; throws SyntaxError if it is malformed.
+    explicit Macro(const ObjectPtr& spec);
+    ~Macro() override;
+
+    // Expansion of the use with tail `args`, in which the names of `forms` are keywords. Throws
+    // SyntaxError if no rule matches.
+    ObjectPtr Expand(const ObjectPtr& args, const SpecialFormRegistry& forms);
+
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override;
+    NodePtr Analyze(const ObjectPtr& expr, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override;
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override;
+
+private:
+    struct Rule;
+
+    ObjectPtr Transcribe(const ObjectPtr& args, const SpecialFormRegistry& forms) const;
+
+    std::string ellipsis_;
+    std::unordered_set<std::string> literals_;
+    std::vector<Rule> rules_;
+
+    UseCache<ObjectPtr> expansions_;
+};
+
+// Expansion of `expr` if it is a use of a macro in `forms`, nullptr otherwise. Throws
+// SyntaxError if it is a use that no rule matches.
+std::shared_ptr<Object> ExpandMacroUse(const std::shared_ptr<Object>& expr,
+                                       const SpecialFormRegistry& forms);
+
+// Scope of the analysis of a macro expansion. Throws SyntaxError when expansions are nested
+// deeper than Macro::kMaxExpansionDepth, so that a macro expanding into itself forever is left
+// to the tree walker instead of overflowing the native stack.
+class NestedExpansion {
+public:
+    NestedExpansion();
+    ~NestedExpansion();
+
+    NestedExpansion(const NestedExpansion&) = delete;
+    NestedExpansion& operator=(const NestedExpansion&) = delete;
+};
+
+// define-syntax. Macros are registered in the evaluator's registry and so are global; they can
+// only be defined at top level and cannot replace the core forms.
+void RegisterMacroForms(SpecialFormRegistry* registry);
@@ -0,0 +1,146 @@
+#include "eval/native_stack.h"
+
+#include "runtime/error.h"
+
+#include <cstdint>
+#include <exception>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <utility>
+
+#if defined(__SANITIZE_ADDRESS__)
+#define SCHEME_ASAN_FIBERS 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define SCHEME_ASAN_FIBERS 1
+#endif
+#endif
+
+#ifdef SCHEME_ASAN_FIBERS
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+namespace {
+
+size_t PageSize() {
+    static const auto size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+// Segment usable from `base` up, with an inaccessible guard page below it; nullptr if the memory
+// cannot be mapped.
+char* MapSegment() {
+    auto guard = PageSize();
+    void* memory = mmap(nullptr, NativeStack::kSegmentSize + guard, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    mprotect(memory, guard, PROT_NONE);
+    return static_cast<char*>(memory) + guard;
+}
+
+void UnmapSegment(char* base) {
+    auto guard = PageSize();
+    munmap(base - guard, NativeStack::kSegmentSize + guard);
+}
+
+// Call running on a segment together with the contexts switched between.
+struct SegmentCall {
+    const std::function<NativeStack::ObjectPtr()>* fn;
+    NativeStack::ObjectPtr result;
+    std::exception_ptr error;
+    ucontext_t caller;
+    ucontext_t callee;
+    const void* caller_bottom = nullptr;
+    size_t caller_size = 0;
+};
+
+void StartSwitch([[maybe_unused]] void** fake_stack, [[maybe_unused]] const void* bottom,
+                 [[maybe_unused]] size_t size) {
+#ifdef SCHEME_ASAN_FIBERS
+    __sanitizer_start_switch_fiber(fake_stack, bottom, size);
+#endif
+}
+
+void FinishSwitch([[maybe_unused]] void* fake_stack, [[maybe_unused]] const void** bottom,
+                  [[maybe_unused]] size_t* size) {
+#ifdef SCHEME_ASAN_FIBERS
+    __sanitizer_finish_switch_fiber(fake_stack, bottom, size);
+#endif
+}
+
+// Entry point of a segment. Exceptions cannot cross a context switch, so they are handed over
+// to the caller, which rethrows them on its own stack.
+void RunSegmentCall(unsigned int high, unsigned int low) {
+    auto address = (static_cast<uintptr_t>(high) << 32) | static_cast<uintptr_t>(low);
+    auto* call = reinterpret_cast<SegmentCall*>(address);
+    FinishSwitch(nullptr, &call->caller_bottom, &call->caller_size);
+    try {
+        call->result = (*call->fn)();
+    } catch (...) {
+        call->error = std::current_exception();
+    }
+    StartSwitch(nullptr, call->caller_bottom, call->caller_size);
+}
+
+}  // namespace
+
+NativeStack::~NativeStack() {
+    if (spare_) {
+        UnmapSegment(spare_);
+    }
+}
+
+NativeStack::ObjectPtr NativeStack::RunOnNewSegment(const std::function<ObjectPtr()>& fn) {
+    if (in_use_ + kSegmentSize > limit_) {
+        return Fail(Error::Runtime("Stack limit exceeded"));
+    }
+    auto* base = spare_ ? std::exchange(spare_, nullptr) : MapSegment();
+    if (!base) {
+        return Fail(Error::Runtime("Cannot allocate stack segment"));
+    }
+    in_use_ += kSegmentSize;
+
+    SegmentCall call{};
+    call.fn = &fn;
+    getcontext(&call.callee);
+    call.callee.uc_stack.ss_sp = base;
+    call.callee.uc_stack.ss_size = kSegmentSize;
+    call.callee.uc_link = &call.caller;
+    auto address = reinterpret_cast<uintptr_t>(&call);
+    makecontext(&call.callee, reinterpret_cast<void (*)()>(&RunSegmentCall), 2,
+                static_cast<unsigned int>(address >> 32), static_cast<unsigned int>(address));
+
+    auto* previous_limit = segment_limit_;
+    segment_limit_ = base + kRedZone;
+    void* fake_stack = nullptr;
+    StartSwitch(&fake_stack, base, kSegmentSize);
+    swapcontext(&call.caller, &call.callee);
+    FinishSwitch(fake_stack, nullptr, nullptr);
+    segment_limit_ = previous_limit;
+
+    in_use_ -= kSegmentSize;
+    if (spare_) {
+        UnmapSegment(spare_);
+    }
+    spare_ = base;
+    if (call.error) {
+        std::rethrow_exception(call.error);
+    }
+    return std::move(call.result);
+}
+
+const char* NativeStack::FindThreadLimit() {
+    pthread_attr_t attr;
+    void* low = nullptr;
+    size_t size = 0;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        pthread_attr_getstack(&attr, &low, &size);
+        pthread_attr_destroy(&attr);
+    }
+    segment_limit_ = static_cast<const char*>(low) + kRedZone;
+    return segment_limit_;
+}
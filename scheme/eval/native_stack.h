@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+class Object;
+
+// Native stack the recursive evaluator runs on. Procedure calls check how much of the current
+// stack segment is left, which costs one comparison, and continue on a fresh mmap'd segment
+// when it runs low, switching back when the call returns. Extra segments together may take up
+// to the limit; a call that would need more fails with a runtime error instead of crashing.
+class NativeStack {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+
+    static constexpr size_t kSegmentSize = size_t{8} << 20;
+    static constexpr size_t kRedZone = size_t{256} << 10;
+    // Enough for a recursion a million calls deep in every tier. Segments are mapped as the
+    // recursion reaches them, so the limit only bounds how much a runaway recursion may take.
+    static constexpr size_t kDefaultLimit = size_t{4} << 30;
+
+    NativeStack() = default;
+    NativeStack(const NativeStack&) = delete;
+    NativeStack& operator=(const NativeStack&) = delete;
+    ~NativeStack();
+
+    // Whether the current segment has room for one more procedure call.
+    bool HasRoom() const {
+        auto* limit = segment_limit_ ? segment_limit_ : FindThreadLimit();
+        return static_cast<const char*>(__builtin_frame_address(0)) > limit;
+    }
+
+    // Result of `fn` called on a new segment.
+    ObjectPtr RunOnNewSegment(const std::function<ObjectPtr()>& fn);
+
+    // Bytes of extra segments allowed in use at once.
+    size_t GetLimit() const {
+        return limit_;
+    }
+
+    void SetLimit(size_t bytes) {
+        limit_ = bytes;
+    }
+
+private:
+    static const char* FindThreadLimit();
+
+    // Lowest address calls on the current segment may reach before switching.
+    static inline thread_local const char* segment_limit_ = nullptr;
+
+    size_t limit_ = kDefaultLimit;
+    size_t in_use_ = 0;
+    // Last segment released, kept so recursion going back and forth across a segment boundary
+    // does not map and unmap one every time.
+    char* spare_ = nullptr;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <memory>
+
+class Environment;
+class Evaluator;
+class Object;
+
+// Pre-analyzed expression. Produced once by Analyzer and evaluated without re-dispatching on the
+// shape of the source expression.
+class Node {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+    using EnvPtr = std::shared_ptr<Environment>;
+
+    virtual ~Node() = default;
+
+    virtual ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) = 0;
+};
+
+using NodePtr = std::shared_ptr<Node>;
@@ -0,0 +1,536 @@
+#include "eval/optimizer.h"
+
+#include "eval/eval.h"
+#include "eval/macros.h"
+#include "eval/procedure.h"
+#include "runtime/env.h"
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+#include "runtime/list_utils.h"
+#include "runtime/object.h"
+
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+using ObjectPtr = Optimizer::ObjectPtr;
+using EnvPtr = Optimizer::EnvPtr;
+
+class GuardNode : public Node {
+public:
+    GuardNode(std::vector<Assumption> assumptions, NodePtr fast, NodePtr slow)
+        : assumptions_(std::move(assumptions)), fast_(std::move(fast)), slow_(std::move(slow)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        if (version_ != evaluator.GetBindingVersion()) {
+            holds_ = Optimizer::Holds(assumptions_, env, evaluator);
+            version_ = evaluator.GetBindingVersion();
+        }
+        return holds_ ? fast_->Eval(env, evaluator) : slow_->Eval(env, evaluator);
+    }
+
+private:
+    std::vector<Assumption> assumptions_;
+    NodePtr fast_;
+    NodePtr slow_;
+    uint64_t version_ = Evaluator::kNoBindingVersion;
+    bool holds_ = false;
+};
+
+bool TryToVector(const ObjectPtr& list, std::vector<ObjectPtr>* out) {
+    if (!listutils::IsProperList(list)) {
+        return false;
+    }
+    *out = listutils::ToVector(list);
+    return true;
+}
+
+bool IsHead(const ObjectPtr& expr, const char* name) {
+    auto cell = As<Cell>(expr);
+    if (!cell) {
+        return false;
+    }
+    auto head = As<Symbol>(cell->GetFirst());
+    return head && head->GetName() == name;
+}
+
+bool IsSymbolList(const ObjectPtr& list) {
+    std::vector<ObjectPtr> items;
+    if (!TryToVector(list, &items)) {
+        return false;
+    }
+    for (const auto& item : items) {
+        if (!Is<Symbol>(item)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether evaluating `expr` certainly neither fails nor has side effects.
+bool IsPure(const ObjectPtr& expr) {
+    if (Is<Number>(expr) || Is<Boolean>(expr)) {
+        return true;
+    }
+    std::vector<ObjectPtr> items;
+    if (!TryToVector(expr, &items)) {
+        return false;
+    }
+    if (IsHead(expr, "quote")) {
+        return items.size() == 2;
+    }
+    if (IsHead(expr, "lambda")) {
+        return items.size() >= 3 && IsSymbolList(items[1]);
+    }
+    return false;
+}
+
+// Name introduced by a define with no side effects, or nullptr.
+std::shared_ptr<Symbol> PureDefinition(const ObjectPtr& expr) {
+    std::vector<ObjectPtr> items;
+    if (!IsHead(expr, "define") || !TryToVector(expr, &items) || items.size() < 3) {
+        return nullptr;
+    }
+    if (auto name = As<Symbol>(items[1])) {
+        return items.size() == 3 && IsPure(items[2]) ? name : nullptr;
+    }
+    auto signature = As<Cell>(items[1]);
+    if (!signature || !IsSymbolList(signature->GetSecond())) {
+        return nullptr;
+    }
+    return As<Symbol>(signature->GetFirst());
+}
+
+size_t CountOccurrences(const ObjectPtr& expr, const std::string& name) {
+    if (auto symbol = As<Symbol>(expr)) {
+        return symbol->GetName() == name ? 1 : 0;
+    }
+    size_t count = 0;
+    for (auto cur = expr; cur;) {
+        auto cell = As<Cell>(cur);
+        if (!cell) {
+            auto symbol = As<Symbol>(cur);
+            return count + (symbol && symbol->GetName() == name ? 1 : 0);
+        }
+        count += CountOccurrences(cell->GetFirst(), name);
+        cur = cell->GetSecond();
+    }
+    return count;
+}
+
+bool IsMacroUse(const ObjectPtr& expr, const SpecialFormRegistry& forms) {
+    auto* cell = dynamic_cast<const Cell*>(expr.get());
+    auto head = cell ? As<Symbol>(cell->GetFirst()) : nullptr;
+    return head && dynamic_cast<const Macro*>(forms.Lookup(*head));
+}
+
+bool ContainsMacroUse(const ObjectPtr& expr, const SpecialFormRegistry& forms) {
+    if (IsMacroUse(expr, forms)) {
+        return true;
+    }
+    auto cur = expr;
+    while (auto cell = As<Cell>(cur)) {
+        if (ContainsMacroUse(cell->GetFirst(), forms)) {
+            return true;
+        }
+        cur = cell->GetSecond();
+    }
+    return false;
+}
+
+// Walks code that is about to be inlined, counting its atoms and collecting the names it does
+// not bind. Fails on forms that bind names or assign one of `params`, on macro uses, which may do
+// either, and on quasiquote, whose template holds names as data outside of its unquotes.
+bool Inspect(const ObjectPtr& expr, const SpecialFormRegistry& forms,
+             const std::unordered_set<std::string>& params, size_t* size,
+             std::unordered_set<std::string>* free) {
+    ++*size;
+    if (auto symbol = As<Symbol>(expr)) {
+        if (!params.contains(symbol->GetName())) {
+            free->insert(symbol->GetName());
+        }
+        return true;
+    }
+    if (!Is<Cell>(expr) || IsHead(expr, "quote")) {
+        return true;
+    }
+    for (const auto* binder : {"lambda", "define", "let", "let*", "letrec", "do", "let-values",
+                               "receive", "guard"}) {
+        if (IsHead(expr, binder)) {
+            return false;
+        }
+    }
+    if (IsMacroUse(expr, forms) || IsHead(expr, "quasiquote")) {
+        return false;
+    }
+    std::vector<ObjectPtr> items;
+    if (!TryToVector(expr, &items)) {
+        return false;
+    }
+    if (IsHead(expr, "set!") && items.size() > 1) {
+        auto target = As<Symbol>(items[1]);
+        if (target && params.contains(target->GetName())) {
+            return false;
+        }
+    }
+    for (const auto& item : items) {
+        if (!Inspect(item, forms, params, size, free)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// `expr` with every symbol in `bindings` replaced by its value. Quoted data is left alone.
+ObjectPtr Substitute(const ObjectPtr& expr,
+                     const std::unordered_map<std::string, ObjectPtr>& bindings) {
+    if (auto symbol = As<Symbol>(expr)) {
+        auto it = bindings.find(symbol->GetName());
+        return it == bindings.end() ? expr : it->second;
+    }
+    if (!Is<Cell>(expr) || IsHead(expr, "quote")) {
+        return expr;
+    }
+    auto items = listutils::ToVector(expr);
+    for (auto& item : items) {
+        item = Substitute(item, bindings);
+    }
+    return listutils::FromVector(items);
+}
+
+// Forms whose subforms are analyzed together with the form itself.
+bool IsAnalyzedInPlace(const std::string& form) {
+    static const std::unordered_set<std::string> kForms = {"if",  "begin", "and",  "or", "let",
+                                                           "let*", "cond", "case", "set!"};
+    return kForms.contains(form);
+}
+
+void Append(std::vector<Assumption>* to, std::vector<Assumption>&& from) {
+    to->insert(to->end(), std::make_move_iterator(from.begin()),
+               std::make_move_iterator(from.end()));
+}
+
+}  // namespace
+
+Optimizer::Optimizer(const SpecialFormRegistry& forms, Scope::Ptr scope, EnvPtr env,
+                     const LambdaCode* code)
+    : forms_(forms), scope_(scope), env_scope_(std::move(scope)), env_(std::move(env)),
+      code_(code) {
+}
+
+void Optimizer::SetScope(Scope::Ptr scope) {
+    scope_ = std::move(scope);
+}
+
+std::optional<FoldedValue> Optimizer::Fold(const ObjectPtr& expr) {
+    if (Is<Number>(expr) || Is<Boolean>(expr)) {
+        return FoldedValue{expr, {}};
+    }
+    if (!Is<Cell>(expr)) {
+        return std::nullopt;
+    }
+    auto it = folded_.find(expr);
+    if (it == folded_.end()) {
+        it = folded_.emplace(expr, FoldUncached(expr)).first;
+    }
+    return it->second;
+}
+
+std::optional<FoldedValue> Optimizer::FoldUncached(const ObjectPtr& expr) {
+    auto cell = As<Cell>(expr);
+    auto head = As<Symbol>(cell->GetFirst());
+    std::vector<ObjectPtr> args;
+    if (!head || !TryToVector(cell->GetSecond(), &args)) {
+        return std::nullopt;
+    }
+    const auto& name = head->GetName();
+
+    if (forms_.Lookup(name)) {
+        if (name == "quote" && args.size() == 1) {
+            return FoldedValue{args[0], {}};
+        }
+        if (name == "if" && (args.size() == 2 || args.size() == 3)) {
+            auto cond = Fold(args[0]);
+            if (!cond) {
+                return std::nullopt;
+            }
+            std::optional<FoldedValue> branch = FoldedValue{nullptr, {}};
+            if (!helpers::IsFalse(cond->value)) {
+                branch = Fold(args[1]);
+            } else if (args.size() == 3) {
+                branch = Fold(args[2]);
+            }
+            if (branch) {
+                Append(&branch->assumptions, std::move(cond->assumptions));
+            }
+            return branch;
+        }
+        if (name == "and" || name == "or") {
+            return FoldLogic(args, name == "and");
+        }
+        return std::nullopt;
+    }
+
+    auto primitive = Speculate(name);
+    if (primitive == Primitive::None || primitive == Primitive::Cons) {
+        return std::nullopt;
+    }
+    FoldedValue result{nullptr, {{name, primitive}}};
+    std::vector<ObjectPtr> values;
+    for (const auto& arg : args) {
+        auto folded = Fold(arg);
+        if (!folded) {
+            return std::nullopt;
+        }
+        values.push_back(std::move(folded->value));
+        Append(&result.assumptions, std::move(folded->assumptions));
+    }
+    result.value = ApplyPrimitive(primitive, values.data(), values.size());
+    if (IsFailure(result.value)) {
+        TakeError();
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<FoldedValue> Optimizer::FoldLogic(const std::vector<ObjectPtr>& exprs,
+                                                bool is_and) {
+    FoldedValue result{MakeBool(is_and), {}};
+    for (const auto& expr : exprs) {
+        auto folded = Fold(expr);
+        if (!folded) {
+            return std::nullopt;
+        }
+        Append(&result.assumptions, std::move(folded->assumptions));
+        result.value = std::move(folded->value);
+        if (helpers::IsFalse(result.value) == is_and) {
+            if (is_and) {
+                result.value = False();
+            }
+            break;
+        }
+    }
+    return result;
+}
+
+std::vector<ObjectPtr> Optimizer::DropDeadDefines(const std::vector<ObjectPtr>& body,
+                                                  const SpecialFormRegistry& forms) {
+    for (const auto& expr : body) {
+        if (ContainsMacroUse(expr, forms)) {
+            return body;
+        }
+    }
+    std::vector<ObjectPtr> kept;
+    for (size_t i = 0; i < body.size(); ++i) {
+        auto name = i + 1 < body.size() ? PureDefinition(body[i]) : nullptr;
+        if (name) {
+            size_t uses = 0;
+            for (const auto& expr : body) {
+                uses += CountOccurrences(expr, name->GetName());
+            }
+            if (uses == 1) {
+                continue;
+            }
+        }
+        kept.push_back(body[i]);
+    }
+    return kept;
+}
+
+std::optional<InlinedCall> Optimizer::Inline(const ObjectPtr& expr) {
+    auto cell = As<Cell>(expr);
+    std::vector<ObjectPtr> args;
+    if (!cell || !TryToVector(cell->GetSecond(), &args)) {
+        return std::nullopt;
+    }
+    for (const auto& arg : args) {
+        if (!IsTrivial(arg)) {
+            return std::nullopt;
+        }
+    }
+
+    InlinedCall result;
+    std::vector<ObjectPtr> params;
+    auto head = cell->GetFirst();
+    if (auto name = As<Symbol>(head)) {
+        if (scope_ && scope_->Binds(name->GetName())) {
+            return std::nullopt;
+        }
+        auto* value = env_->Find(name->GetName());
+        auto proc = value ? As<LambdaProcedure>(*value) : nullptr;
+        // Free names of the body must resolve at the top level wherever it is inlined.
+        if (!proc || proc->GetCode().get() == code_ || proc->GetCode()->GetRest() ||
+            proc->GetCode()->GetSelf() || !TopLevel() ||
+            proc->GetClosure().get() != TopLevel()) {
+            return std::nullopt;
+        }
+        for (const auto& param : proc->GetCode()->GetParams()) {
+            params.push_back(std::make_shared<Symbol>(param));
+        }
+        result.body = proc->GetCode()->GetBody();
+        result.assumptions.push_back({name->GetName(), Primitive::None, proc});
+    } else {
+        std::vector<ObjectPtr> lambda;
+        if (!IsHead(head, "lambda") || !forms_.Lookup("lambda") || !TryToVector(head, &lambda) ||
+            lambda.size() < 3 || !IsSymbolList(lambda[1])) {
+            return std::nullopt;
+        }
+        params = listutils::ToVector(lambda[1]);
+        result.body.assign(lambda.begin() + 2, lambda.end());
+    }
+    if (params.size() != args.size()) {
+        return std::nullopt;
+    }
+
+    std::unordered_set<std::string> names;
+    std::unordered_map<std::string, ObjectPtr> bindings;
+    for (size_t i = 0; i < params.size(); ++i) {
+        const auto& param = As<Symbol>(params[i])->GetName();
+        if (!names.insert(param).second) {
+            return std::nullopt;
+        }
+        bindings.emplace(param, args[i]);
+    }
+    size_t size = 0;
+    std::unordered_set<std::string> free;
+    for (const auto& body_expr : result.body) {
+        if (!Inspect(body_expr, forms_, names, &size, &free) || size > kInlineBudget) {
+            return std::nullopt;
+        }
+    }
+    if (!result.assumptions.empty()) {
+        for (const auto& name : free) {
+            if (name == result.assumptions.front().name || (scope_ && scope_->Binds(name))) {
+                return std::nullopt;
+            }
+        }
+    }
+    for (auto& body_expr : result.body) {
+        body_expr = Substitute(body_expr, bindings);
+    }
+    return result;
+}
+
+std::optional<BuiltPair> Optimizer::TakeApartPair(const ObjectPtr& expr) {
+    std::vector<ObjectPtr> items;
+    if (!Is<Cell>(expr) || !TryToVector(expr, &items)) {
+        return std::nullopt;
+    }
+    auto head = As<Symbol>(items[0]);
+    if (head && items.size() == 3 && Speculate(head->GetName()) == Primitive::Cons) {
+        return BuiltPair{{items[1], items[2]}, {{head->GetName(), Primitive::Cons}}};
+    }
+    auto inlined = Inline(expr);
+    if (!inlined || inlined->body.size() != 1) {
+        return std::nullopt;
+    }
+    auto pair = TakeApartPair(inlined->body.front());
+    if (pair) {
+        Append(&pair->assumptions, std::move(inlined->assumptions));
+    }
+    return pair;
+}
+
+std::optional<size_t> Optimizer::CountPairAccesses(const std::string& name,
+                                                   const std::vector<ObjectPtr>& body) {
+    size_t count = 0;
+    for (const auto& expr : body) {
+        if (CountOccurrences(expr, name) == 0) {
+            continue;
+        }
+        std::vector<ObjectPtr> items;
+        if (!Is<Cell>(expr) || IsHead(expr, "quote") || IsMacroUse(expr, forms_) ||
+            !TryToVector(expr, &items)) {
+            return std::nullopt;
+        }
+        auto head = As<Symbol>(items[0]);
+        auto arg = items.size() == 2 ? As<Symbol>(items[1]) : nullptr;
+        if (head && arg && arg->GetName() == name) {
+            auto primitive = Speculate(head->GetName());
+            if (primitive == Primitive::Car || primitive == Primitive::Cdr) {
+                ++count;
+                continue;
+            }
+        }
+        if (head && forms_.Lookup(*head) && !IsAnalyzedInPlace(head->GetName())) {
+            return std::nullopt;
+        }
+        auto inner = CountPairAccesses(name, items);
+        if (!inner) {
+            return std::nullopt;
+        }
+        count += *inner;
+    }
+    return count;
+}
+
+NodePtr Optimizer::Guard(std::vector<Assumption> assumptions, NodePtr fast, NodePtr slow) {
+    if (assumptions.empty()) {
+        return fast;
+    }
+    return std::make_shared<GuardNode>(std::move(assumptions), std::move(fast), std::move(slow));
+}
+
+bool Optimizer::Holds(const std::vector<Assumption>& assumptions, const EnvPtr& env,
+                      Evaluator& evaluator) {
+    for (const auto& assumption : assumptions) {
+        evaluator.NoteCachedName(assumption.name);
+    }
+    for (const auto& assumption : assumptions) {
+        auto* value = env->Find(assumption.name);
+        if (!value) {
+            return false;
+        }
+        if (assumption.primitive == Primitive::None) {
+            if (*value != assumption.procedure.lock()) {
+                return false;
+            }
+            continue;
+        }
+        auto builtin = As<BuiltinProcedure>(*value);
+        if (!builtin || builtin->GetPrimitive() != assumption.primitive) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Primitive Optimizer::Speculate(const std::string& name) {
+    if (scope_ && scope_->Binds(name)) {
+        return Primitive::None;
+    }
+    auto it = speculated_.find(name);
+    if (it != speculated_.end()) {
+        return it->second;
+    }
+    auto primitive = Primitive::None;
+    auto* value = forms_.Lookup(name) ? nullptr : env_->Find(name);
+    if (auto builtin = value ? As<BuiltinProcedure>(*value) : nullptr) {
+        primitive = builtin->GetPrimitive();
+    }
+    speculated_.emplace(name, primitive);
+    return primitive;
+}
+
+bool Optimizer::IsTrivial(const ObjectPtr& arg) const {
+    if (Is<Number>(arg) || Is<Boolean>(arg)) {
+        return true;
+    }
+    if (auto symbol = As<Symbol>(arg)) {
+        return scope_ && scope_->IsImmutable(symbol->GetName());
+    }
+    std::vector<ObjectPtr> items;
+    return IsHead(arg, "quote") && forms_.Lookup("quote") && TryToVector(arg, &items) &&
+           items.size() == 2;
+}
+
+// Environment of the top level, reached by leaving every analyzed lambda around the body.
+const Environment* Optimizer::TopLevel() const {
+    auto* env = env_.get();
+    for (auto* scope = env_scope_.get(); scope && env; scope = scope->GetParent().get()) {
+        env = env->GetParent().get();
+    }
+    return env && !env->GetParent() ? env : nullptr;
+}
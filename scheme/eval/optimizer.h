@@ -0,0 +1,116 @@
+#pragma once
+
+#include "eval/analyzer.h"
+#include "eval/node.h"
+#include "eval/primitives.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Environment;
+class Object;
+
+// Folding a call is only valid while `name` still refers to the builtin tagged `primitive`.
+// Assumptions made for inlining have no primitive and require `name` to refer to `procedure`.
+struct Assumption {
+    std::string name;
+    Primitive primitive;
+    std::weak_ptr<Object> procedure = {};
+};
+
+// Value an expression evaluates to, provided every assumption still holds.
+struct FoldedValue {
+    std::shared_ptr<Object> value;
+    std::vector<Assumption> assumptions;
+};
+
+// Body of a lambda with the arguments of a call substituted for its parameters.
+struct InlinedCall {
+    std::vector<std::shared_ptr<Object>> body;
+    std::vector<Assumption> assumptions;
+};
+
+// Pair an expression builds whose components are known without building it, valid while every
+// assumption holds.
+struct BuiltPair {
+    std::array<std::shared_ptr<Object>, 2> components;
+    std::vector<Assumption> assumptions;
+};
+
+// Hot tier pass over the expressions of a lambda body. Folds pure primitive calls on constant
+// arguments, lets the analyzer prune if/and/or branches that cannot be taken, inlines calls to
+// small lambdas and drops internal defines that are never referenced. What a free name refers
+// to is speculated from the environment the body is compiled in; Guard re-checks the
+// speculation whenever bindings change.
+class Optimizer {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+    using EnvPtr = std::shared_ptr<Environment>;
+
+    // Lambdas inlined into inlined code are at most this deep, which also bounds mutual recursion.
+    static constexpr size_t kMaxInlineDepth = 4;
+    // Largest lambda body, counted in atoms, that is inlined.
+    static constexpr size_t kInlineBudget = 32;
+
+    Optimizer(const SpecialFormRegistry& forms, Scope::Ptr scope, EnvPtr env,
+              const LambdaCode* code = nullptr);
+
+    // Scope of the code analyzed from now on: the scope the optimizer was created with or one
+    // nested in it by a binding form such as let.
+    void SetScope(Scope::Ptr scope);
+
+    std::optional<FoldedValue> Fold(const ObjectPtr& expr);
+
+    // Beta-reduces a call of a lambda expression or of a top-level procedure. Only calls whose
+    // arguments are constants or parameters that are never assigned are inlined, so arguments
+    // are neither evaluated out of order nor observe a set!. The lambda must be small, must not
+    // bind names of its own, assign its parameters or call itself by name.
+    std::optional<InlinedCall> Inline(const ObjectPtr& expr);
+
+    // `(cons a b)` as its components, with `cons` the builtin. A call inlined into a body that is
+    // such a cons is taken apart as well.
+    std::optional<BuiltPair> TakeApartPair(const ObjectPtr& expr);
+
+    // Number of car and cdr calls on the variable `name` in `body`, provided `name` occurs nowhere
+    // else and every one of them is in code the analyzer of the body analyzes on the spot: not in
+    // a lambda, a quasiquote template, a macro use or any other form that keeps code for later.
+    std::optional<size_t> CountPairAccesses(const std::string& name,
+                                            const std::vector<ObjectPtr>& body);
+
+    // `body` without `(define name value)` forms whose value has no side effects and whose name
+    // appears nowhere else in the body. The last expression is always kept, and so is every
+    // define of a body that uses a macro of `forms`, whose expansions may refer to the name.
+    static std::vector<ObjectPtr> DropDeadDefines(const std::vector<ObjectPtr>& body,
+                                                  const SpecialFormRegistry& forms);
+
+    // Evaluates `fast` while every assumption holds and `slow` otherwise.
+    static NodePtr Guard(std::vector<Assumption> assumptions, NodePtr fast, NodePtr slow);
+
+    // Whether every assumption holds for names looked up from `env`. Notes the names with
+    // `evaluator`, so that rebinding any of them bumps the binding version.
+    static bool Holds(const std::vector<Assumption>& assumptions, const EnvPtr& env,
+                      Evaluator& evaluator);
+
+    // Tag of the builtin the free name `name` refers to, None for anything else, including the
+    // keywords of special forms and macros.
+    Primitive Speculate(const std::string& name);
+
+private:
+    std::optional<FoldedValue> FoldUncached(const ObjectPtr& expr);
+    std::optional<FoldedValue> FoldLogic(const std::vector<ObjectPtr>& exprs, bool is_and);
+    bool IsTrivial(const ObjectPtr& arg) const;
+    const Environment* TopLevel() const;
+
+    const SpecialFormRegistry& forms_;
+    Scope::Ptr scope_;
+    // Scope of the lambda `env_` is a call environment of.
+    Scope::Ptr env_scope_;
+    EnvPtr env_;
+    const LambdaCode* code_;
+    std::unordered_map<ObjectPtr, std::optional<FoldedValue>> folded_;
+    std::unordered_map<std::string, Primitive> speculated_;
+};
@@ -0,0 +1,86 @@
+#include "eval/primitives.h"
+
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+#include "runtime/object.h"
+
+#include <functional>
+
+using helpers::NumericChainCmp;
+using helpers::NumericFold;
+using helpers::NumericSubtract;
+using helpers::RequireCell;
+
+namespace {
+
+using ObjectPtr = std::shared_ptr<Object>;
+
+bool RequireCount(size_t count, size_t n) {
+    if (count != n) {
+        Fail(Error::Runtime("Invalid argument count"));
+        return false;
+    }
+    return true;
+}
+
+ObjectPtr Car(const ObjectPtr* args, size_t count) {
+    if (!RequireCount(count, 1)) {
+        return Failure();
+    }
+    auto* cell = RequireCell(args[0]);
+    return cell ? cell->GetFirst() : Failure();
+}
+
+ObjectPtr Cdr(const ObjectPtr* args, size_t count) {
+    if (!RequireCount(count, 1)) {
+        return Failure();
+    }
+    auto* cell = RequireCell(args[0]);
+    return cell ? cell->GetSecond() : Failure();
+}
+
+}  // namespace
+
+ObjectPtr ApplyPrimitive(Primitive primitive, const ObjectPtr* args, size_t count) {
+    helpers::Args span{args, count};
+    switch (primitive) {
+        case Primitive::Add:
+            return NumericFold(span, 0, false, std::plus<int64_t>{});
+        case Primitive::Sub:
+            return NumericSubtract(span);
+        case Primitive::Mul:
+            return NumericFold(span, 1, false, std::multiplies<int64_t>{});
+        case Primitive::Eq:
+            return NumericChainCmp(span, std::equal_to<int64_t>{});
+        case Primitive::Lt:
+            return NumericChainCmp(span, std::less<int64_t>{});
+        case Primitive::Gt:
+            return NumericChainCmp(span, std::greater<int64_t>{});
+        case Primitive::Le:
+            return NumericChainCmp(span, std::less_equal<int64_t>{});
+        case Primitive::Ge:
+            return NumericChainCmp(span, std::greater_equal<int64_t>{});
+        case Primitive::Car:
+            return Car(args, count);
+        case Primitive::Cdr:
+            return Cdr(args, count);
+        case Primitive::Cons:
+            if (!RequireCount(count, 2)) {
+                return Failure();
+            }
+            return std::make_shared<Cell>(args[0], args[1]);
+        case Primitive::IsPair:
+            if (!RequireCount(count, 1)) {
+                return Failure();
+            }
+            return MakeBool(Is<Cell>(args[0]));
+        case Primitive::IsNull:
+            if (!RequireCount(count, 1)) {
+                return Failure();
+            }
+            return MakeBool(args[0] == nullptr);
+        case Primitive::None:
+            break;
+    }
+    return Fail(Error::Runtime("Not a primitive"));
+}
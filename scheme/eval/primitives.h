@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+class Object;
+
+// Builtins that hot code may evaluate inline instead of calling. Each BuiltinProcedure registered
+// by the stdlib for one of these operations carries its tag, so a call site can tell that a name
+// still refers to the original builtin no matter what it is called.
+enum class Primitive { None, Add, Sub, Mul, Eq, Lt, Gt, Le, Ge, Car, Cdr, Cons, IsPair, IsNull };
+
+// Same result and errors as calling the tagged builtin with `args`.
+std::shared_ptr<Object> ApplyPrimitive(Primitive primitive, const std::shared_ptr<Object>* args,
+                                       size_t count);
@@ -1,20 +1,305 @@
 #include "eval/procedure.h"
 
+#include "eval/analyzer.h"
 #include "eval/eval.h"
+#include "eval/fixnum_loop.h"
+#include "eval/macros.h"
+#include "eval/optimizer.h"
+#include "runtime/helpers.h"
+#include "runtime/list_utils.h"
 
-Procedure::ObjectPtr LambdaProcedure::Apply(const ArgsVec& args, const EnvPtr&,
-                                            Evaluator& evaluator) {
-    if (args.size() != params_.size()) {
-        throw RuntimeError{"Invalid argument count"};
+namespace {
+
+using ObjectPtr = Procedure::ObjectPtr;
+
+class CurrentProcedureScope {
+public:
+    CurrentProcedureScope(Evaluator& evaluator, LambdaProcedure* procedure)
+        : evaluator_(evaluator), previous_(evaluator.SetCurrentProcedure(procedure)) {
+    }
+
+    ~CurrentProcedureScope() {
+        evaluator_.SetCurrentProcedure(previous_);
+    }
+
+private:
+    Evaluator& evaluator_;
+    LambdaProcedure* previous_;
+};
+
+// Whether `expr` may refer to the variable `name`. Quoted data never do; macro uses are assumed to,
+// as their expansions may.
+bool MayRefer(const ObjectPtr& expr, const std::string& name, const SpecialFormRegistry& forms) {
+    if (auto sym = As<Symbol>(expr)) {
+        return sym->GetName() == name;
+    }
+    auto cell = As<Cell>(expr);
+    if (!cell) {
+        return false;
+    }
+    if (auto head = As<Symbol>(cell->GetFirst())) {
+        auto* form = forms.Lookup(*head);
+        if (dynamic_cast<Macro*>(form)) {
+            return true;
+        }
+        if (form && head->GetName() == "quote") {
+            return false;
+        }
+    }
+    auto cur = expr;
+    while (auto item = As<Cell>(cur)) {
+        if (MayRefer(item->GetFirst(), name, forms)) {
+            return true;
+        }
+        cur = item->GetSecond();
+    }
+    return MayRefer(cur, name, forms);
+}
+
+}  // namespace
+
+std::shared_ptr<BuiltinProcedure> BuiltinProcedure::Unary(Fn1 fn, Primitive primitive) {
+    auto variadic = [fn](Args args, const EnvPtr&, Evaluator&) {
+        return helpers::RequireArgsCount(args, 1) ? fn(args[0]) : Failure();
+    };
+    return std::make_shared<BuiltinProcedure>(variadic, primitive, FixedArity{.apply1 = fn});
+}
+
+std::shared_ptr<BuiltinProcedure> BuiltinProcedure::Binary(Fn2 fn, Primitive primitive) {
+    auto variadic = [fn](Args args, const EnvPtr&, Evaluator&) {
+        return helpers::RequireArgsCount(args, 2) ? fn(args[0], args[1]) : Failure();
+    };
+    return std::make_shared<BuiltinProcedure>(variadic, primitive, FixedArity{.apply2 = fn});
+}
+
+LambdaCode::LambdaCode(Params params, ArgsVec body, ScopePtr scope,
+                       std::optional<std::string> rest, std::optional<std::string> self)
+    : params_(std::move(params)), body_(std::move(body)), scope_(std::move(scope)),
+      rest_(std::move(rest)), self_(std::move(self)) {
+}
+
+LambdaCode::~LambdaCode() = default;
+
+bool LambdaCode::BindArgs(Args args, const LambdaProcedure& proc, Environment* env,
+                          const SpecialFormRegistry& forms) {
+    if (args.size() < params_.size() || (!rest_ && args.size() > params_.size())) {
+        Fail(Error::Runtime("Invalid argument count"));
+        return false;
+    }
+    if (self_) {
+        env->Define(*self_, std::const_pointer_cast<Object>(proc.shared_from_this()));
+    }
+    for (size_t i = 0; i < params_.size(); ++i) {
+        env->Define(params_[i], args[i]);
+    }
+    if (!rest_) {
+        return true;
+    }
+    if (uses_rest_forms_ != forms.GetId()) {
+        uses_rest_forms_ = forms.GetId();
+        uses_rest_ = false;
+        for (const auto& expr : body_) {
+            if (MayRefer(expr, *rest_, forms)) {
+                uses_rest_ = true;
+                break;
+            }
+        }
+    }
+    if (uses_rest_) {
+        env->Define(*rest_, listutils::FromVector(args.subspan(params_.size())));
+    }
+    return true;
+}
+
+Procedure::Params LambdaCode::GetBoundNames() const {
+    Params names;
+    if (self_) {
+        names.push_back(*self_);
+    }
+    names.insert(names.end(), params_.begin(), params_.end());
+    if (rest_) {
+        names.push_back(*rest_);
+    }
+    return names;
+}
+
+Tier LambdaCode::Promote(const TierPolicy& policy) {
+    auto hotness = calls_ + loop_iterations_;
+    if (hotness >= policy.hot_threshold) {
+        tier_ = Tier::Hot;
+    } else if (hotness >= policy.warm_threshold && tier_ == Tier::Cold) {
+        tier_ = Tier::Warm;
     }
-    auto call_env = std::make_shared<Environment>(closure_);
-    for (auto i = 0; i < params_.size(); ++i) {
-        call_env->Define(params_[i], args[i]);
+    return tier_;
+}
+
+void LambdaCode::DropStaleCode(const SpecialFormRegistry& forms) {
+    if (compiled_forms_ == forms.GetId()) {
+        return;
+    }
+    compiled_forms_ = forms.GetId();
+    warm_body_.reset();
+    hot_body_.reset();
+    fixnum_loop_.reset();
+    fixnum_compiled_ = false;
+}
+
+const NodePtr& LambdaCode::GetCompiledBody(Tier tier, Evaluator& evaluator, const EnvPtr& env) {
+    const auto& forms = evaluator.GetSpecialForms();
+    DropStaleCode(forms);
+    if (tier == Tier::Warm) {
+        if (!warm_body_) {
+            Analyzer analyzer(forms, tier,
+                              Scope::ForLambda(GetBoundNames(), body_, scope_, forms));
+            warm_body_ = analyzer.AnalyzeBody(body_);
+        }
+        return warm_body_;
+    }
+    if (!hot_body_) {
+        Analyzer analyzer(forms, tier, Scope::ForLambda(GetBoundNames(), body_, scope_, forms),
+                          env, this);
+        hot_body_ = analyzer.AnalyzeBody(Optimizer::DropDeadDefines(body_, forms));
+    }
+    return hot_body_;
+}
+
+FixnumLoop* LambdaCode::GetFixnumLoop(Evaluator& evaluator, const EnvPtr& closure) {
+    const auto& forms = evaluator.GetSpecialForms();
+    DropStaleCode(forms);
+    if (!fixnum_compiled_) {
+        fixnum_compiled_ = true;
+        fixnum_loop_ = FixnumLoop::Compile(*this, forms,
+                                           Scope::ForLambda(GetBoundNames(), body_, scope_, forms),
+                                           closure);
     }
+    return fixnum_loop_.get();
+}
+
+Procedure::ObjectPtr LambdaProcedure::Apply(Args args, const EnvPtr& env, Evaluator& evaluator) {
+    return Call(args, nullptr, env, evaluator);
+}
+
+Procedure::ObjectPtr LambdaProcedure::ApplyTaking(ArgsBuffer* args, const EnvPtr& env,
+                                                  Evaluator& evaluator) {
+    return Call(args->Get(), args, env, evaluator);
+}
+
+Procedure::ObjectPtr LambdaProcedure::Call(Args args, ArgsBuffer* owner, const EnvPtr& env,
+                                           Evaluator& evaluator) {
+    if (!evaluator.GetNativeStack().HasRoom()) {
+        return CallOnNewSegment(args, owner, env, evaluator);
+    }
+    CurrentProcedureScope scope(evaluator, this);
+    code_->CountCall();
+
+    // Arguments of the iteration that are not the caller's: those a fixnum loop bailed out with
+    // or a self tail call passed. Allocated on first use, so that a call of a deep recursion only
+    // keeps a pointer to them on the native stack.
+    std::unique_ptr<ArgsBuffer> own_args;
+    // Whether the fixnum loop was tried. That happens on the first iteration the code is hot in,
+    // so a loop entered cold switches to unboxed arithmetic once it is promoted.
+    auto fixnum_tried = false;
+    for (;;) {
+        auto tier = code_->Promote(evaluator.GetTierPolicy());
+        if (tier == Tier::Hot && !fixnum_tried) {
+            fixnum_tried = true;
+            if (auto* loop = code_->GetFixnumLoop(evaluator, closure_)) {
+                ArgsVec deopt_args;
+                uint64_t iterations = 0;
+                auto result = loop->Run(args, closure_, evaluator, &deopt_args, &iterations);
+                code_->CountLoopIteration(iterations);
+                if (result) {
+                    return *result;
+                }
+                if (!deopt_args.empty()) {
+                    if (!own_args) {
+                        own_args = std::make_unique<ArgsBuffer>();
+                    }
+                    own_args->Assign(deopt_args);
+                    args = own_args->Get();
+                }
+            }
+        }
+        if (!evaluator.Tick()) {
+            return Failure();
+        }
+        auto call_env = std::make_shared<Environment>(closure_);
+        if (!code_->BindArgs(args, *this, call_env.get(), evaluator.GetSpecialForms())) {
+            return Failure();
+        }
+        if (owner) {
+            owner->Clear();
+            owner = nullptr;
+            args = {};
+        }
 
+        auto result = RunBody(tier, call_env, evaluator);
+        if (result != Evaluator::TailCallMarker()) {
+            return result;
+        }
+        code_->CountLoopIteration();
+        if (!own_args) {
+            own_args = std::make_unique<ArgsBuffer>();
+        }
+        evaluator.TakeTailCallArgs(own_args.get());
+        args = own_args->Get();
+    }
+}
+
+Procedure::ObjectPtr LambdaProcedure::CallOnNewSegment(Args args, ArgsBuffer* owner,
+                                                       const EnvPtr& env, Evaluator& evaluator) {
+    return evaluator.GetNativeStack().RunOnNewSegment(
+        [&] { return Call(args, owner, env, evaluator); });
+}
+
+Procedure::ObjectPtr LambdaProcedure::RunBody(Tier tier, const EnvPtr& env,
+                                              Evaluator& evaluator) {
+    if (tier != Tier::Cold) {
+        return code_->GetCompiledBody(tier, evaluator, env)->Eval(env, evaluator);
+    }
     ObjectPtr result = nullptr;
-    for (const auto& expr : body_) {
-        result = evaluator.Eval(expr, call_env);
+    const auto& body = code_->GetBody();
+    for (size_t i = 0; i < body.size(); ++i) {
+        result = evaluator.Eval(body[i], env, i + 1 == body.size());
+        if (IsFailure(result)) {
+            break;
+        }
     }
     return result;
 }
+
+Procedure::ObjectPtr ApplyProcedure::Apply(Args args, const EnvPtr& env, Evaluator& evaluator) {
+    ArgsBuffer spread;
+    auto proc = Spread(args, &spread);
+    if (!proc) {
+        return Failure();
+    }
+    return proc->Apply(spread.Get(), env, evaluator);
+}
+
+std::shared_ptr<Procedure> ApplyProcedure::Spread(Args args, ArgsBuffer* out) {
+    if (args.size() < 2) {
+        Fail(Error::Runtime("Invalid argument count"));
+        return nullptr;
+    }
+    auto proc = As<Procedure>(args[0]);
+    if (!proc) {
+        Fail(Error::Runtime("Not a procedure"));
+        return nullptr;
+    }
+    const auto& list = args.back();
+    if (!listutils::IsProperList(list)) {
+        Fail(Error::Runtime("Expected proper list"));
+        return nullptr;
+    }
+    out->Clear();
+    for (size_t i = 1; i + 1 < args.size(); ++i) {
+        out->Push(args[i]);
+    }
+    auto cur = list;
+    while (auto cell = As<Cell>(cur)) {
+        out->Push(cell->GetFirst());
+        cur = cell->GetSecond();
+    }
+    return proc;
+}
@@ -1,14 +1,24 @@
 #pragma once
 
+#include "eval/args.h"
+#include "eval/node.h"
+#include "eval/primitives.h"
+#include "eval/tier.h"
 #include "runtime/env.h"
 #include "runtime/object.h"
 
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 class Evaluator;
+class FixnumLoop;
+class LambdaProcedure;
+class Scope;
+class SpecialFormRegistry;
 
 class Procedure : public Object {
 public:
@@ -17,37 +27,241 @@ public:
     using ArgsVec = std::vector<ObjectPtr>;
     using Params = std::vector<std::string>;
 
-    virtual ObjectPtr Apply(const ArgsVec& args, const EnvPtr& env, Evaluator& evaluator) = 0;
+    virtual ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) = 0;
+
+    // Same as Apply, for a caller that needs `args` no more. The procedure may clear them once it
+    // has taken what it needs, so that a long-running call, such as a loop walking a stream, does
+    // not keep the values it started with alive.
+    virtual ObjectPtr ApplyTaking(ArgsBuffer* args, const EnvPtr& env, Evaluator& evaluator) {
+        return Apply(args->Get(), env, evaluator);
+    }
 };
 
 class BuiltinProcedure final : public Procedure {
 public:
-    using Fn =
-        std::function<ObjectPtr(const ArgsVec& args, const EnvPtr& env, Evaluator& evaluator)>;
+    using Fn = std::function<ObjectPtr(Args args, const EnvPtr& env, Evaluator& evaluator)>;
+    using Fn0 = ObjectPtr (*)();
+    using Fn1 = ObjectPtr (*)(const ObjectPtr&);
+    using Fn2 = ObjectPtr (*)(const ObjectPtr&, const ObjectPtr&);
+
+    // Plain function entry points for calls with exactly zero, one or two arguments. Each must
+    // behave like `fn` called with that many arguments; calls without one go through `fn`.
+    struct FixedArity {
+        Fn0 apply0 = nullptr;
+        Fn1 apply1 = nullptr;
+        Fn2 apply2 = nullptr;
+    };
+
+    explicit BuiltinProcedure(Fn fn, Primitive primitive = Primitive::None)
+        : fn_(std::move(fn)), primitive_(primitive) {
+    }
 
-    explicit BuiltinProcedure(Fn fn) : fn_(std::move(fn)) {
+    BuiltinProcedure(Fn fn, Primitive primitive, FixedArity fixed)
+        : fn_(std::move(fn)), primitive_(primitive), fixed_(fixed) {
     }
 
-    ObjectPtr Apply(const ArgsVec& args, const EnvPtr& env, Evaluator& evaluator) override {
+    // Builtins taking exactly one or two arguments.
+    static std::shared_ptr<BuiltinProcedure> Unary(Fn1 fn, Primitive primitive = Primitive::None);
+    static std::shared_ptr<BuiltinProcedure> Binary(Fn2 fn,
+                                                    Primitive primitive = Primitive::None);
+
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override {
+        switch (args.size()) {
+            case 0:
+                if (fixed_.apply0) {
+                    return fixed_.apply0();
+                }
+                break;
+            case 1:
+                if (fixed_.apply1) {
+                    return fixed_.apply1(args[0]);
+                }
+                break;
+            case 2:
+                if (fixed_.apply2) {
+                    return fixed_.apply2(args[0], args[1]);
+                }
+                break;
+        }
         return fn_(args, env, evaluator);
     }
 
+    Primitive GetPrimitive() const {
+        return primitive_;
+    }
+
+    const FixedArity& GetFixedArity() const {
+        return fixed_;
+    }
+
 private:
     Fn fn_;
+    Primitive primitive_;
+    FixedArity fixed_;
 };
 
 using ProcPtr = std::shared_ptr<BuiltinProcedure>;
 
-class LambdaProcedure final : public Procedure {
+// Source of a lambda together with its hotness counters and the bodies compiled for each tier.
+// Closures created from the same analyzed lambda expression share one LambdaCode, so the body is
+// analyzed once no matter how many closures are made from it. `scope` holds the names bound by
+// the analyzed lambdas around it and is empty for lambdas created by the tree walker. `rest`, if
+// set, names a parameter for a list of the arguments past `params`. `self`, if set, names a
+// variable every call binds to the procedure called, which is how a helper lifted out of the
+// body defining it still refers to itself.
+class LambdaCode {
 public:
-    LambdaProcedure(Params params, ArgsVec body, EnvPtr closure)
-        : params_(std::move(params)), body_(std::move(body)), closure_(std::move(closure)) {
+    using ObjectPtr = Procedure::ObjectPtr;
+    using ArgsVec = Procedure::ArgsVec;
+    using Params = Procedure::Params;
+    using EnvPtr = Procedure::EnvPtr;
+    using ScopePtr = std::shared_ptr<const Scope>;
+
+    LambdaCode(Params params, ArgsVec body, ScopePtr scope = nullptr,
+               std::optional<std::string> rest = std::nullopt,
+               std::optional<std::string> self = std::nullopt);
+    ~LambdaCode();
+
+    const Params& GetParams() const {
+        return params_;
+    }
+
+    const std::optional<std::string>& GetRest() const {
+        return rest_;
     }
 
-    ObjectPtr Apply(const ArgsVec& args, const EnvPtr& env, Evaluator& evaluator) override;
+    const std::optional<std::string>& GetSelf() const {
+        return self_;
+    }
+
+    const ArgsVec& GetBody() const {
+        return body_;
+    }
+
+    uint64_t GetCallCount() const {
+        return calls_;
+    }
+
+    uint64_t GetLoopIterations() const {
+        return loop_iterations_;
+    }
+
+    Tier GetTier() const {
+        return tier_;
+    }
+
+    void CountCall() {
+        ++calls_;
+    }
+
+    void CountLoopIteration(uint64_t count = 1) {
+        loop_iterations_ += count;
+    }
+
+    // Defines the parameters in `env`, the environment of a call to `proc` with `args`. The rest
+    // list is built only if the body may refer to it. Fails and returns false on a wrong argument
+    // count.
+    bool BindArgs(Args args, const LambdaProcedure& proc, Environment* env,
+                  const SpecialFormRegistry& forms);
+
+    // Moves the code up the tiers according to `policy` and returns the tier to run at.
+    Tier Promote(const TierPolicy& policy);
+
+    // Analyzed body for a warm or hot tier, built on first request. The hot body is optimized
+    // against `env`, the environment of the call that triggers compilation.
+    const NodePtr& GetCompiledBody(Tier tier, Evaluator& evaluator, const EnvPtr& env);
+
+    // Hot body compiled to unboxed integer code, or nullptr if type inference fails on it.
+    FixnumLoop* GetFixnumLoop(Evaluator& evaluator, const EnvPtr& closure);
 
 private:
+    // Self name followed by the parameters and the rest parameter, if any.
+    Params GetBoundNames() const;
+
+    // Drops the compiled bodies if the registry changed since they were compiled: they have the
+    // expansions of the macros of the time built in, which the tree walker would no longer use.
+    // Macros are only defined at top level, so no compiled body is running when that happens.
+    void DropStaleCode(const SpecialFormRegistry& forms);
+
     Params params_;
     ArgsVec body_;
+    ScopePtr scope_;
+    std::optional<std::string> rest_;
+    std::optional<std::string> self_;
+    // Whether the body may refer to the rest parameter, as of the registry with the given id.
+    bool uses_rest_ = true;
+    std::optional<uint64_t> uses_rest_forms_;
+    uint64_t calls_ = 0;
+    uint64_t loop_iterations_ = 0;
+    Tier tier_ = Tier::Cold;
+    // Id of the registry the bodies below were compiled with.
+    std::optional<uint64_t> compiled_forms_;
+    NodePtr warm_body_;
+    NodePtr hot_body_;
+    std::unique_ptr<FixnumLoop> fixnum_loop_;
+    bool fixnum_compiled_ = false;
+};
+
+using LambdaCodePtr = std::shared_ptr<LambdaCode>;
+
+class LambdaProcedure final : public Procedure {
+public:
+    LambdaProcedure(Params params, ArgsVec body, EnvPtr closure)
+        : code_(std::make_shared<LambdaCode>(std::move(params), std::move(body))),
+          closure_(std::move(closure)) {
+    }
+
+    LambdaProcedure(LambdaCodePtr code, EnvPtr closure)
+        : code_(std::move(code)), closure_(std::move(closure)) {
+    }
+
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override;
+
+    // Clears `args` once they are bound.
+    ObjectPtr ApplyTaking(ArgsBuffer* args, const EnvPtr& env, Evaluator& evaluator) override;
+
+    // Number of times the procedure was applied. Shared between closures of the same code.
+    uint64_t GetCallCount() const {
+        return code_->GetCallCount();
+    }
+
+    // Number of self calls in tail position, i.e. iterations of loops written as tail recursion.
+    uint64_t GetLoopIterations() const {
+        return code_->GetLoopIterations();
+    }
+
+    Tier GetTier() const {
+        return code_->GetTier();
+    }
+
+    const LambdaCodePtr& GetCode() const {
+        return code_;
+    }
+
+    const EnvPtr& GetClosure() const {
+        return closure_;
+    }
+
+private:
+    // Apply, clearing `owner`, which holds `args`, if set.
+    ObjectPtr Call(Args args, ArgsBuffer* owner, const EnvPtr& env, Evaluator& evaluator);
+    // Call continued on a new native stack segment.
+    [[gnu::noinline]] ObjectPtr CallOnNewSegment(Args args, ArgsBuffer* owner, const EnvPtr& env,
+                                                 Evaluator& evaluator);
+    ObjectPtr RunBody(Tier tier, const EnvPtr& env, Evaluator& evaluator);
+
+    LambdaCodePtr code_;
     EnvPtr closure_;
 };
+
+// apply. `(apply f a ... list)` calls f with the arguments a ... followed by the items of `list`.
+// The Machine applies it itself, so that f runs on the machine too.
+class ApplyProcedure final : public Procedure {
+public:
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override;
+
+    // Checks the arguments of apply and spreads them into `out`, which is where the callee's
+    // arguments live; no list or vector is built on the way. Fails and returns nullptr if the
+    // arguments are wrong, otherwise returns the procedure to call.
+    static std::shared_ptr<Procedure> Spread(Args args, ArgsBuffer* out);
+};
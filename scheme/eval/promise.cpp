@@ -0,0 +1,273 @@
+#include "eval/promise.h"
+
+#include "eval/analyzer.h"
+#include "eval/closure_conversion.h"
+#include "eval/machine.h"
+#include "eval/syntax.h"
+#include "eval/values.h"
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+
+#include <array>
+#include <utility>
+
+namespace {
+
+using ObjectPtr = SpecialForm::ObjectPtr;
+using EnvPtr = SpecialForm::EnvPtr;
+using ProcPtr = std::shared_ptr<Procedure>;
+
+// Code of a thunk evaluating `expr`, analyzed in `scope` if it is set.
+LambdaCodePtr ThunkCode(const ObjectPtr& expr, Scope::Ptr scope) {
+    return std::make_shared<LambdaCode>(Procedure::Params{}, Procedure::ArgsVec{expr},
+                                        std::move(scope));
+}
+
+ObjectPtr MakePromise(ProcPtr thunk, bool chained) {
+    return std::make_shared<Promise>(std::move(thunk), chained);
+}
+
+// Stream pair of the promises of `first` and of `rest`.
+ObjectPtr MakeStreamPair(ProcPtr first, ProcPtr rest) {
+    return std::make_shared<Promise>(std::make_shared<Cell>(MakePromise(std::move(first), false),
+                                                            MakePromise(std::move(rest), true)));
+}
+
+class ThunkNode : public Node {
+public:
+    explicit ThunkNode(LambdaCodePtr code) : code_(std::move(code)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator&) override {
+        return std::make_shared<LambdaProcedure>(code_, env);
+    }
+
+private:
+    LambdaCodePtr code_;
+};
+
+// Node creating a thunk of `expr`, closure-converted where AnalyzeClosure allows it, so that a
+// promise only keeps the variables its expression uses.
+NodePtr AnalyzeThunk(const ObjectPtr& expr, Analyzer& analyzer) {
+    auto code = ThunkCode(expr, analyzer.GetScope());
+    if (auto node = AnalyzeClosure(code, analyzer)) {
+        return node;
+    }
+    return std::make_shared<ThunkNode>(std::move(code));
+}
+
+ProcPtr EvalThunk(const NodePtr& node, const EnvPtr& env, Evaluator& evaluator) {
+    return std::static_pointer_cast<Procedure>(node->Eval(env, evaluator));
+}
+
+class DelayNode : public Node {
+public:
+    DelayNode(NodePtr thunk, bool chained) : thunk_(std::move(thunk)), chained_(chained) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        return MakePromise(EvalThunk(thunk_, env, evaluator), chained_);
+    }
+
+private:
+    NodePtr thunk_;
+    bool chained_;
+};
+
+class StreamConsNode : public Node {
+public:
+    StreamConsNode(NodePtr first, NodePtr rest) : first_(std::move(first)), rest_(std::move(rest)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        return MakeStreamPair(EvalThunk(first_, env, evaluator), EvalThunk(rest_, env, evaluator));
+    }
+
+private:
+    NodePtr first_;
+    NodePtr rest_;
+};
+
+// delay, or delay-force when `chained` is set.
+class DelayForm : public SpecialForm {
+public:
+    explicit DelayForm(bool chained) : chained_(chained) {
+    }
+
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator&) override {
+        return MakePromise(std::make_shared<LambdaProcedure>(ThunkCode(Parse(args), nullptr), env),
+                           chained_);
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer, bool) override {
+        return std::make_shared<DelayNode>(AnalyzeThunk(Parse(args), analyzer), chained_);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        machine.Return(Evaluate(args, env, machine.GetEvaluator()));
+    }
+
+private:
+    static ObjectPtr Parse(const ObjectPtr& args) {
+        std::array<ObjectPtr, 1> parts;
+        syntax::UnpackOrSyntaxError(args, &parts, 1);
+        return std::move(parts[0]);
+    }
+
+    bool chained_;
+};
+
+class StreamConsForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator&) override {
+        auto parts = Parse(args);
+        return MakeStreamPair(
+            std::make_shared<LambdaProcedure>(ThunkCode(parts[0], nullptr), env),
+            std::make_shared<LambdaProcedure>(ThunkCode(parts[1], nullptr), env));
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer, bool) override {
+        auto parts = Parse(args);
+        return std::make_shared<StreamConsNode>(AnalyzeThunk(parts[0], analyzer),
+                                                AnalyzeThunk(parts[1], analyzer));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        machine.Return(Evaluate(args, env, machine.GetEvaluator()));
+    }
+
+private:
+    static std::array<ObjectPtr, 2> Parse(const ObjectPtr& args) {
+        std::array<ObjectPtr, 2> parts;
+        syntax::UnpackOrSyntaxError(args, &parts, 2);
+        return parts;
+    }
+};
+
+void ContinueForce(Machine& machine, std::shared_ptr<Promise> promise, const EnvPtr& env);
+
+// Resolves the promise with the value of its thunk and goes on forcing it.
+class ForceFrame : public Frame {
+public:
+    ForceFrame(std::shared_ptr<Promise> promise, EnvPtr env)
+        : promise_(std::move(promise)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        if (!promise_->Resolve(value)) {
+            machine.Return(Failure());
+            return;
+        }
+        ContinueForce(machine, promise_, env_);
+    }
+
+private:
+    std::shared_ptr<Promise> promise_;
+    EnvPtr env_;
+};
+
+void ContinueForce(Machine& machine, std::shared_ptr<Promise> promise, const EnvPtr& env) {
+    if (promise->IsDone()) {
+        machine.Return(promise->GetValue());
+        return;
+    }
+    auto thunk = promise->GetThunk();
+    machine.Push(std::make_shared<ForceFrame>(std::move(promise), env));
+    machine.Apply(thunk, {}, env);
+}
+
+}  // namespace
+
+Promise::Promise(ObjectPtr value) : state_(std::make_shared<State>()) {
+    state_->done = true;
+    state_->value = std::move(value);
+}
+
+Promise::Promise(std::shared_ptr<Procedure> thunk, bool chained)
+    : state_(std::make_shared<State>()) {
+    state_->chained = chained;
+    state_->thunk = std::move(thunk);
+}
+
+// Releases the rest of a forced stream iteratively, so dropping a long one does not recurse once
+// per item.
+Promise::~Promise() {
+    auto state = std::move(state_);
+    while (state && state.use_count() == 1 && state->value.use_count() == 1) {
+        auto* cell = dynamic_cast<Cell*>(state->value.get());
+        auto rest = cell ? As<Promise>(cell->GetSecond()) : nullptr;
+        if (!rest) {
+            break;
+        }
+        cell->SetSecond(nullptr);
+        if (rest.use_count() != 1) {
+            break;
+        }
+        state = std::move(rest->state_);
+    }
+}
+
+bool Promise::Resolve(const ObjectPtr& value) {
+    if (state_->done) {
+        return true;
+    }
+    if (IsFailure(OneValue(value))) {
+        return false;
+    }
+    if (!state_->chained) {
+        state_->done = true;
+        state_->value = value;
+        state_->thunk.reset();
+        return true;
+    }
+    auto promise = As<Promise>(value);
+    if (!promise) {
+        Fail(Error::Runtime("Expected promise"));
+        return false;
+    }
+    *state_ = *promise->state_;
+    promise->state_ = state_;
+    return true;
+}
+
+std::shared_ptr<Object> Force(const std::shared_ptr<Promise>& promise,
+                              const Procedure::EnvPtr& env, Evaluator& evaluator) {
+    while (!promise->IsDone()) {
+        auto thunk = promise->GetThunk();
+        auto value = thunk->Apply({}, env, evaluator);
+        if (IsFailure(value)) {
+            return value;
+        }
+        if (!promise->Resolve(value)) {
+            return Failure();
+        }
+    }
+    return promise->GetValue();
+}
+
+Procedure::ObjectPtr ForceProcedure::Apply(Args args, const EnvPtr& env, Evaluator& evaluator) {
+    if (!helpers::RequireArgsCount(args, 1)) {
+        return Failure();
+    }
+    auto promise = As<Promise>(args[0]);
+    return promise ? Force(promise, env, evaluator) : args[0];
+}
+
+void StepForce(Args args, const Procedure::EnvPtr& env, Machine& machine) {
+    if (!helpers::RequireArgsCount(args, 1)) {
+        machine.Return(Failure());
+        return;
+    }
+    auto promise = As<Promise>(args[0]);
+    if (!promise) {
+        machine.Return(args[0]);
+        return;
+    }
+    ContinueForce(machine, std::move(promise), env);
+}
+
+void RegisterPromiseForms(SpecialFormRegistry* registry) {
+    registry->Register("delay", std::make_shared<DelayForm>(false));
+    registry->Register("delay-force", std::make_shared<DelayForm>(true));
+    registry->Register("stream-cons", std::make_shared<StreamConsForm>());
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "eval/args.h"
+#include "eval/procedure.h"
+#include "eval/special_forms.h"
+
+#include <memory>
+
+// Promises of delay, delay-force and make-promise. A promise not yet forced holds a thunk, a
+// procedure of no arguments. Forcing it calls the thunk once and keeps the value; for delay-force
+// the thunk returns another promise, which the forced one takes over. The two then share their
+// state, so forcing a chain of delay-force promises is a loop in constant space rather than a
+// recursion that keeps every link alive. Reentrant forcing is as in R7RS: if the thunk forces the
+// same promise, the value computed first wins.
+class Promise final : public Object {
+public:
+    using ObjectPtr = std::shared_ptr<Object>;
+
+    // Promise already forced to `value`.
+    explicit Promise(ObjectPtr value);
+
+    // Promise of the value of `thunk`, or with `chained` of the promise it returns.
+    Promise(std::shared_ptr<Procedure> thunk, bool chained);
+
+    ~Promise() override;
+
+    bool IsDone() const {
+        return state_->done;
+    }
+
+    // Value of a forced promise.
+    const ObjectPtr& GetValue() const {
+        return state_->value;
+    }
+
+    // Thunk of a promise not forced yet.
+    const std::shared_ptr<Procedure>& GetThunk() const {
+        return state_->thunk;
+    }
+
+    // Records `value`, the thunk's result, unless a reentrant force has done so already. A chained
+    // promise takes over the promise `value`; anything else fails and returns false.
+    bool Resolve(const ObjectPtr& value);
+
+private:
+    struct State {
+        bool done = false;
+        bool chained = false;
+        ObjectPtr value;
+        std::shared_ptr<Procedure> thunk;
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+// Value of `promise`, forced on the recursive evaluator, or Failure() if its thunk fails.
+std::shared_ptr<Object> Force(const std::shared_ptr<Promise>& promise,
+                              const Procedure::EnvPtr& env, Evaluator& evaluator);
+
+// force. Returns anything other than a promise as is. The Machine applies it itself, so that the
+// thunks run on the machine too.
+class ForceProcedure final : public Procedure {
+public:
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override;
+};
+
+// The Machine's force, which calls each thunk with a frame resolving the promise on top.
+void StepForce(Args args, const Procedure::EnvPtr& env, Machine& machine);
+
+// delay, delay-force and stream-cons. A stream is a promise of the empty list or of a pair of a
+// promise of the first item and the stream of the rest; `(stream-cons a b)` delays both `a` and
+// `b`, the latter with delay-force, so streams defined recursively are forced in constant space.
+void RegisterPromiseForms(SpecialFormRegistry* registry);
@@ -0,0 +1,301 @@
+#include "eval/quasiquote.h"
+
+#include "eval/analyzer.h"
+#include "eval/args.h"
+#include "eval/eval.h"
+#include "eval/machine.h"
+#include "eval/syntax.h"
+#include "eval/use_cache.h"
+#include "eval/values.h"
+#include "runtime/error.h"
+#include "runtime/list_utils.h"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using ObjectPtr = SpecialForm::ObjectPtr;
+using EnvPtr = SpecialForm::EnvPtr;
+using ArgsVec = std::vector<ObjectPtr>;
+
+using syntax::UnpackOrSyntaxError;
+
+enum class Marker { None, Quasiquote, Unquote, UnquoteSplicing };
+
+Marker GetMarker(const ObjectPtr& datum) {
+    auto cell = As<Cell>(datum);
+    auto head = cell ? As<Symbol>(cell->GetFirst()) : nullptr;
+    if (!head) {
+        return Marker::None;
+    }
+    const auto& name = head->GetName();
+    if (name == "quasiquote") {
+        return Marker::Quasiquote;
+    }
+    if (name == "unquote") {
+        return Marker::Unquote;
+    }
+    if (name == "unquote-splicing") {
+        return Marker::UnquoteSplicing;
+    }
+    return Marker::None;
+}
+
+// Operand of the unquote `form`.
+ObjectPtr GetOperand(const ObjectPtr& form) {
+    std::array<ObjectPtr, 1> operand;
+    UnpackOrSyntaxError(As<Cell>(form)->GetSecond(), &operand, 1);
+    return operand[0];
+}
+
+// Compiled quasiquote template. Parts are stored children first, so the root is the last one.
+class Template {
+public:
+    // `datum` is the operand of quasiquote; throws SyntaxError if it unquotes wrongly.
+    explicit Template(const ObjectPtr& datum) {
+        Compile(datum, 0);
+    }
+
+    // Expressions whose values are unquoted, in the order they are evaluated.
+    const ArgsVec& GetExprs() const {
+        return exprs_;
+    }
+
+    // Instance of the template with `values` for the expressions; Failure() if a value spliced
+    // in is not a list. Without expressions, this is the quoted datum itself.
+    ObjectPtr Instantiate(Args values) const {
+        return Build(parts_.size() - 1, values);
+    }
+
+private:
+    enum class Kind { Constant, Value, Splice, Pair };
+
+    // A constant datum, a value or spliced value in `slot`, or a pair of parts.
+    struct Part {
+        Kind kind;
+        ObjectPtr datum;
+        size_t slot = 0;
+        size_t first = 0;
+        size_t second = 0;
+    };
+
+    size_t Add(Part part) {
+        parts_.push_back(std::move(part));
+        return parts_.size() - 1;
+    }
+
+    size_t AddSlot(Kind kind, const ObjectPtr& form) {
+        exprs_.push_back(GetOperand(form));
+        return Add({.kind = kind, .datum = nullptr, .slot = exprs_.size() - 1});
+    }
+
+    // Compiles `datum` at quasiquote nesting `depth` and returns the index of its part.
+    size_t Compile(const ObjectPtr& datum, size_t depth) {
+        auto cell = As<Cell>(datum);
+        if (!cell) {
+            return Add({.kind = Kind::Constant, .datum = datum});
+        }
+        auto rest_depth = depth;
+        switch (GetMarker(datum)) {
+            case Marker::Quasiquote:
+                ++rest_depth;
+                break;
+            case Marker::Unquote:
+                if (depth == 0) {
+                    return AddSlot(Kind::Value, datum);
+                }
+                --rest_depth;
+                break;
+            case Marker::UnquoteSplicing:
+                if (depth == 0) {
+                    throw SyntaxError{""};
+                }
+                --rest_depth;
+                break;
+            case Marker::None:
+                break;
+        }
+        size_t first;
+        if (depth == 0 && GetMarker(cell->GetFirst()) == Marker::UnquoteSplicing) {
+            first = AddSlot(Kind::Splice, cell->GetFirst());
+        } else {
+            first = Compile(cell->GetFirst(), depth);
+        }
+        auto second = Compile(cell->GetSecond(), rest_depth);
+        if (parts_[first].kind == Kind::Constant && parts_[second].kind == Kind::Constant) {
+            parts_.resize(first);
+            return Add({.kind = Kind::Constant, .datum = datum});
+        }
+        return Add({.kind = Kind::Pair, .datum = nullptr, .first = first, .second = second});
+    }
+
+    ObjectPtr Build(size_t index, Args values) const {
+        const auto& part = parts_[index];
+        switch (part.kind) {
+            case Kind::Constant:
+                return part.datum;
+            case Kind::Value:
+                return values[part.slot];
+            case Kind::Splice:
+            case Kind::Pair:
+                break;
+        }
+        auto second = Build(part.second, values);
+        if (IsFailure(second)) {
+            return second;
+        }
+        const auto& first = parts_[part.first];
+        if (first.kind == Kind::Splice) {
+            return Splice(values[first.slot], std::move(second));
+        }
+        return std::make_shared<Cell>(Build(part.first, values), std::move(second));
+    }
+
+    // Copy of `list` ending in `rest` rather than the empty list, or `list` itself if `rest` is
+    // empty.
+    static ObjectPtr Splice(const ObjectPtr& list, ObjectPtr rest) {
+        if (!listutils::IsProperList(list)) {
+            return Fail(Error::Runtime("Expected proper list"));
+        }
+        if (!rest || !list) {
+            return list ? list : rest;
+        }
+        auto head = std::make_shared<Cell>(As<Cell>(list)->GetFirst(), nullptr);
+        auto last = head;
+        for (auto cur = As<Cell>(list)->GetSecond(); cur;) {
+            auto cell = As<Cell>(cur);
+            auto next = std::make_shared<Cell>(cell->GetFirst(), nullptr);
+            last->SetSecond(next);
+            last = std::move(next);
+            cur = cell->GetSecond();
+        }
+        last->SetSecond(std::move(rest));
+        return head;
+    }
+
+    std::vector<Part> parts_;
+    ArgsVec exprs_;
+};
+
+using TemplatePtr = std::shared_ptr<const Template>;
+
+class QuasiquoteNode : public Node {
+public:
+    QuasiquoteNode(TemplatePtr tmpl, std::vector<NodePtr> exprs)
+        : tmpl_(std::move(tmpl)), exprs_(std::move(exprs)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        ArgsBuffer values(exprs_.size());
+        for (const auto& expr : exprs_) {
+            auto value = OneValue(expr->Eval(env, evaluator));
+            if (IsFailure(value)) {
+                return value;
+            }
+            values.Push(std::move(value));
+        }
+        return tmpl_->Instantiate(values.Get());
+    }
+
+private:
+    TemplatePtr tmpl_;
+    std::vector<NodePtr> exprs_;
+};
+
+class QuasiquoteFrame : public Frame {
+public:
+    QuasiquoteFrame(TemplatePtr tmpl, ArgsVec values, EnvPtr env)
+        : tmpl_(std::move(tmpl)), values_(std::move(values)), env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override;
+
+private:
+    TemplatePtr tmpl_;
+    ArgsVec values_;
+    EnvPtr env_;
+};
+
+// Evaluates the expressions of `tmpl` from the one after `values` on, then returns the instance.
+void ContinueQuasiquote(Machine& machine, TemplatePtr tmpl, ArgsVec values, const EnvPtr& env) {
+    const auto& exprs = tmpl->GetExprs();
+    auto index = values.size();
+    if (index == exprs.size()) {
+        machine.Return(tmpl->Instantiate(values));
+        return;
+    }
+    const auto& expr = exprs[index];
+    machine.Push(std::make_shared<QuasiquoteFrame>(std::move(tmpl), std::move(values), env));
+    machine.Eval(expr, env);
+}
+
+void QuasiquoteFrame::Resume(ObjectPtr value, Machine& machine) const {
+    value = OneValue(std::move(value));
+    if (IsFailure(value)) {
+        machine.Return(std::move(value));
+        return;
+    }
+    auto values = values_;
+    values.push_back(std::move(value));
+    ContinueQuasiquote(machine, tmpl_, std::move(values), env_);
+}
+
+class QuasiquoteForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        auto tmpl = GetTemplate(args);
+        ArgsBuffer values(tmpl->GetExprs().size());
+        for (const auto& expr : tmpl->GetExprs()) {
+            auto value = OneValue(evaluator.Eval(expr, env));
+            if (IsFailure(value)) {
+                return value;
+            }
+            values.Push(std::move(value));
+        }
+        return tmpl->Instantiate(values.Get());
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer, bool) override {
+        auto tmpl = GetTemplate(args);
+        if (tmpl->GetExprs().empty()) {
+            return analyzer.Constant(tmpl->Instantiate({}));
+        }
+        std::vector<NodePtr> exprs;
+        for (const auto& expr : tmpl->GetExprs()) {
+            exprs.push_back(analyzer.Analyze(expr));
+        }
+        return std::make_shared<QuasiquoteNode>(std::move(tmpl), std::move(exprs));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        ContinueQuasiquote(machine, GetTemplate(args), {}, env);
+    }
+
+private:
+    TemplatePtr GetTemplate(const ObjectPtr& args) {
+        return templates_.Get(args, [](const ObjectPtr& args) {
+            std::array<ObjectPtr, 1> datum;
+            UnpackOrSyntaxError(args, &datum, 1);
+            return std::make_shared<const Template>(datum[0]);
+        });
+    }
+
+    UseCache<TemplatePtr> templates_;
+};
+
+class UnquoteForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr&, const EnvPtr&, Evaluator&) override {
+        throw SyntaxError{""};
+    }
+};
+
+}  // namespace
+
+void RegisterQuasiquoteForms(SpecialFormRegistry* registry) {
+    registry->Register("quasiquote", std::make_shared<QuasiquoteForm>());
+    registry->Register("unquote", std::make_shared<UnquoteForm>());
+    registry->Register("unquote-splicing", std::make_shared<UnquoteForm>());
+}
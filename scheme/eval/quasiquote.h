@@ -0,0 +1,11 @@
+#pragma once
+
+#include "eval/special_forms.h"
+
+// quasiquote, with unquote and unquote-splicing inside its template; nested quasiquotes raise
+// the level at which unquotes are evaluated. Each template is compiled once into a plan that
+// keeps the parts unquoting nothing as the constant data they are in the source, and builds
+// only the cells on the way to an unquoted value. The last list spliced into a list is shared
+// with the result rather than copied. Using unquote or unquote-splicing outside of quasiquote
+// is a syntax error.
+void RegisterQuasiquoteForms(SpecialFormRegistry* registry);
@@ -1,11 +1,25 @@
 #include "eval/special_forms.h"
 
+#include "eval/analyzer.h"
+#include "eval/closure_conversion.h"
+#include "eval/derived_forms.h"
 #include "eval/eval.h"
+#include "eval/exceptions.h"
+#include "eval/machine.h"
+#include "eval/macros.h"
+#include "eval/optimizer.h"
 #include "eval/procedure.h"
+#include "eval/promise.h"
+#include "eval/quasiquote.h"
+#include "eval/syntax.h"
+#include "eval/values.h"
 #include "runtime/error.h"
 #include "runtime/helpers.h"
-#include "runtime/list_utils.h"
 
+#include <array>
+#include <atomic>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -17,77 +31,453 @@ using CellPtr = std::shared_ptr<Cell>;
 using ArgsVec = std::vector<ObjectPtr>;
 using FormPtr = SpecialFormPtr;
 
-std::vector<std::string> ParseParamNames(const ObjectPtr& params_obj) {
-    std::vector<std::string> params;
-    ObjectPtr cur = params_obj;
-    while (cur) {
-        auto cell = As<Cell>(cur);
-        if (!cell) {
-            throw SyntaxError{""};
+using syntax::ParseFormals;
+using syntax::ToVectorOrSyntaxError;
+using syntax::UnpackOrSyntaxError;
+
+// Whether `name` is bound in the scope being analyzed, so no inline cache looks it up.
+bool IsLocal(const std::string& name, const Analyzer& analyzer) {
+    const auto& scope = analyzer.GetScope();
+    return scope && scope->Binds(name);
+}
+
+std::vector<NodePtr> AnalyzeEach(const ArgsVec& exprs, Analyzer& analyzer, bool tail) {
+    std::vector<NodePtr> nodes;
+    nodes.reserve(exprs.size());
+    for (auto i = 0; i < exprs.size(); ++i) {
+        nodes.push_back(analyzer.Analyze(exprs[i], tail && i + 1 == exprs.size()));
+    }
+    return nodes;
+}
+
+NodePtr AnalyzeLogic(const ObjectPtr& args, Analyzer& analyzer, bool tail, bool is_and);
+
+class IfNode : public Node {
+public:
+    IfNode(NodePtr cond, NodePtr then_branch, NodePtr else_branch)
+        : cond_(std::move(cond)),
+          then_(std::move(then_branch)),
+          else_(std::move(else_branch)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        auto cond = OneValue(cond_->Eval(env, evaluator));
+        if (IsFailure(cond)) {
+            return cond;
         }
-        auto sym = As<Symbol>(cell->GetFirst());
-        if (!sym) {
-            throw SyntaxError{""};
+        if (!helpers::IsFalse(cond)) {
+            return then_->Eval(env, evaluator);
+        }
+        if (else_) {
+            return else_->Eval(env, evaluator);
+        }
+        return nullptr;
+    }
+
+private:
+    NodePtr cond_;
+    NodePtr then_;
+    NodePtr else_;
+};
+
+class LambdaNode : public Node {
+public:
+    explicit LambdaNode(LambdaCodePtr code) : code_(std::move(code)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator&) override {
+        return std::make_shared<LambdaProcedure>(code_, env);
+    }
+
+private:
+    LambdaCodePtr code_;
+};
+
+// Closure-converted where AnalyzeClosure allows it.
+NodePtr AnalyzeLambda(LambdaCodePtr code, Analyzer& analyzer,
+                      const std::optional<std::string>& name = std::nullopt) {
+    if (auto node = AnalyzeClosure(code, analyzer, name)) {
+        return node;
+    }
+    return std::make_shared<LambdaNode>(std::move(code));
+}
+
+class DefineNode : public Node {
+public:
+    // `local` if the name is bound in the scope the node was analyzed in.
+    DefineNode(std::string name, NodePtr value, bool local)
+        : name_(std::move(name)), value_(std::move(value)), local_(local) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        auto value = OneValue(value_->Eval(env, evaluator));
+        if (IsFailure(value)) {
+            return value;
+        }
+        env->Define(name_, std::move(value));
+        if (!local_) {
+            evaluator.NoteRebinding(name_);
+        }
+        return nullptr;
+    }
+
+private:
+    std::string name_;
+    NodePtr value_;
+    bool local_;
+};
+
+class SetNode : public Node {
+public:
+    // `local` if the name is bound in the scope the node was analyzed in.
+    SetNode(std::string name, NodePtr value, bool local)
+        : name_(std::move(name)), value_(std::move(value)), local_(local) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        auto value = OneValue(value_->Eval(env, evaluator));
+        if (IsFailure(value)) {
+            return value;
+        }
+        if (!env->Assign(name_, std::move(value))) {
+            return Fail(Error::Name(name_));
+        }
+        if (!local_) {
+            evaluator.NoteRebinding(name_);
+        }
+        return nullptr;
+    }
+
+private:
+    std::string name_;
+    NodePtr value_;
+    bool local_;
+};
+
+// `and` when `is_and` holds, `or` otherwise.
+class LogicNode : public Node {
+public:
+    LogicNode(std::vector<NodePtr> nodes, bool is_and) : nodes_(std::move(nodes)), is_and_(is_and) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        if (nodes_.empty()) {
+            return MakeBool(is_and_);
+        }
+        for (size_t i = 0; i + 1 < nodes_.size(); ++i) {
+            auto value = OneValue(nodes_[i]->Eval(env, evaluator));
+            if (IsFailure(value)) {
+                return value;
+            }
+            if (helpers::IsFalse(value) == is_and_) {
+                return is_and_ ? False() : value;
+            }
+        }
+        return nodes_.back()->Eval(env, evaluator);
+    }
+
+private:
+    std::vector<NodePtr> nodes_;
+    bool is_and_;
+};
+
+// Operands whose value is known are dropped when they cannot decide the result; everything after
+// one that always short-circuits is unreachable.
+NodePtr AnalyzeLogic(const ObjectPtr& args, Analyzer& analyzer, bool tail, bool is_and) {
+    auto exprs = ToVectorOrSyntaxError(args);
+    std::vector<Assumption> assumptions;
+    ArgsVec kept;
+    for (auto i = 0; i < exprs.size(); ++i) {
+        auto folded = analyzer.TryFold(exprs[i]);
+        if (folded) {
+            auto decides = helpers::IsFalse(folded->value) == is_and;
+            if (decides || i + 1 < exprs.size()) {
+                assumptions.insert(assumptions.end(), folded->assumptions.begin(),
+                                   folded->assumptions.end());
+            }
+            if (decides) {
+                kept.push_back(exprs[i]);
+                break;
+            }
+            if (i + 1 < exprs.size()) {
+                continue;
+            }
         }
-        params.push_back(sym->GetName());
-        cur = cell->GetSecond();
+        kept.push_back(exprs[i]);
     }
-    return params;
+    auto pruned = std::make_shared<LogicNode>(AnalyzeEach(kept, analyzer, tail), is_and);
+    if (assumptions.empty()) {
+        return pruned;
+    }
+    auto full = std::make_shared<LogicNode>(AnalyzeEach(exprs, analyzer, tail), is_and);
+    return analyzer.Guard(std::move(assumptions), std::move(pruned), std::move(full));
 }
 
-ArgsVec ToVectorOrSyntaxError(const ObjectPtr& list) {
-    try {
-        return listutils::ToVector(list);
-    } catch (const RuntimeError&) {
+class IfFrame : public Frame {
+public:
+    IfFrame(ObjectPtr then_branch, ObjectPtr else_branch, bool has_else, EnvPtr env)
+        : then_(std::move(then_branch)),
+          else_(std::move(else_branch)),
+          has_else_(has_else),
+          env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        value = OneValue(std::move(value));
+        if (IsFailure(value)) {
+            machine.Return(std::move(value));
+        } else if (!helpers::IsFalse(value)) {
+            machine.Eval(then_, env_);
+        } else if (has_else_) {
+            machine.Eval(else_, env_);
+        } else {
+            machine.Return(nullptr);
+        }
+    }
+
+private:
+    ObjectPtr then_;
+    ObjectPtr else_;
+    bool has_else_;
+    EnvPtr env_;
+};
+
+// Binds the value of a define when `define` holds and assigns it as set! does otherwise.
+class AssignFrame : public Frame {
+public:
+    AssignFrame(std::string name, EnvPtr env, bool define)
+        : name_(std::move(name)), env_(std::move(env)), define_(define) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        value = OneValue(std::move(value));
+        if (IsFailure(value)) {
+            machine.Return(std::move(value));
+            return;
+        }
+        if (define_) {
+            env_->Define(name_, std::move(value));
+        } else if (!env_->Assign(name_, std::move(value))) {
+            machine.Return(Fail(Error::Name(name_)));
+            return;
+        }
+        machine.GetEvaluator().NoteRebinding(name_);
+        machine.Return(nullptr);
+    }
+
+private:
+    std::string name_;
+    EnvPtr env_;
+    bool define_;
+};
+
+void StepLogic(const ObjectPtr& args, const EnvPtr& env, Machine& machine, bool is_and);
+
+// Remaining operands of `and` or `or`.
+class LogicFrame : public Frame {
+public:
+    LogicFrame(ObjectPtr rest, EnvPtr env, bool is_and)
+        : rest_(std::move(rest)), env_(std::move(env)), is_and_(is_and) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        value = OneValue(std::move(value));
+        if (IsFailure(value)) {
+            machine.Return(std::move(value));
+            return;
+        }
+        if (helpers::IsFalse(value) == is_and_) {
+            machine.Return(is_and_ ? False() : std::move(value));
+            return;
+        }
+        StepLogic(rest_, env_, machine, is_and_);
+    }
+
+private:
+    ObjectPtr rest_;
+    EnvPtr env_;
+    bool is_and_;
+};
+
+// Evaluates the operands `args` of `and` or `or`, the last one in tail position.
+void StepLogic(const ObjectPtr& args, const EnvPtr& env, Machine& machine, bool is_and) {
+    auto cell = As<Cell>(args);
+    if (!cell) {
         throw SyntaxError{""};
     }
+    if (cell->GetSecond()) {
+        machine.Push(std::make_shared<LogicFrame>(cell->GetSecond(), env, is_and));
+    }
+    machine.Eval(cell->GetFirst(), env);
 }
 
 class QuoteForm : public SpecialForm {
 public:
     ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr&, Evaluator&) override {
-        auto vec = ToVectorOrSyntaxError(args);
-        if (vec.size() != 1) {
-            throw SyntaxError{""};
-        }
-        return vec[0];
+        return Parse(args);
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer, bool) override {
+        return analyzer.Constant(Parse(args));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr&, Machine& machine) override {
+        machine.Return(Parse(args));
+    }
+
+private:
+    static ObjectPtr Parse(const ObjectPtr& args) {
+        std::array<ObjectPtr, 1> datum;
+        UnpackOrSyntaxError(args, &datum, 1);
+        return datum[0];
     }
 };
 
 class IfForm : public SpecialForm {
 public:
     ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
-        auto vec = ToVectorOrSyntaxError(args);
-        if (vec.size() != 2 && vec.size() != 3) {
-            throw SyntaxError{""};
+        std::array<ObjectPtr, 3> vec;
+        auto count = Parse(args, &vec);
+        auto cond = OneValue(evaluator.Eval(vec[0], env));
+        if (IsFailure(cond)) {
+            return cond;
         }
-        auto cond = evaluator.Eval(vec[0], env);
         if (!helpers::IsFalse(cond)) {
-            return evaluator.Eval(vec[1], env);
+            return evaluator.EvalInTail(vec[1], env);
         }
-        if (vec.size() == 3) {
-            return evaluator.Eval(vec[2], env);
+        if (count == 3) {
+            return evaluator.EvalInTail(vec[2], env);
         }
         return nullptr;
     }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        std::array<ObjectPtr, 3> vec;
+        auto count = Parse(args, &vec);
+        auto then_branch = analyzer.Analyze(vec[1], tail);
+        auto else_branch = count == 3 ? analyzer.Analyze(vec[2], tail) : nullptr;
+        auto cond = analyzer.TryFold(vec[0]);
+        if (!cond) {
+            return std::make_shared<IfNode>(analyzer.Analyze(vec[0]), std::move(then_branch),
+                                            std::move(else_branch));
+        }
+        auto taken = helpers::IsFalse(cond->value) ? else_branch : then_branch;
+        if (!taken) {
+            taken = analyzer.Constant(nullptr);
+        }
+        auto full = std::make_shared<IfNode>(analyzer.Analyze(vec[0]), std::move(then_branch),
+                                             std::move(else_branch));
+        return analyzer.Guard(std::move(cond->assumptions), std::move(taken), std::move(full));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        std::array<ObjectPtr, 3> vec;
+        auto count = Parse(args, &vec);
+        machine.Push(
+            std::make_shared<IfFrame>(std::move(vec[1]), std::move(vec[2]), count == 3, env));
+        machine.Eval(std::move(vec[0]), env);
+    }
+
+private:
+    // Unpacks the condition and the branches into `parts` and returns their number.
+    static size_t Parse(const ObjectPtr& args, std::array<ObjectPtr, 3>* parts) {
+        return UnpackOrSyntaxError(args, parts, 2);
+    }
 };
 
 class LambdaForm : public SpecialForm {
 public:
     ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator&) override {
+        return std::make_shared<LambdaProcedure>(Parse(args, nullptr), env);
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer, bool) override {
+        return AnalyzeLambda(Parse(args, analyzer.GetScope()), analyzer);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        machine.Return(std::make_shared<LambdaProcedure>(Parse(args, nullptr), env));
+    }
+
+    static LambdaCodePtr Parse(const ObjectPtr& args, Scope::Ptr scope) {
         auto vec = ToVectorOrSyntaxError(args);
         if (vec.size() < 2) {
             throw SyntaxError{""};
         }
-        auto params = ParseParamNames(vec[0]);
+        auto formals = ParseFormals(vec[0]);
         ArgsVec body(vec.begin() + 1, vec.end());
-        return std::make_shared<LambdaProcedure>(std::move(params), std::move(body), env);
+        return std::make_shared<LambdaCode>(std::move(formals.names), std::move(body),
+                                            std::move(scope), std::move(formals.rest));
     }
 };
 
 class DefineForm : public SpecialForm {
 public:
     ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        auto definition = Parse(args, nullptr);
+        ObjectPtr value;
+        if (definition.code) {
+            value = std::make_shared<LambdaProcedure>(std::move(definition.code), env);
+        } else {
+            value = OneValue(evaluator.Eval(definition.value, env));
+            if (IsFailure(value)) {
+                return value;
+            }
+        }
+        env->Define(definition.name, std::move(value));
+        evaluator.NoteRebinding(definition.name);
+        return nullptr;
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool) override {
+        auto definition = Parse(args, analyzer.GetScope());
+        NodePtr value;
+        if (definition.code) {
+            value = AnalyzeLambda(std::move(definition.code), analyzer, definition.name);
+        } else if (auto lambda = AsLambda(definition.value, analyzer.GetSpecialForms())) {
+            value = AnalyzeLambda(LambdaForm::Parse(lambda->GetSecond(), analyzer.GetScope()),
+                                  analyzer, definition.name);
+        } else {
+            value = analyzer.Analyze(definition.value);
+        }
+        auto local = IsLocal(definition.name, analyzer);
+        return std::make_shared<DefineNode>(std::move(definition.name), std::move(value), local);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        auto definition = Parse(args, nullptr);
+        if (definition.code) {
+            env->Define(definition.name,
+                        std::make_shared<LambdaProcedure>(std::move(definition.code), env));
+            machine.GetEvaluator().NoteRebinding(definition.name);
+            machine.Return(nullptr);
+            return;
+        }
+        machine.Push(std::make_shared<AssignFrame>(std::move(definition.name), env, true));
+        machine.Eval(std::move(definition.value), env);
+    }
+
+private:
+    // `expr` if it is a lambda expression.
+    static CellPtr AsLambda(const ObjectPtr& expr, const SpecialFormRegistry& forms) {
+        auto cell = As<Cell>(expr);
+        auto head = cell ? As<Symbol>(cell->GetFirst()) : nullptr;
+        if (!head || !dynamic_cast<LambdaForm*>(forms.Lookup(*head))) {
+            return nullptr;
+        }
+        return cell;
+    }
+
+    // Either `(define name value)` or the `(define (name params...) body...)` sugar.
+    struct Definition {
+        std::string name;
+        ObjectPtr value;
+        LambdaCodePtr code;
+    };
+
+    static Definition Parse(const ObjectPtr& args, Scope::Ptr scope) {
         auto vec = ToVectorOrSyntaxError(args);
         if (vec.size() < 2) {
             throw SyntaxError{""};
@@ -97,9 +487,7 @@ public:
             if (vec.size() != 2) {
                 throw SyntaxError{""};
             }
-            auto value = evaluator.Eval(vec[1], env);
-            env->Define(name->GetName(), std::move(value));
-            return nullptr;
+            return {name->GetName(), vec[1], nullptr};
         }
 
         auto signature = As<Cell>(vec[0]);
@@ -110,30 +498,54 @@ public:
         if (!name) {
             throw SyntaxError{""};
         }
-        auto params_obj = signature->GetSecond();
-        auto params = ParseParamNames(params_obj);
+        auto formals = ParseFormals(signature->GetSecond());
         ArgsVec body(vec.begin() + 1, vec.end());
-        auto lambda = std::make_shared<LambdaProcedure>(std::move(params), std::move(body), env);
-        env->Define(name->GetName(), std::move(lambda));
-        return nullptr;
+        return {name->GetName(), nullptr,
+                std::make_shared<LambdaCode>(std::move(formals.names), std::move(body),
+                                             std::move(scope), std::move(formals.rest))};
     }
 };
 
 class SetForm : public SpecialForm {
 public:
     ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
-        auto vec = ToVectorOrSyntaxError(args);
-        if (vec.size() != 2) {
-            throw SyntaxError{""};
+        std::array<ObjectPtr, 2> vec;
+        const auto& name = Parse(args, &vec);
+        auto value = OneValue(evaluator.Eval(vec[1], env));
+        if (IsFailure(value)) {
+            return value;
         }
-        auto name = As<Symbol>(vec[0]);
-        if (!name) {
-            throw SyntaxError{""};
+        if (!env->Assign(name, std::move(value))) {
+            return Fail(Error::Name(name));
         }
-        auto value = evaluator.Eval(vec[1], env);
-        env->Set(name->GetName(), std::move(value));
+        evaluator.NoteRebinding(name);
         return nullptr;
     }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool) override {
+        std::array<ObjectPtr, 2> vec;
+        const auto& name = Parse(args, &vec);
+        return std::make_shared<SetNode>(name, analyzer.Analyze(vec[1]), IsLocal(name, analyzer));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        std::array<ObjectPtr, 2> vec;
+        const auto& name = Parse(args, &vec);
+        machine.Push(std::make_shared<AssignFrame>(name, env, false));
+        machine.Eval(std::move(vec[1]), env);
+    }
+
+private:
+    // Unpacks the target and the value into `parts` and returns the name of the target.
+    static const std::string& Parse(const ObjectPtr& args, std::array<ObjectPtr, 2>* parts) {
+        UnpackOrSyntaxError(args, parts, 2);
+        auto* symbol = dynamic_cast<Symbol*>((*parts)[0].get());
+        if (!symbol) {
+            throw SyntaxError{""};
+        }
+        return symbol->GetName();
+    }
 };
 
 class AndForm : public SpecialForm {
@@ -149,7 +561,13 @@ public:
             if (!cell) {
                 throw SyntaxError{""};
             }
-            last = evaluator.Eval(cell->GetFirst(), env);
+            if (!cell->GetSecond()) {
+                return evaluator.EvalInTail(cell->GetFirst(), env);
+            }
+            last = OneValue(evaluator.Eval(cell->GetFirst(), env));
+            if (IsFailure(last)) {
+                return last;
+            }
             if (helpers::IsFalse(last)) {
                 return False();
             }
@@ -157,6 +575,19 @@ public:
         }
         return last;
     }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        return AnalyzeLogic(args, analyzer, tail, true);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        if (!args) {
+            machine.Return(True());
+            return;
+        }
+        StepLogic(args, env, machine, true);
+    }
 };
 
 class OrForm : public SpecialForm {
@@ -172,7 +603,10 @@ public:
             if (!cell) {
                 throw SyntaxError{""};
             }
-            last = evaluator.Eval(cell->GetFirst(), env);
+            if (!cell->GetSecond()) {
+                return evaluator.EvalInTail(cell->GetFirst(), env);
+            }
+            last = OneValue(evaluator.Eval(cell->GetFirst(), env));
             if (!helpers::IsFalse(last)) {
                 return last;
             }
@@ -180,12 +614,68 @@ public:
         }
         return last;
     }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        return AnalyzeLogic(args, analyzer, tail, false);
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        if (!args) {
+            machine.Return(False());
+            return;
+        }
+        StepLogic(args, env, machine, false);
+    }
 };
 
 }  // namespace
 
+NodePtr SpecialForm::Analyze(const ObjectPtr& expr, const ObjectPtr&, Analyzer& analyzer, bool) {
+    return analyzer.Fallback(expr);
+}
+
+void SpecialForm::Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) {
+    machine.Return(Evaluate(args, env, machine.GetEvaluator()));
+}
+
+namespace {
+
+uint64_t NextRegistryId() {
+    static std::atomic<uint64_t> next_id = 1;
+    return next_id++;
+}
+
+}  // namespace
+
+SpecialFormRegistry::SpecialFormRegistry() : id_(NextRegistryId()) {
+}
+
+SpecialFormRegistry::SpecialFormRegistry(const SpecialFormRegistry& other)
+    : forms_(other.forms_), id_(NextRegistryId()) {
+}
+
+SpecialFormRegistry::SpecialFormRegistry(SpecialFormRegistry&& other) noexcept
+    : forms_(std::move(other.forms_)), id_(NextRegistryId()) {
+    other.id_ = NextRegistryId();
+}
+
+SpecialFormRegistry& SpecialFormRegistry::operator=(const SpecialFormRegistry& other) {
+    forms_ = other.forms_;
+    id_ = NextRegistryId();
+    return *this;
+}
+
+SpecialFormRegistry& SpecialFormRegistry::operator=(SpecialFormRegistry&& other) noexcept {
+    forms_ = std::move(other.forms_);
+    id_ = NextRegistryId();
+    other.id_ = NextRegistryId();
+    return *this;
+}
+
 void SpecialFormRegistry::Register(const std::string& name, FormPtr form) {
     forms_[name] = std::move(form);
+    id_ = NextRegistryId();
 }
 
 SpecialFormPtr SpecialFormRegistry::Lookup(const std::string& name) const {
@@ -196,6 +686,16 @@ SpecialFormPtr SpecialFormRegistry::Lookup(const std::string& name) const {
     return nullptr;
 }
 
+SpecialForm* SpecialFormRegistry::Lookup(const Symbol& symbol) const {
+    auto& cache = symbol.GetFormCache();
+    if (cache.registry != id_) {
+        auto it = forms_.find(symbol.GetName());
+        cache.form = it != forms_.end() ? it->second.get() : nullptr;
+        cache.registry = id_;
+    }
+    return cache.form;
+}
+
 SpecialFormRegistry CreateStandardForms() {
     SpecialFormRegistry registry;
     registry.Register("quote", std::make_shared<QuoteForm>());
@@ -205,5 +705,11 @@ SpecialFormRegistry CreateStandardForms() {
     registry.Register("set!", std::make_shared<SetForm>());
     registry.Register("and", std::make_shared<AndForm>());
     registry.Register("or", std::make_shared<OrForm>());
+    RegisterDerivedForms(&registry);
+    RegisterValuesForms(&registry);
+    RegisterQuasiquoteForms(&registry);
+    RegisterExceptionForms(&registry);
+    RegisterPromiseForms(&registry);
+    RegisterMacroForms(&registry);
     return registry;
 }
@@ -1,13 +1,17 @@
 #pragma once
 
+#include "eval/node.h"
 #include "runtime/env.h"
 #include "runtime/object.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
 
+class Analyzer;
 class Evaluator;
+class Machine;
 
 class SpecialForm {
 public:
@@ -17,18 +21,44 @@ public:
     virtual ~SpecialForm() = default;
 
     virtual ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) = 0;
+
+    // Builds a node for `expr`, whose tail is `args`. Forms that do not override this are
+    // evaluated through Evaluate every time.
+    virtual NodePtr Analyze(const ObjectPtr& expr, const ObjectPtr& args, Analyzer& analyzer,
+                            bool tail);
+
+    // Makes the next steps of `machine` evaluate the form with tail `args`, ending with the value
+    // of the form passed to the current continuation. Forms that do not override this run through
+    // Evaluate in a single step, so continuations captured inside them can only escape.
+    virtual void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine);
 };
 
 using SpecialFormPtr = std::shared_ptr<SpecialForm>;
 
 class SpecialFormRegistry {
 public:
+    SpecialFormRegistry();
+    SpecialFormRegistry(const SpecialFormRegistry& other);
+    SpecialFormRegistry(SpecialFormRegistry&& other) noexcept;
+    SpecialFormRegistry& operator=(const SpecialFormRegistry& other);
+    SpecialFormRegistry& operator=(SpecialFormRegistry&& other) noexcept;
+
     void Register(const std::string& name, SpecialFormPtr form);
 
     SpecialFormPtr Lookup(const std::string& name) const;
 
+    // Same as looking up the name of `symbol`, but the result is cached on the symbol. Every
+    // registry and every change to one gets a fresh id, so a cached result is never stale.
+    SpecialForm* Lookup(const Symbol& symbol) const;
+
+    // Id of the registry as it is now; see Lookup.
+    uint64_t GetId() const {
+        return id_;
+    }
+
 private:
     std::unordered_map<std::string, SpecialFormPtr> forms_;
+    uint64_t id_;
 };
 
 SpecialFormRegistry CreateStandardForms();
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "runtime/error.h"
+#include "runtime/list_utils.h"
+#include "runtime/object.h"
+
+#include <array>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Helpers for taking special forms apart. Malformed forms throw SyntaxError.
+namespace syntax {
+
+using ObjectPtr = std::shared_ptr<Object>;
+
+// Parameters of a lambda: a name for each argument, and a rest parameter for a list of the ones
+// past those if the list of formals ends in a name, as in `(a b . rest)` or `rest`.
+struct Formals {
+    std::vector<std::string> names;
+    std::optional<std::string> rest;
+};
+
+inline Formals ParseFormals(const ObjectPtr& formals) {
+    auto name_of = [](const ObjectPtr& obj) {
+        auto sym = As<Symbol>(obj);
+        if (!sym) {
+            throw SyntaxError{""};
+        }
+        return sym->GetName();
+    };
+    Formals parsed;
+    auto cur = formals;
+    while (auto cell = As<Cell>(cur)) {
+        parsed.names.push_back(name_of(cell->GetFirst()));
+        cur = cell->GetSecond();
+    }
+    if (cur) {
+        parsed.rest = name_of(cur);
+    }
+    return parsed;
+}
+
+// Copies the items of `list` into `out` without allocating and returns their number, which must
+// be between `min` and N.
+template <size_t N>
+size_t UnpackOrSyntaxError(const ObjectPtr& list, std::array<ObjectPtr, N>* out, size_t min) {
+    size_t count = 0;
+    for (auto cur = list; cur; ++count) {
+        auto cell = As<Cell>(cur);
+        if (!cell || count == N) {
+            throw SyntaxError{""};
+        }
+        (*out)[count] = cell->GetFirst();
+        cur = cell->GetSecond();
+    }
+    if (count < min) {
+        throw SyntaxError{""};
+    }
+    return count;
+}
+
+inline std::vector<ObjectPtr> ToVectorOrSyntaxError(const ObjectPtr& list) {
+    if (!listutils::IsProperList(list)) {
+        throw SyntaxError{""};
+    }
+    return listutils::ToVector(list);
+}
+
+}  // namespace syntax
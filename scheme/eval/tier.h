@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// Execution tier of a lambda body. Cold bodies are walked as raw expressions, warm bodies run
+// from analyzed nodes and hot bodies are re-analyzed with every optimization available. Analyzed
+// bodies run self calls in tail position as iterations of the Apply loop.
+enum class Tier { Cold, Warm, Hot };
+
+// A body is promoted once calls plus loop iterations of its lambda reach the threshold.
+struct TierPolicy {
+    uint64_t warm_threshold = 8;
+    uint64_t hot_threshold = 1000;
+};
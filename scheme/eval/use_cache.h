@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+class Object;
+
+// Values special forms derive from the source of one of their uses, such as a macro expansion,
+// kept as long as the use itself. Entries are keyed on the cell holding the arguments of the use,
+// which the cache refers to weakly, so code that is dropped takes its entries with it.
+template <class T>
+class UseCache {
+public:
+    // Value for the use with tail `args`, made by `make(args)` the first time. Returned by value,
+    // as making a value may itself add entries to the cache.
+    template <class Make>
+    T Get(const std::shared_ptr<Object>& args, Make make) {
+        if (!args) {
+            if (!empty_) {
+                empty_ = make(args);
+            }
+            return *empty_;
+        }
+        auto it = entries_.find(args.get());
+        if (it != entries_.end() && !it->second.args.expired()) {
+            return it->second.value;
+        }
+        auto value = make(args);
+        if (entries_.size() >= purge_size_) {
+            Purge();
+        }
+        entries_.insert_or_assign(args.get(), Entry{args, value});
+        return value;
+    }
+
+private:
+    struct Entry {
+        std::weak_ptr<Object> args;
+        T value;
+    };
+
+    // Expired entries are purged whenever the cache grows to this many or twice the entries left
+    // by the previous purge.
+    static constexpr size_t kMinPurgeSize = 64;
+
+    void Purge() {
+        std::erase_if(entries_, [](const auto& entry) { return entry.second.args.expired(); });
+        purge_size_ = std::max(kMinPurgeSize, 2 * entries_.size());
+    }
+
+    std::unordered_map<const Object*, Entry> entries_;
+    // Value for the use without arguments, which has no cell to key it on.
+    std::optional<T> empty_;
+    size_t purge_size_ = kMinPurgeSize;
+};
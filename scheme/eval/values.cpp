@@ -0,0 +1,302 @@
+#include "eval/values.h"
+
+#include "eval/analyzer.h"
+#include "eval/derived_forms.h"
+#include "eval/eval.h"
+#include "eval/machine.h"
+#include "eval/syntax.h"
+#include "runtime/error.h"
+#include "runtime/helpers.h"
+#include "runtime/list_utils.h"
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using ObjectPtr = SpecialForm::ObjectPtr;
+using EnvPtr = SpecialForm::EnvPtr;
+using ArgsVec = std::vector<ObjectPtr>;
+
+using syntax::ToVectorOrSyntaxError;
+
+thread_local ArgsBuffer pending_values;
+
+using syntax::Formals;
+
+// Parses `formals`, adding the names it binds to `bound`, which they must not be in yet.
+Formals ParseFormals(const ObjectPtr& formals, std::vector<std::string>* bound) {
+    auto parsed = syntax::ParseFormals(formals);
+    auto add = [bound](const std::string& name) {
+        for (const auto& other : *bound) {
+            if (other == name) {
+                throw SyntaxError{""};
+            }
+        }
+        bound->push_back(name);
+    };
+    for (const auto& name : parsed.names) {
+        add(name);
+    }
+    if (parsed.rest) {
+        add(*parsed.rest);
+    }
+    return parsed;
+}
+
+// Whether `formals` take `count` values. Fails with a runtime error if not.
+bool Accepts(const Formals& formals, size_t count) {
+    if (count == formals.names.size() || (formals.rest && count > formals.names.size())) {
+        return true;
+    }
+    Fail(Error::Runtime("Invalid argument count"));
+    return false;
+}
+
+// Calls `bind(name, value)` for each variable of `formals`, which accept `values`.
+template <class Bind>
+void ForEachBinding(const Formals& formals, Args values, Bind bind) {
+    for (size_t i = 0; i < formals.names.size(); ++i) {
+        bind(formals.names[i], values[i]);
+    }
+    if (formals.rest) {
+        bind(*formals.rest, listutils::FromVector(values.subspan(formals.names.size())));
+    }
+}
+
+// `(((formals) init) ...) body...` of let-values, or `formals init body...` of receive.
+struct ValuesBindings {
+    std::vector<Formals> formals;
+    ArgsVec inits;
+    // Every name bound, in order.
+    std::vector<std::string> names;
+    // Non-empty proper list.
+    ObjectPtr body;
+};
+
+using ValuesBindingsPtr = std::shared_ptr<const ValuesBindings>;
+
+void SetBody(const ObjectPtr& body, ValuesBindings* bindings) {
+    if (!Is<Cell>(body) || !listutils::IsProperList(body)) {
+        throw SyntaxError{""};
+    }
+    bindings->body = body;
+}
+
+ValuesBindings ParseLetValues(const ObjectPtr& args) {
+    auto form = As<Cell>(args);
+    if (!form) {
+        throw SyntaxError{""};
+    }
+    ValuesBindings bindings;
+    for (const auto& binding : ToVectorOrSyntaxError(form->GetFirst())) {
+        std::array<ObjectPtr, 2> parts;
+        syntax::UnpackOrSyntaxError(binding, &parts, 2);
+        bindings.formals.push_back(ParseFormals(parts[0], &bindings.names));
+        bindings.inits.push_back(std::move(parts[1]));
+    }
+    SetBody(form->GetSecond(), &bindings);
+    return bindings;
+}
+
+ValuesBindings ParseReceive(const ObjectPtr& args) {
+    auto form = As<Cell>(args);
+    auto rest = form ? As<Cell>(form->GetSecond()) : nullptr;
+    if (!rest) {
+        throw SyntaxError{""};
+    }
+    ValuesBindings bindings;
+    bindings.formals.push_back(ParseFormals(form->GetFirst(), &bindings.names));
+    bindings.inits.push_back(rest->GetFirst());
+    SetBody(rest->GetSecond(), &bindings);
+    return bindings;
+}
+
+// Binds the values of `value` to `formals` in `env`; false if they do not fit.
+bool BindValues(const Formals& formals, ObjectPtr value, Environment& env) {
+    ArgsBuffer values;
+    TakeValues(std::move(value), &values);
+    if (!Accepts(formals, values.Size())) {
+        return false;
+    }
+    ForEachBinding(formals, values.Get(),
+                   [&env](const std::string& name, ObjectPtr value) {
+                       env.Define(name, std::move(value));
+                   });
+    return true;
+}
+
+class LetValuesNode : public Node {
+public:
+    LetValuesNode(ValuesBindingsPtr bindings, std::vector<NodePtr> inits, NodePtr body)
+        : bindings_(std::move(bindings)), inits_(std::move(inits)), body_(std::move(body)) {
+    }
+
+    ObjectPtr Eval(const EnvPtr& env, Evaluator& evaluator) override {
+        auto let_env = std::make_shared<Environment>(env);
+        for (size_t i = 0; i < inits_.size(); ++i) {
+            auto value = inits_[i]->Eval(env, evaluator);
+            if (IsFailure(value)) {
+                return value;
+            }
+            if (!BindValues(bindings_->formals[i], std::move(value), *let_env)) {
+                return Failure();
+            }
+        }
+        return body_->Eval(let_env, evaluator);
+    }
+
+private:
+    ValuesBindingsPtr bindings_;
+    std::vector<NodePtr> inits_;
+    NodePtr body_;
+};
+
+void ContinueLetValues(Machine& machine, ValuesBindingsPtr bindings, size_t index,
+                       ArgsVec values, const EnvPtr& env);
+
+// Inits of a let-values evaluated so far. Keeps its own copy of the values bound, so resuming it
+// through a captured continuation binds fresh variables.
+class LetValuesFrame : public Frame {
+public:
+    LetValuesFrame(ValuesBindingsPtr bindings, size_t index, ArgsVec values, EnvPtr env)
+        : bindings_(std::move(bindings)), index_(index), values_(std::move(values)),
+          env_(std::move(env)) {
+    }
+
+    void Resume(ObjectPtr value, Machine& machine) const override {
+        ArgsBuffer taken;
+        TakeValues(std::move(value), &taken);
+        const auto& formals = bindings_->formals[index_];
+        if (!Accepts(formals, taken.Size())) {
+            machine.Return(Failure());
+            return;
+        }
+        auto values = values_;
+        ForEachBinding(formals, taken.Get(), [&values](const std::string&, ObjectPtr value) {
+            values.push_back(std::move(value));
+        });
+        ContinueLetValues(machine, bindings_, index_ + 1, std::move(values), env_);
+    }
+
+private:
+    ValuesBindingsPtr bindings_;
+    size_t index_;
+    ArgsVec values_;
+    EnvPtr env_;
+};
+
+void ContinueLetValues(Machine& machine, ValuesBindingsPtr bindings, size_t index,
+                       ArgsVec values, const EnvPtr& env) {
+    if (index < bindings->inits.size()) {
+        const auto& init = bindings->inits[index];
+        machine.Push(
+            std::make_shared<LetValuesFrame>(std::move(bindings), index, std::move(values), env));
+        machine.Eval(init, env);
+        return;
+    }
+    auto let_env = std::make_shared<Environment>(env);
+    for (size_t i = 0; i < values.size(); ++i) {
+        let_env->Define(bindings->names[i], std::move(values[i]));
+    }
+    StepSequence(bindings->body, let_env, machine);
+}
+
+// let-values, or receive when `Parse` parses its form.
+template <ValuesBindings (*Parse)(const ObjectPtr&)>
+class ValuesBindingForm : public SpecialForm {
+public:
+    ObjectPtr Evaluate(const ObjectPtr& args, const EnvPtr& env, Evaluator& evaluator) override {
+        auto bindings = Parse(args);
+        auto let_env = std::make_shared<Environment>(env);
+        for (size_t i = 0; i < bindings.inits.size(); ++i) {
+            auto value = evaluator.Eval(bindings.inits[i], env);
+            if (IsFailure(value)) {
+                return value;
+            }
+            if (!BindValues(bindings.formals[i], std::move(value), *let_env)) {
+                return Failure();
+            }
+        }
+        return EvalSequence(bindings.body, let_env, evaluator);
+    }
+
+    NodePtr Analyze(const ObjectPtr&, const ObjectPtr& args, Analyzer& analyzer,
+                    bool tail) override {
+        auto bindings = std::make_shared<const ValuesBindings>(Parse(args));
+        std::vector<NodePtr> inits;
+        inits.reserve(bindings->inits.size());
+        for (const auto& init : bindings->inits) {
+            inits.push_back(analyzer.Analyze(init));
+        }
+        auto body_exprs = ToVectorOrSyntaxError(bindings->body);
+        auto scope = Scope::ForLambda(bindings->names, body_exprs, analyzer.GetScope(),
+                                      analyzer.GetSpecialForms());
+        auto body = analyzer.AnalyzeBodyIn(scope, body_exprs, tail);
+        return std::make_shared<LetValuesNode>(std::move(bindings), std::move(inits),
+                                               std::move(body));
+    }
+
+    void Step(const ObjectPtr& args, const EnvPtr& env, Machine& machine) override {
+        ContinueLetValues(machine, std::make_shared<const ValuesBindings>(Parse(args)), 0, {},
+                          env);
+    }
+};
+
+}  // namespace
+
+const std::shared_ptr<Object>& MultipleValues() {
+    static const std::shared_ptr<Object> marker = std::make_shared<Object>();
+    return marker;
+}
+
+std::shared_ptr<Object> ReturnValues(Args values) {
+    if (values.size() == 1) {
+        return values[0];
+    }
+    pending_values.Assign(values);
+    return MultipleValues();
+}
+
+void TakeValues(std::shared_ptr<Object> value, ArgsBuffer* out) {
+    if (value != MultipleValues()) {
+        out->Clear();
+        out->Push(std::move(value));
+        return;
+    }
+    *out = std::move(pending_values);
+    pending_values.Clear();
+}
+
+std::shared_ptr<Object> OneValue(std::shared_ptr<Object> value) {
+    if (value != MultipleValues()) [[likely]] {
+        return value;
+    }
+    pending_values.Clear();
+    return Fail(Error::Runtime("Expected one value"));
+}
+
+Procedure::ObjectPtr CallWithValues::Apply(Args args, const EnvPtr& env, Evaluator& evaluator) {
+    if (!helpers::RequireArgsCount(args, 2)) {
+        return Failure();
+    }
+    auto producer = As<Procedure>(args[0]);
+    auto consumer = As<Procedure>(args[1]);
+    if (!producer || !consumer) {
+        return Fail(Error::Runtime("Not a procedure"));
+    }
+    auto value = producer->Apply({}, env, evaluator);
+    if (IsFailure(value)) {
+        return value;
+    }
+    ArgsBuffer values;
+    TakeValues(std::move(value), &values);
+    return consumer->Apply(values.Get(), env, evaluator);
+}
+
+void RegisterValuesForms(SpecialFormRegistry* registry) {
+    registry->Register("let-values", std::make_shared<ValuesBindingForm<ParseLetValues>>());
+    registry->Register("receive", std::make_shared<ValuesBindingForm<ParseReceive>>());
+}
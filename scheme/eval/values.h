@@ -0,0 +1,37 @@
+#pragma once
+
+#include "eval/args.h"
+#include "eval/procedure.h"
+#include "eval/special_forms.h"
+
+#include <memory>
+
+// Multiple values travel like errors do. A procedure returning other than one value stores them
+// in a register of the current thread and returns the MultipleValues() marker in place of a
+// value; the receiver takes them back with TakeValues before evaluating anything else. Up to
+// ArgsBuffer::kInlineArgs values are passed without allocating anything.
+const std::shared_ptr<Object>& MultipleValues();
+
+// `values` as the value of a call: the one value itself, or MultipleValues() with `values`
+// stored in the register.
+std::shared_ptr<Object> ReturnValues(Args values);
+
+// Moves the values `value` stands for into `out`: the ones in the register if it is
+// MultipleValues(), otherwise `value` alone.
+void TakeValues(std::shared_ptr<Object> value, ArgsBuffer* out);
+
+// `value` if it is one value. Arguments, bindings and tests take exactly one: MultipleValues()
+// there fails with a runtime error and drops the values from the register.
+std::shared_ptr<Object> OneValue(std::shared_ptr<Object> value);
+
+// call-with-values. Applies the producer to no arguments and the consumer to its values. The
+// Machine applies it itself, so that the producer runs on the machine too.
+class CallWithValues final : public Procedure {
+public:
+    ObjectPtr Apply(Args args, const EnvPtr& env, Evaluator& evaluator) override;
+};
+
+// receive and let-values, which bind the values of their expressions to lists of formals such
+// as `(a b)`, `(a . rest)` or `rest`. Values are bound as they are taken from the register, so
+// only a rest variable allocates.
+void RegisterValuesForms(SpecialFormRegistry* registry);
@@ -9,6 +9,19 @@ void ThrowSyntax() {
     throw SyntaxError{""};
 }
 
+std::shared_ptr<Object> ReadInternal(Tokenizer* tokenizer);
+
+// `(name datum)` for the datum following a prefix such as `'`.
+std::shared_ptr<Object> ReadAbbreviation(Tokenizer* tokenizer, const char* name) {
+    tokenizer->Next();
+    if (tokenizer->IsEnd()) {
+        ThrowSyntax();
+    }
+    auto datum = ReadInternal(tokenizer);
+    auto name_sym = std::make_shared<Symbol>(name);
+    return std::make_shared<Cell>(name_sym, std::make_shared<Cell>(datum, nullptr));
+}
+
 std::shared_ptr<Object> ReadInternal(Tokenizer* tokenizer) {
     Token token = tokenizer->GetToken();
     if (ConstantToken* number = std::get_if<ConstantToken>(&token)) {
@@ -33,13 +46,13 @@ std::shared_ptr<Object> ReadInternal(Tokenizer* tokenizer) {
         return ReadList(tokenizer);
     }
     if (std::holds_alternative<QuoteToken>(token)) {
-        tokenizer->Next();
-        if (tokenizer->IsEnd()) {
-            ThrowSyntax();
-        }
-        auto quoted = ReadInternal(tokenizer);
-        auto quote_sym = std::make_shared<Symbol>("quote");
-        return std::make_shared<Cell>(quote_sym, std::make_shared<Cell>(quoted, nullptr));
+        return ReadAbbreviation(tokenizer, "quote");
+    }
+    if (std::holds_alternative<QuasiquoteToken>(token)) {
+        return ReadAbbreviation(tokenizer, "quasiquote");
+    }
+    if (UnquoteToken* unquote = std::get_if<UnquoteToken>(&token)) {
+        return ReadAbbreviation(tokenizer, unquote->splicing ? "unquote-splicing" : "unquote");
     }
     if (std::holds_alternative<DotToken>(token)) {
         ThrowSyntax();
@@ -95,11 +108,15 @@ std::shared_ptr<Object> ReadList(Tokenizer* tokenizer) {
     }
 }
 
-std::shared_ptr<Object> Read(Tokenizer* tokenizer) {
+std::shared_ptr<Object> ReadNext(Tokenizer* tokenizer) {
     if (tokenizer->IsEnd()) {
         ThrowSyntax();
     }
-    std::shared_ptr<Object> result = ReadInternal(tokenizer);
+    return ReadInternal(tokenizer);
+}
+
+std::shared_ptr<Object> Read(Tokenizer* tokenizer) {
+    std::shared_ptr<Object> result = ReadNext(tokenizer);
     if (!tokenizer->IsEnd()) {
         ThrowSyntax();
     }
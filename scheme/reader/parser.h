@@ -5,4 +5,8 @@
 
 #include <memory>
 
+// The only datum left in the input.
 std::shared_ptr<Object> Read(Tokenizer* tokenizer);
+
+// The next datum of the input, which may go on with more of them.
+std::shared_ptr<Object> ReadNext(Tokenizer* tokenizer);
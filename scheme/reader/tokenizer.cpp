@@ -11,8 +11,8 @@ Char Classify(char ch) {
         return Char::Whitespace;
     }
 
-    std::string_view start = "<=>*#";
-    std::string_view body = "<=>*#?!-";
+    std::string_view start = "<=>*#_";
+    std::string_view body = "<=>*#?!-/_";
 
     if (std::isalpha(uch) || start.find(ch) != std::string_view::npos) {
         return Char::SymbolStart;
@@ -117,9 +117,30 @@ bool Tokenizer::ReadToken(Token& out) {
             in_->get();
             out = QuoteToken{};
             return true;
+        } else if (ch == '`') {
+            in_->get();
+            out = QuasiquoteToken{};
+            return true;
+        } else if (ch == ',') {
+            in_->get();
+            out = UnquoteToken{in_->peek() == '@'};
+            if (in_->peek() == '@') {
+                in_->get();
+            }
+            return true;
         } else if (ch == '.') {
             in_->get();
             out = DotToken{};
+            // The ellipsis of syntax-rules is the one symbol made of dots.
+            if (in_->peek() == '.') {
+                in_->get();
+                if (in_->peek() == '.') {
+                    in_->get();
+                    out = SymbolToken{"..."};
+                } else {
+                    in_->unget();
+                }
+            }
             return true;
         } else if (ch == '/') {
             in_->get();
@@ -19,6 +19,20 @@ struct QuoteToken {
     }
 };
 
+struct QuasiquoteToken {
+    bool operator==(const QuasiquoteToken&) const {
+        return true;
+    }
+};
+
+// `,` or, if `splicing`, `,@`.
+struct UnquoteToken {
+    bool splicing;
+    bool operator==(const UnquoteToken& other) const {
+        return splicing == other.splicing;
+    }
+};
+
 struct DotToken {
     bool operator==(const DotToken&) const {
         return true;
@@ -34,7 +48,8 @@ struct ConstantToken {
     }
 };
 
-using Token = std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken>;
+using Token = std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, QuasiquoteToken,
+                           UnquoteToken, DotToken>;
 
 class Tokenizer {
 public:
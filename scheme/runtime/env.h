@@ -4,7 +4,9 @@
 #include "runtime/object.h"
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 class Environment : public std::enable_shared_from_this<Environment> {
@@ -16,32 +18,66 @@ public:
     explicit Environment(Ptr parent = nullptr) : parent_(std::move(parent)) {
     }
 
-    void Define(const std::string& name, ObjectPtr value) {
-        values_[name] = std::move(value);
+    // Binds `name` here and returns its slot, which stays valid for the life of the environment.
+    ObjectPtr& Define(const std::string& name, ObjectPtr value) {
+        auto& slot = values_[name];
+        slot = std::move(value);
+        return slot;
     }
 
-    ObjectPtr Lookup(const std::string& name) const {
-        auto it = values_.find(name);
-        if (it != values_.end()) {
-            return it->second;
+    // Slot bound to `name` here or in a parent, nullptr if the name is unbound. An alias made
+    // by GlobalAlias that nothing binds resolves to the global it stands for.
+    const ObjectPtr* Find(const std::string& name) const {
+        for (auto* env = this;; env = env->parent_.get()) {
+            auto it = env->values_.find(name);
+            if (it != env->values_.end()) {
+                return &it->second;
+            }
+            if (!env->parent_) {
+                return env->FindAliased(name);
+            }
         }
-        if (parent_) {
-            return parent_->Lookup(name);
+    }
+
+    // Slot bound to `name` in this environment itself, ignoring its parents.
+    const ObjectPtr* FindLocal(const std::string& name) const {
+        auto it = values_.find(name);
+        return it != values_.end() ? &it->second : nullptr;
+    }
+
+    ObjectPtr Lookup(const std::string& name) const {
+        if (auto* value = Find(name)) {
+            return *value;
         }
         throw NameError{name};
     }
 
-    void Set(const std::string& name, ObjectPtr value) {
-        auto it = values_.find(name);
-        if (it != values_.end()) {
-            it->second = std::move(value);
-            return;
+    // Rebinds an existing name, resolved as Find does; false if it is unbound.
+    bool Assign(const std::string& name, ObjectPtr value) {
+        for (auto* env = this;; env = env->parent_.get()) {
+            auto it = env->values_.find(name);
+            if (it == env->values_.end() && !env->parent_) {
+                auto global = Unalias(name);
+                it = global ? env->values_.find(*global) : it;
+            }
+            if (it != env->values_.end()) {
+                it->second = std::move(value);
+                return true;
+            }
+            if (!env->parent_) {
+                return false;
+            }
         }
-        if (parent_) {
-            parent_->Set(name, std::move(value));
-            return;
+    }
+
+    void Set(const std::string& name, ObjectPtr value) {
+        if (!Assign(name, std::move(value))) {
+            throw NameError{name};
         }
-        throw NameError{name};
+    }
+
+    const Ptr& GetParent() const {
+        return parent_;
     }
 
     void Clear() {
@@ -49,7 +85,29 @@ public:
         parent_.reset();
     }
 
+    // Name by which macro expansions refer to the global `name`. Source code cannot bind it, so
+    // it resolves past whatever binds `name` at the site of the use to the binding in the global
+    // environment, the one without a parent, where macros are defined.
+    static std::string GlobalAlias(const std::string& name) {
+        return name + std::string(kAliasSuffix);
+    }
+
+    // The name the alias `name` was made from by GlobalAlias, if it is one.
+    static std::optional<std::string> Unalias(const std::string& name) {
+        if (!name.ends_with(kAliasSuffix) || name.size() == kAliasSuffix.size()) {
+            return std::nullopt;
+        }
+        return name.substr(0, name.size() - kAliasSuffix.size());
+    }
+
 private:
+    static constexpr std::string_view kAliasSuffix = ".global";
+
+    const ObjectPtr* FindAliased(const std::string& name) const {
+        auto global = Unalias(name);
+        return global ? FindLocal(*global) : nullptr;
+    }
+
     Ptr parent_;
     ValuesMap values_;
 };
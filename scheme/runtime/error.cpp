@@ -0,0 +1,56 @@
+#include "runtime/error.h"
+
+#include "runtime/object.h"
+
+#include <optional>
+#include <utility>
+
+namespace {
+
+thread_local std::optional<Error> pending_error;
+
+}  // namespace
+
+const char* NameError::what() const noexcept {
+    if (message_.empty()) {
+        try {
+            message_ = "Name not found: " + name_;
+        } catch (...) {
+            return "Name not found";
+        }
+    }
+    return message_.c_str();
+}
+
+void Error::Throw() const {
+    switch (code_) {
+        case ErrorCode::Syntax:
+            throw SyntaxError{GetMessage()};
+        case ErrorCode::Runtime:
+            throw RuntimeError{GetMessage()};
+        case ErrorCode::Name:
+            throw NameError{subject_};
+        case ErrorCode::Budget:
+            throw BudgetError{GetMessage()};
+    }
+    throw RuntimeError{GetMessage()};
+}
+
+const std::shared_ptr<Object>& Failure() {
+    static const std::shared_ptr<Object> marker = std::make_shared<Object>();
+    return marker;
+}
+
+std::shared_ptr<Object> Fail(Error error) {
+    pending_error = std::move(error);
+    return Failure();
+}
+
+Error TakeError() {
+    if (!pending_error) {
+        return Error::Runtime("Unknown error");
+    }
+    auto error = std::move(*pending_error);
+    pending_error.reset();
+    return error;
+}
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <stdexcept>
 #include <string>
 
+class Object;
+
 class SyntaxError : public std::runtime_error {
     using std::runtime_error::runtime_error;
 };
@@ -11,8 +14,96 @@ class RuntimeError : public std::runtime_error {
     using std::runtime_error::runtime_error;
 };
 
+class BudgetError : public std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
 class NameError : public std::runtime_error {
 public:
-    explicit NameError(const std::string& name) : std::runtime_error{"Name not found: " + name} {
+    explicit NameError(std::string name) : std::runtime_error{""}, name_(std::move(name)) {
     }
+
+    const std::string& GetName() const {
+        return name_;
+    }
+
+    // "Name not found: <name>", put together on first call.
+    const char* what() const noexcept override;
+
+private:
+    std::string name_;
+    mutable std::string message_;
 };
+
+enum class ErrorCode { Syntax, Runtime, Name, Budget };
+
+// Error returned as a value rather than thrown. The message is a static text followed by an
+// optional subject, such as the unbound name, and is only concatenated when asked for.
+class Error {
+public:
+    // `text` must outlive the error; in practice it is a string literal.
+    Error(ErrorCode code, const char* text, std::string subject = {})
+        : code_(code), text_(text), subject_(std::move(subject)) {
+    }
+
+    static Error Runtime(const char* text) {
+        return {ErrorCode::Runtime, text};
+    }
+
+    static Error Name(std::string name) {
+        return {ErrorCode::Name, "Name not found: ", std::move(name)};
+    }
+
+    static Error Budget(const char* text) {
+        return {ErrorCode::Budget, text};
+    }
+
+    // Error raised by the script with `(raise payload)`.
+    static Error Raised(std::shared_ptr<Object> payload) {
+        Error error{ErrorCode::Runtime, "Uncaught exception"};
+        error.payload_ = std::move(payload);
+        error.raised_ = true;
+        return error;
+    }
+
+    ErrorCode GetCode() const {
+        return code_;
+    }
+
+    std::string GetMessage() const {
+        return text_ + subject_;
+    }
+
+    bool IsRaised() const {
+        return raised_;
+    }
+
+    // Object raised by the script if IsRaised().
+    const std::shared_ptr<Object>& GetPayload() const {
+        return payload_;
+    }
+
+    // Throws the exception Scheme::Evaluate reports this error with.
+    [[noreturn]] void Throw() const;
+
+private:
+    ErrorCode code_;
+    const char* text_;
+    std::string subject_;
+    std::shared_ptr<Object> payload_;
+    bool raised_ = false;
+};
+
+// Evaluation does not throw on errors. Code that fails records the error for the current thread
+// with Fail and returns the Failure() marker in place of a value; every caller of Eval or Apply
+// passes the marker on unchanged until the evaluation entry point takes the error back.
+const std::shared_ptr<Object>& Failure();
+
+std::shared_ptr<Object> Fail(Error error);
+
+inline bool IsFailure(const std::shared_ptr<Object>& value) {
+    return value == Failure();
+}
+
+// The error recorded by the last Fail, which is cleared.
+Error TakeError();
@@ -4,35 +4,62 @@
 
 namespace helpers {
 
-int64_t RequireInt(const ObjectPtr& obj) {
-    auto num = As<Number>(obj);
+bool RequireInt(const ObjectPtr& obj, int64_t* value) {
+    auto* num = dynamic_cast<const Number*>(obj.get());
     if (!num) {
-        throw RuntimeError{"Expected number"};
+        Fail(Error::Runtime("Expected number"));
+        return false;
     }
-    return num->GetValue();
+    *value = num->GetValue();
+    return true;
 }
 
-CellPtr RequireCell(const ObjectPtr& obj) {
-    auto cell = As<Cell>(obj);
+Cell* RequireCell(const ObjectPtr& obj) {
+    auto* cell = dynamic_cast<Cell*>(obj.get());
     if (!cell) {
-        throw RuntimeError{"Expected pair"};
+        Fail(Error::Runtime("Expected pair"));
     }
     return cell;
 }
 
-int64_t RequireIndex(const ObjectPtr& obj) {
-    auto index = RequireInt(obj);
-    if (index < 0) {
-        throw RuntimeError{"Invalid index"};
+bool RequireIndex(const ObjectPtr& obj, int64_t* index) {
+    if (!RequireInt(obj, index)) {
+        return false;
     }
-    return index;
+    if (*index < 0) {
+        Fail(Error::Runtime("Invalid index"));
+        return false;
+    }
+    return true;
 }
 
-const Args& RequireArgsCount(const Args& args, size_t n) {
+bool RequireArgsCount(const Args& args, size_t n) {
     if (args.size() != n) {
-        throw RuntimeError{"Invalid argument count"};
+        Fail(Error::Runtime("Invalid argument count"));
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<Object> NumericSubtract(const Args& args) {
+    if (args.empty()) {
+        return Fail(Error::Runtime("Invalid argument count"));
+    }
+    int64_t value;
+    if (!RequireInt(args[0], &value)) {
+        return Failure();
+    }
+    if (args.size() == 1) {
+        return std::make_shared<Number>(-value);
+    }
+    for (size_t i = 1; i < args.size(); ++i) {
+        int64_t sub;
+        if (!RequireInt(args[i], &sub)) {
+            return Failure();
+        }
+        value -= sub;
     }
-    return args;
+    return std::make_shared<Number>(value);
 }
 
 bool IsFalse(const ObjectPtr& obj) {
@@ -40,4 +67,23 @@ bool IsFalse(const ObjectPtr& obj) {
     return boolean && !boolean->GetValue();
 }
 
+bool IsEqv(const ObjectPtr& a, const ObjectPtr& b) {
+    if (a == b) {
+        return true;
+    }
+    if (auto* num = dynamic_cast<const Number*>(a.get())) {
+        auto* other = dynamic_cast<const Number*>(b.get());
+        return other && num->GetValue() == other->GetValue();
+    }
+    if (auto* sym = dynamic_cast<const Symbol*>(a.get())) {
+        auto* other = dynamic_cast<const Symbol*>(b.get());
+        return other && sym->GetName() == other->GetName();
+    }
+    if (auto* boolean = dynamic_cast<const Boolean*>(a.get())) {
+        auto* other = dynamic_cast<const Boolean*>(b.get());
+        return other && boolean->GetValue() == other->GetValue();
+    }
+    return false;
+}
+
 }  // namespace helpers
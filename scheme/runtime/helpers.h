@@ -4,38 +4,44 @@
 #include "runtime/object.h"
 
 #include <memory>
-#include <vector>
+#include <span>
 
 namespace helpers {
 
 using ObjectPtr = std::shared_ptr<Object>;
 using CellPtr = std::shared_ptr<Cell>;
-using Args = std::vector<ObjectPtr>;
+using Args = std::span<const ObjectPtr>;
 
-int64_t RequireInt(const ObjectPtr& obj);
+// Checks for builtin arguments. A failed check records the error with Fail, so the caller only
+// has to return Failure().
+bool RequireInt(const ObjectPtr& obj, int64_t* value);
 
-CellPtr RequireCell(const ObjectPtr& obj);
+Cell* RequireCell(const ObjectPtr& obj);
 
-int64_t RequireIndex(const ObjectPtr& obj);
+bool RequireIndex(const ObjectPtr& obj, int64_t* index);
 
-const Args& RequireArgsCount(const Args& args, size_t n);
+bool RequireArgsCount(const Args& args, size_t n);
 
 bool IsFalse(const ObjectPtr& obj);
 
-template <class Pred>
-std::shared_ptr<Object> UnaryPredicate(const Args& args, Pred pred) {
-    RequireArgsCount(args, 1);
-    return MakeBool(pred(args[0]));
-}
+// Whether `a` and `b` are the same object or equal numbers, symbols or booleans.
+bool IsEqv(const ObjectPtr& a, const ObjectPtr& b);
+
+// Difference of the integers in `args`, or the negation of a single one.
+std::shared_ptr<Object> NumericSubtract(const Args& args);
 
 template <class Fn>
 std::shared_ptr<Object> NumericFold(const Args& args, int64_t identity, bool require_alo, Fn fn) {
     if (require_alo && args.empty()) {
-        throw RuntimeError{"Invalid argument count"};
+        return Fail(Error::Runtime("Invalid argument count"));
     }
     auto acc = identity;
     for (const auto& a : args) {
-        acc = fn(acc, RequireInt(a));
+        int64_t value;
+        if (!RequireInt(a, &value)) {
+            return Failure();
+        }
+        acc = fn(acc, value);
     }
     return std::make_shared<Number>(acc);
 }
@@ -45,9 +51,15 @@ std::shared_ptr<Object> NumericChainCmp(const Args& args, Pred pred) {
     if (args.size() <= 1) {
         return True();
     }
-    auto prev = RequireInt(args[0]);
+    int64_t prev;
+    if (!RequireInt(args[0], &prev)) {
+        return Failure();
+    }
     for (auto i = 1; i < args.size(); ++i) {
-        auto cur = RequireInt(args[i]);
+        int64_t cur;
+        if (!RequireInt(args[i], &cur)) {
+            return Failure();
+        }
         if (!pred(prev, cur)) {
             return False();
         }
@@ -32,7 +32,7 @@ ObjectVec ToVector(const ObjectPtr& list) {
     return out;
 }
 
-ObjectPtr FromVector(const ObjectVec& vec) {
+ObjectPtr FromVector(std::span<const ObjectPtr> vec) {
     ObjectPtr head = nullptr;
     std::shared_ptr<Cell> last = nullptr;
     for (const auto& elem : vec) {
@@ -48,19 +48,4 @@ ObjectPtr FromVector(const ObjectVec& vec) {
     return head;
 }
 
-ObjectPtr Advance(ObjectPtr list, int64_t steps) {
-    if (!IsProperList(list)) {
-        throw RuntimeError{"Expected proper list"};
-    }
-    ObjectPtr cur = std::move(list);
-    for (auto i = 0; i < steps; ++i) {
-        auto cell = As<Cell>(cur);
-        if (!cell) {
-            throw RuntimeError{"Index out of range"};
-        }
-        cur = cell->GetSecond();
-    }
-    return cur;
-}
-
 }  // namespace listutils
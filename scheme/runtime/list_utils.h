@@ -3,6 +3,7 @@
 #include "runtime/object.h"
 
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace listutils {
@@ -14,8 +15,6 @@ bool IsProperList(const ObjectPtr& obj);
 
 ObjectVec ToVector(const ObjectPtr& list);
 
-ObjectPtr FromVector(const ObjectVec& vec);
-
-ObjectPtr Advance(ObjectPtr list, int64_t steps);
+ObjectPtr FromVector(std::span<const ObjectPtr> vec);
 
 }  // namespace listutils
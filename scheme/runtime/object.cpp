@@ -1,5 +1,6 @@
 #include "runtime/object.h"
 
+#include <functional>
 #include <utility>
 
 Number::Number(int64_t value) {
@@ -12,6 +13,7 @@ int64_t Number::GetValue() const {
 
 Symbol::Symbol(std::string name) {
     name_ = std::move(name);
+    hash_ = std::hash<std::string>{}(name_);
 }
 
 const std::string& Symbol::GetName() const {
@@ -23,6 +25,18 @@ Cell::Cell(std::shared_ptr<Object> first, std::shared_ptr<Object> second) {
     second_ = std::move(second);
 }
 
+// Releases the tail iteratively, so dropping a long list does not recurse once per cell.
+Cell::~Cell() {
+    auto rest = std::move(second_);
+    while (rest && rest.use_count() == 1) {
+        auto* cell = dynamic_cast<Cell*>(rest.get());
+        if (!cell) {
+            break;
+        }
+        rest = std::move(cell->second_);
+    }
+}
+
 std::shared_ptr<Object> Cell::GetFirst() const {
     return first_;
 }
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
+class SpecialForm;
+
 class Object : public std::enable_shared_from_this<Object> {
 public:
     virtual ~Object() = default;
@@ -32,16 +36,35 @@ private:
 
 class Symbol : public Object {
 public:
+    // Special form the name resolves to in the registry with id `registry`, memoized by
+    // SpecialFormRegistry::Lookup so evaluating a form does not hash its name every time.
+    struct FormCache {
+        uint64_t registry = 0;
+        SpecialForm* form = nullptr;
+    };
+
     Symbol(std::string name);
     const std::string& GetName() const;
 
+    // Hash of the name, computed once when the symbol is made.
+    size_t GetHash() const {
+        return hash_;
+    }
+
+    FormCache& GetFormCache() const {
+        return form_cache_;
+    }
+
 private:
     std::string name_;
+    size_t hash_;
+    mutable FormCache form_cache_;
 };
 
 class Cell : public Object {
 public:
     Cell(std::shared_ptr<Object> first, std::shared_ptr<Object> second);
+    ~Cell() override;
 
     std::shared_ptr<Object> GetFirst() const;
     std::shared_ptr<Object> GetSecond() const;
@@ -1,6 +1,7 @@
 #include "scheme.h"
 
 #include "eval/eval.h"
+#include "eval/values.h"
 #include "io/printer.h"
 #include "reader/parser.h"
 #include "reader/tokenizer.h"
@@ -19,10 +20,103 @@ Scheme::~Scheme() {
     }
 }
 
-std::string Scheme::Evaluate(const std::string& expression) {
+namespace {
+
+// Error for the exceptions that parsing and printing still throw.
+template <class Fn>
+auto Catching(Fn fn) -> decltype(fn()) {
+    try {
+        return fn();
+    } catch (const SyntaxError& error) {
+        return std::unexpected(Error{ErrorCode::Syntax, "", error.what()});
+    } catch (const RuntimeError& error) {
+        return std::unexpected(Error{ErrorCode::Runtime, "", error.what()});
+    }
+}
+
+ObjectPtr ReadExpression(const std::string& expression) {
     std::istringstream in(expression);
     Tokenizer tokenizer(&in);
-    auto ast = Read(&tokenizer);
-    auto value = evaluator_.Eval(ast, global_env_);
-    return Print(value);
+    return Read(&tokenizer);
+}
+
+// Multiple values are printed separated by spaces.
+std::string PrintValues(ObjectPtr value) {
+    ArgsBuffer values;
+    TakeValues(std::move(value), &values);
+    std::string printed;
+    for (const auto& item : values.Get()) {
+        if (!printed.empty()) {
+            printed += ' ';
+        }
+        printed += Print(item);
+    }
+    return printed;
+}
+
+std::expected<std::string, Error> PrintResult(const ObjectPtr& value) {
+    if (IsFailure(value)) {
+        return std::unexpected(TakeError());
+    }
+    return PrintValues(value);
+}
+
+}  // namespace
+
+std::expected<std::string, Error> Scheme::Task::Resume(const Budget& budget) {
+    if (finished_) {
+        return std::unexpected(Error::Runtime("Task has finished"));
+    }
+    evaluator_.SetBudget(budget);
+    return Catching([&] {
+        finished_ = true;
+        auto value = machine_.Continue();
+        finished_ = machine_.IsFinished();
+        return PrintResult(value);
+    });
+}
+
+std::string Scheme::Evaluate(const std::string& expression, const Budget& budget) {
+    auto result = TryEvaluate(expression, budget);
+    if (!result) {
+        result.error().Throw();
+    }
+    return std::move(*result);
+}
+
+std::expected<std::string, Error> Scheme::TryEvaluate(const std::string& expression,
+                                                      const Budget& budget) {
+    return Catching([&]() -> std::expected<std::string, Error> {
+        auto ast = ReadExpression(expression);
+        evaluator_.SetBudget(budget);
+        if (eval_mode_ == EvalMode::Machine) {
+            Machine machine(evaluator_);
+            return PrintResult(machine.Run(ast, global_env_));
+        }
+        auto value = evaluator_.TryEval(ast, global_env_);
+        if (!value) {
+            return std::unexpected(std::move(value.error()));
+        }
+        return PrintValues(std::move(*value));
+    });
+}
+
+std::expected<Scheme::Task, Error> Scheme::Start(const std::string& expression) {
+    return Catching([&]() -> std::expected<Task, Error> {
+        Task task(evaluator_);
+        task.machine_.Start(ReadExpression(expression), global_env_);
+        return task;
+    });
+}
+
+void Scheme::SetTierPolicy(const TierPolicy& policy) {
+    evaluator_.SetTierPolicy(policy);
+}
+
+void Scheme::SetEvalMode(EvalMode mode) {
+    eval_mode_ = mode;
+}
+
+void Scheme::SetStackLimit(size_t bytes) {
+    evaluator_.GetNativeStack().SetLimit(bytes);
 }
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "eval/eval.h"
+#include "eval/machine.h"
+#include "runtime/error.h"
 
+#include <expected>
 #include <memory>
 #include <string>
 
@@ -9,11 +12,57 @@ class Environment;
 
 class Scheme {
 public:
+    // Evaluation of one expression that pauses when its budget runs out and can then be resumed
+    // with a new one, so that many evaluations can take turns on one thread. Runs on the Machine
+    // whatever the eval mode. Tasks share the environment of their Scheme and the thread that
+    // resumes them must not evaluate anything else on it at the same time.
+    class Task {
+    public:
+        // Continues the evaluation within `budget`. Returns the printed value or the error the
+        // evaluation ended with. An error with ErrorCode::Budget while IsFinished is false means
+        // that the task paused and may be resumed.
+        std::expected<std::string, Error> Resume(const Budget& budget = {});
+
+        bool IsFinished() const {
+            return finished_;
+        }
+
+    private:
+        friend class Scheme;
+
+        explicit Task(Evaluator& evaluator) : evaluator_(evaluator), machine_(evaluator) {
+        }
+
+        Evaluator& evaluator_;
+        Machine machine_;
+        bool finished_ = false;
+    };
+
     Scheme();
     ~Scheme();
-    std::string Evaluate(const std::string& expression);
+    // Printed value of `expression`. Errors are thrown as SyntaxError, RuntimeError, NameError or
+    // BudgetError. The budget limits this call only.
+    std::string Evaluate(const std::string& expression, const Budget& budget = {});
+
+    // Same as Evaluate, but errors are returned instead of thrown.
+    std::expected<std::string, Error> TryEvaluate(const std::string& expression,
+                                                  const Budget& budget = {});
+
+    // Task evaluating `expression`; nothing is evaluated until it is resumed.
+    std::expected<Task, Error> Start(const std::string& expression);
+
+    // Thresholds at which lambda bodies move from the tree walker to analyzed code.
+    void SetTierPolicy(const TierPolicy& policy);
+
+    // Evaluator that runs top-level expressions. Defaults to EvalMode::Recursive.
+    void SetEvalMode(EvalMode mode);
+
+    // Bytes of native stack that deep recursion may take beyond the thread's own stack before
+    // it fails with RuntimeError. Defaults to NativeStack::kDefaultLimit.
+    void SetStackLimit(size_t bytes);
 
 private:
     Evaluator evaluator_;
+    EvalMode eval_mode_ = EvalMode::Recursive;
     std::shared_ptr<Environment> global_env_;
 };
@@ -5,31 +5,32 @@
 #include "runtime/list_utils.h"
 
 using helpers::IsFalse;
-using helpers::RequireArgsCount;
-using helpers::UnaryPredicate;
 
 namespace {
 
-template <class Pred>
-ProcPtr MakePredicate(Pred pred) {
-    return std::make_shared<BuiltinProcedure>(
-        [pred](const auto& args, const auto&, auto&) { return UnaryPredicate(args, pred); });
+using ObjectPtr = std::shared_ptr<Object>;
+
+template <bool (*Pred)(const ObjectPtr&)>
+ObjectPtr Predicate(const ObjectPtr& obj) {
+    return MakeBool(Pred(obj));
+}
+
+template <bool (*Pred)(const ObjectPtr&)>
+ProcPtr MakePredicate(Primitive primitive = Primitive::None) {
+    return BuiltinProcedure::Unary(&Predicate<Pred>, primitive);
 }
 
-ProcPtr MakeNot() {
-    return std::make_shared<BuiltinProcedure>([](const auto& args, const auto&, auto&) {
-        RequireArgsCount(args, 1);
-        return MakeBool(IsFalse(args[0]));
-    });
+bool IsNull(const ObjectPtr& obj) {
+    return obj == nullptr;
 }
 
 }  // namespace
 
 void RegisterBoolOperations(const std::shared_ptr<Environment>& env) {
-    env->Define("boolean?", MakePredicate(Is<Boolean>));
-    env->Define("symbol?", MakePredicate(Is<Symbol>));
-    env->Define("pair?", MakePredicate(Is<Cell>));
-    env->Define("null?", MakePredicate([](const auto& obj) { return obj == nullptr; }));
-    env->Define("list?", MakePredicate(listutils::IsProperList));
-    env->Define("not", MakeNot());
+    env->Define("boolean?", MakePredicate<Is<Boolean>>());
+    env->Define("symbol?", MakePredicate<Is<Symbol>>());
+    env->Define("pair?", MakePredicate<Is<Cell>>(Primitive::IsPair));
+    env->Define("null?", MakePredicate<IsNull>(Primitive::IsNull));
+    env->Define("list?", MakePredicate<listutils::IsProperList>());
+    env->Define("not", MakePredicate<IsFalse>());
 }
@@ -1,13 +1,17 @@
 #include "stdlib/builtins.h"
 
 #include "stdlib/bool_operations.h"
+#include "stdlib/control_operations.h"
 #include "stdlib/int_operations.h"
 #include "stdlib/list_operations.h"
+#include "stdlib/stream_operations.h"
 
 void AddBuiltins(const std::shared_ptr<Environment>& env) {
     env->Define("#t", True());
     env->Define("#f", False());
     RegisterBoolOperations(env);
+    RegisterControlOperations(env);
     RegisterIntOperations(env);
     RegisterListOperations(env);
+    RegisterStreamOperations(env);
 }
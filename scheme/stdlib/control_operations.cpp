@@ -0,0 +1,53 @@
+#include "stdlib/control_operations.h"
+
+#include "eval/continuation.h"
+#include "eval/exceptions.h"
+#include "eval/promise.h"
+#include "eval/values.h"
+
+void RegisterControlOperations(const std::shared_ptr<Environment>& env) {
+    auto call_cc = std::make_shared<CallWithContinuation>(false);
+    env->Define("call-with-current-continuation", call_cc);
+    env->Define("call/cc", call_cc);
+    auto call_ec = std::make_shared<CallWithContinuation>(true);
+    env->Define("call-with-escape-continuation", call_ec);
+    env->Define("call/ec", call_ec);
+
+    env->Define("values",
+                std::make_shared<BuiltinProcedure>(
+                    [](Args args, const std::shared_ptr<Environment>&, Evaluator&) {
+                        return ReturnValues(args);
+                    },
+                    Primitive::None,
+                    BuiltinProcedure::FixedArity{
+                        .apply1 = [](const std::shared_ptr<Object>& value) { return value; }}));
+    env->Define("call-with-values", std::make_shared<CallWithValues>());
+    env->Define("apply", std::make_shared<ApplyProcedure>());
+
+    env->Define("force", std::make_shared<ForceProcedure>());
+    env->Define("make-promise", BuiltinProcedure::Unary([](const std::shared_ptr<Object>& obj) {
+                    if (Is<Promise>(obj)) {
+                        return obj;
+                    }
+                    return std::static_pointer_cast<Object>(std::make_shared<Promise>(obj));
+                }));
+    env->Define("promise?", BuiltinProcedure::Unary([](const std::shared_ptr<Object>& obj) {
+                    return std::static_pointer_cast<Object>(MakeBool(Is<Promise>(obj)));
+                }));
+
+    env->Define("raise", std::make_shared<Raise>(false));
+    env->Define("raise-continuable", std::make_shared<Raise>(true));
+    env->Define("with-exception-handler", std::make_shared<WithExceptionHandler>());
+    env->Define("error-object?", BuiltinProcedure::Unary([](const std::shared_ptr<Object>& obj) {
+                    return std::static_pointer_cast<Object>(MakeBool(Is<ErrorObject>(obj)));
+                }));
+    env->Define("error-object-message",
+                BuiltinProcedure::Unary([](const std::shared_ptr<Object>& obj) {
+                    auto error = As<ErrorObject>(obj);
+                    if (!error) {
+                        return Fail(Error::Runtime("Expected error object"));
+                    }
+                    return std::static_pointer_cast<Object>(
+                        std::make_shared<Symbol>(error->GetError().GetMessage()));
+                }));
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "runtime/env.h"
+
+#include <memory>
+
+void RegisterControlOperations(const std::shared_ptr<Environment>& env);
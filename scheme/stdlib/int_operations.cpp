@@ -9,9 +9,7 @@
 using helpers::Args;
 using helpers::NumericChainCmp;
 using helpers::NumericFold;
-using helpers::RequireArgsCount;
 using helpers::RequireInt;
-using helpers::UnaryPredicate;
 
 using EnvPtr = std::shared_ptr<Environment>;
 using ProcPtr = std::shared_ptr<BuiltinProcedure>;
@@ -33,29 +31,22 @@ std::shared_ptr<Object> MulFn(const Args& args, const EnvPtr& env, Evaluator& ev
 }
 
 std::shared_ptr<Object> SubFn(const Args& args, const EnvPtr&, Evaluator&) {
-    if (args.empty()) {
-        throw RuntimeError{"Invalid argument count"};
-    }
-    auto value = RequireInt(args[0]);
-    if (args.size() == 1) {
-        return std::make_shared<Number>(-value);
-    }
-    for (auto i = 1; i < args.size(); ++i) {
-        value -= RequireInt(args[i]);
-    }
-    return std::make_shared<Number>(value);
+    return helpers::NumericSubtract(args);
 }
 
 std::shared_ptr<Object> DivFn(const Args& args, const EnvPtr&, Evaluator&) {
-    if (args.empty()) {
-        throw RuntimeError{"Invalid argument count"};
+    if (args.size() < 2) {
+        return Fail(Error::Runtime("Invalid argument count"));
     }
-    auto value = RequireInt(args[0]);
-    if (args.size() == 1) {
-        throw RuntimeError{"Invalid argument count"};
+    int64_t value;
+    if (!RequireInt(args[0], &value)) {
+        return Failure();
     }
     for (auto i = 1; i < args.size(); ++i) {
-        auto div = RequireInt(args[i]);
+        int64_t div;
+        if (!RequireInt(args[i], &div)) {
+            return Failure();
+        }
         value /= div;
     }
     return std::make_shared<Number>(value);
@@ -88,55 +79,124 @@ std::shared_ptr<Object> GeFn(const Args& args, const EnvPtr& env, Evaluator& ev)
 
 std::shared_ptr<Object> MaxFn(const Args& args, const EnvPtr&, Evaluator&) {
     if (args.empty()) {
-        throw RuntimeError{"Invalid argument count"};
+        return Fail(Error::Runtime("Invalid argument count"));
+    }
+    int64_t best;
+    if (!RequireInt(args[0], &best)) {
+        return Failure();
     }
-    auto best = RequireInt(args[0]);
     for (auto i = 1; i < args.size(); ++i) {
-        best = std::max(best, RequireInt(args[i]));
+        int64_t value;
+        if (!RequireInt(args[i], &value)) {
+            return Failure();
+        }
+        best = std::max(best, value);
     }
     return std::make_shared<Number>(best);
 }
 
 std::shared_ptr<Object> MinFn(const Args& args, const EnvPtr&, Evaluator&) {
     if (args.empty()) {
-        throw RuntimeError{"Invalid argument count"};
+        return Fail(Error::Runtime("Invalid argument count"));
+    }
+    int64_t best;
+    if (!RequireInt(args[0], &best)) {
+        return Failure();
     }
-    auto best = RequireInt(args[0]);
     for (auto i = 1; i < args.size(); ++i) {
-        best = std::min(best, RequireInt(args[i]));
+        int64_t value;
+        if (!RequireInt(args[i], &value)) {
+            return Failure();
+        }
+        best = std::min(best, value);
     }
     return std::make_shared<Number>(best);
 }
 
-std::shared_ptr<Object> AbsFn(const Args& args, const EnvPtr&, Evaluator&) {
-    RequireArgsCount(args, 1);
-    auto v = RequireInt(args[0]);
+using ObjectPtr = std::shared_ptr<Object>;
+
+ObjectPtr Abs(const ObjectPtr& arg) {
+    int64_t v;
+    if (!RequireInt(arg, &v)) {
+        return Failure();
+    }
     return std::make_shared<Number>(v < 0 ? -v : v);
 }
 
-ProcPtr MakeProc(std::shared_ptr<Object> (*fn)(const Args&, const EnvPtr&, Evaluator&)) {
-    return std::make_shared<BuiltinProcedure>(fn);
+ObjectPtr Negate(const ObjectPtr& arg) {
+    int64_t v;
+    if (!RequireInt(arg, &v)) {
+        return Failure();
+    }
+    return std::make_shared<Number>(-v);
+}
+
+// Two-argument forms of the variadic operations, which make up most arithmetic calls.
+template <class Op>
+ObjectPtr Arithmetic2(const ObjectPtr& lhs, const ObjectPtr& rhs) {
+    int64_t left, right;
+    if (!RequireInt(lhs, &left) || !RequireInt(rhs, &right)) {
+        return Failure();
+    }
+    return std::make_shared<Number>(Op{}(left, right));
+}
+
+template <class Pred>
+ObjectPtr Compare2(const ObjectPtr& lhs, const ObjectPtr& rhs) {
+    int64_t left, right;
+    if (!RequireInt(lhs, &left) || !RequireInt(rhs, &right)) {
+        return Failure();
+    }
+    return MakeBool(Pred{}(left, right));
+}
+
+ObjectPtr Max2(const ObjectPtr& lhs, const ObjectPtr& rhs) {
+    int64_t left, right;
+    if (!RequireInt(lhs, &left) || !RequireInt(rhs, &right)) {
+        return Failure();
+    }
+    return std::make_shared<Number>(std::max(left, right));
+}
+
+ObjectPtr Min2(const ObjectPtr& lhs, const ObjectPtr& rhs) {
+    int64_t left, right;
+    if (!RequireInt(lhs, &left) || !RequireInt(rhs, &right)) {
+        return Failure();
+    }
+    return std::make_shared<Number>(std::min(left, right));
+}
+
+ObjectPtr IsNumber(const ObjectPtr& arg) {
+    return MakeBool(Is<Number>(arg));
+}
+
+ProcPtr MakeProc(std::shared_ptr<Object> (*fn)(const Args&, const EnvPtr&, Evaluator&),
+                 Primitive primitive = Primitive::None,
+                 BuiltinProcedure::FixedArity fixed = BuiltinProcedure::FixedArity{}) {
+    return std::make_shared<BuiltinProcedure>(fn, primitive, fixed);
 }
 
 }  // namespace
 
 void RegisterIntOperations(const std::shared_ptr<Environment>& env) {
-    env->Define("number?",
-                std::make_shared<BuiltinProcedure>([](const auto& args, const auto&, auto&) {
-                    return UnaryPredicate(args, Is<Number>);
-                }));
-    env->Define("+", MakeProc(&AddFn));
-    env->Define("*", MakeProc(&MulFn));
-    env->Define("-", MakeProc(&SubFn));
+    env->Define("number?", BuiltinProcedure::Unary(&IsNumber));
+    env->Define("+", MakeProc(&AddFn, Primitive::Add,
+                              {.apply2 = &Arithmetic2<std::plus<int64_t>>}));
+    env->Define("*", MakeProc(&MulFn, Primitive::Mul,
+                              {.apply2 = &Arithmetic2<std::multiplies<int64_t>>}));
+    env->Define("-", MakeProc(&SubFn, Primitive::Sub,
+                              {.apply1 = &Negate, .apply2 = &Arithmetic2<std::minus<int64_t>>}));
     env->Define("/", MakeProc(&DivFn));
 
-    env->Define("=", MakeProc(&EqFn));
-    env->Define("<", MakeProc(&LtFn));
-    env->Define(">", MakeProc(&GtFn));
-    env->Define("<=", MakeProc(&LeFn));
-    env->Define(">=", MakeProc(&GeFn));
-
-    env->Define("max", MakeProc(&MaxFn));
-    env->Define("min", MakeProc(&MinFn));
-    env->Define("abs", MakeProc(&AbsFn));
+    env->Define("=", MakeProc(&EqFn, Primitive::Eq, {.apply2 = &Compare2<std::equal_to<int64_t>>}));
+    env->Define("<", MakeProc(&LtFn, Primitive::Lt, {.apply2 = &Compare2<std::less<int64_t>>}));
+    env->Define(">", MakeProc(&GtFn, Primitive::Gt, {.apply2 = &Compare2<std::greater<int64_t>>}));
+    env->Define("<=",
+                MakeProc(&LeFn, Primitive::Le, {.apply2 = &Compare2<std::less_equal<int64_t>>}));
+    env->Define(">=",
+                MakeProc(&GeFn, Primitive::Ge, {.apply2 = &Compare2<std::greater_equal<int64_t>>}));
+
+    env->Define("max", MakeProc(&MaxFn, Primitive::None, {.apply2 = &Max2}));
+    env->Define("min", MakeProc(&MinFn, Primitive::None, {.apply2 = &Min2}));
+    env->Define("abs", BuiltinProcedure::Unary(&Abs));
 }
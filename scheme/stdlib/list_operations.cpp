@@ -8,83 +8,96 @@
 #include <memory>
 
 using helpers::Args;
-using helpers::RequireArgsCount;
 using helpers::RequireCell;
 using helpers::RequireIndex;
 
 using EnvPtr = std::shared_ptr<Environment>;
-using ProcPtr = std::shared_ptr<BuiltinProcedure>;
 
 namespace {
 
-std::shared_ptr<Object> ConsFn(const Args& args, const EnvPtr&, Evaluator&) {
-    RequireArgsCount(args, 2);
-    return std::make_shared<Cell>(args[0], args[1]);
+using ObjectPtr = std::shared_ptr<Object>;
+
+ObjectPtr Cons(const ObjectPtr& first, const ObjectPtr& second) {
+    return std::make_shared<Cell>(first, second);
 }
 
 std::shared_ptr<Object> ListFn(const Args& args, const EnvPtr&, Evaluator&) {
     return listutils::FromVector(args);
 }
 
-std::shared_ptr<Object> CarFn(const Args& args, const EnvPtr&, Evaluator&) {
-    RequireArgsCount(args, 1);
-    return RequireCell(args[0])->GetFirst();
+ObjectPtr Car(const ObjectPtr& pair) {
+    auto* cell = RequireCell(pair);
+    return cell ? cell->GetFirst() : Failure();
 }
 
-std::shared_ptr<Object> CdrFn(const Args& args, const EnvPtr&, Evaluator&) {
-    RequireArgsCount(args, 1);
-    return RequireCell(args[0])->GetSecond();
+ObjectPtr Cdr(const ObjectPtr& pair) {
+    auto* cell = RequireCell(pair);
+    return cell ? cell->GetSecond() : Failure();
 }
 
-std::shared_ptr<Object> SetCarFn(const Args& args, const EnvPtr&, Evaluator&) {
-    RequireArgsCount(args, 2);
-    RequireCell(args[0])->SetFirst(args[1]);
+ObjectPtr SetCar(const ObjectPtr& pair, const ObjectPtr& value) {
+    auto* cell = RequireCell(pair);
+    if (!cell) {
+        return Failure();
+    }
+    cell->SetFirst(value);
     return nullptr;
 }
 
-std::shared_ptr<Object> SetCdrFn(const Args& args, const EnvPtr&, Evaluator&) {
-    RequireArgsCount(args, 2);
-    RequireCell(args[0])->SetSecond(args[1]);
+ObjectPtr SetCdr(const ObjectPtr& pair, const ObjectPtr& value) {
+    auto* cell = RequireCell(pair);
+    if (!cell) {
+        return Failure();
+    }
+    cell->SetSecond(value);
     return nullptr;
 }
 
-std::shared_ptr<Object> ListRefFn(const Args& args, const EnvPtr&, Evaluator&) {
-    RequireArgsCount(args, 2);
-    auto idx = RequireIndex(args[1]);
-    auto cur = listutils::Advance(args[0], idx);
-    auto cell = As<Cell>(cur);
-    if (!cell) {
-        throw RuntimeError{"Index out of range"};
+// Tail of `list` after `index` elements, or Failure() if there is no such tail.
+ObjectPtr Advance(const ObjectPtr& list, const ObjectPtr& index) {
+    int64_t steps;
+    if (!RequireIndex(index, &steps)) {
+        return Failure();
     }
-    return cell->GetFirst();
+    if (!listutils::IsProperList(list)) {
+        return Fail(Error::Runtime("Expected proper list"));
+    }
+    auto cur = list;
+    for (int64_t i = 0; i < steps; ++i) {
+        auto cell = As<Cell>(cur);
+        if (!cell) {
+            return Fail(Error::Runtime("Index out of range"));
+        }
+        cur = cell->GetSecond();
+    }
+    return cur;
 }
 
-std::shared_ptr<Object> ListTailFn(const Args& args, const EnvPtr&, Evaluator&) {
-    RequireArgsCount(args, 2);
-    auto idx = RequireIndex(args[1]);
-    auto cur = listutils::Advance(args[0], idx);
-    if (!cur) {
-        return nullptr;
+ObjectPtr ListRef(const ObjectPtr& list, const ObjectPtr& index) {
+    auto cur = Advance(list, index);
+    if (IsFailure(cur)) {
+        return cur;
     }
-    if (!listutils::IsProperList(cur)) {
-        throw RuntimeError{"Expected proper list"};
+    auto cell = As<Cell>(cur);
+    if (!cell) {
+        return Fail(Error::Runtime("Index out of range"));
     }
-    return cur;
+    return cell->GetFirst();
 }
 
-ProcPtr MakeProc(std::shared_ptr<Object> (*fn)(const Args&, const EnvPtr&, Evaluator&)) {
-    return std::make_shared<BuiltinProcedure>(fn);
+ObjectPtr ListTail(const ObjectPtr& list, const ObjectPtr& index) {
+    return Advance(list, index);
 }
 
 }  // namespace
 
 void RegisterListOperations(const std::shared_ptr<Environment>& env) {
-    env->Define("cons", MakeProc(&ConsFn));
-    env->Define("list", MakeProc(&ListFn));
-    env->Define("car", MakeProc(&CarFn));
-    env->Define("cdr", MakeProc(&CdrFn));
-    env->Define("set-car!", MakeProc(&SetCarFn));
-    env->Define("set-cdr!", MakeProc(&SetCdrFn));
-    env->Define("list-ref", MakeProc(&ListRefFn));
-    env->Define("list-tail", MakeProc(&ListTailFn));
+    env->Define("cons", BuiltinProcedure::Binary(&Cons, Primitive::Cons));
+    env->Define("list", std::make_shared<BuiltinProcedure>(&ListFn));
+    env->Define("car", BuiltinProcedure::Unary(&Car, Primitive::Car));
+    env->Define("cdr", BuiltinProcedure::Unary(&Cdr, Primitive::Cdr));
+    env->Define("set-car!", BuiltinProcedure::Binary(&SetCar));
+    env->Define("set-cdr!", BuiltinProcedure::Binary(&SetCdr));
+    env->Define("list-ref", BuiltinProcedure::Binary(&ListRef));
+    env->Define("list-tail", BuiltinProcedure::Binary(&ListTail));
 }
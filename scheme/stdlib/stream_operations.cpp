@@ -0,0 +1,176 @@
+#include "stdlib/stream_operations.h"
+
+#include "eval/procedure.h"
+#include "eval/promise.h"
+#include "runtime/helpers.h"
+#include "runtime/object.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+using helpers::Args;
+using helpers::RequireArgsCount;
+using helpers::RequireIndex;
+
+using EnvPtr = std::shared_ptr<Environment>;
+
+namespace {
+
+using ObjectPtr = std::shared_ptr<Object>;
+
+// Forced `stream`: the empty list or a pair of the promise of an item and the rest. Fails on
+// anything else.
+ObjectPtr ForceStream(const ObjectPtr& stream, const EnvPtr& env, Evaluator& evaluator) {
+    auto promise = As<Promise>(stream);
+    if (!promise) {
+        return Fail(Error::Runtime("Expected stream"));
+    }
+    auto value = Force(promise, env, evaluator);
+    if (IsFailure(value) || !value || Is<Cell>(value)) {
+        return value;
+    }
+    return Fail(Error::Runtime("Expected stream"));
+}
+
+// Forced pair of the stream `stream`, or nullptr with the error recorded by Fail.
+std::shared_ptr<Cell> ForceStreamPair(const ObjectPtr& stream, const EnvPtr& env,
+                                      Evaluator& evaluator) {
+    auto value = ForceStream(stream, env, evaluator);
+    if (IsFailure(value)) {
+        return nullptr;
+    }
+    auto cell = As<Cell>(value);
+    if (!cell) {
+        Fail(Error::Runtime("Expected stream pair"));
+    }
+    return cell;
+}
+
+// Item of a stream pair. Pairs not made by stream-cons may hold it as is.
+ObjectPtr ForceItem(const Cell& pair, const EnvPtr& env, Evaluator& evaluator) {
+    auto item = pair.GetFirst();
+    auto promise = As<Promise>(item);
+    return promise ? Force(promise, env, evaluator) : item;
+}
+
+// Whether the forced argument is a stream pair if `pair` is set, or the empty stream otherwise.
+ObjectPtr IsStream(Args args, const EnvPtr& env, Evaluator& evaluator, bool pair) {
+    if (!RequireArgsCount(args, 1)) {
+        return Failure();
+    }
+    auto promise = As<Promise>(args[0]);
+    if (!promise) {
+        return False();
+    }
+    auto value = Force(promise, env, evaluator);
+    if (IsFailure(value)) {
+        return value;
+    }
+    return MakeBool(pair ? Is<Cell>(value) : !value);
+}
+
+ObjectPtr StreamCar(Args args, const EnvPtr& env, Evaluator& evaluator) {
+    if (!RequireArgsCount(args, 1)) {
+        return Failure();
+    }
+    auto pair = ForceStreamPair(args[0], env, evaluator);
+    return pair ? ForceItem(*pair, env, evaluator) : Failure();
+}
+
+ObjectPtr StreamCdr(Args args, const EnvPtr& env, Evaluator& evaluator) {
+    if (!RequireArgsCount(args, 1)) {
+        return Failure();
+    }
+    auto pair = ForceStreamPair(args[0], env, evaluator);
+    return pair ? pair->GetSecond() : Failure();
+}
+
+// Stream of the first `count` items of `stream`, which is forced no further than that. Each pair
+// is made when forced, and the stream it came from is released then.
+ObjectPtr Take(int64_t count, ObjectPtr stream) {
+    auto thunk = std::make_shared<BuiltinProcedure>(
+        [count, stream = std::move(stream)](Args, const EnvPtr& env,
+                                            Evaluator& evaluator) -> ObjectPtr {
+            if (count == 0) {
+                return nullptr;
+            }
+            auto value = ForceStream(stream, env, evaluator);
+            auto pair = As<Cell>(value);
+            if (!pair) {
+                return value;
+            }
+            return std::make_shared<Cell>(pair->GetFirst(), Take(count - 1, pair->GetSecond()));
+        });
+    return std::make_shared<Promise>(std::move(thunk), false);
+}
+
+ObjectPtr StreamTake(Args args, const EnvPtr&, Evaluator&) {
+    int64_t count;
+    if (!RequireArgsCount(args, 2) || !RequireIndex(args[0], &count)) {
+        return Failure();
+    }
+    if (!Is<Promise>(args[1])) {
+        return Fail(Error::Runtime("Expected stream"));
+    }
+    return Take(count, args[1]);
+}
+
+// `(stream->list [count] stream)`: list of the items of the stream, or of its first `count`.
+ObjectPtr StreamToList(Args args, const EnvPtr& env, Evaluator& evaluator) {
+    auto count = std::numeric_limits<int64_t>::max();
+    if (args.size() != 1 && !RequireArgsCount(args, 2)) {
+        return Failure();
+    }
+    if (args.size() == 2 && !RequireIndex(args[0], &count)) {
+        return Failure();
+    }
+    ObjectPtr list;
+    Cell* last = nullptr;
+    auto stream = args.back();
+    for (; count > 0; --count) {
+        auto value = ForceStream(stream, env, evaluator);
+        auto pair = As<Cell>(value);
+        if (!pair) {
+            if (IsFailure(value)) {
+                return value;
+            }
+            break;
+        }
+        auto item = ForceItem(*pair, env, evaluator);
+        if (IsFailure(item)) {
+            return item;
+        }
+        auto cell = std::make_shared<Cell>(std::move(item), nullptr);
+        auto* next = cell.get();
+        if (last) {
+            last->SetSecond(std::move(cell));
+        } else {
+            list = std::move(cell);
+        }
+        last = next;
+        stream = pair->GetSecond();
+    }
+    return list;
+}
+
+}  // namespace
+
+void RegisterStreamOperations(const std::shared_ptr<Environment>& env) {
+    env->Define("stream-null", std::make_shared<Promise>(nullptr));
+    env->Define("stream-null?",
+                std::make_shared<BuiltinProcedure>(
+                    [](Args args, const EnvPtr& env, Evaluator& evaluator) {
+                        return IsStream(args, env, evaluator, false);
+                    }));
+    env->Define("stream-pair?",
+                std::make_shared<BuiltinProcedure>(
+                    [](Args args, const EnvPtr& env, Evaluator& evaluator) {
+                        return IsStream(args, env, evaluator, true);
+                    }));
+    env->Define("stream-car", std::make_shared<BuiltinProcedure>(&StreamCar));
+    env->Define("stream-cdr", std::make_shared<BuiltinProcedure>(&StreamCdr));
+    env->Define("stream-take", std::make_shared<BuiltinProcedure>(&StreamTake));
+    env->Define("stream->list", std::make_shared<BuiltinProcedure>(&StreamToList));
+}
@@ -0,0 +1,87 @@
+; Program compiled by scheme-aot for test_aot.cpp.
+
+(define (fact n)
+  (if (= n 0) 1 (* n (fact (- n 1)))))
+
+(define (sum-to n)
+  (let loop ((i 0) (acc 0))
+    (if (> i n) acc (loop (+ i 1) (+ acc i)))))
+
+(define (count-down n)
+  (cond ((< n 0) 'negative)
+        ((= n 0) 'done)
+        (else (count-down (- n 1)))))
+
+(define (fib n)
+  (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))
+
+(define (square x) (* x x))
+
+(define (sum-squares n)
+  (let loop ((i 1) (acc 0))
+    (if (> i n) acc (loop (+ i 1) (+ acc (square i))))))
+
+(define (depth n)
+  (if (= n 0) 0 (+ 1 (depth (- n 1)))))
+
+(define (range a b)
+  (if (>= a b) '() (cons a (range (+ a 1) b))))
+
+(define (reverse-list l)
+  (let loop ((l l) (acc '()))
+    (if (null? l) acc (loop (cdr l) (cons (car l) acc)))))
+
+(define (sum-list l)
+  (let loop ((l l) (acc 0))
+    (if (pair? l) (loop (cdr l) (+ acc (car l))) acc)))
+
+(define (classify x)
+  (cond ((not (number? x)) 'other)
+        ((and (> x 0) (< x 10)) 'small)
+        ((or (< x 0) (= x 0)) 'non-positive)
+        (else 'large)))
+
+(define (table n)
+  (let* ((a (* n 2)) (b (+ a 1)))
+    (list n a b (quote (x y)))))
+
+(define counter 0)
+
+(define (tick!)
+  (set! counter (+ counter 1))
+  counter)
+
+(define (swap-loop n)
+  (let loop ((a 1) (b 2) (n n))
+    (if (= n 0) (list a b) (loop b a (- n 1)))))
+
+(define (nested n)
+  (let outer ((i 0) (acc '()))
+    (if (= i n)
+        acc
+        (let inner ((j 0) (acc acc))
+          (if (= j i) (outer (+ i 1) acc) (inner (+ j 1) (cons (list i j) acc)))))))
+
+(define (accumulate n)
+  (let ((total 0))
+    (let loop ((i 0))
+      (if (< i n)
+          (begin (set! total (+ total i)) (loop (+ i 1)))
+          total))))
+
+(define (add a b) (+ a b))
+(define (sub a b) (- a b))
+(define (negate a) (- a))
+(define (mul a b) (* a b))
+(define (less a b) (< a b))
+(define (quotient a b) (/ a b))
+(define (first l) (car l))
+(define (magnitude x) (abs x))
+(define (bigger a b) (max a b))
+(define (maybe x) (if x 'yes))
+(define (either a b) (or a b))
+(define (both a b) (and a b))
+
+(define limit (sum-to 10))
+(tick!)
+(fact 5)
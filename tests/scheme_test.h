@@ -3,6 +3,7 @@
 #include "scheme.h"
 #include "runtime/error.h"
 
+#include <expected>
 #include <string>
 
 #include <catch2/catch_test_macros.hpp>
@@ -29,6 +30,40 @@ public:
         REQUIRE_THROWS_AS(scheme_.Evaluate(expression), NameError);
     }
 
+    void ExpectBudgetError(const std::string& expression, const Budget& budget) {
+        REQUIRE_THROWS_AS(scheme_.Evaluate(expression, budget), BudgetError);
+    }
+
+    // Checks the error TryEvaluate returns for `expression`, which must not throw.
+    void ExpectError(const std::string& expression, ErrorCode code, const std::string& message) {
+        std::expected<std::string, Error> result;
+        REQUIRE_NOTHROW(result = scheme_.TryEvaluate(expression));
+        REQUIRE_FALSE(result.has_value());
+        REQUIRE(result.error().GetCode() == code);
+        REQUIRE(result.error().GetMessage() == message);
+    }
+
+    std::expected<std::string, Error> TryEvaluate(const std::string& expression,
+                                                  const Budget& budget = {}) {
+        return scheme_.TryEvaluate(expression, budget);
+    }
+
+    std::expected<Scheme::Task, Error> Start(const std::string& expression) {
+        return scheme_.Start(expression);
+    }
+
+    void SetTierPolicy(const TierPolicy& policy) {
+        scheme_.SetTierPolicy(policy);
+    }
+
+    void SetEvalMode(EvalMode mode) {
+        scheme_.SetEvalMode(mode);
+    }
+
+    void SetStackLimit(size_t bytes) {
+        scheme_.SetStackLimit(bytes);
+    }
+
 private:
     Scheme scheme_;
 };
@@ -0,0 +1,101 @@
+#include "aot_rules.h"
+
+#include "aot/runtime.h"
+#include "io/printer.h"
+#include "runtime/error.h"
+#include "runtime/object.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::shared_ptr<Object> Num(int64_t value) {
+    return std::make_shared<Number>(value);
+}
+
+std::shared_ptr<Object> Sym(const char* name) {
+    return std::make_shared<Symbol>(name);
+}
+
+std::vector<std::string> LoadValues() {
+    static std::vector<std::string> values;
+    values.clear();
+    aot_rules::Load([](const std::shared_ptr<Object>& value) { values.push_back(Print(value)); });
+    return values;
+}
+
+}  // namespace
+
+TEST_CASE("AotProgramLoads") {
+    REQUIRE(LoadValues() == std::vector<std::string>{"1", "120"});
+    REQUIRE(Print(aot_rules::tick_x()) == "2");
+    REQUIRE(LoadValues() == std::vector<std::string>{"1", "120"});
+}
+
+TEST_CASE("AotProcedures") {
+    aot_rules::Load(nullptr);
+
+    REQUIRE(Print(aot_rules::fact(Num(10))) == "3628800");
+    REQUIRE(Print(aot_rules::fib(Num(20))) == "6765");
+    REQUIRE(Print(aot_rules::sum_to(Num(100))) == "5050");
+    REQUIRE(Print(aot_rules::sum_squares(Num(3))) == "14");
+    REQUIRE(Print(aot_rules::count_down(Num(1000000))) == "done");
+    REQUIRE(Print(aot_rules::count_down(Num(-1))) == "negative");
+    REQUIRE(Print(aot_rules::accumulate(Num(5))) == "10");
+
+    REQUIRE(Print(aot_rules::range(Num(0), Num(4))) == "(0 1 2 3)");
+    REQUIRE(Print(aot_rules::reverse_list(aot_rules::range(Num(0), Num(4)))) == "(3 2 1 0)");
+    REQUIRE(Print(aot_rules::sum_list(aot_rules::range(Num(1), Num(11)))) == "55");
+    REQUIRE(Print(aot_rules::table(Num(3))) == "(3 6 7 (x y))");
+    REQUIRE(Print(aot_rules::swap_loop(Num(3))) == "(2 1)");
+    REQUIRE(Print(aot_rules::nested(Num(3))) == "((2 1) (2 0) (1 0))");
+
+    REQUIRE(Print(aot_rules::classify(Num(5))) == "small");
+    REQUIRE(Print(aot_rules::classify(Num(0))) == "non-positive");
+    REQUIRE(Print(aot_rules::classify(Num(50))) == "large");
+    REQUIRE(Print(aot_rules::classify(Sym("x"))) == "other");
+
+    REQUIRE(Print(aot_rules::less(Num(1), Num(2))) == "#t");
+    REQUIRE(Print(aot_rules::negate(Num(7))) == "-7");
+    REQUIRE(Print(aot_rules::quotient(Num(7), Num(-2))) == "-3");
+    REQUIRE(Print(aot_rules::magnitude(Num(-4))) == "4");
+    REQUIRE(Print(aot_rules::bigger(Num(3), Num(8))) == "8");
+    REQUIRE(Print(aot_rules::maybe(True())) == "yes");
+    REQUIRE(Print(aot_rules::either(False(), Num(2))) == "2");
+    REQUIRE(Print(aot_rules::both(Num(1), False())) == "#f");
+}
+
+// Values the fast paths do not handle go to the builtins, which report the errors.
+TEST_CASE("AotErrors") {
+    aot_rules::Load(nullptr);
+
+    REQUIRE_THROWS_AS(aot_rules::add(Num(1), Sym("a")), RuntimeError);
+    REQUIRE_THROWS_AS(aot_rules::less(Sym("a"), Num(1)), RuntimeError);
+    REQUIRE_THROWS_AS(aot_rules::first(Num(1)), RuntimeError);
+    REQUIRE_THROWS_AS(aot_rules::sum_list(std::make_shared<Cell>(Sym("a"), nullptr)),
+                      RuntimeError);
+    REQUIRE_THROWS_AS(aot_rules::magnitude(Sym("a")), RuntimeError);
+    REQUIRE_THROWS_AS(aot_rules::quotient(Num(1), Num(0)), RuntimeError);
+
+    auto min = std::numeric_limits<int64_t>::min();
+    REQUIRE(Print(aot_rules::sub(Num(min + 1), Num(1))) == std::to_string(min));
+    REQUIRE(Print(aot_rules::mul(Num(1), Num(min))) == std::to_string(min));
+}
+
+TEST_CASE("AotDeepRecursion") {
+    aot_rules::Load(nullptr);
+
+    REQUIRE(Print(aot_rules::depth(Num(100000))) == "100000");
+
+    auto& stack = aot::GetNativeStack();
+    stack.SetLimit(0);
+    REQUIRE_THROWS_AS(aot_rules::depth(Num(1000000)), RuntimeError);
+    stack.SetLimit(NativeStack::kDefaultLimit);
+    REQUIRE(Print(aot_rules::depth(Num(10))) == "10");
+}
@@ -0,0 +1,103 @@
+#include "scheme_test.h"
+
+#include <chrono>
+
+namespace {
+
+constexpr TierPolicy kNeverPromote{1000000, 1000000};
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void ExpectOutOfFuel(SchemeTest* test, const std::string& expression, uint64_t fuel) {
+    auto result = test->TryEvaluate(expression, Budget{.fuel = fuel});
+    REQUIRE_FALSE(result.has_value());
+    REQUIRE(result.error().GetCode() == ErrorCode::Budget);
+    REQUIRE(result.error().GetMessage() == "Out of fuel");
+}
+
+void CheckFuelStopsLoops(SchemeTest* test) {
+    test->ExpectNoError("(define (spin n) (spin (+ n 1)))");
+    test->ExpectNoError("(define (deep n) (if (= n 0) 0 (+ 1 (deep (- n 1)))))");
+    ExpectOutOfFuel(test, "(spin 0)", 10000);
+    ExpectOutOfFuel(test, "(deep 1000)", 100);
+    ExpectOutOfFuel(test, "(+ 1 2)", 0);
+
+    REQUIRE(test->TryEvaluate("(deep 100)", Budget{.fuel = 100000}) == "100");
+    test->ExpectEq("(deep 100)", "100");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "FuelStopsTreeWalker") {
+    SetTierPolicy(kNeverPromote);
+    CheckFuelStopsLoops(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "FuelStopsHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckFuelStopsLoops(this);
+    ExpectNoError("(define (count n acc) (if (= n 0) acc (count (- n 1) (+ acc 1))))");
+    ExpectOutOfFuel(this, "(count 100000 0)", 1000);
+    ExpectEq("(count 100000 0)", "100000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "FuelStopsMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckFuelStopsLoops(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "DeadlineStopsLoops") {
+    ExpectNoError("(define (spin n) (spin (+ n 1)))");
+    auto deadline = Budget::Clock::now() + std::chrono::milliseconds(20);
+    auto result = TryEvaluate("(spin 0)", Budget{.deadline = deadline});
+    REQUIRE_FALSE(result.has_value());
+    REQUIRE(result.error().GetCode() == ErrorCode::Budget);
+    REQUIRE(result.error().GetMessage() == "Deadline exceeded");
+    REQUIRE(Budget::Clock::now() >= deadline);
+    ExpectEq("(+ 1 2)", "3");
+}
+
+TEST_CASE_METHOD(SchemeTest, "EvaluateThrowsBudgetError") {
+    ExpectNoError("(define (spin n) (spin (+ n 1)))");
+    ExpectBudgetError("(spin 0)", Budget{.fuel = 10});
+    ExpectBudgetError("(spin 0)", Budget{.deadline = Budget::Clock::now()});
+}
+
+TEST_CASE_METHOD(SchemeTest, "TasksPauseAndResume") {
+    ExpectNoError("(define (count n acc) (if (= n 0) acc (count (- n 1) (+ acc 1))))");
+    auto first = Start("(count 1000 0)");
+    auto second = Start("(count 500 1)");
+    REQUIRE(first.has_value());
+    REQUIRE(second.has_value());
+
+    int pauses = 0;
+    std::expected<std::string, Error> first_result, second_result;
+    while (!first->IsFinished() || !second->IsFinished()) {
+        for (auto [task, result] : {std::pair{&*first, &first_result},
+                                    std::pair{&*second, &second_result}}) {
+            if (task->IsFinished()) {
+                continue;
+            }
+            *result = task->Resume(Budget{.fuel = 100});
+            if (!task->IsFinished()) {
+                REQUIRE(result->error().GetCode() == ErrorCode::Budget);
+                ++pauses;
+            }
+        }
+    }
+    REQUIRE(first_result == "1000");
+    REQUIRE(second_result == "501");
+    REQUIRE(pauses > 20);
+    REQUIRE_FALSE(first->Resume().has_value());
+}
+
+TEST_CASE_METHOD(SchemeTest, "TasksReportErrors") {
+    auto syntax = Start("(1 . 2");
+    REQUIRE_FALSE(syntax.has_value());
+    REQUIRE(syntax.error().GetCode() == ErrorCode::Syntax);
+
+    auto task = Start("(car (list 1 (car 2)))");
+    REQUIRE(task.has_value());
+    auto result = task->Resume();
+    REQUIRE(task->IsFinished());
+    REQUIRE(result.error().GetMessage() == "Expected pair");
+}
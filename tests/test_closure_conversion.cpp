@@ -0,0 +1,135 @@
+#include "scheme_test.h"
+
+#include "eval/eval.h"
+#include "eval/procedure.h"
+#include "reader/parser.h"
+#include "runtime/env.h"
+#include "stdlib/builtins.h"
+
+#include <sstream>
+
+namespace {
+
+constexpr TierPolicy kAlwaysWarm{0, UINT64_MAX};
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+std::shared_ptr<Object> ReadExpr(const std::string& str) {
+    std::istringstream in{str};
+    Tokenizer tokenizer{&in};
+    return Read(&tokenizer);
+}
+
+void CheckClosures(SchemeTest* test) {
+    test->ExpectNoError("(define (adder n) (lambda (x) (+ x n)))");
+    test->ExpectEq("((adder 2) 3)", "5");
+    test->ExpectNoError("(define (curry a) (lambda (b) (lambda (c) (list a b c))))");
+    test->ExpectEq("(((curry 1) 2) 3)", "(1 2 3)");
+    test->ExpectNoError("(define (all a b c d e) (lambda () (+ a b c d e)))");
+    test->ExpectEq("((all 1 2 3 4 5))", "15");
+    test->ExpectNoError("(define (gather . xs) (lambda () xs))");
+    test->ExpectEq("((gather 1 2))", "(1 2)");
+    test->ExpectNoError("(define (quoted n) (lambda () '(n n)))");
+    test->ExpectEq("((quoted 1))", "(n n)");
+    test->ExpectNoError("(define-syntax twice (syntax-rules () ((_ e) (begin e e))))");
+    test->ExpectNoError("(define (via-macro n) (lambda () (twice n)))");
+    test->ExpectEq("((via-macro 3))", "3");
+
+    // Lifted lambdas see the global environment as it is when they run.
+    test->ExpectNoError("(define (late) (lambda () (late-target)))");
+    test->ExpectNoError("(define (late-target) 1)");
+    test->ExpectEq("((late))", "1");
+    test->ExpectNoError("(define (late-target) 2)");
+    test->ExpectEq("((late))", "2");
+
+    // Every iteration of a loop binds fresh variables.
+    test->ExpectNoError(
+        "(define (thunks n)"
+        "  (do ((i 0 (+ i 1)) (acc '() (cons (lambda () i) acc))) ((= i n) acc)))");
+    test->ExpectNoError("(define (run l) (if (null? l) '() (cons ((car l)) (run (cdr l)))))");
+    test->ExpectEq("(run (thunks 3))", "(2 1 0)");
+
+    // A letrec variable is not bound yet when the inits before it run.
+    test->ExpectNoError(
+        "(define (shadowed b)"
+        "  (letrec ((a (lambda () b)) (b 2)) (let ((r (a))) (set! a #f) r)))");
+    test->ExpectEq("(shadowed 1)", "2");
+}
+
+void CheckHelpers(SchemeTest* test) {
+    test->ExpectNoError(
+        "(define (count-up n)"
+        "  (define (go i acc) (if (= i 0) acc (go (- i 1) (+ acc 1))))"
+        "  (go n 0))");
+    test->ExpectNoError(
+        "(define (sum-to n)"
+        "  (define (go i acc) (if (> i n) acc (go (+ i 1) (+ acc i))))"
+        "  (go 0 0))");
+    test->ExpectNoError(
+        "(define (sum-squares n)"
+        "  (define square (lambda (x) (* x x)))"
+        "  (let loop ((i 0) (acc 0)) (if (> i n) acc (loop (+ i 1) (+ acc (square i))))))");
+    test->ExpectNoError("(define (twice-next x) (define (g x) (* x 2)) (g (+ x 1)))");
+    test->ExpectNoError(
+        "(define (rebound)"
+        "  (define (g) 1) (define (h) (g)) (set! g (lambda () 2)) (let ((r (h))) (set! h #f) r))");
+    test->ExpectNoError(
+        "(define (replaced)"
+        "  (define (g n) (if (= n 0) 'done (begin (set! g (lambda (n) 'replaced)) (g (- n 1)))))"
+        "  (g 2))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(count-up 10000)", "10000");
+        test->ExpectEq("(sum-to 100)", "5050");
+        test->ExpectEq("(sum-squares 3)", "14");
+        test->ExpectEq("(twice-next 1)", "4");
+        test->ExpectEq("(rebound)", "2");
+        test->ExpectEq("(replaced)", "replaced");
+    }
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "ClosureConversion") {
+    SetTierPolicy(kAlwaysWarm);
+    CheckClosures(this);
+    CheckHelpers(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "ClosureConversionInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckClosures(this);
+    CheckHelpers(this);
+}
+
+// Closures converted by analyzed code run on the machine as well.
+TEST_CASE_METHOD(SchemeTest, "ConvertedClosuresOnMachine") {
+    SetTierPolicy(kAlwaysWarm);
+    ExpectNoError(
+        "(define (make-summer n) (define (go i acc) (if (> i n) acc (go (+ i 1) (+ acc i)))) go)");
+    ExpectNoError("(define summer (make-summer 10))");
+    ExpectNoError("(define (make-counter) (define (go i) (if (= i 0) 'done (go (- i 1)))) go)");
+    ExpectNoError("(define counter (make-counter))");
+    SetEvalMode(EvalMode::Machine);
+    ExpectEq("(summer 0 0)", "55");
+    ExpectEq("(counter 100000)", "done");
+}
+
+TEST_CASE("LiftedLambdasAreCreatedOnce") {
+    auto env = std::make_shared<Environment>();
+    AddBuiltins(env);
+    Evaluator evaluator;
+    evaluator.SetTierPolicy(kAlwaysWarm);
+
+    evaluator.Eval(ReadExpr("(define (identity-maker) (lambda (x) x))"), env);
+    auto first = evaluator.Eval(ReadExpr("(identity-maker)"), env);
+    REQUIRE(Is<LambdaProcedure>(first));
+    REQUIRE(evaluator.Eval(ReadExpr("(identity-maker)"), env) == first);
+
+    // A closure of a few parameters holds them alone rather than the environment of the call.
+    evaluator.Eval(ReadExpr("(define (adder n) (lambda (x) (+ x n)))"), env);
+    auto adder = As<LambdaProcedure>(evaluator.Eval(ReadExpr("(adder 1)"), env));
+    REQUIRE(adder);
+    REQUIRE(adder->GetClosure()->GetParent() == env);
+    REQUIRE(evaluator.Eval(ReadExpr("(adder 1)"), env) != adder);
+
+    env->Clear();
+}
@@ -0,0 +1,121 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckEscapes(SchemeTest* test) {
+    test->ExpectEq("(+ 1 (call/cc (lambda (k) (+ 10 (k 2)))))", "3");
+    test->ExpectEq("(+ 1 (call-with-current-continuation (lambda (k) 5)))", "6");
+    test->ExpectEq("(call/ec (lambda (k) (car (k 'out))))", "out");
+
+    test->ExpectNoError(
+        "(define (walk l return)"
+        "  (if (null? l) #f (if (< (car l) 0) (return (car l)) (walk (cdr l) return))))");
+    test->ExpectNoError("(define (find-negative l) (call/ec (lambda (return) (walk l return))))");
+    test->ExpectEq("(find-negative '(1 2 -3 4 -5))", "-3");
+    test->ExpectEq("(find-negative '(1 2))", "#f");
+
+    test->ExpectNoError("(define (outer) (call/cc (lambda (k) (list 1 (inner k)))))");
+    test->ExpectNoError("(define (inner k) (k 'skipped))");
+    test->ExpectEq("(outer)", "skipped");
+
+    test->ExpectRuntimeError("(call/cc 1)");
+    test->ExpectRuntimeError("(call/cc)");
+    test->ExpectRuntimeError("(call/cc (lambda (k) (k 1 2)))");
+    test->ExpectRuntimeError("(call/ec (lambda () 1))");
+}
+
+void CheckEscapeExpiry(SchemeTest* test) {
+    test->ExpectNoError("(define saved #f)");
+    test->ExpectEq("(call/ec (lambda (k) (set! saved k) 1))", "1");
+    test->ExpectRuntimeError("(saved 2)");
+    test->ExpectEq("(call/ec (lambda (k) (set! saved k) (k 1)))", "1");
+    test->ExpectRuntimeError("(saved 2)");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "MachineEvaluatesLikeRecursiveEvaluator") {
+    SetEvalMode(EvalMode::Machine);
+    ExpectEq("(+ 1 (* 2 3) (- 4))", "3");
+    ExpectEq("(if (< 1 2) 'yes 'no)", "yes");
+    ExpectEq("(if #f 1)", "()");
+    ExpectEq("(and 1 (< 1 2) 3)", "3");
+    ExpectEq("(and 1 #f (car '()))", "#f");
+    ExpectEq("(or #f (< 2 1) 4)", "4");
+    ExpectEq("(list (and) (or))", "(#t #f)");
+
+    ExpectNoError("(define x 1)");
+    ExpectNoError("(set! x (+ x 1))");
+    ExpectEq("x", "2");
+    ExpectNoError("(define (make-counter) (define n 0) (lambda () (set! n (+ n 1)) n))");
+    ExpectNoError("(define c (make-counter))");
+    ExpectNoError("(c)");
+    ExpectEq("(c)", "2");
+    ExpectEq("((lambda (a b) (cons b a)) 1 (list 2 3))", "((2 3) . 1)");
+
+    ExpectSyntaxError("(if)");
+    ExpectSyntaxError("(lambda)");
+    ExpectSyntaxError("(define)");
+    ExpectSyntaxError("(and 1 . 2)");
+    ExpectRuntimeError("(1 2)");
+    ExpectRuntimeError("((lambda (x) x))");
+    ExpectRuntimeError("(+ 1 . 2)");
+    ExpectNameError("(set! y 1)");
+    ExpectNameError("undefined");
+}
+
+TEST_CASE_METHOD(SchemeTest, "MachineRecursionIsNotBoundByNativeStack") {
+    SetEvalMode(EvalMode::Machine);
+    ExpectNoError("(define (count n) (if (= n 0) 0 (+ 1 (count (- n 1)))))");
+    ExpectEq("(count 100000)", "100000");
+    ExpectNoError("(define (loop n acc) (if (= n 0) acc (loop (- n 1) (+ acc 1))))");
+    ExpectEq("(loop 100000 0)", "100000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ContinuationsEscape") {
+    SetTierPolicy(kAlwaysHot);
+    CheckEscapes(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "MachineContinuationsEscape") {
+    SetEvalMode(EvalMode::Machine);
+    CheckEscapes(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "EscapeContinuationsExpire") {
+    CheckEscapeExpiry(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "MachineEscapeContinuationsExpire") {
+    SetEvalMode(EvalMode::Machine);
+    CheckEscapeExpiry(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "MachineContinuationsReenter") {
+    SetEvalMode(EvalMode::Machine);
+    ExpectNoError("(define k #f)");
+    ExpectEq("(+ 1 (call/cc (lambda (c) (set! k c) 1)))", "2");
+    ExpectEq("(k 10)", "11");
+    ExpectEq("(k 20)", "21");
+
+    ExpectNoError("(define tries 0)");
+    ExpectNoError(
+        "(define (retry)"
+        "  (define v (call/cc (lambda (c) (set! k c) 0)))"
+        "  (set! tries (+ tries 1))"
+        "  (if (< v 3) (k (+ v 1)) (list v tries)))");
+    ExpectEq("(retry)", "(3 4)");
+
+    ExpectNoError("(define (args) (list 1 (call/cc (lambda (c) (set! k c) 2)) 3))");
+    ExpectEq("(args)", "(1 2 3)");
+    ExpectEq("(k 'x)", "(1 x 3)");
+    ExpectEq("(k 'y)", "(1 y 3)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "RecursiveContinuationsOnlyEscape") {
+    ExpectNoError("(define k #f)");
+    ExpectEq("(+ 1 (call/cc (lambda (c) (set! k c) 1)))", "2");
+    ExpectRuntimeError("(k 10)");
+}
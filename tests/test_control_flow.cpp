@@ -24,4 +24,8 @@ TEST_CASE_METHOD(SchemeTest, "IfEvaluation") {
 TEST_CASE_METHOD(SchemeTest, "IfSyntaxError") {
     ExpectSyntaxError("(if)");
     ExpectSyntaxError("(if 1 2 3 4)");
+    ExpectSyntaxError("(if 1 . 2)");
+    ExpectSyntaxError("(set! 1 2)");
+    ExpectSyntaxError("(set! x)");
+    ExpectSyntaxError("(quote 1 2)");
 }
@@ -0,0 +1,152 @@
+#include "scheme_test.h"
+
+#include <string>
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckBindings(SchemeTest* test) {
+    test->ExpectEq("(begin 1 2 3)", "3");
+    test->ExpectEq("(let ((x 1) (y 2)) (+ x y))", "3");
+    test->ExpectEq("(let () 5)", "5");
+    test->ExpectEq("(let ((x 1)) (let ((x 2) (y x)) (list x y)))", "(2 1)");
+    test->ExpectEq("(let* ((x 1) (y (+ x 1)) (x (* y 10))) (list x y))", "(20 2)");
+    test->ExpectEq("(let* () (define z 4) z)", "4");
+    // The procedures are cleared at the end, so the environment they close over is freed.
+    test->ExpectEq(
+        "(letrec ((even? (lambda (n) (if (= n 0) #t (odd? (- n 1)))))"
+        "         (odd? (lambda (n) (if (= n 0) #f (even? (- n 1))))))"
+        "  (let ((result (list (even? 10) (odd? 7))))"
+        "    (set! even? #f)"
+        "    (set! odd? #f)"
+        "    result))",
+        "(#t #t)");
+    test->ExpectEq("(letrec ((a 1) (b (+ a 1))) b)", "2");
+
+    test->ExpectNoError("(define x 10)");
+    test->ExpectEq("(let ((x 1)) (set! x (+ x 1)) x)", "2");
+    test->ExpectEq("x", "10");
+    test->ExpectEq("(let ((y 1)) (define x 5) (+ x y))", "6");
+    test->ExpectEq("x", "10");
+    test->ExpectEq("(begin (define x 3) x)", "3");
+
+    test->ExpectSyntaxError("(let ((x 1)))");
+    test->ExpectSyntaxError("(let ((x 1) (x 2)) x)");
+    test->ExpectSyntaxError("(let ((1 2)) 3)");
+    test->ExpectSyntaxError("(let (x) x)");
+    test->ExpectSyntaxError("(letrec)");
+    test->ExpectNameError("(letrec ((a b) (b 1)) a)");
+}
+
+void CheckCond(SchemeTest* test) {
+    test->ExpectEq("(cond ((> 1 2) 'a) ((> 2 1) 'b) (else 'c))", "b");
+    test->ExpectEq("(cond (#f 1) (else 2 3))", "3");
+    test->ExpectEq("(cond ((cdr '(a b c))))", "(b c)");
+    test->ExpectEq("(cond ((cdr '(a b c)) => car) (else #f))", "b");
+    test->ExpectEq("(cond (#f 1))", "()");
+    test->ExpectEq("(cond)", "()");
+
+    test->ExpectSyntaxError("(cond (else 1) (#t 2))");
+    test->ExpectSyntaxError("(cond (else))");
+    test->ExpectSyntaxError("(cond (#t => car cdr))");
+    test->ExpectSyntaxError("(cond 1)");
+    test->ExpectRuntimeError("(cond (1 => 2))");
+}
+
+void CheckCase(SchemeTest* test) {
+    test->ExpectEq("(case (* 2 3) ((2 3 5 7) 'prime) ((1 4 6 8 9) 'composite))", "composite");
+    test->ExpectEq("(case 1000000 ((1) 'one) ((1000000 -5) 'big) (else 'other))", "big");
+    test->ExpectEq("(case 'b ((a) 1) ((b c) 2) (else 3))", "2");
+    test->ExpectEq("(case 'z ((a) 1) (else 2 3))", "3");
+    test->ExpectEq("(case 'z ((a) 1))", "()");
+    test->ExpectEq("(case (list 1) (((1)) 'list) (else 'other))", "other");
+    test->ExpectEq("(case #f ((#t) 'true) ((#f) 'false))", "false");
+    test->ExpectEq("(case '() ((()) 'empty) (else 'other))", "empty");
+    test->ExpectEq("(case 1 ((1) 'first) ((1) 'second))", "first");
+    test->ExpectEq("(case '(1 2) ((a) 1) (else => cdr))", "(2)");
+    test->ExpectEq("(case 5 ((5) => (lambda (x) (* x x))))", "25");
+
+    test->ExpectSyntaxError("(case)");
+    test->ExpectSyntaxError("(case 1 (1 2))");
+    test->ExpectSyntaxError("(case 1 ((1)))");
+    test->ExpectSyntaxError("(case 1 (else 1) ((1) 2))");
+    test->ExpectRuntimeError("(case 1 ((1) => 2))");
+}
+
+// Router with `count` clauses, alternately on symbols and fixnums.
+std::string MakeRouter(int count) {
+    std::string router = "(define (route message) (case message";
+    for (auto i = 0; i < count; ++i) {
+        std::string datum = i % 2 ? "" : "m";
+        datum += std::to_string(i);
+        router += " ((";
+        router += datum;
+        router += ") ";
+        router += std::to_string(i);
+        router += ")";
+    }
+    return router + " (else 'unknown)))";
+}
+
+void CheckRouter(SchemeTest* test) {
+    test->ExpectNoError(MakeRouter(200));
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(list (route 'm0) (route 1) (route 'm198) (route 199) (route 'm1))",
+                       "(0 1 198 199 unknown)");
+    }
+}
+
+void CheckProcedures(SchemeTest* test) {
+    test->ExpectNoError(
+        "(define (classify n)"
+        "  (cond ((< n 0) 'negative) ((= n 0) 'zero) (else 'positive)))");
+    test->ExpectNoError(
+        "(define (count n acc) (let ((m (- n 1))) (if (< n 1) acc (count m (+ acc 1)))))");
+    test->ExpectNoError("(define (adder n) (let ((k n)) (lambda (x) (+ x k))))");
+    test->ExpectNoError("(define (shadow l) (let ((car cdr)) (car l)))");
+    test->ExpectNoError("(define (first l) (car l))");
+
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(list (classify -1) (classify 0) (classify 1))", "(negative zero positive)");
+        test->ExpectEq("((adder 2) 3)", "5");
+        test->ExpectEq("(shadow '(1 2 3))", "(2 3)");
+        test->ExpectEq("(first '(1 2 3))", "1");
+        test->ExpectEq("(let ((car 5)) car)", "5");
+    }
+    test->ExpectEq("(count 100000 0)", "100000");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "DerivedForms") {
+    CheckBindings(this);
+    CheckCond(this);
+    CheckCase(this);
+    CheckRouter(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "DerivedFormsInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckBindings(this);
+    CheckCond(this);
+    CheckCase(this);
+    CheckRouter(this);
+    CheckProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "DerivedFormsInWarmCode") {
+    CheckProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "DerivedFormsOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckBindings(this);
+    CheckCond(this);
+    CheckCase(this);
+    CheckRouter(this);
+    CheckProcedures(this);
+    ExpectEq("(let ((k #f) (n 0)) (let ((x (call/cc (lambda (c) (set! k c) 1)))) (set! n (+ n x))"
+             " (if (< n 3) (k 1) (begin (set! k #f) n))))",
+             "3");
+}
@@ -0,0 +1,69 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kAlwaysWarm{0, 1000000};
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckErrorsFromCalls(SchemeTest* test) {
+    test->ExpectNoError("(define (first l) (car l))");
+    test->ExpectNoError("(define (sum-to n) (if (= n 0) x (+ n (sum-to (- n 1)))))");
+    test->ExpectNoError("(define (count n) (if (= n 0) (car n) (count (- n 1))))");
+
+    test->ExpectError("(first 1)", ErrorCode::Runtime, "Expected pair");
+    test->ExpectError("(first)", ErrorCode::Runtime, "Invalid argument count");
+    test->ExpectError("(+ 1 (first '()))", ErrorCode::Runtime, "Expected pair");
+    test->ExpectError("(sum-to 10)", ErrorCode::Name, "Name not found: x");
+    test->ExpectError("(count 100)", ErrorCode::Runtime, "Expected pair");
+    test->ExpectEq("(first '(1 2))", "1");
+    test->ExpectNoError("(define x 0)");
+    test->ExpectEq("(sum-to 10)", "55");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "ErrorsAreReturnedWithCodeAndMessage") {
+    ExpectError("(+ 1 #t)", ErrorCode::Runtime, "Expected number");
+    ExpectError("(1 2)", ErrorCode::Runtime, "Not a procedure");
+    ExpectError("(list-ref '(1 2) 2)", ErrorCode::Runtime, "Index out of range");
+    ExpectError("(list-ref '(1 2) -1)", ErrorCode::Runtime, "Invalid index");
+    ExpectError("undefined", ErrorCode::Name, "Name not found: undefined");
+    ExpectError("(set! undefined 1)", ErrorCode::Name, "Name not found: undefined");
+    ExpectError("(if)", ErrorCode::Syntax, "");
+    ExpectError("(1 . 2", ErrorCode::Syntax, "");
+
+    ExpectEq("(+ 1 2)", "3");
+    ExpectNoError("(define y 1)");
+    ExpectError("(define y (car '()))", ErrorCode::Runtime, "Expected pair");
+    ExpectError("(set! y (car '()))", ErrorCode::Runtime, "Expected pair");
+    ExpectEq("y", "1");
+}
+
+TEST_CASE_METHOD(SchemeTest, "EvaluateThrowsReturnedErrors") {
+    ExpectRuntimeError("(+ 1 #t)");
+    ExpectNameError("undefined");
+    ExpectSyntaxError("(if)");
+    REQUIRE_THROWS_WITH(Error::Runtime("Expected pair").Throw(), "Expected pair");
+    REQUIRE_THROWS_WITH(Error::Name("x").Throw(), "Name not found: x");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ErrorsPropagateFromTreeWalker") {
+    CheckErrorsFromCalls(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "ErrorsPropagateFromWarmCode") {
+    SetTierPolicy(kAlwaysWarm);
+    CheckErrorsFromCalls(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "ErrorsPropagateFromHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckErrorsFromCalls(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "ErrorsPropagateFromMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckErrorsFromCalls(this);
+    ExpectError("(call/cc (lambda (k) (k (car 1))))", ErrorCode::Runtime, "Expected pair");
+    ExpectEq("(call/cc (lambda (k) (k 1)))", "1");
+}
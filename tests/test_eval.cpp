@@ -1,8 +1,30 @@
 #include "scheme_test.h"
 
+#include "eval/special_forms.h"
+#include "runtime/object.h"
+
 TEST_CASE_METHOD(SchemeTest, "Quote") {
     ExpectEq("(quote (1 2))", "(1 2)");
     ExpectEq("'(1 2)", "(1 2)");
     ExpectEq("'101", "101");
     ExpectEq("(quote (-2 . 3))", "(-2 . 3)");
 }
+
+TEST_CASE("SpecialFormLookupIsCachedPerRegistry") {
+    auto forms = CreateStandardForms();
+    Symbol if_symbol{"if"};
+    Symbol call_symbol{"car"};
+    auto* form = forms.Lookup(if_symbol);
+    REQUIRE(form == forms.Lookup("if").get());
+    REQUIRE(forms.Lookup(if_symbol) == form);
+    REQUIRE(forms.Lookup(call_symbol) == nullptr);
+
+    auto copy = forms;
+    copy.Register("car", copy.Lookup("quote"));
+    REQUIRE(copy.Lookup(call_symbol) == copy.Lookup("quote").get());
+    REQUIRE(forms.Lookup(call_symbol) == nullptr);
+    REQUIRE(copy.Lookup(if_symbol) == form);
+
+    SpecialFormRegistry empty;
+    REQUIRE(empty.Lookup(if_symbol) == nullptr);
+}
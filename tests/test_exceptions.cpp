@@ -0,0 +1,139 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckGuard(SchemeTest* test) {
+    test->ExpectEq("(guard (e (#t (list 'caught e))) (raise 'oops))", "(caught oops)");
+    test->ExpectEq("(guard (e ((symbol? e) 1) ((pair? e) 2)) (raise '(a)))", "2");
+    test->ExpectEq(
+        "(guard (e ((and (pair? e) (car e)) => (lambda (x) (* x 2)))) (raise '(7 8)))", "14");
+    test->ExpectEq("(guard (e (else 'other)) (raise 1))", "other");
+    test->ExpectEq("(guard (e (#t e)) (raise '()))", "()");
+    test->ExpectEq("(guard (e (#t e)) 1 2 5)", "5");
+    test->ExpectEq("(guard (e (#t e)) (guard (e ((number? e) e)) (raise 'inner)))", "inner");
+    test->ExpectEq("(guard (e ((error-object? e) (error-object-message e))) (car 1))",
+                   "Expected pair");
+    test->ExpectEq("(guard (e ((error-object? e) 'unbound)) undefined-name)", "unbound");
+    test->ExpectEq("(guard (e ((error-object? e) e)) 4)", "4");
+
+    test->ExpectRuntimeError("(raise 'x)");
+    test->ExpectRuntimeError("(guard (e ((symbol? e) 1)) (raise 5))");
+    test->ExpectRuntimeError("(guard (e (#f 0)) (car 1))");
+    test->ExpectRuntimeError("(guard (e (#t (raise e))) (car 1))");
+    test->ExpectRuntimeError("(error-object-message 'x)");
+    test->ExpectNameError("(guard (e ((symbol? e) 0)) undefined-name)");
+    test->ExpectSyntaxError("(guard (e (#t 0)))");
+    test->ExpectSyntaxError("(guard (1 (#t 0)) 1)");
+    test->ExpectSyntaxError("(guard e 1)");
+}
+
+void CheckHandlers(SchemeTest* test) {
+    test->ExpectEq(
+        "(with-exception-handler (lambda (e) 10) (lambda () (+ 1 (raise-continuable 'c))))",
+        "11");
+    test->ExpectEq(
+        "(call/cc (lambda (k)"
+        "  (with-exception-handler (lambda (e) (k (list 'handled e)))"
+        "    (lambda () (raise 'boom)))))",
+        "(handled boom)");
+    test->ExpectEq(
+        "(call/cc (lambda (k)"
+        "  (with-exception-handler (lambda (e) (k (error-object-message e)))"
+        "    (lambda () (car '())))))",
+        "Expected pair");
+    test->ExpectEq("(with-exception-handler (lambda (e) 0) (lambda () 3))", "3");
+
+    // Handlers run with the handlers outside of them installed.
+    test->ExpectEq(
+        "(with-exception-handler (lambda (e) (* e 2))"
+        "  (lambda () (with-exception-handler (lambda (e) (+ 1 (raise-continuable e)))"
+        "    (lambda () (raise-continuable 5)))))",
+        "11");
+    test->ExpectEq(
+        "(guard (e (#t (list 'outer e)))"
+        "  (with-exception-handler (lambda (e) (raise 'again)) (lambda () (raise 'x))))",
+        "(outer again)");
+
+    // A guard inside a handler's extent catches raise-continuable before the handler does.
+    test->ExpectEq(
+        "(with-exception-handler (lambda (e) 0)"
+        "  (lambda () (guard (e ((symbol? e) 'guarded)) (raise-continuable 'c))))",
+        "guarded");
+
+    test->ExpectRuntimeError("(with-exception-handler (lambda (e) 0) (lambda () (raise 'x)))");
+    test->ExpectRuntimeError("(with-exception-handler (lambda (e) 0) (lambda () (car 1)))");
+    test->ExpectRuntimeError("(raise-continuable 'x)");
+    test->ExpectRuntimeError("(with-exception-handler 1 (lambda () 0))");
+    test->ExpectRuntimeError("(with-exception-handler (lambda (e) 0))");
+}
+
+void CheckInProcedures(SchemeTest* test) {
+    test->ExpectNoError(
+        "(define (safe-div a b)"
+        "  (guard (e ((symbol? e) e)) (if (= b 0) (raise 'div0) (/ a b))))");
+    test->ExpectNoError(
+        "(define (count-even n acc)"
+        "  (if (= n 0)"
+        "      acc"
+        "      (count-even (- n 1) (guard (e ((symbol? e) (+ acc 1)))"
+        "                            (if (= n (* 2 (/ n 2))) (raise 'even) acc)))))");
+    test->ExpectNoError("(define (retry n) (guard (e ((< n 3) (retry (+ n 1)))) (raise n)))");
+    test->ExpectNoError(
+        "(define (find-first n)"
+        "  (guard (e (#t e)) (let loop ((i 0)) (if (= i n) (raise i) (loop (+ i 1))))))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(safe-div 10 2)", "5");
+        test->ExpectEq("(safe-div 1 0)", "div0");
+        test->ExpectEq("(count-even 1000 0)", "500");
+        test->ExpectEq("(find-first 7)", "7");
+    }
+    test->ExpectRuntimeError("(retry 0)");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "Exceptions") {
+    CheckGuard(this);
+    CheckHandlers(this);
+    CheckInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "ExceptionsInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckGuard(this);
+    CheckHandlers(this);
+    CheckInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "ExceptionsOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckGuard(this);
+    CheckHandlers(this);
+    CheckInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "GuardDoesNotCatchBudget") {
+    ExpectNoError("(define (spin n) (spin (+ n 1)))");
+    auto result = TryEvaluate("(guard (e (#t 'caught)) (spin 0))", Budget{.fuel = 1000});
+    REQUIRE_FALSE(result.has_value());
+    REQUIRE(result.error().GetCode() == ErrorCode::Budget);
+
+    SetEvalMode(EvalMode::Machine);
+    result = TryEvaluate("(with-exception-handler (lambda (e) 'caught) (lambda () (spin 0)))",
+                         Budget{.fuel = 1000});
+    REQUIRE_FALSE(result.has_value());
+    REQUIRE(result.error().GetCode() == ErrorCode::Budget);
+}
+
+// A guard left by a continuation still catches errors raised after it is resumed.
+TEST_CASE_METHOD(SchemeTest, "GuardSurvivesContinuations") {
+    SetEvalMode(EvalMode::Machine);
+    ExpectNoError("(define k #f)");
+    ExpectNoError("(define n 0)");
+    ExpectEq("(guard (e (#t (list 'caught e))) (call/cc (lambda (c) (set! k c))) (set! n (+ n 1))"
+             "  (if (= n 1) 'first (raise n)))",
+             "first");
+    ExpectEq("(k #f)", "(caught 2)");
+}
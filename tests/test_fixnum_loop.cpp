@@ -0,0 +1,100 @@
+#include "scheme_test.h"
+
+#include "eval/eval.h"
+#include "eval/fixnum_loop.h"
+#include "eval/procedure.h"
+#include "reader/parser.h"
+#include "runtime/env.h"
+#include "stdlib/builtins.h"
+
+#include <cstdint>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+std::shared_ptr<Object> ReadExpr(const std::string& str) {
+    std::istringstream in{str};
+    Tokenizer tokenizer{&in};
+    return Read(&tokenizer);
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "FixnumLoopsMatchGenericCode") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (sum n acc) (if (= n 0) acc (sum (- n 1) (+ acc n))))");
+    ExpectEq("(sum 100000 0)", "5000050000");
+    ExpectNoError("(define (fact n acc) (if (< n 2) acc (fact (- n 1) (* acc n))))");
+    ExpectEq("(fact 20 1)", "2432902008176640000");
+    ExpectNoError("(define (between? lo x hi) (<= lo x hi))");
+    ExpectEq("(between? 1 2 3)", "#t");
+    ExpectEq("(between? 1 5 3)", "#f");
+    ExpectNoError("(define (neg x) (- x))");
+    ExpectEq("(neg 5)", "-5");
+
+    ExpectRuntimeError("(sum 'a 0)");
+    ExpectRuntimeError("(sum 1 '())");
+    ExpectRuntimeError("(sum 1)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "FixnumLoopsFollowRebinding") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (count n acc) (if (= n 0) acc (count (- n 1) (+ acc 2))))");
+    ExpectEq("(count 10 0)", "20");
+    ExpectNoError("(define + *)");
+    ExpectEq("(count 10 1)", "1024");
+    ExpectNoError("(define count (lambda (n acc) acc))");
+    ExpectEq("(count 10 1)", "1");
+}
+
+TEST_CASE("FixnumLoopTakesOverLoopPromotedMidway") {
+    auto env = std::make_shared<Environment>();
+    AddBuiltins(env);
+    Evaluator evaluator;
+    evaluator.SetTierPolicy(TierPolicy{2, 10});
+    evaluator.Eval(ReadExpr("(define (sum n acc) (if (= n 0) acc (sum (- n 1) (+ acc n))))"), env);
+    auto sum = As<LambdaProcedure>(env->Lookup("sum"));
+
+    auto result = evaluator.Eval(ReadExpr("(sum 100000 0)"), env);
+    REQUIRE(As<Number>(result)->GetValue() == 5000050000);
+    REQUIRE(sum->GetTier() == Tier::Hot);
+    REQUIRE(sum->GetCallCount() == 1);
+    REQUIRE(sum->GetLoopIterations() == 100000);
+
+    env->Clear();
+}
+
+TEST_CASE("FixnumLoopDeoptimizesOnOverflow") {
+    auto env = std::make_shared<Environment>();
+    AddBuiltins(env);
+    Evaluator evaluator;
+    evaluator.Eval(ReadExpr("(define (up n i) (if (= i 0) n (up (+ n 1) (- i 1))))"), env);
+    auto up = As<LambdaProcedure>(env->Lookup("up"));
+    auto* loop = up->GetCode()->GetFixnumLoop(evaluator, env);
+    REQUIRE(loop);
+
+    constexpr auto kMax = std::numeric_limits<int64_t>::max();
+    Procedure::ArgsVec deopt_args;
+    uint64_t iterations = 0;
+    Procedure::ArgsVec args{std::make_shared<Number>(kMax - 3), std::make_shared<Number>(3)};
+    auto result = loop->Run(args, env, evaluator, &deopt_args, &iterations);
+    REQUIRE(result);
+    REQUIRE(As<Number>(*result)->GetValue() == kMax);
+    REQUIRE(iterations == 3);
+
+    args[1] = std::make_shared<Number>(5);
+    result = loop->Run(args, env, evaluator, &deopt_args, &iterations);
+    REQUIRE_FALSE(result);
+    REQUIRE(deopt_args.size() == 2);
+    REQUIRE(As<Number>(deopt_args[0])->GetValue() == kMax);
+    REQUIRE(As<Number>(deopt_args[1])->GetValue() == 2);
+
+    evaluator.Eval(ReadExpr("(define (f x) (car x))"), env);
+    auto f = As<LambdaProcedure>(env->Lookup("f"));
+    REQUIRE_FALSE(f->GetCode()->GetFixnumLoop(evaluator, env));
+
+    env->Clear();
+}
@@ -0,0 +1,165 @@
+#include "scheme_test.h"
+
+#include "eval/eval.h"
+#include "reader/parser.h"
+#include "runtime/env.h"
+#include "stdlib/builtins.h"
+
+#include <sstream>
+
+namespace {
+
+constexpr TierPolicy kAlwaysWarm{0, 1000000};
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+std::shared_ptr<Object> ReadExpr(const std::string& str) {
+    std::istringstream in{str};
+    Tokenizer tokenizer{&in};
+    return Read(&tokenizer);
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "CallSiteSeesRedefinition") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (g x) (+ x 1))");
+    ExpectNoError("(define (f x) (g x))");
+    ExpectEq("(f 1)", "2");
+    ExpectEq("(f 1)", "2");
+
+    ExpectNoError("(define (g x) (* x 10))");
+    ExpectEq("(f 2)", "20");
+
+    ExpectNoError("(set! g -)");
+    ExpectEq("(f 2)", "-2");
+
+    ExpectNoError("(set! g 5)");
+    ExpectRuntimeError("(f 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "CallSiteRebindingDuringArguments") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (g x) x)");
+    ExpectNoError("(define (f) (g (begin-set)))");
+    ExpectNoError("(define (begin-set) (set! g (lambda (x) 'new)) 'old)");
+    ExpectEq("(f)", "old");
+    ExpectEq("(f)", "new");
+}
+
+TEST_CASE_METHOD(SchemeTest, "CallSiteLocalBindingsAreNotCached") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (call h x) (h x))");
+    ExpectEq("(call - 1)", "-1");
+    ExpectEq("(call abs -3)", "3");
+
+    ExpectNoError("(define (wrap h) (lambda (x) (h x)))");
+    ExpectNoError("(define neg (wrap -))");
+    ExpectNoError("(define inc (wrap (lambda (x) (+ x 1))))");
+    ExpectEq("(neg 4)", "-4");
+    ExpectEq("(inc 4)", "5");
+
+    ExpectNoError("(define (g x) 'global)");
+    ExpectNoError("(define (f) (define a (g -2)) (define g abs) (list a (g -2)))");
+    ExpectEq("(f)", "(global 2)");
+    ExpectEq("(f)", "(global 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "CallSiteSeesRebindingOutsideAnalyzedScopes") {
+    SetTierPolicy(TierPolicy{2, 5});
+    ExpectNoError(
+        "(define (outer)"
+        "  (define (helper) 1)"
+        "  (define (loop n acc) (if (= n 0) acc (loop (- n 1) (+ acc (helper)))))"
+        "  (define a (loop 10 0))"
+        "  (set! helper (lambda () 2))"
+        "  (define b (loop 10 0))"
+        "  (define helper (lambda () 3))"
+        "  (define c (loop 10 0))"
+        "  (set! loop #f)"
+        "  (set! helper #f)"
+        "  (list a b c))");
+    ExpectEq("(outer)", "(10 20 30)");
+}
+
+TEST_CASE("LocalAssignmentsKeepCachesValid") {
+    auto env = std::make_shared<Environment>();
+    AddBuiltins(env);
+    Evaluator evaluator;
+    evaluator.SetTierPolicy(kAlwaysHot);
+    evaluator.Eval(ReadExpr("(define (step x) (+ x 1))"), env);
+    evaluator.Eval(ReadExpr("(define (run n t) (if (= n 0) t (begin (set! t n) "
+                            "(define u (step t)) (run (- n 1) u))))"),
+                   env);
+    evaluator.Eval(ReadExpr("(run 10 0)"), env);
+
+    auto version = evaluator.GetBindingVersion();
+    auto result = evaluator.Eval(ReadExpr("(run 100 0)"), env);
+    REQUIRE(As<Number>(result)->GetValue() == 2);
+    REQUIRE(evaluator.GetBindingVersion() == version);
+
+    evaluator.Eval(ReadExpr("(define (step x) (* x 10))"), env);
+    REQUIRE(evaluator.GetBindingVersion() != version);
+    result = evaluator.Eval(ReadExpr("(run 3 0)"), env);
+    REQUIRE(As<Number>(result)->GetValue() == 10);
+
+    env->Clear();
+}
+
+TEST_CASE_METHOD(SchemeTest, "InlinedPrimitivesMatchBuiltins") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (arith a b) (list (+ a b) (- a b) (* a b) (- a) (+) (*)))");
+    ExpectEq("(arith 7 3)", "(10 4 21 -7 0 1)");
+    ExpectNoError("(define (cmp a b) (list (= a b) (< a b) (> a b) (<= a b) (>= a b) (<)))");
+    ExpectEq("(cmp 1 2)", "(#f #t #f #t #f #t)");
+    ExpectNoError("(define (pairs p) (list (car p) (cdr p) (cons p p) (pair? p) (null? p)))");
+    ExpectEq("(pairs '(1 . 2))", "(1 2 ((1 . 2) 1 . 2) #t #f)");
+
+    ExpectNoError("(define (bad-sub) (-))");
+    ExpectRuntimeError("(bad-sub)");
+    ExpectNoError("(define (bad-add x) (+ 1 x))");
+    ExpectRuntimeError("(bad-add 'a)");
+    ExpectNoError("(define (bad-car x) (car x))");
+    ExpectRuntimeError("(bad-car '())");
+    ExpectNoError("(define (short-cmp) (< 2 1 'a))");
+    ExpectEq("(short-cmp)", "#f");
+}
+
+TEST_CASE_METHOD(SchemeTest, "InlinedPrimitivesFollowRebinding") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (f x) (+ x 1))");
+    ExpectNoError("(define (head l) (car l))");
+    ExpectEq("(f 1)", "2");
+    ExpectEq("(head '(1 2))", "1");
+
+    ExpectNoError("(define + -)");
+    ExpectEq("(f 1)", "0");
+    ExpectNoError("(set! car cdr)");
+    ExpectEq("(head '(1 2))", "(2)");
+
+    ExpectNoError("(define plus *)");
+    ExpectNoError("(define (g x) (plus x 3))");
+    ExpectEq("(g 2)", "6");
+}
+
+TEST_CASE_METHOD(SchemeTest, "FixedArityEntryPointsMatchVariadicCalls") {
+    SetTierPolicy(kAlwaysWarm);
+    ExpectNoError(
+        "(define (two a b) (list (+ a b) (- a b) (max a b) (min a b) (< a b) (cons a b)))");
+    ExpectEq("(two 7 3)", "(10 4 7 3 #f (7 . 3))");
+    ExpectNoError("(define (one a) (list (- a) (abs a) (number? a) (not a) (null? a)))");
+    ExpectEq("(one -4)", "(4 4 #t #f #f)");
+    ExpectNoError("(define (many a) (list (+ a a a) (- a a a) (max a 1 a) (<= 1 a a)))");
+    ExpectEq("(many 2)", "(6 -2 2 #t)");
+
+    ExpectNoError("(define (bad-abs a) (abs a a))");
+    ExpectRuntimeError("(bad-abs 1)");
+    ExpectNoError("(define (bad-car) (car))");
+    ExpectRuntimeError("(bad-car)");
+    ExpectNoError("(define (bad-cons a) (cons a))");
+    ExpectRuntimeError("(bad-cons 1)");
+    ExpectNoError("(define (bad-max a) (max a 'b))");
+    ExpectRuntimeError("(bad-max 1)");
+
+    ExpectNoError("(define max min)");
+    ExpectEq("(two 7 3)", "(10 4 3 3 #f (7 . 3))");
+}
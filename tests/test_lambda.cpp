@@ -62,3 +62,15 @@ TEST_CASE_METHOD(SchemeTest, "DefineLambdaSugar") {
     ExpectEq("(f)", "32");
     ExpectEq("(f)", "32");
 }
+
+TEST_CASE_METHOD(SchemeTest, "LambdaManyArguments") {
+    ExpectNoError("(define (pick a b c d e f g h) (list a f g h))");
+    ExpectEq("(pick 1 2 3 4 5 6 7 8)", "(1 6 7 8)");
+    ExpectEq("(+ 1 2 3 4 5 6 7 8 9 10)", "55");
+    ExpectRuntimeError("(pick 1 2 3 4 5 6 7)");
+
+    ExpectNoError("(define (spin n a b c d e f) (if (= n 0) (list a f) (spin (- n 1) f a b c d e)))");
+    for (auto i = 0; i < 20; ++i) {
+        ExpectEq("(spin 7 1 2 3 4 5 6)", "(6 5)");
+    }
+}
@@ -0,0 +1,93 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckLoops(SchemeTest* test) {
+    test->ExpectEq("(let loop ((i 0) (acc 0)) (if (= i 200000) acc (loop (+ i 1) (+ acc i))))",
+                   "19999900000");
+    test->ExpectEq("(do ((i 0 (+ i 1)) (acc 0 (+ acc i))) ((= i 5) acc))", "10");
+    test->ExpectEq("(do ((i 0 (+ i 1))) ((= i 3)))", "()");
+    test->ExpectEq("(let ((n 0)) (do ((i 0 (+ i 1)) (k 7)) ((= i 4) (list n k)) (set! n (+ n i))))",
+                   "(6 7)");
+    test->ExpectEq(
+        "(let outer ((i 0) (acc '()))"
+        "  (if (= i 3)"
+        "      acc"
+        "      (let inner ((j 0) (acc acc))"
+        "        (if (= j 2) (outer (+ i 1) acc) (inner (+ j 1) (cons (list i j) acc))))))",
+        "((2 1) (2 0) (1 1) (1 0) (0 1) (0 0))");
+    test->ExpectEq(
+        "(let loop ((l '(1 2 3)) (sum 0))"
+        "  (cond ((null? l) sum)"
+        "        ((< (car l) 2) (loop (cdr l) sum))"
+        "        (else (let ((x (car l))) (loop (cdr l) (+ sum x))))))",
+        "5");
+    test->ExpectEq("(let loop ((list 3) (car 0)) (if (= list 0) car (loop (- list 1) (+ car 1))))",
+                   "3");
+
+    // Names used other than for jumps make the loop a procedure.
+    test->ExpectEq("(let count ((l '(1 2 3))) (if (null? l) 0 (+ 1 (count (cdr l)))))", "3");
+    test->ExpectEq("(let loop ((i 0)) (if (< i 3) (loop (+ i 1)) (pair? loop)))", "#f");
+
+    test->ExpectSyntaxError("(let loop)");
+    test->ExpectSyntaxError("(let loop ((i 0)))");
+    test->ExpectSyntaxError("(do)");
+    test->ExpectSyntaxError("(do ((i 0)) ())");
+    test->ExpectSyntaxError("(do ((i 0 1 2)) (#t))");
+    test->ExpectSyntaxError("(do ((i 0) (i 1)) (#t))");
+    test->ExpectRuntimeError("(let loop ((i 0)) (if (= i 0) (loop 1 2) i))");
+}
+
+// Closures made in an iteration keep the values of that iteration.
+void CheckIterationClosures(SchemeTest* test) {
+    test->ExpectEq(
+        "(let ((fs (do ((i 0 (+ i 1)) (fs '() (cons (lambda () i) fs))) ((= i 3) fs))))"
+        "  (list ((car fs)) ((car (cdr fs))) ((car (cdr (cdr fs))))))",
+        "(2 1 0)");
+}
+
+void CheckLoopsInProcedures(SchemeTest* test) {
+    test->ExpectNoError(
+        "(define (sum-to n)"
+        "  (let loop ((i 0) (acc 0)) (if (> i n) acc (loop (+ i 1) (+ acc i)))))");
+    test->ExpectNoError(
+        "(define (count-pairs l)"
+        "  (do ((l l (cdr l)) (n 0 (if (pair? (car l)) (+ n 1) n))) ((null? l) n)))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(sum-to 1000)", "500500");
+        test->ExpectEq("(count-pairs '(1 (2) 3 (4 5)))", "2");
+    }
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "NamedLetAndDo") {
+    CheckLoops(this);
+    CheckIterationClosures(this);
+    CheckLoopsInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "NamedLetAndDoInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckLoops(this);
+    CheckIterationClosures(this);
+    CheckLoopsInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "NamedLetAndDoOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckLoops(this);
+    CheckLoopsInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "LoopsRunInConstantStack") {
+    SetStackLimit(64 * 1024);
+    ExpectEq("(do ((i 0 (+ i 1))) ((= i 300000) i))", "300000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LoopsAreChargedToBudget") {
+    ExpectBudgetError("(let loop ((i 0)) (loop (+ i 1)))", Budget{.fuel = 1000});
+    ExpectBudgetError("(do () (#f))", Budget{.fuel = 1000});
+}
@@ -0,0 +1,193 @@
+#include "scheme_test.h"
+
+#include "eval/macros.h"
+#include "reader/parser.h"
+
+#include <sstream>
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+std::shared_ptr<Object> ReadExpr(const std::string& str) {
+    std::istringstream in{str};
+    Tokenizer tokenizer{&in};
+    return Read(&tokenizer);
+}
+
+void DefineMacros(SchemeTest* test) {
+    test->ExpectNoError(
+        "(define-syntax swap!"
+        "  (syntax-rules () ((_ a b) (let ((tmp a)) (set! a b) (set! b tmp)))))");
+    test->ExpectNoError(
+        "(define-syntax my-or"
+        "  (syntax-rules ()"
+        "    ((_) #f)"
+        "    ((_ e) e)"
+        "    ((_ e rest ...) (let ((t e)) (if t t (my-or rest ...))))))");
+    test->ExpectNoError(
+        "(define-syntax my-let"
+        "  (syntax-rules ()"
+        "    ((_ ((name value) ...) body ...) ((lambda (name ...) body ...) value ...))))");
+    test->ExpectNoError(
+        "(define-syntax my-when"
+        "  (syntax-rules () ((_ test body ...) (if test (begin body ...) #f))))");
+    test->ExpectNoError(
+        "(define-syntax arrow (syntax-rules (=>) ((_ a => b) (list a b)) ((_ a b) 'no-arrow)))");
+    test->ExpectNoError("(define-syntax rest-of (syntax-rules () ((_ a . rest) 'rest)))");
+    test->ExpectNoError(
+        "(define-syntax groups"
+        "  (syntax-rules () ((_ (key value ...) ...) '((key value ...) ...))))");
+    test->ExpectNoError(
+        "(define-syntax define-getter (syntax-rules () ((_ name value) (define (name) value))))");
+    test->ExpectNoError(
+        "(define-syntax define-value (syntax-rules () ((_ name value) (define name value))))");
+    test->ExpectNoError("(define-syntax quoted-tmp (syntax-rules () ((_) (let ((x 1)) 'x))))");
+}
+
+void CheckMacros(SchemeTest* test) {
+    DefineMacros(test);
+
+    test->ExpectNoError("(define tmp 1)");
+    test->ExpectNoError("(define other 2)");
+    test->ExpectNoError("(swap! tmp other)");
+    test->ExpectEq("(list tmp other)", "(2 1)");
+    test->ExpectEq("(let ((t 5)) (my-or #f t))", "5");
+    test->ExpectEq("(my-or)", "#f");
+    test->ExpectEq("(my-or #f #f 3 4)", "3");
+    test->ExpectEq("(my-let ((a 1) (b 2)) (+ a b))", "3");
+    test->ExpectEq("(my-let () 7)", "7");
+    test->ExpectEq("(my-when (< 1 2) 'a 'b)", "b");
+    test->ExpectEq("(my-when (> 1 2) 'a)", "#f");
+    test->ExpectEq("(arrow 1 => 2)", "(1 2)");
+    test->ExpectEq("(arrow 1 2)", "no-arrow");
+    test->ExpectEq("(rest-of 1 2 3)", "(2 3)");
+    test->ExpectEq("(groups (a 1 2) (b))", "((a 1 2) (b))");
+    test->ExpectEq("(quoted-tmp)", "x");
+    test->ExpectNoError("(define-getter five 5)");
+    test->ExpectEq("(five)", "5");
+
+    // Macros expand into uses of other macros and may be redefined.
+    test->ExpectNoError("(define-syntax either (syntax-rules () ((_ a b) (my-or a b))))");
+    test->ExpectEq("(either #f 'b)", "b");
+    test->ExpectNoError("(define-syntax either (syntax-rules () ((_ a b) (list a b))))");
+    test->ExpectEq("(either #f 'b)", "(#f b)");
+
+    test->ExpectSyntaxError("(swap! tmp)");
+    test->ExpectSyntaxError("(arrow 1 2 3)");
+    test->ExpectSyntaxError("(define-syntax)");
+    test->ExpectSyntaxError("(define-syntax m (lambda (x) x))");
+    test->ExpectSyntaxError("(define-syntax m (syntax-rules () ((_ a a) a)))");
+    test->ExpectSyntaxError("(define-syntax m (syntax-rules () ((_ ... a) a)))");
+    test->ExpectSyntaxError("(define-syntax m (syntax-rules () ((_ a) (a ... ...))))");
+    test->ExpectSyntaxError("(define-syntax if (syntax-rules () ((_) 1)))");
+    test->ExpectSyntaxError("(let () (define-syntax m (syntax-rules () ((_) 1))) 1)");
+    test->ExpectNoError("(define-syntax flat (syntax-rules () ((_ a ...) a)))");
+    test->ExpectSyntaxError("(flat 1 2)");
+}
+
+void CheckMacrosInProcedures(SchemeTest* test) {
+    DefineMacros(test);
+    test->ExpectNoError("(define k 'global)");
+    test->ExpectNoError("(define x 10)");
+    test->ExpectNoError("(define-syntax get-x (syntax-rules () ((_) x)))");
+    test->ExpectNoError(
+        "(define-syntax upto"
+        "  (syntax-rules ()"
+        "    ((_ (var limit) body ...) (do ((var 0 (+ var 1))) ((= var limit)) body ...))))");
+
+    // Names defined by expansions are local to the body, found by scanning the expansions.
+    // Free names of a template refer to globals even where the use binds them.
+    test->ExpectNoError("(define (local-k) (define-value k 'local) k)");
+    test->ExpectNoError("(define (local-x) (define x 5) (get-x))");
+    test->ExpectNoError("(define (rotate a b c) (swap! a b) (swap! b c) (list a b c))");
+    test->ExpectNoError(
+        "(define (count-to n) (let loop ((i 0)) (my-or (and (= i n) i) (loop (+ i 1)))))");
+    test->ExpectNoError(
+        "(define (sum-to n) (let ((sum 0)) (upto (i (+ n 1)) (set! sum (+ sum i))) sum))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(local-k)", "local");
+        test->ExpectEq("(local-x)", "10");
+        test->ExpectEq("(rotate 1 2 3)", "(2 3 1)");
+        test->ExpectEq("(count-to 1000)", "1000");
+        test->ExpectEq("(sum-to 100)", "5050");
+    }
+    test->ExpectEq("k", "global");
+    test->ExpectEq("x", "10");
+
+    // Free names of a template are not captured by local bindings at the use, whatever the tier.
+    test->ExpectNoError("(define-syntax first (syntax-rules () ((_ l) (car l))))");
+    test->ExpectNoError(
+        "(define-syntax bump! (syntax-rules () ((_) (set! counter (+ counter 1)))))");
+    test->ExpectNoError(
+        "(define-syntax sign (syntax-rules () ((_ n) (cond ((< n 0) 'neg) (else 'pos)))))");
+    test->ExpectNoError("(define-syntax tag (syntax-rules () ((_ l) `(car ,(car l)))))");
+    test->ExpectNoError("(define counter 0)");
+    test->ExpectNoError("(define (f car) (first (list 1 2)))");
+    test->ExpectNoError("(define (g counter) (bump!) counter)");
+    test->ExpectNoError("(define (s <) (sign -1))");
+    test->ExpectNoError("(define (h car) (tag (list 1 2)))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(f cdr)", "1");
+        test->ExpectEq("(g 5)", "5");
+        test->ExpectEq("(s >)", "neg");
+        test->ExpectEq("(h cdr)", "(car 1)");
+    }
+    test->ExpectEq("counter", "20");
+
+    // Code compiled before a macro is redefined uses the new definition, as the tree walker does.
+    test->ExpectNoError("(define-syntax ten (syntax-rules () ((_) 10)))");
+    test->ExpectNoError("(define (get-ten) (ten))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(get-ten)", "10");
+    }
+    test->ExpectNoError("(define-syntax ten (syntax-rules () ((_) 11)))");
+    test->ExpectEq("(get-ten)", "11");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRules") {
+    CheckMacros(this);
+    CheckMacrosInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRulesInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckMacros(this);
+    CheckMacrosInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRulesOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckMacros(this);
+    CheckMacrosInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "MacrosExpandingForeverFail") {
+    ExpectNoError("(define-syntax forever (syntax-rules () ((_ a) (forever a))))");
+    SetStackLimit(1 << 20);
+    ExpectRuntimeError("(forever 1)");
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (f) (forever 1))");
+    ExpectRuntimeError("(f)");
+    SetEvalMode(EvalMode::Machine);
+    ExpectBudgetError("(forever 1)", Budget{.fuel = 1000});
+}
+
+TEST_CASE("MacroExpansionIsCached") {
+    Macro macro(ReadExpr("(syntax-rules () ((_ a b) (let ((t a)) (+ t b))))"));
+    auto forms = CreateStandardForms();
+    auto use = ReadExpr("(m 1 2)");
+    auto args = As<Cell>(use)->GetSecond();
+    auto expansion = macro.Expand(args, forms);
+    REQUIRE(macro.Expand(args, forms) == expansion);
+    REQUIRE(macro.Expand(ReadExpr("(1 2)"), forms) != expansion);
+
+    // Binders introduced by the template get fresh names in every expansion.
+    auto let = As<Cell>(expansion)->GetSecond();
+    auto binding = As<Cell>(As<Cell>(As<Cell>(let)->GetFirst())->GetFirst());
+    auto name = As<Symbol>(binding->GetFirst())->GetName();
+    REQUIRE(name != "t");
+    REQUIRE(name.starts_with("t."));
+}
@@ -0,0 +1,50 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kNeverPromote{~uint64_t{0}, ~uint64_t{0}};
+
+void DefineListHelpers(SchemeTest* test) {
+    test->ExpectNoError("(define (iota n acc) (if (= n 0) acc (iota (- n 1) (cons n acc))))");
+    test->ExpectNoError("(define (copy l) (if (null? l) '() (cons (car l) (copy (cdr l)))))");
+    test->ExpectNoError("(define (sum l) (if (null? l) 0 (+ (car l) (sum (cdr l)))))");
+    test->ExpectNoError("(define (length-of l) (if (null? l) 0 (+ 1 (length-of (cdr l)))))");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "DeepRecursionContinuesOnNewSegments") {
+    DefineListHelpers(this);
+    ExpectNoError("(define big (iota 40000 '()))");
+    ExpectEq("(list-ref (copy big) 39999)", "40000");
+    ExpectEq("(sum big)", "800020000");
+    ExpectEq("(sum (copy (copy big)))", "800020000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "MillionDeepRecursionFitsDefaultLimit") {
+    DefineListHelpers(this);
+    ExpectNoError("(define big (iota 1000000 '()))");
+    ExpectEq("(list-ref (copy big) 999999)", "1000000");
+    ExpectNoError("(set! big '())");
+    ExpectNoError("(define (deep n) (if (= n 0) 0 (+ 1 (deep (- n 1)))))");
+    ExpectEq("(deep 1000000)", "1000000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "DeepRecursionInTreeWalker") {
+    SetTierPolicy(kNeverPromote);
+    DefineListHelpers(this);
+    ExpectEq("(sum (iota 20000 '()))", "200010000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "DeepRecursionHitsStackLimit") {
+    SetStackLimit(0);
+    DefineListHelpers(this);
+    ExpectNoError("(define big (iota 40000 '()))");
+    ExpectRuntimeError("(copy big)");
+    ExpectEq("(car (copy '(1 2 3)))", "1");
+
+    SetStackLimit(4 * NativeStack::kSegmentSize);
+    ExpectNoError("(define (down n) (+ 1 (down n)))");
+    ExpectRuntimeError("(down 1)");
+    ExpectEq("(length-of (copy '(1 2 3)))", "3");
+}
@@ -0,0 +1,162 @@
+#include "scheme_test.h"
+
+#include "eval/analyzer.h"
+#include "eval/optimizer.h"
+#include "eval/procedure.h"
+#include "io/printer.h"
+#include "reader/parser.h"
+#include "runtime/env.h"
+#include "runtime/list_utils.h"
+#include "stdlib/builtins.h"
+
+#include <sstream>
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+std::shared_ptr<Object> ReadExpr(const std::string& str) {
+    std::istringstream in{str};
+    Tokenizer tokenizer{&in};
+    return Read(&tokenizer);
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "FoldedCallsFollowRebinding") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (f) (+ 1 (* 2 3)))");
+    ExpectEq("(f)", "7");
+    ExpectNoError("(define + -)");
+    ExpectEq("(f)", "-5");
+
+    ExpectNoError("(define (rebind) (set! * max))");
+    ExpectNoError("(define (g) (rebind) (* 2 3))");
+    ExpectEq("(g)", "3");
+
+    ExpectNoError("(define (h) (- 1 'a))");
+    ExpectRuntimeError("(h)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "UnreachableBranchesArePruned") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (f x) (if #t x (car '())))");
+    ExpectEq("(f 1)", "1");
+    ExpectNoError("(define (g x) (if (< 2 1) (car x) x))");
+    ExpectEq("(g 2)", "2");
+    ExpectEq("(g '(7 8))", "(7 8)");
+    ExpectNoError("(define (h x) (list (and #t x #f (car '())) (or #f x 4 (car '())) (and x #t)))");
+    ExpectEq("(h 3)", "(#f 3 #t)");
+    ExpectEq("(h #f)", "(#f 4 #f)");
+
+    ExpectNoError("(define < >)");
+    ExpectEq("(g '(7 8))", "7");
+    ExpectNoError("(define < 5)");
+    ExpectRuntimeError("(g 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "DeadDefinesAreDropped") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (f x) (define unused 5) (define (helper) 1) (define used 2) (+ x used))");
+    ExpectEq("(f 1)", "3");
+    ExpectNoError("(define (g) (define last 5))");
+    ExpectEq("(g)", "()");
+}
+
+TEST_CASE_METHOD(SchemeTest, "InlinedCallsFollowRedefinition") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (inc x) (+ x 1))");
+    ExpectNoError("(define (twice x) (inc (inc x)))");
+    ExpectNoError("(define (f x) (list (twice x) ((lambda (y z) (* y z)) x 'a)))");
+    ExpectRuntimeError("(f 1)");
+    ExpectNoError("(define (f x) (list (twice x) ((lambda (y) (* y y)) x) ((lambda () '(x)))))");
+    ExpectEq("(f 3)", "(5 9 (x))");
+
+    ExpectNoError("(define (inc x) (- x 1))");
+    ExpectEq("(f 3)", "(1 9 (x))");
+    ExpectNoError("(set! inc 5)");
+    ExpectRuntimeError("(f 3)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "InliningKeepsAssignments") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (bump x) (set! x (+ x 1)) x)");
+    ExpectNoError("(define (f a) (bump a))");
+    ExpectEq("(f 1)", "2");
+    ExpectEq("(f 1)", "2");
+
+    ExpectNoError("(define (g a) ((lambda (x) (set! a 10) x) a))");
+    ExpectEq("(g 1)", "1");
+    ExpectEq("(g 1)", "1");
+
+    ExpectNoError("(define y 1)");
+    ExpectNoError("(define (get-y) y)");
+    ExpectNoError("(define (h) (set! y 2) (get-y))");
+    ExpectEq("(h)", "2");
+}
+
+TEST_CASE_METHOD(SchemeTest, "InliningStopsAtRecursion") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (even n) (if (= n 0) #t (odd (- n 1))))");
+    ExpectNoError("(define (odd n) (if (= n 0) #f (even (- n 1))))");
+    ExpectEq("(even 100)", "#t");
+    ExpectEq("(odd 7)", "#t");
+
+    ExpectNoError("(define (count n) (if (= n 0) 0 (count (- n 1))))");
+    ExpectEq("(count 100000)", "0");
+}
+
+TEST_CASE("OptimizerFold") {
+    auto env = std::make_shared<Environment>();
+    AddBuiltins(env);
+    auto forms = CreateStandardForms();
+    Optimizer optimizer(forms, nullptr, env);
+
+    auto folded = optimizer.Fold(ReadExpr("(if (< 1 2) (+ 1 2 3) x)"));
+    REQUIRE(folded);
+    REQUIRE(As<Number>(folded->value)->GetValue() == 6);
+    REQUIRE(folded->assumptions.size() == 2);
+
+    folded = optimizer.Fold(ReadExpr("(and #f x)"));
+    REQUIRE(folded);
+    REQUIRE(folded->value == False());
+    REQUIRE(folded->assumptions.empty());
+
+    REQUIRE_FALSE(optimizer.Fold(ReadExpr("(+ 1 x)")));
+    REQUIRE_FALSE(optimizer.Fold(ReadExpr("(cons 1 2)")));
+    REQUIRE_FALSE(optimizer.Fold(ReadExpr("(car '())")));
+
+    auto body = listutils::ToVector(ReadExpr("((define a 1) (define (b) a) (define c '(1)) c)"));
+    REQUIRE(Optimizer::DropDeadDefines(body, forms).size() == 3);
+
+    env->Clear();
+}
+
+TEST_CASE("OptimizerInline") {
+    auto env = std::make_shared<Environment>();
+    AddBuiltins(env);
+    env->Define("inc", std::make_shared<LambdaProcedure>(
+                           LambdaProcedure::Params{"x"},
+                           listutils::ToVector(ReadExpr("((+ x 1))")), env));
+    auto forms = CreateStandardForms();
+    Optimizer optimizer(forms, nullptr, env);
+
+    auto inlined = optimizer.Inline(ReadExpr("(inc 2)"));
+    REQUIRE(inlined);
+    REQUIRE(inlined->body.size() == 1);
+    REQUIRE(Print(inlined->body[0]) == "(+ 2 1)");
+    REQUIRE(inlined->assumptions.size() == 1);
+
+    inlined = optimizer.Inline(ReadExpr("((lambda (x y) (cons y 'x) x) 1 '(2))"));
+    REQUIRE(inlined);
+    REQUIRE(Print(inlined->body[0]) == "(cons (quote (2)) (quote x))");
+    REQUIRE(inlined->assumptions.empty());
+
+    REQUIRE_FALSE(optimizer.Inline(ReadExpr("(inc (+ 1 2))")));
+    REQUIRE_FALSE(optimizer.Inline(ReadExpr("(inc 1 2)")));
+    REQUIRE_FALSE(optimizer.Inline(ReadExpr("((lambda (x) (set! x 1)) 2)")));
+    REQUIRE_FALSE(optimizer.Inline(ReadExpr("((lambda (x) (lambda () x)) 2)")));
+    REQUIRE_FALSE(optimizer.Inline(ReadExpr("((lambda (x) `(x ,x)) 2)")));
+
+    env->Clear();
+}
@@ -64,6 +64,27 @@ TEST_CASE("Read symbol") {
     }
 }
 
+TEST_CASE("Abbreviations") {
+    auto check = [](const std::string& str, const std::string& name) {
+        auto cell = CheckCell(ReadFull(str));
+        CheckSymbol(cell->GetFirst(), name);
+        cell = CheckCell(cell->GetSecond());
+        CheckSymbol(cell->GetFirst(), "x");
+        REQUIRE_FALSE(cell->GetSecond());
+    };
+    check("'x", "quote");
+    check("`x", "quasiquote");
+    check(",x", "unquote");
+    check(",@x", "unquote-splicing");
+
+    auto cell = CheckCell(ReadFull("(a . ,b)"));
+    CheckSymbol(cell->GetFirst(), "a");
+    cell = CheckCell(cell->GetSecond());
+    CheckSymbol(cell->GetFirst(), "unquote");
+    CHECK_THROWS_AS(ReadFull("`"), SyntaxError);
+    CHECK_THROWS_AS(ReadFull("(,)"), SyntaxError);
+}
+
 TEST_CASE("Lists") {
     SECTION("Empty list") {
         REQUIRE_FALSE(ReadFull("()"));
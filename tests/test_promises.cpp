@@ -0,0 +1,138 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kAlwaysCold{UINT64_MAX, UINT64_MAX};
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckPromises(SchemeTest* test) {
+    test->ExpectNoError("(define count 0)");
+    test->ExpectNoError("(define p (delay (begin (set! count (+ count 1)) (* count 10))))");
+    test->ExpectEq("count", "0");
+    test->ExpectEq("(list (force p) (force p) count)", "(10 10 1)");
+    test->ExpectEq("(promise? p)", "#t");
+    test->ExpectEq("(promise? 5)", "#f");
+    test->ExpectEq("(force 5)", "5");
+    test->ExpectEq("(force (make-promise 7))", "7");
+    test->ExpectEq("(force (make-promise p))", "10");
+    test->ExpectEq("(force (delay-force (delay (+ 1 2))))", "3");
+    test->ExpectEq("(force (let ((x 4)) (delay (* x x))))", "16");
+
+    // The value of the promise is the one its thunk computed first, as in R7RS.
+    test->ExpectNoError("(define n 0)");
+    test->ExpectNoError(
+        "(define q (delay (begin (set! n (+ n 1)) (if (> n x) n (force q)))))");
+    test->ExpectNoError("(define x 5)");
+    test->ExpectEq("(force q)", "6");
+    test->ExpectNoError("(set! x 10)");
+    test->ExpectEq("(force q)", "6");
+
+    test->ExpectRuntimeError("(force (delay (car 1)))");
+    test->ExpectRuntimeError("(force (delay-force 5))");
+    test->ExpectRuntimeError("(force)");
+    test->ExpectRuntimeError("(make-promise 1 2)");
+    test->ExpectSyntaxError("(delay)");
+    test->ExpectSyntaxError("(delay 1 2)");
+    test->ExpectSyntaxError("(delay-force)");
+}
+
+void CheckIterativeForcing(SchemeTest* test) {
+    test->ExpectNoError(
+        "(define (loop n) (delay-force (if (= n 0) (delay 'done) (loop (- n 1)))))");
+    test->ExpectEq("(force (loop 20000))", "done");
+    test->ExpectNoError("(define r (loop 3))");
+    test->ExpectEq("(list (force r) (force r))", "(done done)");
+}
+
+void CheckStreams(SchemeTest* test) {
+    test->ExpectNoError("(define (ints n) (stream-cons n (ints (+ n 1))))");
+    test->ExpectEq("(stream->list (stream-take 5 (ints 0)))", "(0 1 2 3 4)");
+    test->ExpectEq("(stream->list 3 (ints 10))", "(10 11 12)");
+    test->ExpectEq("(stream->list (stream-take 0 (ints 0)))", "()");
+    test->ExpectEq("(stream->list (stream-take 5 (stream-cons 1 stream-null)))", "(1)");
+    test->ExpectEq("(stream-car (stream-cdr (stream-cdr (ints 4))))", "6");
+    test->ExpectEq("(list (stream-null? stream-null) (stream-pair? stream-null))", "(#t #f)");
+    test->ExpectEq("(list (stream-null? (ints 0)) (stream-pair? (ints 0)))", "(#f #t)");
+    test->ExpectEq("(stream-pair? '(1 2))", "#f");
+
+    // Neither part of a stream pair is evaluated before it is asked for.
+    test->ExpectNoError("(define s (stream-cons (car '()) (car '())))");
+    test->ExpectEq("(stream-pair? s)", "#t");
+    test->ExpectRuntimeError("(stream-car s)");
+    test->ExpectRuntimeError("(stream-cdr s)");
+
+    test->ExpectRuntimeError("(stream-car stream-null)");
+    test->ExpectRuntimeError("(stream-cdr stream-null)");
+    test->ExpectRuntimeError("(stream-car '(1))");
+    test->ExpectRuntimeError("(stream-car (delay 5))");
+    test->ExpectRuntimeError("(stream-take -1 (ints 0))");
+    test->ExpectRuntimeError("(stream-take 1 '(1))");
+    test->ExpectRuntimeError("(stream->list 1)");
+    test->ExpectSyntaxError("(stream-cons 1)");
+}
+
+void CheckPipelines(SchemeTest* test) {
+    test->ExpectNoError("(define (ints n) (stream-cons n (ints (+ n 1))))");
+    test->ExpectNoError(
+        "(define (stream-filter keep? s)"
+        "  (delay-force"
+        "    (cond ((stream-null? s) stream-null)"
+        "          ((keep? (stream-car s))"
+        "           (stream-cons (stream-car s) (stream-filter keep? (stream-cdr s))))"
+        "          (else (stream-filter keep? (stream-cdr s))))))");
+    test->ExpectNoError(
+        "(define (stream-map f s)"
+        "  (delay-force"
+        "    (if (stream-null? s) stream-null"
+        "        (stream-cons (f (stream-car s)) (stream-map f (stream-cdr s))))))");
+    test->ExpectNoError(
+        "(define (stream-sum s acc)"
+        "  (if (stream-null? s) acc (stream-sum (stream-cdr s) (+ acc (stream-car s)))))");
+    test->ExpectNoError("(define (multiple-of-7? n) (= n (* 7 (/ n 7))))");
+    test->ExpectEq("(stream->list 4 (stream-filter multiple-of-7? (ints 1)))", "(7 14 21 28)");
+
+    // Filtering skips long runs of items by delay-force alone, without nesting forces.
+    test->ExpectEq("(stream-car (stream-filter (lambda (n) (> n 10000)) (ints 0)))", "10001");
+    test->ExpectEq(
+        "(stream-sum (stream-take 2000 (stream-map (lambda (n) (* n 2))"
+        "  (stream-filter multiple-of-7? (ints 0)))) 0)",
+        "27986000");
+}
+
+void CheckAll(SchemeTest* test) {
+    CheckPromises(test);
+    CheckIterativeForcing(test);
+    CheckStreams(test);
+    CheckPipelines(test);
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "Promises") {
+    SetStackLimit(0);
+    CheckAll(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "PromisesInColdCode") {
+    SetTierPolicy(kAlwaysCold);
+    SetStackLimit(0);
+    CheckAll(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "PromisesInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    SetStackLimit(0);
+    CheckAll(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "PromisesOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckAll(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "ForcedStreamsAreReleasedIteratively") {
+    ExpectNoError("(define (ints n) (stream-cons n (ints (+ n 1))))");
+    ExpectNoError("(define s (stream-take 20000 (ints 0)))");
+    ExpectEq("(car (list-tail (stream->list s) 19999))", "19999");
+    ExpectNoError("(set! s #f)");
+}
@@ -0,0 +1,90 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckQuasiquote(SchemeTest* test) {
+    test->ExpectNoError("(define x 5)");
+    test->ExpectNoError("(define l '(1 2))");
+    test->ExpectEq("`x", "x");
+    test->ExpectEq("`,x", "5");
+    test->ExpectEq("`(a b)", "(a b)");
+    test->ExpectEq("`(a ,x (b ,(+ x 1)))", "(a 5 (b 6))");
+    test->ExpectEq("`(0 ,@l 3)", "(0 1 2 3)");
+    test->ExpectEq("`(,@l ,@l)", "(1 2 1 2)");
+    test->ExpectEq("`(,@'() a ,@'())", "(a)");
+    test->ExpectEq("`(a . ,x)", "(a . 5)");
+    test->ExpectEq("`(a ,@l . b)", "(a 1 2 . b)");
+    test->ExpectEq("(quasiquote (a (unquote x)))", "(a 5)");
+
+    // Unquotes in nested quasiquotes are evaluated only once back at the outer level.
+    test->ExpectEq("`(a `(b ,(c ,x)))", "(a (quasiquote (b (unquote (c 5)))))");
+    test->ExpectEq("`(a `(b ,,x))", "(a (quasiquote (b (unquote 5))))");
+    test->ExpectEq("`(a `(b ,@,@l))", "(a (quasiquote (b (unquote-splicing 1 2))))");
+
+    test->ExpectSyntaxError("(quasiquote)");
+    test->ExpectSyntaxError("(quasiquote a b)");
+    test->ExpectSyntaxError("`,@l");
+    test->ExpectSyntaxError("`(a . ,@l)");
+    test->ExpectSyntaxError("`(a (unquote))");
+    test->ExpectSyntaxError("`(a (unquote x x))");
+    test->ExpectSyntaxError(",x");
+    test->ExpectSyntaxError("(list ,@l)");
+    test->ExpectRuntimeError("`(a ,@x)");
+    test->ExpectRuntimeError("`(a ,@(cons 1 2) b)");
+    test->ExpectNameError("`(a ,y)");
+}
+
+// Instances share the parts of the template that unquote nothing, and the list spliced in last.
+void CheckSharing(SchemeTest* test) {
+    test->ExpectNoError("(define (make v) `((a b) ,v))");
+    test->ExpectNoError("(set-car! (car (make 1)) 'z)");
+    test->ExpectEq("(make 2)", "((z b) 2)");
+
+    test->ExpectNoError("(define l '(1 2))");
+    test->ExpectNoError("(define shared `(0 ,@l))");
+    test->ExpectNoError("(define copied `(,@l 3))");
+    test->ExpectNoError("(set-car! l 9)");
+    test->ExpectEq("shared", "(0 9 2)");
+    test->ExpectEq("copied", "(1 2 3)");
+}
+
+void CheckQuasiquoteInProcedures(SchemeTest* test) {
+    test->ExpectNoError("(define (pair-up a b) `(,a . ,b))");
+    test->ExpectNoError("(define (tag x) `(x ,x))");
+    test->ExpectNoError("(define (tag-one) (tag 1))");
+    test->ExpectNoError("(define (wrap items) `(begin ,@items (end ,(car items))))");
+    test->ExpectNoError(
+        "(define (range n)"
+        "  (let loop ((i n) (acc '())) (if (= i 0) acc (loop (- i 1) `(,i ,@acc)))))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(pair-up 1 2)", "(1 . 2)");
+        test->ExpectEq("(tag-one)", "(x 1)");
+        test->ExpectEq("(wrap '(1 2))", "(begin 1 2 (end 1))");
+        test->ExpectEq("(range 5)", "(1 2 3 4 5)");
+    }
+    test->ExpectRuntimeError("(wrap 1)");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "Quasiquote") {
+    CheckQuasiquote(this);
+    CheckSharing(this);
+    CheckQuasiquoteInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "QuasiquoteInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckQuasiquote(this);
+    CheckSharing(this);
+    CheckQuasiquoteInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "QuasiquoteOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckQuasiquote(this);
+    CheckSharing(this);
+    CheckQuasiquoteInProcedures(this);
+}
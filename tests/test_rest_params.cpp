@@ -0,0 +1,88 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckRestParams(SchemeTest* test) {
+    test->ExpectNoError("(define (tail a . rest) (list a rest))");
+    test->ExpectEq("(tail 1)", "(1 ())");
+    test->ExpectEq("(tail 1 2 3)", "(1 (2 3))");
+    test->ExpectEq("((lambda args args))", "()");
+    test->ExpectEq("((lambda args args) 1 2)", "(1 2)");
+    test->ExpectEq("((lambda (a b . c) (+ a b)) 1 2 3 4)", "3");
+    test->ExpectNoError("(define (first-of . items) (car items))");
+    test->ExpectEq("(first-of 5 6)", "5");
+
+    // The rest list is left unbuilt when the body does not refer to it, which it still may
+    // through a macro defined later.
+    test->ExpectNoError("(define (quoted a . rest) 'rest)");
+    test->ExpectEq("(quoted 1 2)", "rest");
+    test->ExpectNoError("(define (late . rest) (peek rest))");
+    test->ExpectNoError("(define-syntax peek (syntax-rules () ((_ x) x)))");
+    test->ExpectEq("(late 1 2)", "(1 2)");
+
+    test->ExpectRuntimeError("(tail)");
+    test->ExpectRuntimeError("((lambda (a b . c) a) 1)");
+    test->ExpectSyntaxError("(lambda (a . 1) a)");
+    test->ExpectSyntaxError("(define (f . 1) 1)");
+}
+
+void CheckApply(SchemeTest* test) {
+    test->ExpectEq("(apply + '(1 2 3))", "6");
+    test->ExpectEq("(apply + 1 2 '(3 4))", "10");
+    test->ExpectEq("(apply list '())", "()");
+    test->ExpectEq("(apply (lambda (a . rest) rest) 1 '(2 3))", "(2 3)");
+    test->ExpectEq("(apply apply (list list '(1 2)))", "(1 2)");
+    test->ExpectEq("(call/cc (lambda (k) (apply k '(7))))", "7");
+    test->ExpectEq("(call-with-values (lambda () (apply values '(1 2))) list)", "(1 2)");
+
+    test->ExpectRuntimeError("(apply +)");
+    test->ExpectRuntimeError("(apply 1 '())");
+    test->ExpectRuntimeError("(apply + 1 2)");
+    test->ExpectRuntimeError("(apply + '(1 . 2))");
+    test->ExpectRuntimeError("(apply (lambda (a) a) '(1 2))");
+}
+
+void CheckInProcedures(SchemeTest* test) {
+    test->ExpectNoError(
+        "(define (sum . items)"
+        "  (let loop ((l items) (acc 0)) (if (null? l) acc (loop (cdr l) (+ acc (car l))))))");
+    test->ExpectNoError("(define (count-down n . acc) (if (= n 0) acc (count-down (- n 1) n)))");
+    test->ExpectNoError("(define (spin n) (if (= n 0) 'done (apply spin (- n 1) '())))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(sum 1 2 3 4)", "10");
+        test->ExpectEq("(apply sum 1 '(2 3))", "6");
+        test->ExpectEq("(count-down 3)", "(1)");
+        test->ExpectEq("(spin 1000)", "done");
+    }
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "RestParams") {
+    CheckRestParams(this);
+    CheckApply(this);
+    CheckInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "RestParamsInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckRestParams(this);
+    CheckApply(this);
+    CheckInProcedures(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "RestParamsOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckRestParams(this);
+    CheckApply(this);
+    CheckInProcedures(this);
+}
+
+// Applying in tail position does not grow the machine's continuation.
+TEST_CASE_METHOD(SchemeTest, "ApplyInTailPositionOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    ExpectNoError("(define (spin n) (if (= n 0) 'done (apply spin (list (- n 1)))))");
+    ExpectEq("(spin 100000)", "done");
+}
@@ -0,0 +1,126 @@
+#include "scheme_test.h"
+
+#include "eval/optimizer.h"
+#include "eval/procedure.h"
+#include "io/printer.h"
+#include "reader/parser.h"
+#include "runtime/env.h"
+#include "runtime/list_utils.h"
+#include "stdlib/builtins.h"
+
+#include <sstream>
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+std::shared_ptr<Object> ReadExpr(const std::string& str) {
+    std::istringstream in{str};
+    Tokenizer tokenizer{&in};
+    return Read(&tokenizer);
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "ScalarReplacement") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (first a b) (car (cons a b)))");
+    ExpectNoError("(define (second a b) (cdr (cons a b)))");
+    ExpectEq("(first 1 2)", "1");
+    ExpectEq("(second 1 2)", "2");
+    ExpectRuntimeError("(first 1 (car 2))");
+
+    ExpectNoError("(define (sum a b) (let ((p (cons a b)) (n 3)) (+ (car p) (cdr p) n)))");
+    ExpectEq("(sum 1 2)", "6");
+    ExpectNoError("(define (make-pair a b) (cons a b))");
+    ExpectNoError("(define (diff a b) (let ((p (make-pair a b))) (- (car p) (cdr p))))");
+    ExpectEq("(diff 5 2)", "3");
+    ExpectNoError(
+        "(define (swap-sum a b)"
+        "  (let* ((p (cons a b)) (q (cons (cdr p) (car p))))"
+        "    (if (< (car q) (cdr q)) (list (car q) (cdr q)) (- (car q) (cdr q)))))");
+    ExpectEq("(swap-sum 1 2)", "1");
+    ExpectEq("(swap-sum 2 1)", "(1 2)");
+
+    // Components are evaluated in order, once.
+    ExpectNoError("(define log '())");
+    ExpectNoError("(define (note x) (set! log (cons x log)) x)");
+    ExpectNoError("(define (ordered) (let ((p (cons (note 1) (note 2)))) (cdr p)))");
+    ExpectEq("(ordered)", "2");
+    ExpectEq("log", "(2 1)");
+}
+
+// A pair used in any way other than by car and cdr is built as usual.
+TEST_CASE_METHOD(SchemeTest, "EscapingPairsAreBuilt") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (returned a) (let ((p (cons a 1))) (car p) p))");
+    ExpectEq("(returned 0)", "(0 . 1)");
+    ExpectNoError("(define (mutated a) (let ((p (cons a 1))) (set-car! p 5) (car p)))");
+    ExpectEq("(mutated 0)", "5");
+    ExpectNoError("(define (captured a) (let ((p (cons a 1))) (lambda () (car p))))");
+    ExpectEq("((captured 4))", "4");
+    ExpectNoError("(define (reassigned a) (let ((p (cons a 1))) (set! p (cons 2 3)) (car p)))");
+    ExpectEq("(reassigned 0)", "2");
+    ExpectNoError("(define (quoted a) (let ((p (cons a 1))) (list (car p) 'p)))");
+    ExpectEq("(quoted 0)", "(0 p)");
+    ExpectNoError("(define (shadowed a) (let ((p (cons a 1))) (let ((p '(7))) (car p))))");
+    ExpectEq("(shadowed 0)", "7");
+    ExpectNoError("(define (own-car a) (let ((p (cons a 1))) (let ((car cdr)) (car p))))");
+    ExpectEq("(own-car 0)", "1");
+    ExpectNoError("(define-syntax first-of (syntax-rules () ((_ x) (car x))))");
+    ExpectNoError("(define (via-macro a) (let ((p (cons a 1))) (first-of p)))");
+    ExpectEq("(via-macro 0)", "0");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ScalarReplacementFollowsRebinding") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (f a b) (let ((p (cons a b))) (car p)))");
+    ExpectNoError("(define (g a b) (car (cons a b)))");
+    ExpectEq("(f 1 2)", "1");
+    ExpectEq("(g 1 2)", "1");
+    ExpectNoError("(define car cdr)");
+    ExpectEq("(f 1 2)", "2");
+    ExpectEq("(g 1 2)", "2");
+    ExpectNoError("(define cons list)");
+    ExpectEq("(f 1 2)", "(2)");
+    ExpectEq("(g 1 2)", "(2)");
+}
+
+TEST_CASE("OptimizerTakeApartPair") {
+    auto env = std::make_shared<Environment>();
+    AddBuiltins(env);
+    env->Define("make-pair", std::make_shared<LambdaProcedure>(
+                                 LambdaProcedure::Params{"a", "b"},
+                                 listutils::ToVector(ReadExpr("((cons a b))")), env));
+    auto forms = CreateStandardForms();
+    Optimizer optimizer(forms, nullptr, env);
+
+    auto pair = optimizer.TakeApartPair(ReadExpr("(cons x (+ 1 2))"));
+    REQUIRE(pair);
+    REQUIRE(Print(pair->components[0]) == "x");
+    REQUIRE(Print(pair->components[1]) == "(+ 1 2)");
+    REQUIRE(pair->assumptions.size() == 1);
+
+    pair = optimizer.TakeApartPair(ReadExpr("(make-pair 1 'y)"));
+    REQUIRE(pair);
+    REQUIRE(Print(pair->components[1]) == "(quote y)");
+    REQUIRE(pair->assumptions.size() == 2);
+
+    REQUIRE_FALSE(optimizer.TakeApartPair(ReadExpr("(list 1 2)")));
+    REQUIRE_FALSE(optimizer.TakeApartPair(ReadExpr("(cons 1)")));
+    REQUIRE_FALSE(optimizer.TakeApartPair(ReadExpr("(make-pair (f) 2)")));
+
+    auto count = [&](const std::string& body) {
+        return optimizer.CountPairAccesses("p", listutils::ToVector(ReadExpr(body)));
+    };
+    REQUIRE(count("((+ (car p) (cdr p)) (let ((q (car p))) q))") == 3);
+    REQUIRE(count("((car q) 'x)") == 0);
+    REQUIRE_FALSE(count("((list (car p) p))"));
+    REQUIRE_FALSE(count("(p)"));
+    REQUIRE_FALSE(count("((set-car! p 1))"));
+    REQUIRE_FALSE(count("((lambda () (car p)))"));
+    REQUIRE_FALSE(count("('p)"));
+    REQUIRE_FALSE(count("(`(,(car p)))"));
+
+    env->Clear();
+}
@@ -0,0 +1,103 @@
+#include "scheme_test.h"
+
+#include "eval/eval.h"
+#include "eval/procedure.h"
+#include "reader/parser.h"
+#include "runtime/env.h"
+#include "stdlib/builtins.h"
+
+#include <sstream>
+
+namespace {
+
+constexpr TierPolicy kAlwaysCold{UINT64_MAX, UINT64_MAX};
+constexpr TierPolicy kAlwaysWarm{0, UINT64_MAX};
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+std::shared_ptr<Object> ReadExpr(const std::string& str) {
+    std::istringstream in{str};
+    Tokenizer tokenizer{&in};
+    return Read(&tokenizer);
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "TiersAgreeOnResults") {
+    for (auto policy : {kAlwaysCold, kAlwaysWarm, kAlwaysHot}) {
+        SetTierPolicy(policy);
+        ExpectNoError("(define (fact n) (if (= n 0) 1 (* n (fact (- n 1)))))");
+        ExpectEq("(fact 10)", "3628800");
+
+        ExpectNoError("(define (make-counter) (define n 0) (lambda () (set! n (+ n 1)) n))");
+        ExpectNoError("(define c (make-counter))");
+        ExpectEq("(c)", "1");
+        ExpectEq("(c)", "2");
+
+        ExpectNoError("(define (pick x) (and (> x 0) (or (= x 1) 'many)))");
+        ExpectEq("(pick 1)", "#t");
+        ExpectEq("(pick 5)", "many");
+        ExpectEq("(pick 0)", "#f");
+    }
+}
+
+TEST_CASE_METHOD(SchemeTest, "TiersKeepLazySyntaxErrors") {
+    for (auto policy : {kAlwaysCold, kAlwaysWarm, kAlwaysHot}) {
+        SetTierPolicy(policy);
+        ExpectNoError("(define (f x) (if x (if) 1))");
+        ExpectEq("(f #f)", "1");
+        ExpectSyntaxError("(f #t)");
+        ExpectNameError("((lambda () undefined-name))");
+    }
+}
+
+TEST_CASE_METHOD(SchemeTest, "HotSelfTailCallsDoNotGrowStack") {
+    SetTierPolicy(kAlwaysHot);
+    ExpectNoError("(define (count-down n acc) (if (= n 0) acc (count-down (- n 1) (+ acc 1))))");
+    ExpectEq("(count-down 1000000 0)", "1000000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ColdSelfTailCallsDoNotGrowStack") {
+    SetTierPolicy(kAlwaysCold);
+    SetStackLimit(0);
+    ExpectNoError("(define (count-down n acc) (if (= n 0) acc (count-down (- n 1) (+ acc 1))))");
+    ExpectEq("(count-down 100000 0)", "100000");
+    ExpectNoError(
+        "(define (walk n) (cond ((= n 0) 'done) ((odd? n) (and #t (walk (- n 1))))"
+        "  (else (let ((m (- n 1))) (or #f (begin (walk m)))))))");
+    ExpectNoError("(define (odd? n) (= 1 (- n (* 2 (/ n 2)))))");
+    ExpectEq("(walk 100000)", "done");
+
+    // A call in the body of a guard is not in tail position, so the guard still catches.
+    ExpectNoError(
+        "(define (guarded n) (guard (e (#t (list 'caught n))) (if (= n 0) (raise 'x)"
+        "  (guarded (- n 1)))))");
+    ExpectEq("(guarded 3)", "(caught 0)");
+    ExpectNoError("(define (not-tail n) (if (= n 0) 0 (+ 1 (not-tail (- n 1)))))");
+    ExpectRuntimeError("(not-tail 100000)");
+}
+
+TEST_CASE("LambdaProcedurePromotion") {
+    auto env = std::make_shared<Environment>();
+    AddBuiltins(env);
+    Evaluator evaluator;
+    evaluator.SetTierPolicy(TierPolicy{2, 10});
+
+    evaluator.Eval(ReadExpr("(define (loop n) (if (= n 0) 0 (loop (- n 1))))"), env);
+    auto loop = As<LambdaProcedure>(env->Lookup("loop"));
+    REQUIRE(loop);
+    REQUIRE(loop->GetTier() == Tier::Cold);
+
+    evaluator.Eval(ReadExpr("(loop 0)"), env);
+    REQUIRE(loop->GetCallCount() == 1);
+    REQUIRE(loop->GetTier() == Tier::Cold);
+
+    evaluator.Eval(ReadExpr("(loop 0)"), env);
+    REQUIRE(loop->GetTier() == Tier::Warm);
+
+    evaluator.Eval(ReadExpr("(loop 20)"), env);
+    REQUIRE(loop->GetTier() == Tier::Hot);
+    REQUIRE(loop->GetLoopIterations() > 0);
+    REQUIRE(loop->GetCallCount() + loop->GetLoopIterations() == 23);
+
+    env->Clear();
+}
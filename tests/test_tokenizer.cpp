@@ -68,6 +68,11 @@ TEST_CASE("Symbol names") {
     CheckTokens("<=> *42. #hash-tag' 'hi!.##", SymbolToken{"<=>"}, SymbolToken{"*42"}, DotToken{},
                 SymbolToken{"#hash-tag"}, QuoteToken{}, QuoteToken{}, SymbolToken{"hi!"},
                 DotToken{}, SymbolToken{"##"});
+    CheckTokens("call/cc / a/", SymbolToken{"call/cc"}, SymbolToken{"/"}, SymbolToken{"a/"});
+    CheckTokens("_ a_b ... .. .", SymbolToken{"_"}, SymbolToken{"a_b"}, SymbolToken{"..."},
+                DotToken{}, DotToken{}, DotToken{});
+    CheckTokens("(a ...)", BracketToken::OPEN, SymbolToken{"a"}, SymbolToken{"..."},
+                BracketToken::CLOSE);
 }
 
 TEST_CASE("Brackets") {
@@ -80,6 +85,13 @@ TEST_CASE("Brackets") {
                 SymbolToken{"##-15"}, BracketToken::CLOSE, QuoteToken{}, ConstantToken{-8});
 }
 
+TEST_CASE("Quasiquote") {
+    CheckTokens("`(a ,b ,@c)", QuasiquoteToken{}, BracketToken::OPEN, SymbolToken{"a"},
+                UnquoteToken{false}, SymbolToken{"b"}, UnquoteToken{true}, SymbolToken{"c"},
+                BracketToken::CLOSE);
+    CheckTokens(",,@ ,", UnquoteToken{false}, UnquoteToken{true}, UnquoteToken{false});
+}
+
 TEST_CASE("GetToken is not moving") {
     std::stringstream ss{"1234+4"};
     Tokenizer tokenizer{&ss};
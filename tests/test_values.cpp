@@ -0,0 +1,141 @@
+#include "scheme_test.h"
+
+namespace {
+
+constexpr TierPolicy kAlwaysHot{0, 0};
+
+void CheckValues(SchemeTest* test) {
+    test->ExpectNoError("(define (div-mod a b) (values (/ a b) (- a (* b (/ a b)))))");
+    test->ExpectEq("(receive (q r) (div-mod 17 5) (list q r))", "(3 2)");
+    test->ExpectEq("(receive (q . rest) (div-mod 17 5) rest)", "(2)");
+    test->ExpectEq("(receive all (values 1 2 3) all)", "(1 2 3)");
+    test->ExpectEq("(receive () (values) 'none)", "none");
+    test->ExpectEq("(receive (x) 5 x)", "5");
+    test->ExpectEq("(call-with-values (lambda () (div-mod 17 5)) list)", "(3 2)");
+    test->ExpectEq("(call-with-values (lambda () (values)) list)", "()");
+    test->ExpectEq("(call-with-values (lambda () 4) (lambda (x) (* x x)))", "16");
+    test->ExpectEq(
+        "(let-values (((a b) (values 1 2)) ((c . d) (values 3 4 5)) (e (values)) ((f) 6))"
+        "  (list a b c d e f))",
+        "(1 2 3 (4 5) () 6)");
+    test->ExpectEq("(let ((a 1)) (let-values (((a b) (values 2 a))) (list a b)))", "(2 1)");
+    test->ExpectEq("(values 7)", "7");
+    test->ExpectEq("(values 1 2)", "1 2");
+    test->ExpectEq("(values)", "");
+
+    test->ExpectRuntimeError("(receive (a b) (values 1) a)");
+    test->ExpectRuntimeError("(receive (a) (values 1 2) a)");
+    test->ExpectRuntimeError("(let-values (((a . b) (values))) a)");
+    test->ExpectRuntimeError("(call-with-values (lambda () (values 1 2)) (lambda (x) x))");
+    test->ExpectRuntimeError("(call-with-values 1 list)");
+    test->ExpectRuntimeError("(call-with-values (lambda () 1))");
+    test->ExpectSyntaxError("(receive (a b))");
+    test->ExpectSyntaxError("(receive (a 1) (values 1 2) a)");
+    test->ExpectSyntaxError("(receive (a a) (values 1 2) a)");
+    test->ExpectSyntaxError("(let-values (((a) 1) ((a) 2)) a)");
+    test->ExpectSyntaxError("(let-values ((a)) a)");
+}
+
+void CheckValuesInProcedures(SchemeTest* test) {
+    test->ExpectNoError("(define (min-max a b) (if (< a b) (values a b) (values b a)))");
+    test->ExpectNoError(
+        "(define (spread l)"
+        "  (let loop ((l l) (lo 1000) (hi -1000))"
+        "    (if (null? l)"
+        "        (- hi lo)"
+        "        (receive (a b) (min-max (car l) lo)"
+        "          (receive (c d) (min-max (car l) hi) (loop (cdr l) a d))))))");
+    test->ExpectNoError(
+        "(define (sum-pairs n)"
+        "  (do ((i 0 (+ i 1)) (acc 0 (call-with-values (lambda () (values i i)) (lambda (a b)"
+        "                                 (+ acc a b)))))"
+        "      ((= i n) acc)))");
+    for (auto i = 0; i < 20; ++i) {
+        test->ExpectEq("(spread '(3 9 1 4))", "8");
+        test->ExpectEq("(sum-pairs 10)", "90");
+    }
+}
+
+void CheckSingleValueContexts(SchemeTest* test) {
+    test->ExpectNoError("(define (two) (values 1 2))");
+    test->ExpectNoError("(define z 0)");
+    test->ExpectRuntimeError("(define x (values 1 2))");
+    test->ExpectRuntimeError("(define y (two))");
+    test->ExpectNameError("y");
+    test->ExpectRuntimeError("(set! z (two))");
+    test->ExpectEq("z", "0");
+    test->ExpectRuntimeError("(list (values 1 2) 3)");
+    test->ExpectRuntimeError("(car (cons (two) 1))");
+    test->ExpectRuntimeError("(not (two))");
+    test->ExpectRuntimeError("(+ 1 (two))");
+    test->ExpectRuntimeError("(let ((a (two))) a)");
+    test->ExpectRuntimeError("(let* ((a 1) (b (two))) b)");
+    test->ExpectRuntimeError("(letrec ((a (two))) a)");
+    test->ExpectRuntimeError("(let loop ((i (two))) i)");
+    test->ExpectRuntimeError("(if (two) 1 2)");
+    test->ExpectRuntimeError("(and (two) 1)");
+    test->ExpectRuntimeError("(or (two) 1)");
+    test->ExpectRuntimeError("(cond ((two) 1))");
+    test->ExpectRuntimeError("(case (two) ((1) 1))");
+    test->ExpectRuntimeError("`(a ,(two))");
+    test->ExpectRuntimeError("(force (delay (two)))");
+
+    test->ExpectNoError("(define (add-two n) (+ n (two)))");
+    test->ExpectNoError("(define (bind-two) (let ((a (two))) a))");
+    test->ExpectNoError("(define (test-two) (if (two) 'yes 'no))");
+    test->ExpectNoError("(define (count-two n) (if (= n 0) 0 (+ 1 (count-two (- n (two))))))");
+    for (auto i = 0; i < 3; ++i) {
+        test->ExpectRuntimeError("(add-two 1)");
+        test->ExpectRuntimeError("(bind-two)");
+        test->ExpectRuntimeError("(test-two)");
+        test->ExpectRuntimeError("(count-two 3)");
+    }
+
+    // Rejecting the values drops them, so the next receiver gets its own.
+    test->ExpectRuntimeError("(list (two) (receive (a b) (values 3 4) a))");
+    test->ExpectEq("(receive (a b) (values 3 4) (list a b))", "(3 4)");
+    test->ExpectEq("(receive (a b) (two) (list (receive (c d) (values 3 4) (+ c d)) a b))",
+                   "(7 1 2)");
+
+    // Tail positions pass the values on and sequences discard them.
+    test->ExpectEq("(and 1 (two))", "1 2");
+    test->ExpectEq("(or #f (two))", "1 2");
+    test->ExpectEq("(begin (two) 3)", "3");
+    test->ExpectEq("(receive (a b) (if #t (two) 0) (list a b))", "(1 2)");
+    test->ExpectEq("(receive (a b) (let ((x 5)) (two)) (list a b))", "(1 2)");
+}
+
+}  // namespace
+
+TEST_CASE_METHOD(SchemeTest, "MultipleValues") {
+    CheckValues(this);
+    CheckValuesInProcedures(this);
+    CheckSingleValueContexts(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "MultipleValuesInHotCode") {
+    SetTierPolicy(kAlwaysHot);
+    CheckValues(this);
+    CheckValuesInProcedures(this);
+    CheckSingleValueContexts(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "MultipleValuesOnMachine") {
+    SetEvalMode(EvalMode::Machine);
+    CheckValues(this);
+    CheckValuesInProcedures(this);
+    CheckSingleValueContexts(this);
+}
+
+TEST_CASE_METHOD(SchemeTest, "MultipleValuesSurvivePauses") {
+    ExpectNoError("(define (pair n) (values n (+ n 1)))");
+    auto task = Start("(let loop ((i 0) (acc 0)) (if (= i 50) acc (receive (a b) (pair i)"
+                      "  (loop (+ i 1) (+ acc (* a b))))))");
+    REQUIRE(task.has_value());
+    std::expected<std::string, Error> result;
+    while (!task->IsFinished()) {
+        result = task->Resume(Budget{.fuel = 1});
+        ExpectEq("(receive (a b) (values 'x 'y) (list b a))", "(y x)");
+    }
+    REQUIRE(result == "41650");
+}